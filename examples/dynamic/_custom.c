@@ -10,34 +10,34 @@
 
 void sin_impl(FunctionContext *fn_ctx) {
   const Entity *args = FunctionContext_args(fn_ctx);
-  if (NULL == args || PRIMITIVE != args->type) {
+  if (NULL == args || PRIMITIVE != etype(args)) {
     FunctionContext_raise_error(
         fn_ctx, "sin() takes exactly 1 primitive type argument.");
     return;
   }
-  const double r = float_of(&args->pri);
+  const double r = efloat_of(args);
   *FunctionContext_mutable_retval(fn_ctx) = entity_float(sin(r));
 }
 
 void cos_impl(FunctionContext *fn_ctx) {
   const Entity *args = FunctionContext_args(fn_ctx);
-  if (NULL == args || PRIMITIVE != args->type) {
+  if (NULL == args || PRIMITIVE != etype(args)) {
     FunctionContext_raise_error(
         fn_ctx, "cos() takes exactly 1 primitive type argument.");
     return;
   }
-  const double r = float_of(&args->pri);
+  const double r = efloat_of(args);
   *FunctionContext_mutable_retval(fn_ctx) = entity_float(cos(r));
 }
 
 void tan_impl(FunctionContext *fn_ctx) {
   const Entity *args = FunctionContext_args(fn_ctx);
-  if (NULL == args || PRIMITIVE != args->type) {
+  if (NULL == args || PRIMITIVE != etype(args)) {
     FunctionContext_raise_error(
         fn_ctx, "tan() takes exactly 1 primitive type argument.");
     return;
   }
-  const double r = float_of(&args->pri);
+  const double r = efloat_of(args);
   *FunctionContext_mutable_retval(fn_ctx) = entity_float(tan(r));
 }
 
@@ -25,4 +25,9 @@ void array_print__(const Object *obj, FILE *out) {
     entity_print(Array_get_ref_unchecked(array, i), out);
   }
   fprintf(out, "]");
+}
+
+size_t array_bytes__(const Object *obj) {
+  const Array *array = (Array *)obj->_internal_obj;
+  return NULL == array ? 0 : sizeof(Array) + Array_size(array) * sizeof(Entity);
 }
\ No newline at end of file
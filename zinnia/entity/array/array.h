@@ -15,5 +15,6 @@ DEFINE_ARRAYLIKE(Array, Entity);
 void array_init__(Object *obj);
 void array_delete__(Object *obj);
 void array_print__(const Object *obj, FILE *out);
+size_t array_bytes__(const Object *obj);
 
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_ARRAY_ARRAY_H_ */
\ No newline at end of file
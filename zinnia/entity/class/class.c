@@ -5,11 +5,222 @@
 
 #include "zinnia/entity/class/class.h"
 
+#include "c-data-structures/maplike.h"
 #include "c-data-structures/stable_maplike.h"
 #include "zinnia/alloc/alloc.h"
+#include "zinnia/entity/class/layout.h"
 #include "zinnia/entity/function/function.h"
 #include "zinnia/entity/object.h"
 #include "zinnia/util/error.h"
+#include "zinnia/util/sync/atomic.h"
+#include "zinnia/util/sync/thread.h"
+
+// Bytes a ClassReader is padded to, so that readers never share a cache line.
+#define CACHE_LINE_SIZE 64
+
+static uint32_t lookup_epoch_ = 0;
+
+// Tables replaced in Class._table are freed with epoch-based reclamation.
+//
+// Each thread reading tables publishes the reclamation epoch it saw in a
+// ClassReader of its own. A table replaced while the epoch is E goes on
+// retired_tables_[E % 3]. The epoch only advances once every reader has seen
+// it, so when it advances to E + 2 no reader can still hold a table retired in
+// E and those are freed.
+//
+// The VM marks a thread as reading for the whole of each task it runs (see
+// class_begin_lookups()), so lookups themselves only touch thread-locals.
+static uint32_t reclaim_epoch_ = 0;
+static ClassTable *retired_tables_[3] = {NULL, NULL, NULL};
+static uint32_t is_reclaiming_ = false;
+
+typedef struct ClassReader_ ClassReader;
+struct ClassReader_ {
+  // (epoch << 1) | 1 while the thread that took it reads tables, otherwise 0.
+  volatile uint32_t epoch;
+  // Whether a thread has the reader. Threads give it up whenever they stop
+  // reading, so there are only as many as threads that ever read at once.
+  volatile uint32_t is_taken;
+  // The next in readers_. Never changes once added.
+  ClassReader *next;
+  char padding[CACHE_LINE_SIZE - 2 * sizeof(uint32_t) - sizeof(ClassReader *)];
+};
+
+// Every reader ever created. Readers are reused rather than freed.
+static ClassReader *readers_ = NULL;
+
+// The reader of this thread, if it has read before, and how deeply nested its
+// reading is.
+static THREAD_LOCAL ClassReader *thread_reader_ = NULL;
+static THREAD_LOCAL uint32_t thread_read_depth_ = 0;
+
+DEFINE_MAPLIKE(FunctionPtrMap, char *, const Function *);
+IMPL_MAPLIKE(FunctionPtrMap, char *, const Function *);
+
+// A class with its inheritance resolved for a single lookup epoch. Never
+// modified once published to Class._table.
+struct ClassTable_ {
+  uint32_t epoch;
+  // Every function callable on the class, including inherited ones.
+  FunctionPtrMap functions;
+  // Ancestors from the root down, so the class is display[depth].
+  const Class **display;
+  uint32_t depth;
+  // The next table in its list of retired_tables_.
+  ClassTable *previous;
+};
+
+ClassTable *table_create_(const Class *cls, uint32_t epoch) {
+  ClassTable *table = MNEW(ClassTable);
+  table->epoch = epoch;
+  table->previous = NULL;
+  table->depth = 0;
+  for (const Class *c = cls->_super; NULL != c; c = c->_super) {
+    ++table->depth;
+  }
+  table->display = MNEW_ARR(const Class *, table->depth + 1);
+  FunctionPtrMap_init(&table->functions, hash_interned_string,
+                      compare_interned_strings);
+  int i = table->depth;
+  for (const Class *c = cls; NULL != c; c = c->_super, --i) {
+    table->display[i] = c;
+    atomic_store_u32((uint32_t *)&c->_is_referenced, true);
+    FunctionMapIterator funcs;
+    FunctionMap_iterator(&funcs, &c->_functions);
+    for (; FunctionMap_has_entry(&funcs); FunctionMap_next_entry(&funcs)) {
+      const Function *f = FunctionMap_value(&funcs);
+      // Subclasses are visited first, so overrides are never replaced.
+      if (NULL == FunctionPtrMap_find(&table->functions, f->_name,
+                                      sizeof(char *), NULL)) {
+        FunctionPtrMap_insert(&table->functions, f->_name, sizeof(char *), f);
+      }
+    }
+  }
+  return table;
+}
+
+void table_delete_(ClassTable *table) {
+  while (NULL != table) {
+    ClassTable *previous = table->previous;
+    FunctionPtrMap_finalize(&table->functions);
+    RELEASE(table->display);
+    RELEASE(table);
+    table = previous;
+  }
+}
+
+// Must be called while reading, after table was replaced.
+void table_retire_(ClassTable *table) {
+  // The reader keeps the epoch from advancing past the one after what it saw,
+  // so this list cannot be freed before the table is on it.
+  ClassTable *volatile *tables =
+      &retired_tables_[atomic_load_u32(&reclaim_epoch_) % 3];
+  ClassTable *head;
+  do {
+    head = atomic_load_ptr((void *const volatile *)tables);
+    table->previous = head;
+  } while (!atomic_cas_ptr((void *volatile *)tables, head, table));
+}
+
+ClassReader *take_reader_() {
+  ClassReader *reader = thread_reader_;
+  if (NULL != reader && atomic_cas_u32(&reader->is_taken, false, true)) {
+    return reader;
+  }
+  for (reader = atomic_load_ptr((void *const volatile *)&readers_);
+       NULL != reader; reader = reader->next) {
+    if (atomic_cas_u32(&reader->is_taken, false, true)) {
+      return thread_reader_ = reader;
+    }
+  }
+  reader = MNEW(ClassReader);
+  reader->epoch = 0;
+  reader->is_taken = true;
+  ClassReader *head;
+  do {
+    head = atomic_load_ptr((void *const volatile *)&readers_);
+    reader->next = head;
+  } while (!atomic_cas_ptr((void *volatile *)&readers_, head, reader));
+  return thread_reader_ = reader;
+}
+
+// Publishes the current epoch as seen by reader.
+void observe_epoch_(ClassReader *reader) {
+  atomic_store_u32(&reader->epoch,
+                   (atomic_load_u32(&reclaim_epoch_) << 1) | 1);
+  // Orders publishing the epoch before loading Class._table, which
+  // try_reclaim_() relies on.
+  atomic_fence();
+}
+
+// Tables returned by class_table_() may only be read between these.
+void begin_read_() {
+  if (0 != thread_read_depth_++) {
+    return;
+  }
+  observe_epoch_(take_reader_());
+}
+
+void end_read_() {
+  ASSERT(thread_read_depth_ > 0);
+  if (0 != --thread_read_depth_) {
+    return;
+  }
+  ClassReader *reader = thread_reader_;
+  atomic_store_u32(&reader->epoch, 0);
+  atomic_store_u32(&reader->is_taken, false);
+}
+
+// Advances the epoch if every reader has seen it, and frees what can no longer
+// be read. Returns whether it advanced.
+bool try_reclaim_() {
+  if (!atomic_cas_u32(&is_reclaiming_, false, true)) {
+    return false;
+  }
+  const uint32_t epoch = atomic_load_u32(&reclaim_epoch_);
+  // Orders the replacements of what was retired before checking the readers,
+  // pairing with the fence in observe_epoch_().
+  atomic_fence();
+  for (ClassReader *reader = atomic_load_ptr((void *const volatile *)&readers_);
+       NULL != reader; reader = reader->next) {
+    const uint32_t reader_epoch = atomic_load_u32(&reader->epoch);
+    if (0 != reader_epoch && ((epoch << 1) | 1) != reader_epoch) {
+      atomic_store_u32(&is_reclaiming_, false);
+      return false;
+    }
+  }
+  atomic_store_u32(&reclaim_epoch_, epoch + 1);
+  // Retired while the epoch was epoch - 1.
+  ClassTable *tables = atomic_exchange_ptr(
+      (void *volatile *)&retired_tables_[(epoch + 2) % 3], NULL);
+  atomic_store_u32(&is_reclaiming_, false);
+  table_delete_(tables);
+  return true;
+}
+
+ClassTable *class_table_(const Class *cls) {
+  const uint32_t epoch = class_lookup_epoch();
+  ClassTable *table = atomic_load_ptr((void *const volatile *)&cls->_table);
+  if (NULL != table && epoch == table->epoch) {
+    return table;
+  }
+  ClassTable *new_table = table_create_(cls, epoch);
+  if (!atomic_cas_ptr((void *volatile *)&cls->_table, table, new_table)) {
+    // Another thread replaced it first.
+    table_delete_(new_table);
+    return atomic_load_ptr((void *const volatile *)&cls->_table);
+  }
+  if (NULL != table) {
+    table_retire_(table);
+  }
+  return new_table;
+}
+
+void invalidate_if_referenced_(const Class *cls) {
+  if (atomic_load_u32(&cls->_is_referenced)) {
+    class_invalidate_lookups();
+  }
+}
 
 
 Class *class_init(Class *cls, const char name[], const Class *super,
@@ -25,6 +236,11 @@ Class *class_init(Class *cls, const char name[], const Class *super,
   cls->_delete_fn = NULL;
   cls->_print_fn = NULL;
   cls->_copy_fn = NULL;
+  cls->_trace_fn = NULL;
+  cls->_size_fn = NULL;
+  cls->_table = NULL;
+  cls->_is_referenced = false;
+  cls->_layout = NULL;
   FunctionMap_init(&cls->_functions, hash_interned_string,
                    compare_interned_strings);
   FieldMap_init(&cls->_fields, hash_interned_string, compare_interned_strings);
@@ -35,6 +251,8 @@ void class_finalize(Class *cls) {
   ASSERT(cls != NULL);
   FunctionMap_finalize(&cls->_functions);
   FieldMap_finalize(&cls->_fields);
+  table_delete_(cls->_table);
+  class_layout_delete(cls);
 }
 
 Function *class_add_function(Class *cls, const char name[], uint32_t ins_pos,
@@ -51,6 +269,7 @@ Function *class_add_function(Class *cls, const char name[], uint32_t ins_pos,
   function_init(f, name, cls->_module, ins_pos, is_anon(name), is_const,
                 is_async);
   f->_parent_class = cls;
+  invalidate_if_referenced_(cls);
   return f;
 }
 
@@ -80,27 +299,56 @@ FieldMapIterator class_fields(Class *cls) {
   return it;
 }
 
+void class_set_super(Class *cls, const Class *super) {
+  cls->_super = super;
+  invalidate_if_referenced_(cls);
+}
+
+void class_flatten(const Class *cls) {
+  begin_read_();
+  class_table_(cls);
+  end_read_();
+}
+
 const Function *class_get_function(const Class *cls, const char name[]) {
-  const Class *class = cls;
-  while (NULL != class) {
-    const Function *f =
-        FunctionMap_find_ref(&class->_functions, name, sizeof(char *));
-    if (NULL != f) {
-      return f;
-    }
-    class = class->_super;
+  if (NULL == cls) {
+    return NULL;
+  }
+  begin_read_();
+  const Function *f = FunctionPtrMap_find(&class_table_(cls)->functions, name,
+                                          sizeof(char *), NULL);
+  end_read_();
+  return f;
+}
+
+uint32_t class_lookup_epoch() { return atomic_load_u32(&lookup_epoch_); }
+
+void class_invalidate_lookups() { atomic_inc_u32(&lookup_epoch_); }
+
+void class_begin_lookups() { begin_read_(); }
+
+void class_end_lookups() { end_read_(); }
+
+void class_free_retired_tables() {
+  // The caller holds no table, so it need not keep the epoch from advancing.
+  if (thread_read_depth_ > 0) {
+    observe_epoch_(thread_reader_);
+  }
+  // Whatever is retired is freed by the second advance after it, if no reader
+  // is behind.
+  for (int i = 0; i < 3 && try_reclaim_(); ++i) {
   }
-  return NULL;
 }
 
 bool inherits_from(const Class *class, Class *possible_super) {
-  for (;;) {
-    if (NULL == class) {
-      return false;
-    }
-    if (class == possible_super) {
-      return true;
-    }
-    class = class->_super;
+  if (NULL == class || NULL == possible_super) {
+    return false;
   }
+  begin_read_();
+  const ClassTable *table = class_table_(class);
+  const uint32_t depth = class_table_(possible_super)->depth;
+  const bool inherits =
+      depth <= table->depth && possible_super == table->display[depth];
+  end_read_();
+  return inherits;
 }
\ No newline at end of file
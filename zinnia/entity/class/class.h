@@ -18,6 +18,13 @@ Field *class_add_field(Class *cls, const char name[]);
 FunctionMapIterator class_functions(Class *cls);
 FieldMapIterator class_fields(Class *cls);
 
+void class_set_super(Class *cls, const Class *super);
+
+// Resolves the functions and ancestors of cls, including inherited ones, so
+// that class_get_function() and inherits_from() are constant-time. This
+// happens on first use otherwise, and again after class_invalidate_lookups().
+void class_flatten(const Class *cls);
+
 // TODO: Consider merging these 2 functions.
 const Function *class_get_function(const Class *cls, const char name[]);
 // const FunctionRef *class_get_function_ref(const Class *cls, const char
@@ -25,4 +32,23 @@ const Function *class_get_function(const Class *cls, const char name[]);
 
 bool inherits_from(const Class *class, Class *possible_super);
 
+// Cached results of class_get_function() are only valid while the epoch is
+// unchanged.
+uint32_t class_lookup_epoch();
+// Must be called after changing the functions or super of a class that may
+// already have been looked up.
+void class_invalidate_lookups();
+
+// Lets the calling thread look up classes until class_end_lookups() without
+// each lookup marking itself. Nests. Tables replaced meanwhile are only freed
+// once the thread ends or passes class_free_retired_tables(), so threads
+// should not stay between these while idle.
+void class_begin_lookups();
+void class_end_lookups();
+// Frees what class lookups have replaced since they were invalidated and every
+// thread looking up classes has moved on from. Never waits.
+//
+// Must not be called while a lookup is in progress on the calling thread.
+void class_free_retired_tables();
+
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_CLASS_CLASS_H_ */
\ No newline at end of file
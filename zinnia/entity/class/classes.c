@@ -14,6 +14,7 @@
 #include "zinnia/entity/string/string.h"
 #include "zinnia/entity/tuple/tuple.h"
 #include "zinnia/heap/copy_fns.h"
+#include "zinnia/heap/trace_fns.h"
 #include "zinnia/heap/heap.h"
 #include "zinnia/util/error.h"
 #include "zinnia/vm/intern.h"
@@ -72,6 +73,7 @@ void builtin_classes(Heap *heap, Module *builtin) {
   Class_FunctionRef->_delete_fn = function_ref_delete__;
   Class_FunctionRef->_print_fn = function_ref_print__;
   Class_FunctionRef->_copy_fn = (ObjCopyFn)function_ref_copy;
+  Class_FunctionRef->_trace_fn = function_ref_trace;
 
   Class_Module->_super = Class_Object;
   Class_Module->_reflection = heap_new(heap, Class_Class);
@@ -84,6 +86,8 @@ void builtin_classes(Heap *heap, Module *builtin) {
   Class_Array->_delete_fn = array_delete__;
   Class_Array->_print_fn = array_print__;
   Class_Array->_copy_fn = (ObjCopyFn)array_copy;
+  Class_Array->_trace_fn = array_trace;
+  Class_Array->_size_fn = array_bytes__;
 
   Class_String->_super = Class_Object;
   Class_String->_reflection = heap_new(heap, Class_Class);
@@ -92,6 +96,7 @@ void builtin_classes(Heap *heap, Module *builtin) {
   Class_String->_delete_fn = string_delete__;
   Class_String->_print_fn = string_print__;
   Class_String->_copy_fn = (ObjCopyFn)string_copy;
+  Class_String->_size_fn = string_bytes__;
 
   Class_IString->_super = Class_Object;
   Class_IString->_reflection = heap_new(heap, Class_Class);
@@ -100,6 +105,7 @@ void builtin_classes(Heap *heap, Module *builtin) {
   Class_IString->_delete_fn = istring_delete__;
   Class_IString->_print_fn = istring_print__;
   Class_IString->_copy_fn = (ObjCopyFn)istring_copy;
+  Class_IString->_size_fn = istring_bytes__;
 
   Class_Tuple->_super = Class_Object;
   Class_Tuple->_reflection = heap_new(heap, Class_Class);
@@ -108,4 +114,6 @@ void builtin_classes(Heap *heap, Module *builtin) {
   Class_Tuple->_delete_fn = __tuple_delete;
   Class_Tuple->_print_fn = __tuple_print;
   Class_Tuple->_copy_fn = (ObjCopyFn)tuple_copy;
+  Class_Tuple->_trace_fn = tuple_trace;
+  Class_Tuple->_size_fn = __tuple_bytes;
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+// layout.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/entity/class/layout.h"
+
+#include <stdbool.h>
+
+#include "c-data-structures/stable_maplike.h"
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/sync/atomic.h"
+
+bool has_name_(const ObjectLayout *layout, const char name[]) {
+  return layout_slot(layout, name) >= 0;
+}
+
+ObjectLayout *layout_create_(const Class *cls) {
+  uint32_t depth = 0, max_slots = 0;
+  for (const Class *c = cls; NULL != c; c = c->_super) {
+    ++depth;
+    FieldMapIterator fields;
+    FieldMap_iterator(&fields, &c->_fields);
+    for (; FieldMap_has_entry(&fields); FieldMap_next_entry(&fields)) {
+      ++max_slots;
+    }
+  }
+  const Class **ancestors = MNEW_ARR(const Class *, depth);
+  int i = depth;
+  for (const Class *c = cls; NULL != c; c = c->_super) {
+    ancestors[--i] = c;
+  }
+  ObjectLayout *layout = MNEW(ObjectLayout);
+  layout->num_slots = 0;
+  layout->names = MNEW_ARR(const char *, max_slots);
+  for (i = 0; i < depth; ++i) {
+    FieldMapIterator fields;
+    FieldMap_iterator(&fields, &ancestors[i]->_fields);
+    for (; FieldMap_has_entry(&fields); FieldMap_next_entry(&fields)) {
+      const char *name = FieldMap_value(&fields)->name;
+      // Subclasses may redeclare the fields of their ancestors.
+      if (!has_name_(layout, name)) {
+        layout->names[layout->num_slots++] = name;
+      }
+    }
+  }
+  RELEASE(ancestors);
+  return layout;
+}
+
+void layout_delete_(ObjectLayout *layout) {
+  RELEASE(layout->names);
+  RELEASE(layout);
+}
+
+const ObjectLayout *class_layout(const Class *cls) {
+  ASSERT(cls != NULL);
+  ObjectLayout *layout =
+      atomic_load_ptr((void *const volatile *)&cls->_layout);
+  if (NULL != layout) {
+    return layout;
+  }
+  layout = layout_create_(cls);
+  if (!atomic_cas_ptr((void *volatile *)&cls->_layout, NULL, layout)) {
+    // Another thread created it first.
+    layout_delete_(layout);
+    return atomic_load_ptr((void *const volatile *)&cls->_layout);
+  }
+  return layout;
+}
+
+void class_layout_delete(Class *cls) {
+  ASSERT(cls != NULL);
+  if (NULL != cls->_layout) {
+    layout_delete_(cls->_layout);
+    cls->_layout = NULL;
+  }
+}
+
+int32_t layout_slot(const ObjectLayout *layout, const char field[]) {
+  // Classes declare few enough fields that comparing the interned names is
+  // faster than hashing.
+  for (uint32_t i = 0; i < layout->num_slots; ++i) {
+    if (field == layout->names[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,40 @@
+// layout.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+//
+// Fixed slots for the declared fields of objects.
+//
+// The fields declared by a class and its ancestors are stored in the
+// Object._slots of its instances, at the index given by the layout of the
+// class, instead of in a map. Any other members go to Object._members, which
+// is only allocated once the first of them is set.
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_CLASS_LAYOUT_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_CLASS_LAYOUT_H_
+
+#include <stdint.h>
+
+#include "zinnia/entity/object.h"
+
+struct ObjectLayout_ {
+  uint32_t num_slots;
+  // Interned names of the fields, indexed by slot. Fields of ancestors come
+  // first.
+  const char **names;
+};
+
+// Returns the layout of instances of cls, creating it on first use. It never
+// changes after that, so fields which are declared later, e.g., by a new
+// super, are stored as members instead.
+//
+// Thread-safe.
+const ObjectLayout *class_layout(const Class *cls);
+
+// Frees the layout of cls, if it has one.
+void class_layout_delete(Class *cls);
+
+// Returns the slot of field in layout, or -1 if it is not one of its fields.
+int32_t layout_slot(const ObjectLayout *layout, const char field[]);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_CLASS_LAYOUT_H_ */
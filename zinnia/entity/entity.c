@@ -2,58 +2,76 @@
 
 #include <inttypes.h>
 
+#include "zinnia/entity/class/layout.h"
 #include "zinnia/util/error.h"
 
 IMPL_STABLE_MAPLIKE(EntityMap, char *, Entity);
 
-Entity NONE_ENTITY = {.type = NONE};
-Entity TRUE_ENTITY = {.type = PRIMITIVE,
-                      .pri = {._type = PRIMITIVE_BOOL, ._bool_val = true}};
-Entity FALSE_ENTITY = {.type = PRIMITIVE,
-                       .pri = {._type = PRIMITIVE_BOOL, ._bool_val = false}};
-
-EntityType etype(const Entity *e) {
-  ASSERT(e != NULL);
-  return e->type;
-}
-
-const Object *object(const Entity *e) {
-  ASSERT(e != NULL);
-  return e->obj;
-}
-
-Object *object_m(Entity *e) {
+#ifdef ZINNIA_COMPACT_ENTITY
+Entity NONE_ENTITY = ENTITY_BOXED_(NONE, 0);
+Entity UNSET_ENTITY = ENTITY_BOXED_(UNSET, 0);
+Entity TRUE_ENTITY = ENTITY_SMALL_PRIMITIVE_(PRIMITIVE_BOOL, true);
+Entity FALSE_ENTITY = ENTITY_SMALL_PRIMITIVE_(PRIMITIVE_BOOL, false);
+#else
+Entity NONE_ENTITY = {._type = NONE};
+Entity UNSET_ENTITY = {._type = UNSET};
+Entity TRUE_ENTITY = {._type = PRIMITIVE,
+                      ._pri = {._type = PRIMITIVE_BOOL, ._bool_val = true}};
+Entity FALSE_ENTITY = {._type = PRIMITIVE,
+                       ._pri = {._type = PRIMITIVE_BOOL, ._bool_val = false}};
+#endif
+
+Primitive eprimitive(const Entity *e) {
   ASSERT(e != NULL);
-  return e->obj;
+  ASSERT(PRIMITIVE == etype(e));
+  switch (eptype(e)) {
+    case PRIMITIVE_BOOL:
+      return primitive_bool(ebool(e));
+    case PRIMITIVE_CHAR:
+      return primitive_char(echar(e));
+    case PRIMITIVE_INT:
+      return primitive_int(eint(e));
+    case PRIMITIVE_FLOAT:
+      return primitive_float(efloat(e));
+    default:
+      FATALF("Unknown primitive type.");
+  }
+  return primitive_bool(false);
 }
 
-Entity entity_char(const int8_t c) {
-  Entity e = {.type = PRIMITIVE};
-  pset_char(&e.pri, c);
-  return e;
+bool ebool_of(const Entity *e) {
+  const Primitive p = eprimitive(e);
+  return bool_of(&p);
 }
 
-Entity entity_int(const int64_t i) {
-  Entity e = {.type = PRIMITIVE};
-  pset_int(&e.pri, i);
-  return e;
+int64_t eint_of(const Entity *e) {
+  const Primitive p = eprimitive(e);
+  return int_of(&p);
 }
 
-Entity entity_float(const double d) {
-  Entity e = {.type = PRIMITIVE};
-  pset_float(&e.pri, d);
-  return e;
+double efloat_of(const Entity *e) {
+  const Primitive p = eprimitive(e);
+  return float_of(&p);
 }
 
 Entity entity_primitive_ptr(const Primitive *p) {
-  Entity e = {.type = PRIMITIVE, .pri = *p};
-  return e;
+  ASSERT(p != NULL);
+  switch (ptype(p)) {
+    case PRIMITIVE_BOOL:
+      return entity_bool(pbool(p));
+    case PRIMITIVE_CHAR:
+      return entity_char(pchar(p));
+    case PRIMITIVE_INT:
+      return entity_int(pint(p));
+    case PRIMITIVE_FLOAT:
+      return entity_float(pfloat(p));
+    default:
+      FATALF("Unknown primitive type.");
+  }
+  return entity_none();
 }
 
-Entity entity_primitive(Primitive p) {
-  Entity e = {.type = PRIMITIVE, .pri = p};
-  return e;
-}
+Entity entity_primitive(Primitive p) { return entity_primitive_ptr(&p); }
 
 void primitive_print_(const Primitive *p, FILE *file) {
   switch (p->_type) {
@@ -86,33 +104,31 @@ void object_print_(const Object *obj, FILE *file) {
 void entity_print(const Entity *e, FILE *file) {
   ASSERT(e != NULL);
   ASSERT(file != NULL);
-  switch (e->type) {
+  switch (etype(e)) {
     case NONE:
       fprintf(file, "None");
       break;
-    case PRIMITIVE:
-      primitive_print_(&e->pri, file);
+    case PRIMITIVE: {
+      const Primitive p = eprimitive(e);
+      primitive_print_(&p, file);
       break;
+    }
     case OBJECT:
-      object_print_(e->obj, file);
+      object_print_(object(e), file);
       break;
     default:
-      FATALF("Unknown entity type: %d", e->type);
+      FATALF("Unknown entity type: %d", etype(e));
   }
 }
 
-Entity entity_none() {
-  Entity e = {.type = NONE};
-  return e;
-}
-
 Entity *object_get(Object *obj, const char field[]) {
   ASSERT(obj != NULL);
   ASSERT(field != NULL);
-  return EntityMap_find_ref(&obj->_members, field, sizeof(char *));
+  const int32_t slot = layout_slot(obj->_class->_layout, field);
+  if (slot >= 0) {
+    return UNSET == etype(&obj->_slots[slot]) ? NULL : &obj->_slots[slot];
+  }
+  return NULL == obj->_members
+             ? NULL
+             : EntityMap_find_ref(obj->_members, field, sizeof(char *));
 }
-
-Entity entity_object(Object *obj) {
-  Entity e = {.type = OBJECT, .obj = obj};
-  return e;
-}
\ No newline at end of file
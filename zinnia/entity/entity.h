@@ -6,65 +6,261 @@
 #ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_ENTITY_H_
 #define COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_ENTITY_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "c-data-structures/stable_maplike.h"
 #include "zinnia/entity/object.h"
 #include "zinnia/entity/primitive.h"
+#include "zinnia/util/error.h"
 
 #define IS_CLASS(e, class) \
-  (NULL != (e) && OBJECT == (e)->type && ((class) == (e)->obj->_class))
-#define IS_NONE(e) ((NULL == (e)) || (NONE == (e)->type))
-#define IS_FALSE(e) (IS_NONE(e) || (IS_BOOL(e) && false == pbool(&(e)->pri)))
+  (NULL != (e) && OBJECT == etype(e) && ((class) == object(e)->_class))
+#define IS_NONE(e) ((NULL == (e)) || (NONE == etype(e)))
+#define IS_FALSE(e) (IS_NONE(e) || (IS_BOOL(e) && false == ebool(e)))
 #define IS_TRUE(e) (!IS_FALSE(e))
-#define IS_OBJECT(e) ((NULL != (e)) && (OBJECT == (e)->type))
-#define IS_PRIMITIVE(e) ((NULL != (e)) && (PRIMITIVE == (e)->type))
-#define IS_BOOL(e) (IS_PRIMITIVE(e) && (PRIMITIVE_BOOL == ptype(&(e)->pri)))
-#define IS_CHAR(e) (IS_PRIMITIVE(e) && (PRIMITIVE_CHAR == ptype(&(e)->pri)))
-#define IS_INT(e) (IS_PRIMITIVE(e) && (PRIMITIVE_INT == ptype(&(e)->pri)))
-#define IS_FLOAT(e) (IS_PRIMITIVE(e) && (PRIMITIVE_FLOAT == ptype(&(e)->pri)))
-#define IS_TUPLE(e) \
-  ((NULL != e) && (OBJECT == e->type) && (Class_Tuple == e->obj->_class))
-#define IS_ARRAY(e) \
-  ((NULL != e) && (OBJECT == e->type) && (Class_Array == e->obj->_class))
+#define IS_OBJECT(e) ((NULL != (e)) && (OBJECT == etype(e)))
+#define IS_PRIMITIVE(e) ((NULL != (e)) && (PRIMITIVE == etype(e)))
+#define IS_BOOL(e) (IS_PRIMITIVE(e) && (PRIMITIVE_BOOL == eptype(e)))
+#define IS_CHAR(e) (IS_PRIMITIVE(e) && (PRIMITIVE_CHAR == eptype(e)))
+#define IS_INT(e) (IS_PRIMITIVE(e) && (PRIMITIVE_INT == eptype(e)))
+#define IS_FLOAT(e) (IS_PRIMITIVE(e) && (PRIMITIVE_FLOAT == eptype(e)))
+#define IS_TUPLE(e) IS_CLASS(e, Class_Tuple)
+#define IS_ARRAY(e) IS_CLASS(e, Class_Array)
 
 // Contains a primitive, Object, or represents nullptr.
+//
+// The fields are private to this header. Everything else reads entities with
+// the accessors and builds them with the entity_*() constructors below, which
+// lets the layout change with ZINNIA_COMPACT_ENTITY. The only exception is the
+// JIT, which emits code for the layout described by the macros below.
 typedef struct Entity_ Entity;
 
-typedef enum { NONE, PRIMITIVE, OBJECT } EntityType;
+// UNSET is only stored in Object._slots, for declared fields which were never
+// set, and in local slots which have not been assigned in the current block.
+// object_get() and the slot lookups in context.c treat it the same as a
+// missing member, so it is never seen outside of the object or frame.
+typedef enum { NONE, PRIMITIVE, OBJECT, UNSET } EntityType;
 
+#ifdef ZINNIA_COMPACT_ENTITY
+// 8 bytes instead of 24, as a NaN-boxed double.
+//
+// _bits is an IEEE-754 double XORed with ENTITY_XOR_, so that zeroed memory
+// reads as None. Floats are stored as-is, with every NaN canonicalized. The
+// NaNs which remain free hold everything else:
+//   _bits < 4 << 48:
+//     _bits >> 48 is the EntityType. The low 48 bits hold the Object pointer,
+//     or ptype << 8 | value for Bool and Char.
+//   (_bits ^ ENTITY_XOR_) > ENTITY_INT_BASE_:
+//     An Int, offset by ENTITY_INT_BASE_ - 2^51.
+//
+// Ints are therefore limited to ENTITY_INT_MIN..ENTITY_INT_MAX. An Int
+// outside of that range is stored as the nearest Float.
 struct Entity_ {
-  EntityType type;
+  uint64_t _bits;
+};
+
+#define ENTITY_XOR_ 0x7FFE000000000000ULL
+#define ENTITY_BOXED_LIMIT_ (4ULL << 48)
+#define ENTITY_PAYLOAD_MASK_ 0x0000FFFFFFFFFFFFULL
+#define ENTITY_CANONICAL_NAN_ 0x7FF8000000000000ULL
+#define ENTITY_INT_BASE_ 0xFFF0000000000000ULL
+#define ENTITY_INT_BIAS_ (1LL << 51)
+#define ENTITY_INT_MAX (ENTITY_INT_BIAS_ - 1)
+#define ENTITY_INT_MIN (-ENTITY_INT_MAX)
+
+#define ENTITY_BOXED_(type, payload) \
+  {._bits = ((uint64_t)(type) << 48) | (uint64_t)(payload)}
+#define ENTITY_SMALL_PRIMITIVE_(ptype, val) \
+  ENTITY_BOXED_(PRIMITIVE, ((uint64_t)(ptype) << 8) | (uint8_t)(val))
+#else
+struct Entity_ {
+  EntityType _type;
   union {
-    Primitive pri;
-    Object *obj;
+    Primitive _pri;
+    Object *_obj;
   };
 };
 
+// Byte offsets of the EntityType, the PrimitiveType and the value.
+#define ENTITY_TYPE_OFFSET_ offsetof(Entity, _type)
+#define ENTITY_PTYPE_OFFSET_ \
+  (offsetof(Entity, _pri) + offsetof(Primitive, _type))
+#define ENTITY_VALUE_OFFSET_ \
+  (offsetof(Entity, _pri) + offsetof(Primitive, _int_val))
+#endif
+
 extern Entity NONE_ENTITY;
+extern Entity UNSET_ENTITY;
 extern Entity TRUE_ENTITY;
 extern Entity FALSE_ENTITY;
 
 // Gets the entity type from an entity.
-EntityType etype(const Entity *e);
+static inline EntityType etype(const Entity *e);
 // Extracts a const Object from an entity.
-const Object *object(const Entity *e);
+static inline const Object *object(const Entity *e);
 // Extracts a mutable Object from an entity.
-Object *object_m(Entity *e);
+static inline Object *object_m(const Entity *e);
+
+// Gets the type of a PRIMITIVE entity.
+static inline PrimitiveType eptype(const Entity *e);
+// Gets the value of a PRIMITIVE entity with the matching type.
+static inline bool ebool(const Entity *e);
+static inline int8_t echar(const Entity *e);
+static inline int64_t eint(const Entity *e);
+static inline double efloat(const Entity *e);
+// Gets the value of a PRIMITIVE entity as a Primitive.
+Primitive eprimitive(const Entity *e);
+// Same as bool_of(), int_of() and float_of(), for a PRIMITIVE entity.
+bool ebool_of(const Entity *e);
+int64_t eint_of(const Entity *e);
+double efloat_of(const Entity *e);
 
-Entity entity_char(const int8_t c);
-Entity entity_int(const int64_t i);
-Entity entity_float(const double d);
+static inline Entity entity_bool(const bool b);
+static inline Entity entity_char(const int8_t c);
+static inline Entity entity_int(const int64_t i);
+static inline Entity entity_float(const double d);
 
 Entity entity_primitive_ptr(const Primitive *p);
 Entity entity_primitive(Primitive p);
 
 void entity_print(const Entity *e, FILE *file);
 
-Entity entity_none();
+static inline Entity entity_none();
 
 Entity *object_get(Object *obj, const char field[]);
 
-Entity entity_object(Object *obj);
+static inline Entity entity_object(Object *obj);
+
+// The accessors are inlined since the interpreter uses them for nearly every
+// instruction.
+#ifdef ZINNIA_COMPACT_ENTITY
+typedef union {
+  double d;
+  uint64_t u;
+} EntityFloatBits_;
+
+static inline EntityType etype(const Entity *e) {
+  return e->_bits < ENTITY_BOXED_LIMIT_ ? (EntityType)(e->_bits >> 48)
+                                        : PRIMITIVE;
+}
+
+static inline Object *object_m(const Entity *e) {
+  return (Object *)(uintptr_t)(e->_bits & ENTITY_PAYLOAD_MASK_);
+}
+
+static inline PrimitiveType eptype(const Entity *e) {
+  if ((e->_bits ^ ENTITY_XOR_) > ENTITY_INT_BASE_) {
+    return PRIMITIVE_INT;
+  }
+  return e->_bits < ENTITY_BOXED_LIMIT_
+             ? (PrimitiveType)((e->_bits >> 8) & 0xFF)
+             : PRIMITIVE_FLOAT;
+}
+
+static inline bool ebool(const Entity *e) { return 0 != (e->_bits & 0xFF); }
+
+static inline int8_t echar(const Entity *e) {
+  return (int8_t)(uint8_t)(e->_bits & 0xFF);
+}
+
+static inline int64_t eint(const Entity *e) {
+  return (int64_t)((e->_bits ^ ENTITY_XOR_) - ENTITY_INT_BASE_) -
+         ENTITY_INT_BIAS_;
+}
+
+static inline double efloat(const Entity *e) {
+  EntityFloatBits_ bits = {.u = e->_bits ^ ENTITY_XOR_};
+  return bits.d;
+}
+
+static inline Entity entity_bool(const bool b) {
+  Entity e = ENTITY_SMALL_PRIMITIVE_(PRIMITIVE_BOOL, b);
+  return e;
+}
+
+static inline Entity entity_char(const int8_t c) {
+  Entity e = ENTITY_SMALL_PRIMITIVE_(PRIMITIVE_CHAR, c);
+  return e;
+}
+
+static inline Entity entity_float(const double d) {
+  EntityFloatBits_ bits = {.d = d};
+  if (d != d) {
+    bits.u = ENTITY_CANONICAL_NAN_;
+  }
+  Entity e = {._bits = bits.u ^ ENTITY_XOR_};
+  return e;
+}
+
+static inline Entity entity_int(const int64_t i) {
+  if (i < ENTITY_INT_MIN || i > ENTITY_INT_MAX) {
+    return entity_float((double)i);
+  }
+  Entity e = {._bits = (ENTITY_INT_BASE_ + (uint64_t)(i + ENTITY_INT_BIAS_)) ^
+                       ENTITY_XOR_};
+  return e;
+}
+
+static inline Entity entity_object(Object *obj) {
+  ASSERT(0 == ((uintptr_t)obj & ~(uintptr_t)ENTITY_PAYLOAD_MASK_));
+  Entity e = ENTITY_BOXED_(OBJECT, (uintptr_t)obj);
+  return e;
+}
+
+static inline Entity entity_none() {
+  Entity e = {._bits = 0};
+  return e;
+}
+#else
+static inline EntityType etype(const Entity *e) { return e->_type; }
+
+static inline Object *object_m(const Entity *e) { return e->_obj; }
+
+static inline PrimitiveType eptype(const Entity *e) {
+  return ptype(&e->_pri);
+}
+
+static inline bool ebool(const Entity *e) { return pbool(&e->_pri); }
+
+static inline int8_t echar(const Entity *e) { return pchar(&e->_pri); }
+
+static inline int64_t eint(const Entity *e) { return pint(&e->_pri); }
+
+static inline double efloat(const Entity *e) { return pfloat(&e->_pri); }
+
+static inline Entity entity_bool(const bool b) {
+  Entity e = {._type = PRIMITIVE, ._pri = primitive_bool(b)};
+  return e;
+}
+
+static inline Entity entity_char(const int8_t c) {
+  Entity e = {._type = PRIMITIVE, ._pri = primitive_char(c)};
+  return e;
+}
+
+static inline Entity entity_int(const int64_t i) {
+  Entity e = {._type = PRIMITIVE, ._pri = primitive_int(i)};
+  return e;
+}
+
+static inline Entity entity_float(const double d) {
+  Entity e = {._type = PRIMITIVE, ._pri = primitive_float(d)};
+  return e;
+}
+
+static inline Entity entity_object(Object *obj) {
+  Entity e = {._type = OBJECT, ._obj = obj};
+  return e;
+}
+
+static inline Entity entity_none() {
+  Entity e = {._type = NONE};
+  return e;
+}
+#endif
+
+static inline const Object *object(const Entity *e) { return object_m(e); }
 
-#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_ENTITY_H_ */
\ No newline at end of file
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_ENTITY_H_ */
@@ -29,6 +29,9 @@ void function_init(Function *f, const char name[], const Module *module,
   f->_is_const = is_const;
   f->_is_async = is_async;
   f->_is_background = false;
+  f->_num_slots = 0;
+  f->_call_count = 0;
+  f->_jit_code = NULL;
   f->_reflection = NULL;
 }
 
@@ -37,15 +40,20 @@ void function_finalize(Function *f) { ASSERT(f != NULL); }
 void function_ref_create__(Object *obj) { obj->_internal_obj = NULL; }
 
 void function_ref_init__(Object *fn_ref_obj, Object *obj, const Function *func,
-                         void *parent_context, Heap *heap) {
+                         void *parent_context,
+                         Object *parent_context_reflection, Heap *heap) {
   _FunctionRef *func_ref =
       (_FunctionRef *)(fn_ref_obj->_internal_obj = MNEW(_FunctionRef));
   func_ref->obj = obj;
   func_ref->func = func;
   func_ref->parent_context = parent_context;
+  func_ref->parent_context_reflection = parent_context_reflection;
   // To prevent the base object from being collected if there is a reference to
   // its method.
   heap_inc_edge(heap, fn_ref_obj, obj);
+  if (NULL != parent_context_reflection) {
+    heap_inc_edge(heap, fn_ref_obj, parent_context_reflection);
+  }
 }
 
 void function_ref_delete__(Object *obj) {
@@ -80,6 +88,18 @@ void function_ref_copy(EntityCopier *copier, const Object *src_obj,
   Entity e = entity_object(func_ref->obj);
   Entity cpy_obj = entitycopier_copy(copier, &e);
   // TODO: Deep copy parent context?
-  function_ref_init__(target_obj, cpy_obj.obj, func_ref->func,
-                      func_ref->parent_context, copier->target);
+  function_ref_init__(target_obj, object_m(&cpy_obj), func_ref->func,
+                      func_ref->parent_context,
+                      /*parent_context_reflection=*/NULL, copier->target);
+}
+
+void function_ref_trace(Object *fn_ref_obj, HeapTracer *tracer) {
+  _FunctionRef *func_ref = (_FunctionRef *)fn_ref_obj->_internal_obj;
+  if (NULL == func_ref) {
+    return;
+  }
+  heap_trace(tracer, func_ref->obj);
+  if (NULL != func_ref->parent_context_reflection) {
+    heap_trace(tracer, func_ref->parent_context_reflection);
+  }
 }
\ No newline at end of file
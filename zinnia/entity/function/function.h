@@ -21,7 +21,8 @@ void function_finalize(Function *f);
 
 void function_ref_create__(Object *obj);
 void function_ref_init__(Object *fn_ref_obj, Object *obj, const Function *func,
-                         void *parent_context, Heap *heap);
+                         void *parent_context,
+                         Object *parent_context_reflection, Heap *heap);
 void function_ref_delete__(Object *obj);
 void function_ref_print__(const Object *obj, FILE *out);
 
@@ -31,5 +32,6 @@ void *function_ref_get_parent_context(Object *fn_ref_obj);
 
 void function_ref_copy(EntityCopier *copier, const Object *src_obj,
                        Object *target_obj);
+void function_ref_trace(Object *fn_ref_obj, HeapTracer *tracer);
 
 #endif /* COM_GITHUB_JEFFMANZIONE_OBJECT_FUNCTION_FUNCTION_H_ */
\ No newline at end of file
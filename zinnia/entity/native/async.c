@@ -90,7 +90,7 @@ Entity create_process_(Task *task, Context *ctx, Object *obj, Entity *args) {
   const Entity *fn = tuple_get(tuple, 0);
   const Entity *fn_args = tuple_get(tuple, 1);
   const Entity *is_remote_arg = tuple_get(tuple, 2);
-  if (!IS_OBJECT(fn) || !(inherits_from(fn->obj->_class, Class_Function) ||
+  if (!IS_OBJECT(fn) || !(inherits_from(object_m(fn)->_class, Class_Function) ||
                           IS_CLASS(fn, Class_FunctionRef))) {
     return raise_error(task, ctx,
                        "__create_processes expects (Function, ANY, ANY).");
@@ -106,11 +106,11 @@ Entity create_process_(Task *task, Context *ctx, Object *obj, Entity *args) {
   const Function *f;
   Object *self;
   if (IS_CLASS(fn, Class_Function)) {
-    f = fn->obj->_function_obj;
+    f = object_m(fn)->_function_obj;
     self = f->_module->_reflection;
   } else if (IS_CLASS(fn, Class_FunctionRef)) {
-    f = function_ref_get_func(fn->obj);
-    self = function_ref_get_object(fn->obj);
+    f = function_ref_get_func(object_m(fn));
+    self = function_ref_get_object(object_m(fn));
   } else {
     return raise_error(task, ctx,
                        "__create_processes expects (Function, ANY).");
@@ -118,7 +118,8 @@ Entity create_process_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
   BULK_COPY(copier, new_process->heap, {
     Entity self_e = entity_object(self);
-    self = entitycopier_copy(&copier, &self_e).obj;
+    self_e = entitycopier_copy(&copier, &self_e);
+    self = object_m(&self_e);
     new_ctx =
         task_create_context(new_task, self, (Module *)f->_module, f->_ins_pos);
     *task_mutable_resval(new_task) = entitycopier_copy(&copier, fn_args);
@@ -140,9 +141,9 @@ Entity create_process_(Task *task, Context *ctx, Object *obj, Entity *args) {
 Entity sleep__(Task *task, Context *ctx, Object *obj, Entity *args) {
   double sleep_duration_sec = 0;
   if (IS_INT(args)) {
-    sleep_duration_sec = pint(&args->pri);
+    sleep_duration_sec = eint(args);
   } else if (IS_FLOAT(args)) {
-    sleep_duration_sec = pfloat(&args->pri);
+    sleep_duration_sec = efloat(args);
   } else {
     return raise_error(task, ctx, "sleep() expected to be called with number.");
   }
@@ -194,16 +195,16 @@ Entity create_future_for_task_(Task *current_task, Task *remote_task) {
 Entity remote_call_(Task *current_task, Context *current_ctx, Object *obj,
                     Entity *args) {
   Entity error = validate_remote_call_(current_task, current_ctx, args);
-  if (NONE != error.type) {
+  if (NONE != etype(&error)) {
     return error;
   }
 
-  const Tuple *tuple = (Tuple *)args->obj->_internal_obj;
+  const Tuple *tuple = (Tuple *)object_m(args)->_internal_obj;
   const Entity *remote_entity = tuple_get(tuple, 0);
   const Entity *fn_name_entity = tuple_get(tuple, 1);
   const Entity *fn_args = tuple_get(tuple, 2);
 
-  Remote *remote = extract_remote_from_obj(remote_entity->obj);
+  Remote *remote = extract_remote_from_obj(object_m(remote_entity));
   Process *remote_process = remote_get_process(remote);
   Object *remote_object = remote_get_object(remote);
 
@@ -214,9 +215,9 @@ Entity remote_call_(Task *current_task, Context *current_ctx, Object *obj,
 
   const Function *f;
   if (IS_CLASS(&fn, Class_Function)) {
-    f = fn.obj->_function_obj;
+    f = object_m(&fn)->_function_obj;
   } else if (IS_CLASS(&fn, Class_FunctionRef)) {
-    f = function_ref_get_func(fn.obj);
+    f = function_ref_get_func(object_m(&fn));
   } else {
     return raise_error(current_task, current_ctx,
                        "Could not find method '%s' on remote object.", fn_name);
@@ -241,9 +242,9 @@ Entity remote_call_(Task *current_task, Context *current_ctx, Object *obj,
     });
   });
 
-  process_enqueue_task(remote_process, remote_task);
+  // The future must be set before the remote process can run the task.
   Entity future_entity = create_future_for_task_(current_task, remote_task);
-  condition_broadcast(remote_process->task_wait_cond);
+  process_enqueue_task(remote_process, remote_task);
   return future_entity;
 }
 
@@ -2,20 +2,63 @@
 
 #include <stdarg.h>
 
+#include "zinnia/entity/class/classes_def.h"
 #include "zinnia/entity/native/error.h"
+#include "zinnia/entity/tuple/tuple.h"
+#include "zinnia/heap/heap.h"
+#include "zinnia/vm/process/task.h"
 
 void FunctionContext_init(FunctionContext *fn_ctx, Task *task, Context *ctx,
                           const Entity *args) {
   fn_ctx->task_ = task;
   fn_ctx->ctx_ = ctx;
   fn_ctx->args_ = args;
+  fn_ctx->num_stack_args_ = 0;
   fn_ctx->retval_ = NONE_ENTITY;
 }
 
+void FunctionContext_init_stack_args(FunctionContext *fn_ctx, Task *task,
+                                     Context *ctx, uint32_t num_args) {
+  ASSERT(num_args > 0);
+  FunctionContext_init(fn_ctx, task, ctx, NULL);
+  fn_ctx->num_stack_args_ = num_args;
+}
+
 const Entity *FunctionContext_args(FunctionContext *fn_ctx) {
+  if (NULL != fn_ctx->args_) {
+    return fn_ctx->args_;
+  }
+  Heap *heap = fn_ctx->task_->parent_process->heap;
+  Object *tuple_obj = tuple_create_empty(heap, fn_ctx->num_stack_args_);
+  int i;
+  for (i = 0; i < fn_ctx->num_stack_args_; ++i) {
+    tuple_set(heap, tuple_obj, i, task_peekstack_n(fn_ctx->task_, i));
+  }
+  // Kept in resval so that it is reachable until the function returns.
+  *task_mutable_resval(fn_ctx->task_) = entity_object(tuple_obj);
+  fn_ctx->args_ = task_get_resval(fn_ctx->task_);
   return fn_ctx->args_;
 }
 
+uint32_t FunctionContext_num_args(FunctionContext *fn_ctx) {
+  if (NULL == fn_ctx->args_) {
+    return fn_ctx->num_stack_args_;
+  }
+  return IS_TUPLE(fn_ctx->args_)
+             ? tuple_size((Tuple *)object(fn_ctx->args_)->_internal_obj)
+             : 1;
+}
+
+const Entity *FunctionContext_arg(FunctionContext *fn_ctx, uint32_t index) {
+  ASSERT(index < FunctionContext_num_args(fn_ctx));
+  if (NULL == fn_ctx->args_) {
+    return task_peekstack_n(fn_ctx->task_, index);
+  }
+  return IS_TUPLE(fn_ctx->args_)
+             ? tuple_get((Tuple *)object(fn_ctx->args_)->_internal_obj, index)
+             : fn_ctx->args_;
+}
+
 void FunctionContext_raise_error(FunctionContext *fn_ctx, const char fmt[],
                                  ...) {
   va_list args;
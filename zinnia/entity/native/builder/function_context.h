@@ -11,7 +11,10 @@
 typedef struct {
   Task *task_;
   Context *ctx_;
+  // NULL until packed when the arguments were passed on the stack.
   const Entity *args_;
+  // The number of arguments left on the task's stack by the caller.
+  uint32_t num_stack_args_;
   Entity retval_;
 } FunctionContext;
 
@@ -19,7 +22,20 @@ typedef void (*NativeFunctionHandlerFn)(FunctionContext *);
 
 void FunctionContext_init(FunctionContext *fn_ctx, Task *task, Context *ctx,
                           const Entity *args);
+// Same as FunctionContext_init(), for num_args > 0 arguments which the caller
+// left on top of the task's stack with the first argument on top. They must
+// stay there until the function returns.
+void FunctionContext_init_stack_args(FunctionContext *fn_ctx, Task *task,
+                                     Context *ctx, uint32_t num_args);
+// The arguments as a Tuple, or the single argument if there is only one.
+//
+// Arguments passed on the stack are packed into a new Tuple on the first call,
+// so prefer FunctionContext_num_args() and FunctionContext_arg().
 const Entity *FunctionContext_args(FunctionContext *fn_ctx);
+// The number of arguments. Calls without any have a single None argument.
+uint32_t FunctionContext_num_args(FunctionContext *fn_ctx);
+// The argument at index < FunctionContext_num_args(), without packing.
+const Entity *FunctionContext_arg(FunctionContext *fn_ctx, uint32_t index);
 void FunctionContext_raise_error(FunctionContext *, const char fmt[], ...);
 const Entity *FunctionContext_get_retval(FunctionContext *fn_ctx);
 Entity *FunctionContext_mutable_retval(FunctionContext *);
@@ -26,9 +26,12 @@
 #include "zinnia/entity/tuple/tuple.h"
 #include "zinnia/heap/heap.h"
 #include "zinnia/util/string_util.h"
+#include "zinnia/util/sync/mpsc_queue.h"
 #include "zinnia/util/void_array.h"
+#include "zinnia/vm/heap_profiler.h"
 #include "zinnia/vm/intern.h"
 #include "zinnia/vm/process/context.h"
+#include "zinnia/vm/process/gc_stats.h"
 #include "zinnia/vm/process/process.h"
 #include "zinnia/vm/process/processes.h"
 #include "zinnia/vm/process/remote.h"
@@ -36,7 +39,7 @@
 #include "zinnia/vm/vm.h"
 
 // From vm/virtual_machine.h
-ThreadHandle process_run_in_new_thread(Process *process);
+void process_start(Process *process);
 
 #ifndef min
 #define min(x, y) ((x) > (y) ? (y) : (x))
@@ -83,10 +86,10 @@ bool istr_to_int64_(IString *str, int64_t *result) {
 
 bool entity_to_int64_(const Entity *e, int64_t *result) {
   if (IS_CLASS(e, Class_String)) {
-    return str_to_int64_(e->obj->_internal_obj, result);
+    return str_to_int64_(object_m(e)->_internal_obj, result);
   }
   if (IS_CLASS(e, Class_IString)) {
-    return istr_to_int64_(e->obj->_internal_obj, result);
+    return istr_to_int64_(object_m(e)->_internal_obj, result);
   }
   return false;
 }
@@ -98,7 +101,7 @@ Entity Int_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (NULL == args) {
     return entity_int(0);
   }
-  switch (args->type) {
+  switch (etype(args)) {
     case NONE:
       return entity_int(0);
     case OBJECT:
@@ -111,15 +114,15 @@ Entity Int_(Task *task, Context *ctx, Object *obj, Entity *args) {
       }
       return entity_int(result);
     case PRIMITIVE:
-      switch (ptype(&args->pri)) {
+      switch (eptype(args)) {
         case PRIMITIVE_BOOL:
-          return entity_int(pbool(&args->pri) ? 1 : 0);
+          return entity_int(ebool(args) ? 1 : 0);
         case PRIMITIVE_CHAR:
-          return entity_int((int64_t)pchar(&args->pri));
+          return entity_int((int64_t)echar(args));
         case PRIMITIVE_INT:
           return *args;
         case PRIMITIVE_FLOAT:
-          return entity_int((int64_t)pfloat(&args->pri));
+          return entity_int((int64_t)efloat(args));
         default:
           return raise_error(task, ctx, "Unknown primitive type.");
       }
@@ -155,10 +158,10 @@ bool istr_to_float_(IString *str, double *result) {
 
 bool entity_to_float_(const Entity *e, double *result) {
   if (IS_CLASS(e, Class_String)) {
-    return str_to_float_(e->obj->_internal_obj, result);
+    return str_to_float_(object_m(e)->_internal_obj, result);
   }
   if (IS_CLASS(e, Class_IString)) {
-    return istr_to_float_(e->obj->_internal_obj, result);
+    return istr_to_float_(object_m(e)->_internal_obj, result);
   }
   return false;
 }
@@ -170,7 +173,7 @@ Entity Float_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (NULL == args) {
     return entity_float(0);
   }
-  switch (args->type) {
+  switch (etype(args)) {
     case NONE:
       return entity_float(0.f);
     case OBJECT:
@@ -183,13 +186,13 @@ Entity Float_(Task *task, Context *ctx, Object *obj, Entity *args) {
       }
       return entity_float(result);
     case PRIMITIVE:
-      switch (ptype(&args->pri)) {
+      switch (eptype(args)) {
         case PRIMITIVE_BOOL:
-          return entity_float(pbool(&args->pri) ? 1 : 0);
+          return entity_float(ebool(args) ? 1 : 0);
         case PRIMITIVE_CHAR:
-          return entity_float((double)pchar(&args->pri));
+          return entity_float((double)echar(args));
         case PRIMITIVE_INT:
-          return entity_float((double)pint(&args->pri));
+          return entity_float((double)eint(args));
         case PRIMITIVE_FLOAT:
           return *args;
         default:
@@ -236,10 +239,10 @@ bool istr_to_bool_(IString *str, bool *result) {
 
 bool entity_to_bool_(const Entity *e, bool *result) {
   if (IS_CLASS(e, Class_String)) {
-    return str_to_bool_((String *)e->obj->_internal_obj, result);
+    return str_to_bool_((String *)object_m(e)->_internal_obj, result);
   }
   if (IS_CLASS(e, Class_IString)) {
-    return istr_to_bool_((IString *)e->obj->_internal_obj, result);
+    return istr_to_bool_((IString *)object_m(e)->_internal_obj, result);
   }
   return false;
 }
@@ -251,7 +254,7 @@ Entity _Bool_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (NULL == args) {
     return FALSE_ENTITY;
   }
-  switch (args->type) {
+  switch (etype(args)) {
     case NONE:
       return FALSE_ENTITY;
     case OBJECT:
@@ -273,10 +276,7 @@ Entity _Bool_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
 Object *wrap_function_in_ref2_(const Function *f, Object *obj, Task *task,
                                Context *ctx) {
-  Object *fn_ref = heap_new(task->parent_process->heap, Class_FunctionRef);
-  function_ref_init__(fn_ref, obj, f, f->_is_anon ? ctx : NULL,
-                      task->parent_process->heap);
-  return fn_ref;
+  return wrap_function_in_ref(f, obj, task->parent_process->heap, ctx);
 }
 
 // volatile int tmp = 0;
@@ -284,7 +284,9 @@ Object *wrap_function_in_ref2_(const Function *f, Object *obj, Task *task,
 Entity collect_garbage_(Task *task, Context *ctx, Object *obj, Entity *args) {
   Process *process = task->parent_process;
   Heap *heap = process->heap;
-  uint32_t deleted_nodes_count = process_collect_garbage(process);
+  uint32_t deleted_nodes_count = IS_TRUE(args)
+                                     ? process_collect_young_garbage(process)
+                                     : process_collect_garbage(process);
 
   // printf("Tasks:\n\titem_size=%u\n\tcapacity=%u\n\titem_count=%u\n\tsubarena_"
   //        "capacity=%u\n\tsubarena_count=%u\n",
@@ -331,9 +333,61 @@ Entity collect_garbage_(Task *task, Context *ctx, Object *obj, Entity *args) {
   return entity_object(result_tuple);
 }
 
+Entity gc_stats_(Task *task, Context *ctx, Object *obj, Entity *args) {
+  Process *process = task->parent_process;
+  const GcStats *stats = &process->gc_stats;
+  const int64_t values[] = {
+      stats->collections[GC_FULL],
+      stats->collections[GC_YOUNG],
+      stats->collections[GC_INCREMENTAL],
+      stats->objects_freed,
+      stats->objects_surviving,
+      stats->total_pause_usec,
+      gcstats_pause_percentile_usec(stats, 50),
+      gcstats_pause_percentile_usec(stats, 90),
+      gcstats_pause_percentile_usec(stats, 99),
+      stats->max_pause_usec,
+      stats->object_count_threshold,
+      stats->bytes_threshold,
+      stats->threshold_changes,
+      heap_bytes(process->heap),
+  };
+  const size_t num_values = sizeof(values) / sizeof(values[0]);
+  Object *result_tuple = tuple_create_empty(process->heap, num_values);
+  for (int i = 0; i < num_values; ++i) {
+    Entity value_e = entity_int(values[i]);
+    tuple_set(process->heap, result_tuple, i, &value_e);
+  }
+  return entity_object(result_tuple);
+}
+
+Entity write_heap_profile_(Task *task, Context *ctx, Object *obj,
+                           Entity *args) {
+  HeapProfiler *profiler = task->parent_process->vm->heap_profiler;
+  if (NULL == profiler) {
+    return raise_error(
+        task, ctx, "Heap profiling is not enabled. Run with --heap_profile.");
+  }
+  EXTRACT_TUPLE_ARGS(tupl_args, args, 2, task, ctx);
+  EXCTRACT_STRING_AT_INDEX_OR_THROW(path, path_len, tupl_args, 0);
+  EXCTRACT_STRING_AT_INDEX_OR_THROW(name, name_len, tupl_args, 1);
+  char *value_name = ALLOC_STRNDUP(name, name_len);
+  HeapProfileValue value;
+  const bool is_known_value = heapprofile_value_parse(value_name, &value);
+  RELEASE(value_name);
+  if (!is_known_value) {
+    return raise_error(task, ctx, "Unknown heap profile value '%.*s'.",
+                       name_len, name);
+  }
+  char *path_str = ALLOC_STRNDUP(path, path_len);
+  const bool written = heapprofiler_write(profiler, path_str, value);
+  RELEASE(path_str);
+  return written ? TRUE_ENTITY : FALSE_ENTITY;
+}
+
 Entity stringify_(Task *task, Context *ctx, Object *obj, Entity *args) {
   ASSERT(args != NULL);
-  ASSERT(PRIMITIVE == args->type || NONE == args->type);
+  ASSERT(PRIMITIVE == etype(args) || NONE == etype(args));
   if (IS_NONE(args)) {
     return entity_object(
         string_new(task->parent_process->heap, "None", strlen("None")));
@@ -341,7 +395,7 @@ Entity stringify_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
   char buffer[BUFFER_SIZE];
   int num_written = 0;
-  Primitive val = args->pri;
+  Primitive val = eprimitive(args);
 
   switch (ptype(&val)) {
     case PRIMITIVE_BOOL:
@@ -365,9 +419,9 @@ Entity stringify_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
 Entity tuple_(Task *task, Context *ctx, Object *obj, Entity *args) {
   ASSERT(args != NULL);
-  Array *arr = (Array *)args->obj->_internal_obj;
-  Object *tup = heap_new(task->parent_process->heap, Class_Tuple);
-  tup->_internal_obj = tuple_create(Array_size(arr));
+  Array *arr = (Array *)object_m(args)->_internal_obj;
+  Object *tup =
+      tuple_create_empty(task->parent_process->heap, Array_size(arr));
   for (int i = 0; i < Array_size(arr); ++i) {
     const Entity *e = Array_get_ref_unchecked(arr, i);
     tuple_set(task->parent_process->heap, tup, i, e);
@@ -384,18 +438,18 @@ Entity color_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (IS_NONE(args)) {
     ret = string_new(task->parent_process->heap, "\x1b[m", strlen("\x1b[m"));
   } else if (IS_CLASS(args, Class_String)) {
-    String *str = (String *)args->obj->_internal_obj;
+    String *str = (String *)object_m(args)->_internal_obj;
     char buf[16];
     sprintf(buf, "\x1b[%*sm", (int)String_size(str), str->table);
     ret = string_new(task->parent_process->heap, buf, strlen(buf));
   } else if (IS_CLASS(args, Class_IString)) {
-    IString *istr = (IString *)args->obj->_internal_obj;
+    IString *istr = (IString *)object_m(args)->_internal_obj;
     char buf[16];
     sprintf(buf, "\x1b[%*sm", istr->len, istr->str);
     ret = string_new(task->parent_process->heap, buf, strlen(buf));
   } else {
     char buf[16];
-    sprintf(buf, "\x1b[%" PRId64 "m", pint(&args->pri));
+    sprintf(buf, "\x1b[%" PRId64 "m", eint(args));
     ret = string_new(task->parent_process->heap, buf, strlen(buf));
   }
   return entity_object(ret);
@@ -404,10 +458,12 @@ Entity color_(Task *task, Context *ctx, Object *obj, Entity *args) {
 Entity string_extend_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (IS_CLASS(args, Class_String)) {
     String_append((String *)obj->_internal_obj,
-                  (String *)args->obj->_internal_obj);
+                  (String *)object_m(args)->_internal_obj);
+    heap_update_bytes(task->parent_process->heap, obj);
   } else if (IS_CLASS(args, Class_IString)) {
-    const IString *istr = (IString *)args->obj->_internal_obj;
+    const IString *istr = (IString *)object_m(args)->_internal_obj;
     String_append_raw((String *)obj->_internal_obj, istr->str, istr->len);
+    heap_update_bytes(task->parent_process->heap, obj);
   } else {
     return raise_error(task, ctx,
                        "Cannot extend a string with something not a string.");
@@ -446,32 +502,32 @@ Entity istring_cmp_(Task *task, Context *ctx, Object *obj, Entity *args) {
 }
 
 Entity string_eq_(Task *task, Context *ctx, Object *obj, Entity *args) {
-  Primitive p = string_cmp_(task, ctx, obj, args).pri;
-  return pint(&p) == 0 ? TRUE_ENTITY : FALSE_ENTITY;
+  Entity cmp = string_cmp_(task, ctx, obj, args);
+  return eint(&cmp) == 0 ? TRUE_ENTITY : FALSE_ENTITY;
 }
 
 Entity istring_eq_(Task *task, Context *ctx, Object *obj, Entity *args) {
-  Primitive p = istring_cmp_(task, ctx, obj, args).pri;
-  return pint(&p) == 0 ? TRUE_ENTITY : FALSE_ENTITY;
+  Entity cmp = istring_cmp_(task, ctx, obj, args);
+  return eint(&cmp) == 0 ? TRUE_ENTITY : FALSE_ENTITY;
 }
 
 Entity string_neq_(Task *task, Context *ctx, Object *obj, Entity *args) {
-  Primitive p = string_cmp_(task, ctx, obj, args).pri;
-  return pint(&p) != 0 ? TRUE_ENTITY : FALSE_ENTITY;
+  Entity cmp = string_cmp_(task, ctx, obj, args);
+  return eint(&cmp) != 0 ? TRUE_ENTITY : FALSE_ENTITY;
 }
 
 Entity istring_neq_(Task *task, Context *ctx, Object *obj, Entity *args) {
-  Primitive p = istring_cmp_(task, ctx, obj, args).pri;
-  return pint(&p) != 0 ? TRUE_ENTITY : FALSE_ENTITY;
+  Entity cmp = istring_cmp_(task, ctx, obj, args);
+  return eint(&cmp) != 0 ? TRUE_ENTITY : FALSE_ENTITY;
 }
 
 Entity string_index_(Task *task, Context *ctx, Object *obj, Entity *args) {
   ASSERT(args != NULL);
-  if (PRIMITIVE != args->type || PRIMITIVE_INT != ptype(&args->pri)) {
+  if (PRIMITIVE != etype(args) || PRIMITIVE_INT != eptype(args)) {
     return raise_error(task, ctx, "Bad string index input");
   }
   String *self = (String *)obj->_internal_obj;
-  int32_t index = pint(&args->pri);
+  int32_t index = eint(args);
   if (index < 0 || index >= String_size(self)) {
     return raise_error(task, ctx, "Index out of bounds.");
   }
@@ -480,7 +536,7 @@ Entity string_index_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
 Entity istring_index_(Task *task, Context *ctx, Object *obj, Entity *args) {
   ASSERT(args != NULL);
-  if (PRIMITIVE != args->type || PRIMITIVE_INT != ptype(&args->pri)) {
+  if (PRIMITIVE != etype(args) || PRIMITIVE_INT != eptype(args)) {
     return raise_error(task, ctx, "Bad string index input");
   }
 
@@ -488,7 +544,7 @@ Entity istring_index_(Task *task, Context *ctx, Object *obj, Entity *args) {
   int self_len;
   extract_string_obj(obj, &self, &self_len);
 
-  int32_t index = pint(&args->pri);
+  int32_t index = eint(args);
   if (index < 0 || index >= self_len) {
     return raise_error(task, ctx, "Index out of bounds.");
   }
@@ -522,13 +578,13 @@ Entity string_set_(Task *task, Context *ctx, Object *obj, Entity *args) {
   EXTRACT_INT_AT_INDEX_OR_THROW(const uint64_t index, tupl_args, 0);
   const Entity *val = tuple_get(tupl_args, 1);
 
-  if (NULL != val && PRIMITIVE == val->type &&
-      PRIMITIVE_CHAR == ptype(&val->pri)) {
-    String_set(str, index, pchar(&val->pri));
+  if (NULL != val && PRIMITIVE == etype(val) &&
+      PRIMITIVE_CHAR == eptype(val)) {
+    String_set(str, index, echar(val));
   } else if (IS_CLASS(val, Class_String)) {
-    String_set(str, index, ((String *)val->obj->_internal_obj)->table[0]);
+    String_set(str, index, ((String *)object_m(val)->_internal_obj)->table[0]);
   } else if (IS_CLASS(val, Class_IString)) {
-    String_set(str, index, ((IString *)val->obj->_internal_obj)->str[0]);
+    String_set(str, index, ((IString *)object_m(val)->_internal_obj)->str[0]);
   } else {
     return raise_error(task, ctx, "Bad string index.");
   }
@@ -536,10 +592,10 @@ Entity string_set_(Task *task, Context *ctx, Object *obj, Entity *args) {
 }
 
 #define IS_OBJECT_CLASS(e, class) \
-  ((NULL != (e)) && (OBJECT == (e)->type) && ((class) == (e)->obj->_class))
+  ((NULL != (e)) && (OBJECT == etype(e)) && ((class) == object(e)->_class))
 
 #define IS_VALUE_TYPE(e, valtype) \
-  (((e) != NULL) && (PRIMITIVE == (e)->type) && ((valtype) == ptype(&(e)->pri)))
+  (((e) != NULL) && (PRIMITIVE == etype(e)) && ((valtype) == eptype(e)))
 
 Entity string_find_(Task *task, Context *ctx, Object *obj, Entity *args) {
   String *str = (String *)obj->_internal_obj;
@@ -744,11 +800,11 @@ Entity string_trim_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
 Entity string_lshrink_(Task *task, Context *ctx, Object *obj, Entity *args) {
   String *str = (String *)obj->_internal_obj;
-  if (NULL == args || PRIMITIVE != args->type ||
-      PRIMITIVE_INT != ptype(&args->pri)) {
+  if (NULL == args || PRIMITIVE != etype(args) ||
+      PRIMITIVE_INT != eptype(args)) {
     return raise_error(task, ctx, "Trimming String with something not an Int.");
   }
-  int32_t index = pint(&args->pri);
+  int32_t index = eint(args);
   if (index > String_size(str)) {
     return raise_error(task, ctx, "Cannot shrink more than the entire size.");
   }
@@ -758,11 +814,11 @@ Entity string_lshrink_(Task *task, Context *ctx, Object *obj, Entity *args) {
 
 Entity string_rshrink_(Task *task, Context *ctx, Object *obj, Entity *args) {
   String *str = (String *)obj->_internal_obj;
-  if (NULL == args || PRIMITIVE != args->type ||
-      PRIMITIVE_INT != ptype(&args->pri)) {
+  if (NULL == args || PRIMITIVE != etype(args) ||
+      PRIMITIVE_INT != eptype(args)) {
     return raise_error(task, ctx, "Trimming String with something not an Int.");
   }
-  int32_t index = pint(&args->pri);
+  int32_t index = eint(args);
   if (index > String_size(str)) {
     return raise_error(task, ctx, "Cannot shrink more than the entire size.");
   }
@@ -891,7 +947,7 @@ Entity array_append_(Task *task, Context *ctx, Object *obj, Entity *args) {
 }
 
 Entity array_remove_(Task *task, Context *ctx, Object *obj, Entity *args) {
-  return array_remove(task->parent_process->heap, obj, pint(&args->pri));
+  return array_remove(task->parent_process->heap, obj, eint(args));
 }
 
 Entity tuple_len_(Task *task, Context *ctx, Object *obj, Entity *args) {
@@ -1008,7 +1064,7 @@ Entity module_dlcall_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (IS_STRING(args)) {
     fn_name = entity_string_copy(args);
   } else {
-    Tuple *tuple = (Tuple *)args->obj->_internal_obj;
+    Tuple *tuple = (Tuple *)object_m(args)->_internal_obj;
     if (tuple_size(tuple) == 0) {
       return raise_error(task, ctx,
                          "Attempted dlcall on module with invalid arguments.");
@@ -1018,8 +1074,8 @@ Entity module_dlcall_(Task *task, Context *ctx, Object *obj, Entity *args) {
     if (tuple_size(tuple) == 2) {
       args_to_pass = *tuple_get(tuple, 1);
     } else {
-      Object *tuple_obj = heap_new(task->parent_process->heap, Class_Tuple);
-      tuple_obj->_internal_obj = tuple_create(tuple_size(tuple) - 1);
+      Object *tuple_obj = tuple_create_empty(task->parent_process->heap,
+                                             tuple_size(tuple) - 1);
       args_to_pass = entity_object(tuple_obj);
       for (int i = 0; i < tuple_size(tuple) - 1; ++i) {
         tuple_set(task->parent_process->heap, tuple_obj, i,
@@ -1111,7 +1167,7 @@ Entity class_is_subclass_of_(Task *task, Context *ctx, Object *obj,
                        "is_subclass_of() requires a Class as an argument.");
   }
   const bool is_subclass_of =
-      inherits_from(obj->_class_obj, args->obj->_class_obj);
+      inherits_from(obj->_class_obj, object_m(args)->_class_obj);
   return is_subclass_of ? TRUE_ENTITY : FALSE_ENTITY;
 }
 
@@ -1119,7 +1175,7 @@ Entity object_super_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (!IS_CLASS(args, Class_Class)) {
     return raise_error(task, ctx, "super() requires a Class as an argument.");
   }
-  const Class *target_super = args->obj->_class_obj;
+  const Class *target_super = object_m(args)->_class_obj;
 
   const Class *super = obj->_class->_super;
   const Function *constructor = NULL;
@@ -1160,8 +1216,8 @@ Entity class_set_super_(Task *task, Context *ctx, Object *obj, Entity *args) {
                        "Argument 1 of $_set_super_ must be of type Class.");
   }
   Class *class = obj->_class_obj;
-  Class *new_super = args->obj->_class_obj;
-  class->_super = new_super;
+  Class *new_super = object_m(args)->_class_obj;
+  class_set_super(class, new_super);
   return entity_object(obj);
 }
 
@@ -1236,13 +1292,75 @@ Entity process_start_(Task *current_task, Context *current_ctx, Object *obj,
   Process *process = (Process *)obj->_internal_obj;
   Entity future = create_future_for_process_(current_task->parent_process,
                                              process, current_task);
-  process_run_in_new_thread(process);
+  process_start(process);
   return future;
 }
 
+void trace_task_set_(TaskSet *tasks, HeapTracer *tracer) {
+  TaskSetIterator iter;
+  TaskSet_iterator(&iter, tasks);
+  for (; TaskSet_has_next(&iter); TaskSet_next(&iter)) {
+    heap_trace_unbarriered(tracer,
+                           (*TaskSet_mutable_value(&iter))->_reflection);
+  }
+}
+
+// Same references that process_collect_garbage() adds edges for.
+void process_trace_(Object *obj, HeapTracer *tracer) {
+  Process *process = (Process *)obj->_internal_obj;
+  if (NULL != process->current_task) {
+    heap_trace_unbarriered(tracer, process->current_task->_reflection);
+  }
+  if (process->is_remote && NULL != process->remote_non_daemon_task) {
+    heap_trace_unbarriered(tracer,
+                           process->remote_non_daemon_task->_reflection);
+  }
+  MpscQueueIterator queued_tasks;
+  mpscqueue_iterator(&queued_tasks, &process->queued_tasks,
+                     mpscqueue_size(&process->queued_tasks));
+  for (; mpscqueue_has_next(&queued_tasks); mpscqueue_next(&queued_tasks)) {
+    heap_trace_unbarriered(
+        tracer, ((Task *)mpscqueue_value(&queued_tasks))->_reflection);
+  }
+  for (Task *task = process->waiting_tasks; NULL != task;
+       task = task->next_waiting) {
+    heap_trace_unbarriered(tracer, task->_reflection);
+  }
+  trace_task_set_(&process->background_tasks, tracer);
+}
+
 void task_init_(Object *obj) {}
 void task_delete_(Object *obj) {}
 
+void task_trace_(Object *obj, HeapTracer *tracer) {
+  Task *task = (Task *)obj->_internal_obj;
+  if (NULL == task) {
+    return;
+  }
+  if (NULL != task->parent_task) {
+    heap_trace_unbarriered(tracer, task->parent_task->_reflection);
+  }
+  EntityStackIterator stack;
+  EntityStack_iterator(&stack, &task->entity_stack);
+  for (; EntityStack_has_next(&stack); EntityStack_next(&stack)) {
+    heap_trace_entity(tracer, EntityStack_value(&stack));
+  }
+  heap_trace_entity(tracer, &task->resval);
+  Context *ctx = task->current, *caller = NULL;
+  while (NULL != ctx) {
+    if (NULL != ctx->_reflection) {
+      heap_trace_unbarriered(tracer, ctx->_reflection);
+    } else {
+      // Same as context_trace_().
+      heap_trace_entity(tracer, &ctx->self);
+      if (NULL != ctx->error) {
+        heap_trace(tracer, ctx->error);
+      }
+    }
+    ctx = task_next_context(ctx, &caller);
+  }
+}
+
 void context_init_(Object *obj) {}
 void context_delete_(Object *obj) {
   Context *ctx = (Context *)obj->_internal_obj;
@@ -1252,6 +1370,14 @@ void context_delete_(Object *obj) {
   arena_free(&ctx->parent_task->parent_process->context_arena, ctx);
 }
 
+void context_trace_(Object *obj, HeapTracer *tracer) {
+  Context *ctx = (Context *)obj->_internal_obj;
+  heap_trace_entity(tracer, &ctx->self);
+  if (NULL != ctx->error) {
+    heap_trace(tracer, ctx->error);
+  }
+}
+
 void remote_init_(Object *obj) { create_remote_on_object(obj); }
 
 void remote_delete_(Object *obj) {
@@ -1338,9 +1464,12 @@ void builtin_add_process_(Module *builtin) {
   Class_Process =
       native_class(builtin, PROCESS_NAME, process_init_, process_delete_);
   native_method(Class_Process, global_intern("start"), process_start_);
+  Class_Process->_trace_fn = process_trace_;
   Class_Task = native_class(builtin, TASK_NAME, task_init_, task_delete_);
+  Class_Task->_trace_fn = task_trace_;
   Class_Context =
       native_class(builtin, CONTEXT_NAME, context_init_, context_delete_);
+  Class_Context->_trace_fn = context_trace_;
   Class_Remote =
       native_class(builtin, REMOTE_CLASS_NAME, remote_init_, remote_delete_);
   native_method(Class_Remote, global_intern("process"), remote_process_);
@@ -1353,6 +1482,9 @@ void builtin_add_native(ModuleManager *mm, Module *builtin) {
 
   native_function(builtin, global_intern("__collect_garbage"),
                   collect_garbage_);
+  native_function(builtin, global_intern("__gc_stats"), gc_stats_);
+  native_function(builtin, global_intern("__write_heap_profile"),
+                  write_heap_profile_);
   native_function(builtin, global_intern("Int"), Int_);
   native_function(builtin, global_intern("Float"), Float_);
   native_function(builtin, global_intern("Bool"), _Bool_);
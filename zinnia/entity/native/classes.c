@@ -28,7 +28,7 @@ Entity load_class_from_text_(Task *task, Context *ctx, Object *obj,
                        "Invalid argument(0) for "
                        "__load_class_from_text: Expected type Module.");
   }
-  Module *m = arg0->obj->_module_obj;
+  Module *m = object_m(arg0)->_module_obj;
 
   if (!IS_STRING(arg1)) {
     return raise_error(task, ctx,
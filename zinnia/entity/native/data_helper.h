@@ -22,22 +22,28 @@
   void _##class_name##_init(Object *obj) { obj->_internal_obj = NULL; }       \
   void _##class_name##_delete(Object *obj) {                                  \
     class_name##_delete(obj->_internal_obj);                                  \
+  }                                                                           \
+  size_t _##class_name##_bytes(const Object *obj) {                           \
+    const class_name *arr = (class_name *)obj->_internal_obj;                 \
+    return NULL == arr ? 0                                                    \
+                       : sizeof(class_name) +                                 \
+                             class_name##_size(arr) * sizeof(type_name);      \
   }                                                                           \
                                                                               \
   type_name _to_##type_name(const Entity *e) {                                \
-    switch (e->type) {                                                        \
+    switch (etype(e)) {                                                       \
       case NONE:                                                              \
         return 0L;                                                            \
       case OBJECT:                                                            \
-        return (type_name)(uint64_t)e->obj;                                   \
+        return (type_name)(uint64_t)object_m(e);                              \
       case PRIMITIVE:                                                         \
-        switch (ptype(&e->pri)) {                                             \
+        switch (eptype(e)) {                                                  \
           case PRIMITIVE_CHAR:                                                \
-            return (type_name)pchar(&e->pri);                                 \
+            return (type_name)echar(e);                                       \
           case PRIMITIVE_INT:                                                 \
-            return pint(&e->pri);                                             \
+            return eint(e);                                                   \
           case PRIMITIVE_FLOAT:                                               \
-            return (type_name)pfloat(&e->pri);                                \
+            return (type_name)efloat(e);                                      \
           default:                                                            \
             FATALF("Unknown primitive type");                                 \
         }                                                                     \
@@ -53,9 +59,9 @@
     if (NULL == args || IS_NONE(args)) {                                      \
       initial_size = ARRAY_INITIAL_SIZE;                                      \
     } else if (IS_INT(args)) {                                                \
-      initial_size = pint(&args->pri);                                        \
+      initial_size = eint(args);                                              \
     } else if (IS_CLASS(args, Class_Array)) {                                 \
-      Array *arr = (Array *)args->obj->_internal_obj;                         \
+      Array *arr = (Array *)object_m(args)->_internal_obj;                    \
       initial_size = Array_size(arr);                                         \
     } else {                                                                  \
       return raise_error(                                                     \
@@ -67,7 +73,7 @@
     if (IS_INT(args)) {                                                       \
       class_name##_set(arr, initial_size - 1, 0);                             \
     } else if (IS_CLASS(args, Class_Array)) {                                 \
-      Array *arr2 = (Array *)args->obj->_internal_obj;                        \
+      Array *arr2 = (Array *)object_m(args)->_internal_obj;                   \
       for (int i = 0; i < Array_size(arr2); ++i) {                            \
         Entity *e = Array_mutable_ref_unchecked(arr2, i);                     \
         type_name ie = _to_##type_name(e);                                    \
@@ -76,6 +82,7 @@
     } else {                                                                  \
       memset(arr->table, 0x0, sizeof(type_name) * initial_size);              \
     }                                                                         \
+    heap_update_bytes(task->parent_process->heap, obj);                       \
     return entity_object(obj);                                                \
   }                                                                           \
                                                                               \
@@ -91,6 +98,7 @@
       size_t new_len = range->end - range->start;                             \
       obj->_internal_obj =                                                    \
           class_name##_create_copy(self->table + range->start, new_len);      \
+      heap_update_bytes(task->parent_process->heap, obj);                     \
       return entity_object(obj);                                              \
     } else {                                                                  \
       if (class_name##_size(self) < range->end || range->start < 0) {         \
@@ -107,6 +115,7 @@
         class_name##_set(arr, j, class_name##_get_unchecked(self, i));        \
       }                                                                       \
       obj->_internal_obj = arr;                                               \
+      heap_update_bytes(task->parent_process->heap, obj);                     \
       return entity_object(obj);                                              \
     }                                                                         \
   }                                                                           \
@@ -117,15 +126,15 @@
     class_name *self = (class_name *)obj->_internal_obj;                      \
                                                                               \
     if (IS_CLASS(args, Class_Range)) {                                        \
-      Range_ *range = (Range_ *)args->obj->_internal_obj;                     \
+      Range_ *range = (Range_ *)object_m(args)->_internal_obj;                \
       return _##class_name##_index_range(task, ctx, self, range);             \
     }                                                                         \
                                                                               \
-    if (PRIMITIVE != args->type || PRIMITIVE_INT != ptype(&args->pri)) {      \
+    if (PRIMITIVE != etype(args) || PRIMITIVE_INT != eptype(args)) {          \
       return raise_error(task, ctx, "Bad " #class_name " index");             \
     }                                                                         \
                                                                               \
-    int32_t index = pint(&args->pri);                                         \
+    int32_t index = eint(args);                                               \
                                                                               \
     if (index < 0 || index >= class_name##_size(self)) {                      \
       return raise_error(task, ctx, "Index out of bounds: index=%d, size=%d", \
@@ -137,7 +146,7 @@
                                                                               \
   Entity _##class_name##_set_range(Task *task, Context *ctx, class_name *arr, \
                                    Range_ *range, const Entity *val) {        \
-    class_name *value = (class_name *)val->obj->_internal_obj;                \
+    class_name *value = (class_name *)object_m(val)->_internal_obj;           \
     size_t expected_len = (range->end - range->start + 1) / range->inc;       \
     if (range->end > class_name##_size(arr) || range->start < 0) {            \
       return raise_error(task, ctx, "Invalid range: (%d:%d:%d) vs size=%d",   \
@@ -164,7 +173,7 @@
     if (!IS_TUPLE(args)) {                                                    \
       return raise_error(task, ctx, "Expected tuple input");                  \
     }                                                                         \
-    Tuple *tupl_args = (Tuple *)args->obj->_internal_obj;                     \
+    Tuple *tupl_args = (Tuple *)object_m(args)->_internal_obj;                \
     if (2 != tuple_size(tupl_args)) {                                         \
       return raise_error(task, ctx,                                           \
                          "Invalid number of arguments, expected 2, got %d",   \
@@ -174,18 +183,18 @@
     const Entity *val = tuple_get(tupl_args, 1);                              \
                                                                               \
     if (IS_CLASS(index, Class_Range)) {                                       \
-      Range_ *range = (Range_ *)index->obj->_internal_obj;                    \
+      Range_ *range = (Range_ *)object_m(index)->_internal_obj;               \
       if (!IS_CLASS(val, Class_##class_name)) {                               \
         return raise_error(task, ctx, "Value must be an " #class_name);       \
       }                                                                       \
       return _##class_name##_set_range(task, ctx, arr, range, val);           \
     } else if (IS_INT(index)) {                                               \
-      int indexi = pint(&index->pri);                                         \
+      int indexi = eint(index);                                               \
       if (indexi < 0 || indexi >= class_name##_size(arr)) {                   \
         return raise_error(task, ctx, "Index out of bounds");                 \
       }                                                                       \
       type_name ival = _to_##type_name(val);                                  \
-      class_name##_set(arr, pint(&index->pri), ival);                         \
+      class_name##_set(arr, eint(index), ival);                               \
     } else {                                                                  \
       return raise_error(task, ctx, "Index must be int or Range.");           \
     }                                                                         \
@@ -204,6 +213,7 @@
       *Array_set_ref_unchecked(arr, i) =                                      \
           to_entity_fn(class_name##_get_unchecked(self, i));                  \
     }                                                                         \
+    heap_update_bytes(task->parent_process->heap, arre);                      \
     return entity_object(arre);                                               \
   }                                                                           \
                                                                               \
@@ -221,6 +231,7 @@
                        class_name##_get_unchecked(self, i));                  \
     }                                                                         \
     new_obj->_internal_obj = arr;                                             \
+    heap_update_bytes(task->parent_process->heap, new_obj);                   \
     return entity_object(new_obj);                                            \
   }                                                                           \
                                                                               \
@@ -273,6 +284,7 @@
     class_name *arr = class_name##_copy(self);                                \
     _##type_name##_sort(arr->table, 0, size - 1);                             \
     new_obj->_internal_obj = arr;                                             \
+    heap_update_bytes(task->parent_process->heap, new_obj);                   \
     return entity_object(new_obj);                                            \
   }                                                                           \
                                                                               \
@@ -295,6 +307,12 @@
   void _##class_name##_delete(Object *obj) {                                   \
     array_class_name##_delete(((class_name *)obj->_internal_obj)->arr);        \
     RELEASE(obj->_internal_obj);                                               \
+  }                                                                            \
+  size_t _##class_name##_bytes(const Object *obj) {                            \
+    const class_name *mat = (class_name *)obj->_internal_obj;                  \
+    return NULL == mat ? 0                                                     \
+                       : sizeof(class_name) + sizeof(array_class_name) +       \
+                             mat->dim1 * mat->dim2 * sizeof(type_name);        \
   }                                                                            \
                                                                                \
   class_name *_##class_name##_create(int dim1, int dim2, bool clear) {         \
@@ -311,7 +329,7 @@
   Entity _##class_name##_constructor(Task *task, Context *ctx, Object *obj,    \
                                      Entity *args) {                           \
     if (IS_TUPLE(args)) {                                                      \
-      Tuple *tupl_args = (Tuple *)args->obj->_internal_obj;                    \
+      Tuple *tupl_args = (Tuple *)object_m(args)->_internal_obj;               \
       if (2 != tuple_size(tupl_args)) {                                        \
         return raise_error(task, ctx,                                          \
                            "Invalid number of arguments, expected 2, got %d",  \
@@ -324,23 +342,23 @@
         return raise_error(task, ctx, "Invalid input: expected (Int, Int).");  \
       }                                                                        \
                                                                                \
-      const size_t dim1 = pint(&e_dim1->pri);                                  \
-      const size_t dim2 = pint(&e_dim2->pri);                                  \
+      const size_t dim1 = eint(e_dim1);                                        \
+      const size_t dim2 = eint(e_dim2);                                        \
                                                                                \
       obj->_internal_obj = _##class_name##_create(dim1, dim2, /*clear=*/true); \
     } else if (IS_ARRAY(args)) {                                               \
-      Array *arr = (Array *)args->obj->_internal_obj;                          \
+      Array *arr = (Array *)object_m(args)->_internal_obj;                     \
       const size_t dim1 = Array_size(arr);                                     \
       int max_dim2 = 0;                                                        \
       for (int i = 0; i < Array_size(arr); ++i) {                              \
         Entity *e = Array_mutable_ref_unchecked(arr, i);                       \
         if (IS_ARRAY(e)) {                                                     \
           max_dim2 =                                                           \
-              max(max_dim2, Array_size((Array *)e->obj->_internal_obj));       \
+              max(max_dim2, Array_size((Array *)object_m(e)->_internal_obj));  \
         } else if (IS_CLASS(e, Class_##array_class_name)) {                    \
-          max_dim2 =                                                           \
-              max(max_dim2, array_class_name##_size(                           \
-                                (array_class_name *)e->obj->_internal_obj));   \
+          array_class_name *row =                                              \
+              (array_class_name *)object_m(e)->_internal_obj;                  \
+          max_dim2 = max(max_dim2, array_class_name##_size(row));              \
         } else {                                                               \
           return raise_error(task, ctx,                                        \
                              "Invalid member of input array at index %d", i);  \
@@ -353,19 +371,20 @@
       for (int i = 0; i < Array_size(arr); ++i) {                              \
         Entity *e = Array_mutable_ref_unchecked(arr, i);                       \
         if (IS_ARRAY(e)) {                                                     \
-          Array *arri = (Array *)e->obj->_internal_obj;                        \
+          Array *arri = (Array *)object_m(e)->_internal_obj;                   \
           for (int j = 0; j < Array_size(arri); ++j) {                         \
-            type_name val = pint(&Array_mutable_ref_unchecked(arri, j)->pri);  \
+            type_name val = eint(Array_mutable_ref_unchecked(arri, j));        \
             mat->arr->table[i * mat->dim2 + j] = val;                          \
           }                                                                    \
         } else /*if (IS_CLASS(e, Class_##array_class_name))*/ {                \
           const array_class_name *arri =                                       \
-              (array_class_name *)e->obj->_internal_obj;                       \
+              (array_class_name *)object_m(e)->_internal_obj;                  \
           memcpy(mat->arr->table + i * mat->dim2, arri->table,                 \
                  sizeof(type_name) * mat->dim2);                               \
         }                                                                      \
       }                                                                        \
     }                                                                          \
+    heap_update_bytes(task->parent_process->heap, obj);                        \
     return entity_object(obj);                                                 \
   }                                                                            \
                                                                                \
@@ -386,8 +405,8 @@
                                       const Tuple *dim_indices) {              \
     for (int i = 0; i < tuple_size(dim_indices); ++i) {                        \
       const Entity *e = tuple_get(dim_indices, i);                             \
-      if (!IS_INT(e) || pint(&e->pri) < 0 ||                                   \
-          pint(&e->pri) >= _##class_name##_get_dim(mat, dim)) {                \
+      if (!IS_INT(e) || eint(e) < 0 ||                                         \
+          eint(e) >= _##class_name##_get_dim(mat, dim)) {                      \
         return i;                                                              \
       }                                                                        \
     }                                                                          \
@@ -409,14 +428,14 @@
       Task *task, Context *ctx, const Entity *arg, const class_name *mat,      \
       int dim, int *dim_index, Tuple **dim_indices, Range_ **dim_range) {      \
     if (IS_INT(arg)) {                                                         \
-      *dim_index = pint(&arg->pri);                                            \
+      *dim_index = eint(arg);                                                  \
       if (!_##class_name##_index_is_valid(mat, dim, *dim_index)) {             \
         return raise_error(task, ctx,                                          \
                            "Dim%d out of bounds: %d, must be in [0, %d)", dim, \
                            *dim_index, _##class_name##_get_dim(mat, dim));     \
       }                                                                        \
     } else if (IS_TUPLE(arg)) {                                                \
-      *dim_indices = (Tuple *)arg->obj->_internal_obj;                         \
+      *dim_indices = (Tuple *)object_m(arg)->_internal_obj;                    \
       int bad_index = -1;                                                      \
       if ((bad_index = _##class_name##_first_bad_index(mat, dim,               \
                                                        *dim_indices)) >= 0) {  \
@@ -424,7 +443,7 @@
                            bad_index);                                         \
       }                                                                        \
     } else if (IS_CLASS(arg, Class_Range)) {                                   \
-      *dim_range = (Range_ *)arg->obj->_internal_obj;                          \
+      *dim_range = (Range_ *)object_m(arg)->_internal_obj;                     \
       if (!_##class_name##_range_is_valid(mat, dim, *dim_range)) {             \
         return raise_error(                                                    \
             task, ctx, "Dim%d out of bounds: (%d:%d:%d), must be in [0, %d)",  \
@@ -457,7 +476,7 @@
                                Entity *args) {                                 \
     const class_name *mat = (class_name *)obj->_internal_obj;                  \
     if (IS_TUPLE(args)) {                                                      \
-      Tuple *targs = (Tuple *)args->obj->_internal_obj;                        \
+      Tuple *targs = (Tuple *)object_m(args)->_internal_obj;                   \
       if (tuple_size(targs) != 2) {                                            \
         return raise_error(task, ctx, "Expected exactly 2 args");              \
       }                                                                        \
@@ -494,8 +513,9 @@
             array_class_name##_set(                                            \
                 new_arr, i,                                                    \
                 _##class_name##_get_value(                                     \
-                    mat, dim1_index, pint(&tuple_get(dim2_indices, i)->pri))); \
+                    mat, dim1_index, eint(tuple_get(dim2_indices, i))));       \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         } else /* (NULL != dim2_range) */ {                                    \
           array_class_name *new_arr;                                           \
@@ -511,6 +531,7 @@
             array_class_name##_set(                                            \
                 new_arr, j, _##class_name##_get_value(mat, dim1_index, i));    \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         }                                                                      \
       } else if (NULL != dim1_indices) {                                       \
@@ -524,8 +545,9 @@
             array_class_name##_set(                                            \
                 new_arr, i,                                                    \
                 _##class_name##_get_value(                                     \
-                    mat, pint(&tuple_get(dim1_indices, i)->pri), dim2_index)); \
+                    mat, eint(tuple_get(dim1_indices, i)), dim2_index));       \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         } else if (NULL != dim2_indices) {                                     \
           class_name *new_mat;                                                 \
@@ -539,10 +561,11 @@
               array_class_name##_set(                                          \
                   new_mat->arr, i * new_mat->dim2 + j,                         \
                   _##class_name##_get_value(                                   \
-                      mat, pint(&tuple_get(dim1_indices, i)->pri),             \
-                      pint(&tuple_get(dim2_indices, j)->pri)));                \
+                      mat, eint(tuple_get(dim1_indices, i)),                   \
+                      eint(tuple_get(dim2_indices, j))));                      \
             }                                                                  \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         } else /* (NULL != dim2_range) */ {                                    \
           class_name *new_mat;                                                 \
@@ -559,9 +582,10 @@
               array_class_name##_set(                                          \
                   new_mat->arr, i * new_mat->dim2 + j,                         \
                   _##class_name##_get_value(                                   \
-                      mat, pint(&tuple_get(dim1_indices, i)->pri), i2));       \
+                      mat, eint(tuple_get(dim1_indices, i)), i2));             \
             }                                                                  \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         }                                                                      \
       } else /* if (NULL != dim1_range) */ {                                   \
@@ -579,6 +603,7 @@
             array_class_name##_set(                                            \
                 new_arr, j, _##class_name##_get_value(mat, i, dim2_index));    \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         } else if (NULL != dim2_indices) {                                     \
           class_name *new_mat;                                                 \
@@ -595,9 +620,10 @@
               array_class_name##_set(                                          \
                   new_mat->arr, j * new_mat->dim2 + i,                         \
                   _##class_name##_get_value(                                   \
-                      mat, i2, pint(&tuple_get(dim2_indices, i)->pri)));       \
+                      mat, i2, eint(tuple_get(dim2_indices, i))));             \
             }                                                                  \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         } else /* (NULL != dim2_range) */ {                                    \
           class_name *new_mat;                                                 \
@@ -618,11 +644,12 @@
                                      _##class_name##_get_value(mat, i, k));    \
             }                                                                  \
           }                                                                    \
+          heap_update_bytes(task->parent_process->heap, new_obj);              \
           return entity_object(new_obj);                                       \
         }                                                                      \
       }                                                                        \
     } else if (IS_INT(args)) {                                                 \
-      const int dim1_index = (int)pint(&args->pri);                            \
+      const int dim1_index = (int)eint(args);                                  \
       if (!_##class_name##_index_is_valid(mat, 1, dim1_index)) {               \
         return raise_error(task, ctx,                                          \
                            "Index out of bounds: was %d, must be in [0,%d)",   \
@@ -632,9 +659,10 @@
           heap_new(task->parent_process->heap, Class_##array_class_name);      \
       subarr->_internal_obj = array_class_name##_create_copy(                  \
           mat->arr->table + dim1_index * mat->dim2, mat->dim2);                \
+      heap_update_bytes(task->parent_process->heap, subarr);                   \
       return entity_object(subarr);                                            \
     } else if (IS_CLASS(args, Class_Range)) {                                  \
-      const Range_ *range = (Range_ *)args->obj->_internal_obj;                \
+      const Range_ *range = (Range_ *)object_m(args)->_internal_obj;           \
       if (!_##class_name##_range_is_valid(mat, 1, range)) {                    \
         return raise_error(task, ctx,                                          \
                            "Range out of bounds: (%d:%d:%d) vs size=%d",       \
@@ -654,6 +682,7 @@
                mat->arr->table + i * mat->dim2,                                \
                sizeof(type_name) * mat->dim2);                                 \
       }                                                                        \
+      heap_update_bytes(task->parent_process->heap, submat_o);                 \
       return entity_object(submat_o);                                          \
     } else {                                                                   \
       return raise_error(task, ctx, "Expected tuple arg.");                    \
@@ -678,7 +707,7 @@
       IntArray_push_back(indices, index);                                      \
     } else if (NULL != tuple) {                                                \
       for (int i = 0; i < tuple_size(tuple); ++i) {                            \
-        IntArray_push_back(indices, (int)pint(&tuple_get(tuple, i)->pri));     \
+        IntArray_push_back(indices, (int)eint(tuple_get(tuple, i)));           \
       }                                                                        \
     } else if (NULL != range) {                                                \
       for (int i = range->start, j = 0;                                        \
@@ -698,7 +727,7 @@
     if (!IS_TUPLE(args)) {                                                     \
       return raise_error(task, ctx, "Expected tuple input");                   \
     }                                                                          \
-    Tuple *targs = (Tuple *)args->obj->_internal_obj;                          \
+    Tuple *targs = (Tuple *)object_m(args)->_internal_obj;                     \
     if (tuple_size(targs) != 2) {                                              \
       return raise_error(task, ctx, "Expected exactly 2 args");                \
     }                                                                          \
@@ -708,7 +737,7 @@
     if (!IS_TUPLE(lhs)) {                                                      \
       return raise_error(task, ctx, "Expected tuple lhs");                     \
     }                                                                          \
-    Tuple *dims = (Tuple *)lhs->obj->_internal_obj;                            \
+    Tuple *dims = (Tuple *)object_m(lhs)->_internal_obj;                       \
     if (tuple_size(dims) != 2) {                                               \
       return raise_error(task, ctx, "Expected lhs to be Tuple(2)");            \
     }                                                                          \
@@ -716,7 +745,7 @@
     if (!IS_CLASS(rhs, Class_##class_name)) {                                  \
       return raise_error(task, ctx, "Expected rhs to be class_name");          \
     }                                                                          \
-    const class_name *rhs_mat = (class_name *)rhs->obj->_internal_obj;         \
+    const class_name *rhs_mat = (class_name *)object_m(rhs)->_internal_obj;    \
                                                                                \
     IntArray dim1_indices, dim2_indices;                                       \
     IntArray_init(&dim1_indices);                                              \
@@ -767,6 +796,7 @@
         native_class(data, global_intern(#class_name), _##class_name##_init,   \
                      _##class_name##_delete);                                  \
     Class_##class_name->_copy_fn = (ObjCopyFn)_##class_name##_copy_fn;         \
+    Class_##class_name->_size_fn = _##class_name##_bytes;                      \
     native_method(Class_##class_name, CONSTRUCTOR_KEY,                         \
                   _##class_name##_constructor);                                \
     native_method(Class_##class_name, global_intern("len"),                    \
@@ -787,6 +817,7 @@
     Class_##class_name =                                                       \
         native_class(data, global_intern(#class_name), _##class_name##_init,   \
                      _##class_name##_delete);                                  \
+    Class_##class_name->_size_fn = _##class_name##_bytes;                      \
     native_method(Class_##class_name, CONSTRUCTOR_KEY,                         \
                   _##class_name##_constructor);                                \
     native_method(Class_##class_name, ARRAYLIKE_INDEX_KEY,                     \
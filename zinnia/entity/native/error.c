@@ -109,8 +109,7 @@ Entity token_tuple_(Task *task, const Token *token) {
   if (NULL == token) {
     return NONE_ENTITY;
   }
-  Object *tuple_obj = heap_new(task->parent_process->heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(3);
+  Object *tuple_obj = tuple_create_empty(task->parent_process->heap, 3);
 
   Entity token_text;
   if (NULL == token->text) {
@@ -159,12 +158,12 @@ Entity error_constructor_(Task *task, Context *ctx, Object *obj, Entity *args) {
     return raise_error(task, ctx, "Error argument is not a String.");
   }
   object_set_member_obj(task->parent_process->heap, obj,
-                        global_intern("message"), args->obj);
+                        global_intern("message"), object_m(args));
   Object *stacktrace = heap_new(task->parent_process->heap, Class_Array);
   Task *t = task;
   while (NULL != t) {
-    Context *c;
-    for (c = t->current; NULL != c; c = c->previous_context) {
+    Context *c, *caller = NULL;
+    for (c = t->current; NULL != c; c = task_next_context(c, &caller)) {
       Object *stackline = heap_new(task->parent_process->heap, Class_StackLine);
       StackLine_ *sl = (StackLine_ *)stackline->_internal_obj;
       sl->module = c->module;
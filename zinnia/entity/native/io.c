@@ -7,17 +7,25 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef OS_WINDOWS
+#include <fcntl.h>
 #include <sys/inotify.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
 
 #include "file-utils/file_utils.h"
+#include "zinnia/util/sync/atomic.h"
+#include "zinnia/util/sync/reactor.h"
 
 #define MAX_EVENTS 1024
 #define FILE_NAME_LENGTH_ESTIMATE 16
+// Largest read or write of one op. Reading a whole file takes as many as it
+// needs.
+#define MAX_OP_LENGTH (1 << 30)
 
 #ifndef min
 #define min(x, y) ((x) > (y) ? (y) : (x))
@@ -29,6 +37,17 @@ typedef struct {
   FILE *fp;
 } File_;
 
+// Set in AsyncFile_.refs once the file is closed.
+#define ASYNC_FILE_CLOSED_ 0x80000000u
+
+// The file holds one of refs until it is closed and each submission holds
+// another until its ops are done. fd is closed once none are left, so it is
+// never closed, and maybe reused, under ops still in flight.
+typedef struct {
+  int fd;
+  volatile uint32_t refs;
+} AsyncFile_;
+
 #ifndef OS_WINDOWS
 
 #define EVENT_SIZE (sizeof(struct inotify_event))
@@ -74,7 +93,7 @@ void _file_delete_(Object *obj) {
 }
 
 Entity file_constructor_(Task *task, Context *ctx, Object *obj, Entity *args) {
-  if (NULL == args || OBJECT != args->type) {
+  if (NULL == args || OBJECT != etype(args)) {
     return raise_error(task, ctx, "Invalid input for File.");
   }
   File_ *f = (File_ *)obj->_internal_obj;
@@ -85,8 +104,8 @@ Entity file_constructor_(Task *task, Context *ctx, Object *obj, Entity *args) {
     mode = global_intern("r");
     f->fp = fopen(fn, mode);
     RELEASE(fn);
-  } else if (Class_Tuple == args->obj->_class) {
-    Tuple *tup = (Tuple *)args->obj->_internal_obj;
+  } else if (Class_Tuple == object_m(args)->_class) {
+    Tuple *tup = (Tuple *)object_m(args)->_internal_obj;
     if (tuple_size(tup) < 2) {
       return raise_error(task, ctx, "Too few arguments for File constructor.");
     }
@@ -120,6 +139,35 @@ Entity file_constructor_(Task *task, Context *ctx, Object *obj, Entity *args) {
   return entity_object(obj);
 }
 
+Entity getenv_(Task *task, Context *ctx, Object *obj, Entity *args) {
+  if (!IS_STRING(args)) {
+    return raise_error(task, ctx, "Expected environment variable name.");
+  }
+  char *name = entity_string_copy(args);
+  const char *value = getenv(name);
+  RELEASE(name);
+  if (NULL == value) {
+    return NONE_ENTITY;
+  }
+  return entity_object(
+      string_new(task->parent_process->heap, value, strlen(value)));
+}
+
+Entity remove_(Task *task, Context *ctx, Object *obj, Entity *args) {
+  if (!IS_STRING(args)) {
+    return raise_error(task, ctx, "Expected file name.");
+  }
+  char *fn = entity_string_copy(args);
+  if (0 != remove(fn)) {
+    Entity error = raise_error(task, ctx, "File '%s' could not be removed: %s",
+                               fn, strerror(errno));
+    RELEASE(fn);
+    return error;
+  }
+  RELEASE(fn);
+  return NONE_ENTITY;
+}
+
 Entity file_close_(Task *task, Context *ctx, Object *obj, Entity *args) {
   File_ *f = (File_ *)obj->_internal_obj;
   if (NULL == f->fp) {
@@ -136,15 +184,15 @@ Entity file_gets_(Task *task, Context *ctx, Object *obj, Entity *args) {
   File_ *f = (File_ *)obj->_internal_obj;
   ASSERT(f != NULL);
   ASSERT(f->fp != NULL);
-  if (NULL == args || PRIMITIVE != args->type ||
-      PRIMITIVE_INT != ptype(&args->pri)) {
+  if (NULL == args || PRIMITIVE != etype(args) ||
+      PRIMITIVE_INT != eptype(args)) {
     return native_background_raise_error(task, ctx, "Invalid input to gets.");
   }
-  char *buf = MNEW_ARR(char, pint(&args->pri) + 1);
+  char *buf = MNEW_ARR(char, eint(args) + 1);
   Entity string;
-  if (fgets(buf, pint(&args->pri), f->fp)) {
+  if (fgets(buf, eint(args), f->fp)) {
     string = entity_object(native_background_string_new(task->parent_process,
-                                                        buf, pint(&args->pri)));
+                                                        buf, eint(args)));
   } else {
     string = NONE_ENTITY;
   }
@@ -205,6 +253,387 @@ Entity file_puts_(Task *task, Context *ctx, Object *obj, Entity *args) {
 }
 
 #ifndef OS_WINDOWS
+void async_file_init_(Object *obj) {
+  AsyncFile_ *af = MNEW(AsyncFile_);
+  af->fd = -1;
+  af->refs = ASYNC_FILE_CLOSED_;
+  obj->_internal_obj = af;
+}
+
+void async_file_delete_(Object *obj) {
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  if (NULL == af) {
+    return;
+  }
+  if (af->fd >= 0) {
+    close(af->fd);
+  }
+  RELEASE(af);
+}
+
+// Flags for open() like the fopen() mode. Appending is left out since pwrite()
+// would then ignore offsets.
+int open_flags_(const char mode[], int mode_len) {
+  if (mode_len < 1) {
+    return -1;
+  }
+  const bool is_update = NULL != memchr(mode, '+', mode_len);
+  switch (mode[0]) {
+    case 'r':
+      return is_update ? O_RDWR : O_RDONLY;
+    case 'w':
+      return (is_update ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+    case 'a':
+      return (is_update ? O_RDWR : O_WRONLY) | O_CREAT;
+    default:
+      return -1;
+  }
+}
+
+Entity async_file_constructor_(Task *task, Context *ctx, Object *obj,
+                               Entity *args) {
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  EXTRACT_TUPLE_ARGS(tuple, args, 2, task, ctx);
+  EXCTRACT_STRING_AT_INDEX_OR_THROW(fn, fn_len, tuple, 0);
+  EXCTRACT_STRING_AT_INDEX_OR_THROW(mode, mode_len, tuple, 1);
+  const int flags = open_flags_(mode, mode_len);
+  if (flags < 0) {
+    return raise_error(task, ctx, "Invalid mode '%.*s'.", mode_len, mode);
+  }
+  char *fn_str = ALLOC_STRNDUP(fn, fn_len);
+  af->fd = open(fn_str, flags | O_CLOEXEC, 0644);
+  atomic_store_u32(&af->refs, af->fd < 0 ? ASYNC_FILE_CLOSED_ : 1);
+  if (af->fd < 0) {
+    Entity error =
+        raise_error(task, ctx, "File '%s' could not be opened.", fn_str);
+    RELEASE(fn_str);
+    return error;
+  }
+  RELEASE(fn_str);
+  return entity_object(obj);
+}
+
+// Takes a ref for ops about to be submitted. Returns false if the file is
+// closed.
+bool async_file_acquire_(AsyncFile_ *af) {
+  uint32_t refs;
+  do {
+    refs = atomic_load_u32(&af->refs);
+    if (0 != (refs & ASYNC_FILE_CLOSED_)) {
+      return false;
+    }
+  } while (!atomic_cas_u32(&af->refs, refs, refs + 1));
+  return true;
+}
+
+void async_file_release_(AsyncFile_ *af) {
+  if (ASYNC_FILE_CLOSED_ == atomic_dec_u32(&af->refs)) {
+    close(af->fd);
+    af->fd = -1;
+  }
+}
+
+// Ops still in flight keep the fd open until they are done.
+Entity async_file_close_(Task *task, Context *ctx, Object *obj, Entity *args) {
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  uint32_t refs;
+  do {
+    refs = atomic_load_u32(&af->refs);
+    if (0 != (refs & ASYNC_FILE_CLOSED_)) {
+      return NONE_ENTITY;
+    }
+  } while (!atomic_cas_u32(&af->refs, refs, refs | ASYNC_FILE_CLOSED_));
+  async_file_release_(af);
+  return NONE_ENTITY;
+}
+
+// Extracts (offset, value) from args.
+bool extract_offset_pair_(const Entity *args, int64_t *offset,
+                          const Entity **value) {
+  if (!IS_TUPLE(args)) {
+    return false;
+  }
+  const Tuple *tuple = (Tuple *)object_m(args)->_internal_obj;
+  if (2 != tuple_size(tuple) || !IS_INT(tuple_get(tuple, 0))) {
+    return false;
+  }
+  *offset = eint_of(tuple_get(tuple, 0));
+  *value = tuple_get(tuple, 1);
+  return *offset >= 0;
+}
+
+// Prepares a read of (offset, length) args into a buffer of its own.
+bool prep_read_(ReactorOp *op, int fd, const Entity *args) {
+  int64_t offset;
+  const Entity *length;
+  if (!extract_offset_pair_(args, &offset, &length) || !IS_INT(length) ||
+      eint_of(length) < 0 || eint_of(length) > MAX_OP_LENGTH) {
+    return false;
+  }
+  op->type = REACTOR_READ;
+  op->fd = fd;
+  op->len = (uint32_t)eint_of(length);
+  op->buf = MNEW_ARR(char, op->len);
+  op->offset = offset;
+  op->result = 0;
+  return true;
+}
+
+// Prepares a write of (offset, string) args from a copy of the string, so it
+// may change meanwhile.
+bool prep_write_(ReactorOp *op, int fd, const Entity *args) {
+  int64_t offset;
+  const Entity *str;
+  char *src;
+  int len;
+  if (!extract_offset_pair_(args, &offset, &str) ||
+      !extract_string(str, &src, &len) || len > MAX_OP_LENGTH) {
+    return false;
+  }
+  op->type = REACTOR_WRITE;
+  op->fd = fd;
+  op->len = len;
+  op->buf = MNEW_ARR(char, len);
+  memcpy(op->buf, src, len);
+  op->offset = offset;
+  op->result = 0;
+  return true;
+}
+
+void release_ops_(ReactorOp *ops, uint32_t num_ops) {
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    RELEASE(ops[i].buf);
+  }
+  RELEASE(ops);
+}
+
+// Must hold heap_access_lock. None once the file has ended.
+Entity op_result_(Heap *heap, const ReactorOp *op) {
+  if (REACTOR_WRITE == op->type) {
+    return entity_int(op->result);
+  }
+  if (0 == op->result) {
+    return NONE_ENTITY;
+  }
+  return entity_object(string_new(heap, op->buf, op->result));
+}
+
+// Raises the first error of ops or else returns the result of each, which
+// are put in an Array if there is more than one.
+Entity ops_results_(Task *task, Context *ctx, ReactorOp *ops, uint32_t num_ops,
+                    bool is_batch) {
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    if (ops[i].result < 0) {
+      const int error = -ops[i].result;
+      release_ops_(ops, num_ops);
+      return native_background_raise_error(
+          task, ctx, "%s failed: %s",
+          REACTOR_READ == ops[i].type ? "Read" : "Write", strerror(error));
+    }
+  }
+  Process *process = task->parent_process;
+  Entity results;
+  SYNCHRONIZED(process->heap_access_lock, {
+    if (is_batch) {
+      Object *arr = heap_new(process->heap, Class_Array);
+      for (uint32_t i = 0; i < num_ops; ++i) {
+        const Entity result = op_result_(process->heap, &ops[i]);
+        array_add(process->heap, arr, &result);
+      }
+      results = entity_object(arr);
+    } else {
+      results = op_result_(process->heap, &ops[0]);
+    }
+  });
+  release_ops_(ops, num_ops);
+  return results;
+}
+
+Entity async_file_read_(Task *task, Context *ctx, Object *obj, Entity *args) {
+  uint32_t num_ops;
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  ReactorOp *ops = native_background_done_ops(task, &num_ops);
+  if (NULL != ops) {
+    async_file_release_(af);
+    return ops_results_(task, ctx, ops, num_ops, /*is_batch=*/false);
+  }
+  if (!async_file_acquire_(af)) {
+    return native_background_raise_error(task, ctx, "File is closed.");
+  }
+  ops = MNEW(ReactorOp);
+  if (!prep_read_(ops, af->fd, args)) {
+    RELEASE(ops);
+    async_file_release_(af);
+    return native_background_raise_error(task, ctx,
+                                         "Expected (offset, length).");
+  }
+  return native_background_submit(task, ops, 1, *args);
+}
+
+Entity async_file_write_(Task *task, Context *ctx, Object *obj, Entity *args) {
+  uint32_t num_ops;
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  ReactorOp *ops = native_background_done_ops(task, &num_ops);
+  if (NULL != ops) {
+    async_file_release_(af);
+    return ops_results_(task, ctx, ops, num_ops, /*is_batch=*/false);
+  }
+  if (!async_file_acquire_(af)) {
+    return native_background_raise_error(task, ctx, "File is closed.");
+  }
+  ops = MNEW(ReactorOp);
+  if (!prep_write_(ops, af->fd, args)) {
+    RELEASE(ops);
+    async_file_release_(af);
+    return native_background_raise_error(task, ctx,
+                                         "Expected (offset, string).");
+  }
+  return native_background_submit(task, ops, 1, *args);
+}
+
+// Submits one op per element of an Array of args, all at once.
+Entity submit_batch_(Task *task, Context *ctx, AsyncFile_ *af, Entity *args,
+                     bool (*prep_fn)(ReactorOp *, int, const Entity *),
+                     const char expected[]) {
+  if (!IS_CLASS(args, Class_Array)) {
+    return native_background_raise_error(task, ctx, "Expected Array of %s.",
+                                         expected);
+  }
+  if (!async_file_acquire_(af)) {
+    return native_background_raise_error(task, ctx, "File is closed.");
+  }
+  Array *arr = (Array *)object_m(args)->_internal_obj;
+  const uint32_t num_ops = Array_size(arr);
+  ReactorOp *ops = MNEW_ARR(ReactorOp, num_ops);
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    if (!prep_fn(&ops[i], af->fd, Array_get_ref_unchecked(arr, i))) {
+      release_ops_(ops, i);
+      async_file_release_(af);
+      return native_background_raise_error(
+          task, ctx, "Expected %s at index %d.", expected, i);
+    }
+  }
+  return native_background_submit(task, ops, num_ops, *args);
+}
+
+Entity async_file_read_batch_(Task *task, Context *ctx, Object *obj,
+                              Entity *args) {
+  uint32_t num_ops;
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  ReactorOp *ops = native_background_done_ops(task, &num_ops);
+  if (NULL != ops) {
+    async_file_release_(af);
+    return ops_results_(task, ctx, ops, num_ops, /*is_batch=*/true);
+  }
+  return submit_batch_(task, ctx, af, args, prep_read_, "(offset, length)");
+}
+
+Entity async_file_write_batch_(Task *task, Context *ctx, Object *obj,
+                               Entity *args) {
+  uint32_t num_ops;
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  ReactorOp *ops = native_background_done_ops(task, &num_ops);
+  if (NULL != ops) {
+    async_file_release_(af);
+    return ops_results_(task, ctx, ops, num_ops, /*is_batch=*/true);
+  }
+  return submit_batch_(task, ctx, af, args, prep_write_, "(offset, string)");
+}
+
+// Moves each op past what it read. Returns whether every op is done, otherwise
+// what is left of a short read is to be read again. Ops from where the file
+// was found to end on are left empty there, so once every op is done the last
+// one is at the end of what was read.
+bool advance_read_all_ops_(ReactorOp ops[], uint32_t num_ops) {
+  bool is_done = true;
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    ReactorOp *op = &ops[i];
+    if (0 == op->len) {
+      continue;
+    }
+    if (0 == op->result) {
+      // The file was shortened meanwhile.
+      char *end_buf = op->buf;
+      const int64_t end_offset = op->offset;
+      for (uint32_t j = i; j < num_ops; ++j) {
+        ops[j].buf = end_buf;
+        ops[j].offset = end_offset;
+        ops[j].len = 0;
+      }
+      break;
+    }
+    op->buf += op->result;
+    op->offset += op->result;
+    op->len -= op->result;
+    is_done = is_done && 0 == op->len;
+  }
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    ops[i].result = 0;
+  }
+  return is_done;
+}
+
+// Reads the whole file into one buffer as many ops at once as it takes. Each
+// op's buf is as far into the buffer as its offset is into the file.
+Entity async_file_read_all_(Task *task, Context *ctx, Object *obj,
+                            Entity *args) {
+  AsyncFile_ *af = (AsyncFile_ *)obj->_internal_obj;
+  uint32_t num_ops;
+  ReactorOp *ops = native_background_done_ops(task, &num_ops);
+  if (NULL != ops) {
+    char *buf = ops[0].buf - ops[0].offset;
+    for (uint32_t i = 0; i < num_ops; ++i) {
+      if (ops[i].result < 0) {
+        const int error = -ops[i].result;
+        RELEASE(buf);
+        RELEASE(ops);
+        async_file_release_(af);
+        return native_background_raise_error(task, ctx, "Read failed: %s",
+                                             strerror(error));
+      }
+    }
+    if (!advance_read_all_ops_(ops, num_ops)) {
+      // Keeps its ref for what is left to read.
+      return native_background_submit(task, ops, num_ops, *args);
+    }
+    async_file_release_(af);
+    const int64_t len = ops[num_ops - 1].offset;
+    Object *str = native_background_string_new(task->parent_process, buf, len);
+    RELEASE(buf);
+    RELEASE(ops);
+    return entity_object(str);
+  }
+  if (!async_file_acquire_(af)) {
+    return native_background_raise_error(task, ctx, "File is closed.");
+  }
+  struct stat st;
+  if (0 != fstat(af->fd, &st)) {
+    const int error = errno;
+    async_file_release_(af);
+    return native_background_raise_error(task, ctx, "Read failed: %s",
+                                         strerror(error));
+  }
+  if (0 == st.st_size) {
+    async_file_release_(af);
+    return entity_object(
+        native_background_string_new(task->parent_process, NULL, 0));
+  }
+  num_ops = (st.st_size + MAX_OP_LENGTH - 1) / MAX_OP_LENGTH;
+  ops = MNEW_ARR(ReactorOp, num_ops);
+  char *buf = MNEW_ARR(char, st.st_size);
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    const int64_t offset = (int64_t)i * MAX_OP_LENGTH;
+    ReactorOp *op = &ops[i];
+    op->type = REACTOR_READ;
+    op->fd = af->fd;
+    op->buf = buf + offset;
+    op->len = min(st.st_size - offset, MAX_OP_LENGTH);
+    op->offset = offset;
+    op->result = 0;
+  }
+  return native_background_submit(task, ops, num_ops, *args);
+}
+
 void watch_dir_init_(Object *obj) {
   WatchDir_ *wd = MNEW(WatchDir_);
   obj->_internal_obj = wd;
@@ -249,7 +678,7 @@ Entity file_watcher_watch_(Task *task, Context *ctx, Object *obj,
                            Entity *args) {
   FileWatcher_ *fw = (FileWatcher_ *)obj->_internal_obj;
   ASSERT(fw != NULL);
-  String *dir = args->obj->_internal_obj;
+  String *dir = object_m(args)->_internal_obj;
   Object *wd_obj = heap_new(task->parent_process->heap, Class_WatchDir);
   WatchDir_ *wd = (WatchDir_ *)wd_obj->_internal_obj;
   char *dir_str = ALLOC_STRNDUP(dir->table, String_size(dir));
@@ -264,7 +693,7 @@ Entity file_watcher_unwatch_(Task *task, Context *ctx, Object *obj,
                              Entity *args) {
   FileWatcher_ *fw = (FileWatcher_ *)obj->_internal_obj;
   ASSERT(fw != NULL);
-  WatchDir_ *wd = (WatchDir_ *)args->obj->_internal_obj;
+  WatchDir_ *wd = (WatchDir_ *)object_m(args)->_internal_obj;
   inotify_rm_watch(fw->fd, wd->wd);
   return NONE_ENTITY;
 }
@@ -293,8 +722,7 @@ Entity file_watcher_get_read_(Task *task, Context *ctx, Object *obj,
     Entity name = entity_object(string_new(task->parent_process->heap,
                                            event->name, strlen(event->name)));
     Entity mask = entity_int(event->mask);
-    Object *tuple_obj = heap_new(task->parent_process->heap, Class_Tuple);
-    tuple_obj->_internal_obj = tuple_create(2);
+    Object *tuple_obj = tuple_create_empty(task->parent_process->heap, 2);
     Entity tuple_e = entity_object(tuple_obj);
     tuple_set(task->parent_process->heap, tuple_obj, 0, &name);
     tuple_set(task->parent_process->heap, tuple_obj, 1, &mask);
@@ -328,7 +756,25 @@ void io_add_native(ModuleManager *mm, Module *io) {
   native_background_method(file, global_intern("__getall"), file_getall_);
   native_background_method(file, global_intern("__puts"), file_puts_);
 
+  native_function(io, global_intern("__getenv"), getenv_);
+  native_function(io, global_intern("__remove"), remove_);
+
 #ifndef OS_WINDOWS
+  Class *async_file = native_class(io, global_intern("__AsyncFile"),
+                                   async_file_init_, async_file_delete_);
+  native_method(async_file, CONSTRUCTOR_KEY, async_file_constructor_);
+  native_method(async_file, global_intern("__close"), async_file_close_);
+  native_background_method(async_file, global_intern("__read"),
+                           async_file_read_);
+  native_background_method(async_file, global_intern("__write"),
+                           async_file_write_);
+  native_background_method(async_file, global_intern("__read_batch"),
+                           async_file_read_batch_);
+  native_background_method(async_file, global_intern("__write_batch"),
+                           async_file_write_batch_);
+  native_background_method(async_file, global_intern("__read_all"),
+                           async_file_read_all_);
+
   Class_WatchDir = native_class(io, global_intern("__WatchDir"),
                                 watch_dir_init_, watch_dir_delete_);
   Class *file_watcher = native_class(io, global_intern("__FileWatcher"),
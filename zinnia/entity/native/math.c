@@ -9,11 +9,11 @@
 
 #define SingleFloatFn(name, val_var, body)                                     \
   Entity name##_(Task *task, Context *ctx, Object *obj, Entity *args) {        \
-    if (NULL == args || PRIMITIVE != args->type) {                             \
+    if (NULL == args || PRIMITIVE != etype(args)) {                            \
       return raise_error(task, ctx,                                            \
                          #name "() takes exactly 1 primitive type argument."); \
     }                                                                          \
-    const double val_var = float_of(&args->pri);                               \
+    const double val_var = efloat_of(args);                                    \
     body;                                                                      \
   }
 
@@ -31,10 +31,10 @@ Entity log_(Task *task, Context *ctx, Object *obj, Entity *args) {
     EXTRACT_FLOAT_AT_INDEX_OR_THROW(const double base, tuple, 1);
     return entity_float(log_special_(base, num));
   }
-  if (args->type != PRIMITIVE) {
+  if (etype(args) != PRIMITIVE) {
     return raise_error(task, ctx, "Cannot perform _log_ on a non-value.");
   }
-  return entity_float(log(float_of(&args->pri)));
+  return entity_float(log(efloat_of(args)));
 }
 
 Entity pow_(Task *task, Context *ctx, Object *obj, Entity *args) {
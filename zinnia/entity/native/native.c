@@ -60,5 +60,35 @@ Object *native_background_string_new(Process *process, const char src[],
                                      size_t len) {
   Object *str = native_background_new(process, Class_String);
   string_init__(str, src, len);
+  SYNCHRONIZED(process->heap_access_lock,
+               { heap_update_bytes(process->heap, str); });
   return str;
 }
+
+Entity native_background_await(Task *task, int fd, ReactorEvent event,
+                               Entity args) {
+  task->io_wait_fd = fd;
+  task->io_wait_event = event;
+  // Becomes the args of the next run.
+  return args;
+}
+
+Entity native_background_submit(Task *task, ReactorOp ops[], uint32_t num_ops,
+                                Entity args) {
+  task->io_ops = ops;
+  task->num_io_ops = num_ops;
+  task->io_ops_done = false;
+  return args;
+}
+
+ReactorOp *native_background_done_ops(Task *task, uint32_t *num_ops) {
+  if (NULL == task->io_ops || !task->io_ops_done) {
+    return NULL;
+  }
+  ReactorOp *ops = task->io_ops;
+  *num_ops = task->num_io_ops;
+  task->io_ops = NULL;
+  task->num_io_ops = 0;
+  task->io_ops_done = false;
+  return ops;
+}
@@ -10,6 +10,7 @@
 #include "zinnia/entity/entity.h"
 #include "zinnia/entity/function/function.h"
 #include "zinnia/entity/object.h"
+#include "zinnia/util/sync/reactor.h"
 #include "zinnia/vm/process/processes.h"
 
 typedef Entity (*NativeFn)(Task *, Context *, Object *obj, Entity *args);
@@ -26,5 +27,17 @@ Class *native_class(Module *module, const char name[], ObjInitFn init_fn,
 Object *native_background_new(Process *process, Class *class);
 Object *native_background_string_new(Process *process, const char src[],
                                      size_t len);
+// Has the background native calling this run again with args once fd is ready
+// for event, rather than block on it. Its task is parked until then.
+Entity native_background_await(Task *task, int fd, ReactorEvent event,
+                               Entity args);
+// Has the background native calling this run again with args once ops are
+// done, rather than block on them. Its task is parked until then. ops must
+// stay valid until native_background_done_ops() returns them.
+Entity native_background_submit(Task *task, ReactorOp ops[], uint32_t num_ops,
+                                Entity args);
+// Returns the ops submitted with native_background_submit() once they are
+// done, and forgets them. Returns NULL if none are.
+ReactorOp *native_background_done_ops(Task *task, uint32_t *num_ops);
 
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_NATIVE_NATIVE_H_ */
\ No newline at end of file
@@ -12,7 +12,7 @@
   if (!IS_TUPLE(args)) {                                                      \
     return raise_error(task, ctx, "Expected tuple(%d) argument", num_args);   \
   }                                                                           \
-  const Tuple *var = (Tuple *)args->obj->_internal_obj;                       \
+  const Tuple *var = (Tuple *)object_m(args)->_internal_obj;                  \
   if (tuple_size(var) != num_args) {                                          \
     return raise_error(task, ctx, "Expects tuple(%d) but received tuple(%d)", \
                        num_args, tuple_size(var));                            \
@@ -23,21 +23,21 @@
     return raise_error(task, ctx,                                            \
                        "Expected argument at index %d to be an Int", index); \
   }                                                                          \
-  var = int_of(&tuple_get(tuple, index)->pri);
+  var = eint_of(tuple_get(tuple, index));
 
 #define EXTRACT_FLOAT_AT_INDEX_OR_THROW(var, tuple, index)                     \
   if (!IS_FLOAT(tuple_get(tuple, index))) {                                    \
     return raise_error(task, ctx,                                              \
                        "Expected argument at index %d to be an Float", index); \
   }                                                                            \
-  var = float_of(&tuple_get(tuple, index)->pri);
+  var = efloat_of(tuple_get(tuple, index));
 
 #define EXTRACT_BOOL_AT_INDEX_OR_THROW(var, tuple, index)                     \
   if (!IS_BOOL(tuple_get(tuple, index))) {                                    \
     return raise_error(task, ctx,                                             \
                        "Expected argument at index %d to be an Bool", index); \
   }                                                                           \
-  var = bool_of(&tuple_get(tuple, index)->pri);
+  var = ebool_of(tuple_get(tuple, index));
 
 #define EXCTRACT_STRING_OR_THROW(str, str_len, entity) \
   char *str;                                           \
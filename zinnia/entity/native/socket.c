@@ -6,6 +6,7 @@
 #include "zinnia/entity/native/socket.h"
 
 #include "zinnia/util/socket.h"
+#include "zinnia/util/sync/reactor.h"
 
 #define BUFFER_SIZE 4096
 #define SOCKET_ERROR (-1)
@@ -61,6 +62,8 @@ Entity Socket_constructor_(Task *task, Context *ctx, Object *obj,
     if (SOCKET_ERROR == socket_listen(socket, port)) {
       return raise_error(task, ctx, "Could not listen to socket.");
     }
+    // Accepting then waits on the reactor instead of a background thread.
+    socket_set_nonblocking(socket);
   }
   return entity_object(obj);
 }
@@ -70,6 +73,8 @@ Entity Socket_close_(Task *task, Context *ctx, Object *obj, Entity *args) {
   if (NULL == socket) {
     return raise_error(task, ctx, "Weird Socket error.");
   }
+  // Whatever waits on it would otherwise wait forever.
+  reactor_wake(task->parent_process->vm->reactor, socket_fd(socket));
   socket_close(socket);
   return NONE_ENTITY;
 }
@@ -80,6 +85,12 @@ Entity Socket_accept_(Task *task, Context *ctx, Object *obj, Entity *args) {
     return native_background_raise_error(task, ctx, "Weird Socket error.");
   }
   SocketHandle *sh = socket_accept(socket);
+  if (!sockethandle_is_valid(sh) && socket_would_block()) {
+    sockethandle_delete(sh);
+    return native_background_await(task, socket_fd(socket), REACTOR_READABLE,
+                                   *args);
+  }
+  sockethandle_set_nonblocking(sh);
   Object *socket_handle =
       native_background_new(task->parent_process, Class_SocketHandle);
   socket_handle->_internal_obj = sh;
@@ -127,6 +138,7 @@ Entity Socket_connect_(Task *task, Context *ctx, Object *obj, Entity *args) {
     return native_background_raise_error(task, ctx, "Weird Socket error.");
   }
   SocketHandle *sh = socket_connect(socket);
+  sockethandle_set_nonblocking(sh);
   Object *socket_handle =
       native_background_new(task->parent_process, Class_SocketHandle);
   socket_handle->_internal_obj = sh;
@@ -139,10 +151,53 @@ Entity SocketHandle_close_(Task *task, Context *ctx, Object *obj,
   if (NULL == sh) {
     return raise_error(task, ctx, "Weird Socket error.");
   }
+  reactor_wake(task->parent_process->vm->reactor, sockethandle_fd(sh));
   sockethandle_close(sh);
   return NONE_ENTITY;
 }
 
+// Sends as much of msg as the socket takes without blocking. Returns how much
+// that was, which is all of it unless it would have blocked. Failures are
+// only printed, as they always were.
+int send_available_(SocketHandle *sh, const char msg[], int msg_len) {
+  int sent = 0;
+  while (sent < msg_len) {
+    const int32_t result = sockethandle_send(sh, msg + sent, msg_len - sent);
+    if (SOCKET_ERROR == result) {
+      return socket_would_block() ? sent : msg_len;
+    }
+    sent += result;
+  }
+  return sent;
+}
+
+// Waits to send what is left of the strings in arr from offset in the one at
+// index on, joined into one.
+Entity await_send_(Task *task, SocketHandle *sh, Array *arr, int index,
+                   int offset) {
+  const int arr_len = Array_size(arr);
+  int i, unsent_len = 0;
+  char *msg;
+  int msg_len;
+  for (i = index; i < arr_len; ++i) {
+    extract_string(Array_get_ref_unchecked(arr, i), &msg, &msg_len);
+    unsent_len += msg_len;
+  }
+  unsent_len -= offset;
+  char *unsent = MNEW_ARR(char, unsent_len), *pos = unsent;
+  for (i = index; i < arr_len; ++i) {
+    extract_string(Array_get_ref_unchecked(arr, i), &msg, &msg_len);
+    const int skip = i == index ? offset : 0;
+    memcpy(pos, msg + skip, msg_len - skip);
+    pos += msg_len - skip;
+  }
+  Object *str =
+      native_background_string_new(task->parent_process, unsent, unsent_len);
+  RELEASE(unsent);
+  return native_background_await(task, sockethandle_fd(sh), REACTOR_WRITABLE,
+                                 entity_object(str));
+}
+
 Entity SocketHandle_send_(Task *task, Context *ctx, Object *obj, Entity *args) {
   SocketHandle *sh = (SocketHandle *)obj->_internal_obj;
   if (NULL == sh) {
@@ -154,21 +209,35 @@ Entity SocketHandle_send_(Task *task, Context *ctx, Object *obj, Entity *args) {
   const bool is_string = extract_string(args, &msg, &msg_len);
 
   if (is_string) {
-    sockethandle_send(sh, msg, msg_len);
+    const int sent = send_available_(sh, msg, msg_len);
+    if (0 == sent && msg_len > 0) {
+      return native_background_await(task, sockethandle_fd(sh),
+                                     REACTOR_WRITABLE, *args);
+    }
+    if (sent < msg_len) {
+      return native_background_await(
+          task, sockethandle_fd(sh), REACTOR_WRITABLE,
+          entity_object(native_background_string_new(
+              task->parent_process, msg + sent, msg_len - sent)));
+    }
     return NONE_ENTITY;
   } else if (IS_CLASS(args, Class_Array)) {
-    Array *arr = args->obj->_internal_obj;
+    Array *arr = object_m(args)->_internal_obj;
     int i, arr_len = Array_size(arr);
+    // Checked up front since whatever is not sent right away is sent later as
+    // one string.
     for (i = 0; i < arr_len; ++i) {
-      char *msg;
-      int msg_len;
-      const bool is_string =
-          extract_string(Array_get_ref_unchecked(arr, i), &msg, &msg_len);
-      if (!is_string) {
+      if (!extract_string(Array_get_ref_unchecked(arr, i), &msg, &msg_len)) {
         return native_background_raise_error(
             task, ctx, "Cannot send non-string at index %d.", i);
       }
-      sockethandle_send(sh, msg, msg_len);
+    }
+    for (i = 0; i < arr_len; ++i) {
+      extract_string(Array_get_ref_unchecked(arr, i), &msg, &msg_len);
+      const int sent = send_available_(sh, msg, msg_len);
+      if (sent < msg_len) {
+        return await_send_(task, sh, arr, i, sent);
+      }
     }
     return NONE_ENTITY;
   } else {
@@ -185,6 +254,10 @@ Entity SocketHandle_receive_(Task *task, Context *ctx, Object *obj,
 
   char buf[BUFFER_SIZE];
   const int32_t chars_received = sockethandle_receive(sh, buf, BUFFER_SIZE);
+  if (chars_received < 0 && socket_would_block()) {
+    return native_background_await(task, sockethandle_fd(sh), REACTOR_READABLE,
+                                   *args);
+  }
   if (chars_received == 0) {
     return NONE_ENTITY;
   }
@@ -25,25 +25,25 @@ void now_timestamp_(FunctionContext *fn_ctx) {
 
 void timestamp_to_micros_(FunctionContext *fn_ctx) {
   Timestamp ts;
-  EXTRACT_TUPLE_ARGS2(tuple, fn_ctx, 7);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.year, fn_ctx, tuple, 0);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.month, fn_ctx, tuple, 1);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.day_of_month, fn_ctx, tuple, 2);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.hour, fn_ctx, tuple, 3);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.minute, fn_ctx, tuple, 4);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.second, fn_ctx, tuple, 5);
-  EXTRACT_INT_AT_INDEX_OR_THROW2(ts.millisecond, fn_ctx, tuple, 6);
+  EXPECT_NUM_ARGS2(fn_ctx, 7);
+  EXTRACT_INT_ARG_OR_THROW2(ts.year, fn_ctx, 0);
+  EXTRACT_INT_ARG_OR_THROW2(ts.month, fn_ctx, 1);
+  EXTRACT_INT_ARG_OR_THROW2(ts.day_of_month, fn_ctx, 2);
+  EXTRACT_INT_ARG_OR_THROW2(ts.hour, fn_ctx, 3);
+  EXTRACT_INT_ARG_OR_THROW2(ts.minute, fn_ctx, 4);
+  EXTRACT_INT_ARG_OR_THROW2(ts.second, fn_ctx, 5);
+  EXTRACT_INT_ARG_OR_THROW2(ts.millisecond, fn_ctx, 6);
   *FunctionContext_mutable_retval(fn_ctx) =
       entity_int(timestamp_to_micros(&ts));
 }
 
 void micros_to_timestamp_(FunctionContext *fn_ctx) {
-  const Entity *args = FunctionContext_args(fn_ctx);
-  if (!IS_INT(args)) {
+  if (1 != FunctionContext_num_args(fn_ctx) ||
+      !IS_INT(FunctionContext_arg(fn_ctx, 0))) {
     FunctionContext_raise_error(fn_ctx, "Expected an int.");
     return;
   }
-  int64_t micros_since_epoch = pint(&args->pri);
+  int64_t micros_since_epoch = eint(FunctionContext_arg(fn_ctx, 0));
   Timestamp ts = micros_to_timestamp(micros_since_epoch);
 
   Object *t_obj = FunctionContext_create_tuple(
@@ -7,6 +7,7 @@
 #define COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_OBJECT_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "c-data-structures/arraylike.h"
@@ -25,12 +26,21 @@ typedef struct Function_ Function;
 typedef struct EntityCopier_ EntityCopier;
 typedef struct Entity_ Entity;
 typedef struct Field_ Field;
+typedef struct ClassTable_ ClassTable;
+typedef struct HeapTracer_ HeapTracer;
+typedef struct ObjectLayout_ ObjectLayout;
 
 typedef void (*ObjDelFn)(Object *);
 typedef void (*ObjInitFn)(Object *);
 // TODO: This should only be temporary until to_s() is supported.
 typedef void (*ObjPrintFn)(const Object *, FILE *);
 typedef void (*ObjCopyFn)(EntityCopier *copier, Object *src, Object *target);
+// Reports the objects referenced by obj outside of its members to the tracing
+// collector with heap_trace().
+typedef void (*ObjTraceFn)(Object *obj, HeapTracer *tracer);
+// Returns the number of bytes allocated for obj->_internal_obj, e.g., the
+// storage of an Array, so that they can be charged to the owning heap.
+typedef size_t (*ObjSizeFn)(const Object *obj);
 
 DEFINE_STABLE_MAPLIKE(EntityMap, char *, Entity);
 DEFINE_STABLE_MAPLIKE(ClassMap, char *, Class);
@@ -39,9 +49,21 @@ DEFINE_STABLE_MAPLIKE(FunctionMap, char *, Function);
 
 // Represents an object with properties.
 struct Object_ {
-  const Node *_node_ref;
+  union {
+    // Used by HEAP_COLLECTOR_REFGRAPH.
+    const Node *_node_ref;
+    // Used by the tracing collectors. Where the object was allocated from, with
+    // the collector's flags in the low bits.
+    uintptr_t _gc_header;
+  };
   const Class *_class;
-  EntityMap _members;  // Member
+  // Fields declared by _class, indexed by their slot in class_layout(_class).
+  // NULL if it declares none.
+  Entity *_slots;
+  // All other members. NULL until the first one is set.
+  EntityMap *_members;
+  // What the heap was last charged for _internal_obj. See heap_update_bytes().
+  size_t _internal_bytes;
 
   // If the object is reflected.
   union {
@@ -68,6 +90,14 @@ struct Class_ {
   ObjDelFn _delete_fn;
   ObjPrintFn _print_fn;
   ObjCopyFn _copy_fn;
+  ObjTraceFn _trace_fn;
+  ObjSizeFn _size_fn;
+  // Inheritance-resolved functions and ancestors. See class_flatten().
+  ClassTable *_table;
+  // Set once the class is part of any ClassTable.
+  uint32_t _is_referenced;
+  // Set when the first instance is created. See class_layout().
+  ObjectLayout *_layout;
 };
 
 struct Module_ {
@@ -100,6 +130,11 @@ struct Function_ {
   bool _is_async;
   bool _is_const;
   bool _is_background;
+  // Number of frame slots used by locals resolved by resolve_locals().
+  uint16_t _num_slots;
+  // Number of times the function has been entered while the JIT is enabled.
+  uint32_t _call_count;
+  void *_jit_code;  // JitCode
   union {
     uint32_t _ins_pos;
     void *_native_fn;   // NativeFn
@@ -111,6 +146,8 @@ typedef struct {
   Object *obj;
   const Function *func;
   void *parent_context;  // To avoid circular dependency.
+  // Keeps parent_context from being freed. NULL if there is none.
+  Object *parent_context_reflection;
 } _FunctionRef;
 
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_OBJECT_H_ */
\ No newline at end of file
@@ -46,6 +46,11 @@ void string_print__(const Object *obj, FILE *out) {
   fprintf(out, "'%*s'", (int)String_size(str), str->table);
 }
 
+size_t string_bytes__(const Object *obj) {
+  const String *str = (String *)obj->_internal_obj;
+  return NULL == str ? 0 : sizeof(String) + String_size(str);
+}
+
 void istring_create__(Object *obj) { obj->_internal_obj = NULL; }
 
 void istring_init__(Object *obj, const char *str, size_t size) {
@@ -69,4 +74,9 @@ void istring_delete__(Object *obj) {
 void istring_print__(const Object *obj, FILE *out) {
   IString *istr = (IString *)obj->_internal_obj;
   fprintf(out, "i'%*s'", istr->len, istr->str);
+}
+
+// The characters are interned, so only the IString itself is charged.
+size_t istring_bytes__(const Object *obj) {
+  return NULL == obj->_internal_obj ? 0 : sizeof(IString);
 }
\ No newline at end of file
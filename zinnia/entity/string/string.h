@@ -18,6 +18,7 @@ void string_create__(Object *obj);
 void string_init__(Object *obj, const char *str, size_t size);
 void string_delete__(Object *obj);
 void string_print__(const Object *obj, FILE *out);
+size_t string_bytes__(const Object *obj);
 
 typedef struct {
   char *str;
@@ -29,5 +30,6 @@ void istring_init__(Object *obj, const char *str, size_t size);
 void istring_init_no_intern__(Object *obj, const char *str, size_t size);
 void istring_delete__(Object *obj);
 void istring_print__(const Object *obj, FILE *out);
+size_t istring_bytes__(const Object *obj);
 
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_ENTITY_STRING_STRING_H_ */
\ No newline at end of file
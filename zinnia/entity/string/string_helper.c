@@ -13,30 +13,33 @@
 Object *string_new(Heap *heap, const char src[], size_t len) {
   Object *str = heap_new(heap, Class_String);
   string_init__(str, src, len);
+  heap_update_bytes(heap, str);
   return str;
 }
 
 Object *istring_new(Heap *heap, const char src[], size_t len) {
   Object *str = heap_new(heap, Class_IString);
   istring_init__(str, src, len);
+  heap_update_bytes(heap, str);
   return str;
 }
 
 Object *istring_new_no_intern(Heap *heap, const char src[], size_t len) {
   Object *str = heap_new(heap, Class_IString);
   istring_init_no_intern__(str, src, len);
+  heap_update_bytes(heap, str);
   return str;
 }
 
 bool extract_string(const Entity *e, char **raw_str, int *len) {
   if (IS_CLASS(e, Class_String)) {
-    const String *str = (String *)e->obj->_internal_obj;
+    const String *str = (String *)object_m(e)->_internal_obj;
     *raw_str = str->table;
     *len = String_size(str);
     return true;
   }
   if (IS_CLASS(e, Class_IString)) {
-    const IString *istr = (IString *)e->obj->_internal_obj;
+    const IString *istr = (IString *)object_m(e)->_internal_obj;
     *raw_str = istr->str;
     *len = istr->len;
     return true;
@@ -66,11 +69,11 @@ bool extract_string_obj(const Object *obj, char **raw_str, int *len) {
 
 const char *intern_entity(const Entity *e) {
   if (IS_CLASS(e, Class_String)) {
-    const String *str = (String *)e->obj->_internal_obj;
+    const String *str = (String *)object_m(e)->_internal_obj;
     return global_intern_range(str->table, 0, String_size(str));
   }
   if (IS_CLASS(e, Class_IString)) {
-    const IString *istr = (IString *)e->obj->_internal_obj;
+    const IString *istr = (IString *)object_m(e)->_internal_obj;
     return istr->str;
   }
   return NULL;
@@ -78,11 +81,11 @@ const char *intern_entity(const Entity *e) {
 
 int entity_string_len(const Entity *e) {
   if (IS_CLASS(e, Class_String)) {
-    const String *str = (String *)e->obj->_internal_obj;
+    const String *str = (String *)object_m(e)->_internal_obj;
     return String_size(str);
   }
   if (IS_CLASS(e, Class_IString)) {
-    const IString *istr = (IString *)e->obj->_internal_obj;
+    const IString *istr = (IString *)object_m(e)->_internal_obj;
     return istr->len;
   }
   return -1;
@@ -21,7 +21,7 @@ struct _Tuple {
 
 void tuple_print(const Tuple *t, FILE *file);
 
-void __tuple_create(Object *obj) {}
+void __tuple_create(Object *obj) { obj->_internal_obj = NULL; }
 
 void __tuple_delete(Object *obj) {
   ASSERT(obj != NULL);
@@ -37,6 +37,12 @@ void __tuple_print(const Object *obj, FILE *out) {
   tuple_print(tuple, out);
 }
 
+size_t __tuple_bytes(const Object *obj) {
+  ASSERT(obj != NULL);
+  const Tuple *tuple = (Tuple *)obj->_internal_obj;
+  return NULL == tuple ? 0 : sizeof(Tuple) + tuple->size * sizeof(Entity);
+}
+
 Tuple *tuple_create(size_t size) {
   Tuple *t = CNEW(Tuple);
   t->size = size;
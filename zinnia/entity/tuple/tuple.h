@@ -16,6 +16,7 @@ typedef struct _Tuple Tuple;
 void __tuple_create(Object *obj);
 void __tuple_delete(Object *obj);
 void __tuple_print(const Object *obj, FILE *out);
+size_t __tuple_bytes(const Object *obj);
 
 Tuple *tuple_create(size_t size);
 Entity *tuple_get_mutable(const Tuple *t, uint32_t index);
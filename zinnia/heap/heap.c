@@ -6,18 +6,75 @@
 #include "zinnia/heap/heap.h"
 
 #include <stdint.h>
+#include <string.h>
 
+#include "c-data-structures/arraylike.h"
+#include "c-data-structures/setlike.h"
 #include "rzalloc/rzalloc.h"
 #include "zinnia/alloc/alloc.h"
 #include "zinnia/entity/array/array.h"
 #include "zinnia/entity/class/classes_def.h"
+#include "zinnia/entity/class/layout.h"
 #include "zinnia/entity/object.h"
 #include "zinnia/entity/string/string.h"
 #include "zinnia/entity/tuple/tuple.h"
+#include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/time.h"
 
 IMPL_MAPLIKE(ObjectTypeCountMap, Class *, int);
 IMPL_MAPLIKE(ObjectCopyMap, Object *, Object *);
 
+DEFINE_ARRAYLIKE(ObjectPtrArray, Object *);
+IMPL_ARRAYLIKE(ObjectPtrArray, Object *);
+DEFINE_MAPLIKE(ObjectPinMap, Object *, uint32_t);
+IMPL_MAPLIKE(ObjectPinMap, Object *, uint32_t);
+DEFINE_SETLIKE(ObjectPtrSet, Object *);
+IMPL_SETLIKE(ObjectPtrSet, Object *);
+
+// Low bits of Object._gc_header. The rest is the owning Heap, or the owning
+// NurseryBlock with HEAP_COLLECTOR_GENERATIONAL.
+#define GC_MARK_BIT ((uintptr_t)1)
+#define GC_ROOT_BIT ((uintptr_t)2)
+#define GC_YOUNG_BIT ((uintptr_t)4)
+#define GC_REMEMBERED_BIT ((uintptr_t)8)
+#define GC_FLAG_BITS \
+  (GC_MARK_BIT | GC_ROOT_BIT | GC_YOUNG_BIT | GC_REMEMBERED_BIT)
+
+// Charged for each entry in a member map: its key and its value.
+#define MEMBER_BYTES (sizeof(char *) + sizeof(Entity))
+
+// Number of objects bump-allocated from each NurseryBlock.
+#define NURSERY_BLOCK_SIZE 256
+// Number of young objects after which a minor collection is due.
+#define NURSERY_OBJECT_COUNT 4096
+// Number of objects allocated after which the next step of an incremental
+// collection is due.
+#define INCREMENTAL_STEP_ALLOCATIONS 1024
+// Number of objects traced or swept between checks of the clock.
+#define INCREMENTAL_CLOCK_INTERVAL 256
+
+typedef enum {
+  GC_PHASE_IDLE,
+  GC_PHASE_MARKING,
+  GC_PHASE_SWEEPING,
+} GcPhase;
+
+typedef struct NurseryBlock_ NurseryBlock;
+
+// Objects are never moved, so survivors of a minor collection are promoted in
+// place and their block can only be reused once all of them are deleted.
+struct NurseryBlock_ {
+  Heap *heap;
+  // Index of the next object to allocate.
+  uint32_t allocated;
+  // Number of allocated objects which have not been deleted.
+  uint32_t live_count;
+  Object objects[NURSERY_BLOCK_SIZE];
+};
+
+DEFINE_ARRAYLIKE(NurseryBlockPtrArray, NurseryBlock *);
+IMPL_ARRAYLIKE(NurseryBlockPtrArray, NurseryBlock *);
+
 uint32_t hash_class_(const Class *cl, uint32_t size) {
   return (uint32_t)(intptr_t)cl;
 }
@@ -36,18 +93,72 @@ int32_t compare_objects_(const Object *ob1, uint32_t size1, const Object *ob2,
   return (intptr_t)ob1 - (intptr_t)ob2;
 }
 
+struct HeapTracer_ {
+  Heap *heap;
+  // Only young objects are marked during a minor collection.
+  bool young_only;
+  // Whether marking is interleaved with running code.
+  bool incremental;
+  // Marked objects whose references have not been traced yet.
+  ObjectPtrArray gray;
+  // Old objects marked during a minor collection, to be unmarked after.
+  ObjectPtrArray scanned_old;
+  // Objects whose references may have changed without the write barrier since
+  // they were traced during incremental marking. They are traced again before
+  // sweeping.
+  ObjectPtrArray rescan;
+};
+
 struct Heap_ {
   HeapConf config;
   MGraph mg;
   RzallocArena object_arena;
   uint32_t object_count_threshold_for_garbage_collection;
+  // See heap_bytes().
+  size_t bytes;
+  size_t bytes_threshold_for_garbage_collection;
+
+  // See heap_set_sampler().
+  HeapSampler sampler;
+  bool is_sampled;
+  uint32_t until_sample;
+
+  // Only used by the tracing collectors.
+  ObjectPtrArray objects;  // Old objects with HEAP_COLLECTOR_GENERATIONAL.
+  ObjectPtrArray roots;
+  // Number of edges from roots to each object. See heap_inc_edge().
+  ObjectPinMap pins;
+  // Objects that other heaps stored references to objects of this heap in
+  // since the last collection. See foreign_inc_edge_().
+  Mutex foreign_lock;
+  ObjectPtrSet foreign_parents;  // Guarded by foreign_lock.
+
+  // Only used by HEAP_COLLECTOR_GENERATIONAL.
+  ObjectPtrArray young;
+  // Old objects given a reference to a young object since the last
+  // collection.
+  ObjectPtrArray remembered;
+  NurseryBlock *nursery;
+  NurseryBlockPtrArray blocks;
+  NurseryBlockPtrArray free_blocks;
+
+  // Only used by incremental collections.
+  GcPhase phase;
+  HeapTracer marker;
+  // While sweeping, objects before sweep_pos have been swept and the
+  // survivors moved to swept. Objects from sweep_end on were allocated after
+  // marking and are kept.
+  ObjectPtrArray swept;
+  size_t sweep_pos;
+  size_t sweep_end;
+  uint32_t allocated_since_step;
 };
 
 struct HeapProfile_ {
   ObjectTypeCountMap object_type_counts;
 };
 
-Object *object_create_(Heap *heap, const Class *class);
+void object_init_(Object *object, const Class *class);
 void object_delete_(Object *object, Heap *heap);
 
 Heap *heap_create(HeapConf *config) {
@@ -57,24 +168,453 @@ Heap *heap_create(HeapConf *config) {
   heap->config = *config;
   heap->object_count_threshold_for_garbage_collection =
       config->max_object_count / 2;
-  mgraph_init(&heap->mg, &heap->config.mgraph_config);
+  heap->bytes = 0;
+  heap->bytes_threshold_for_garbage_collection = config->max_bytes / 2;
+  heap->is_sampled = false;
+  heap->phase = GC_PHASE_IDLE;
+  heap->sweep_pos = 0;
+  heap->sweep_end = 0;
+  heap->allocated_since_step = 0;
+  if (HEAP_COLLECTOR_REFGRAPH == config->collector) {
+    mgraph_init(&heap->mg, &heap->config.mgraph_config);
+  } else {
+    ASSERT(0 == ((uintptr_t)heap & GC_FLAG_BITS));
+    ObjectPtrArray_init(&heap->objects);
+    ObjectPtrArray_init(&heap->roots);
+    ObjectPinMap_init(&heap->pins, hash_object_, compare_objects_);
+    heap->foreign_lock = mutex_create();
+    ObjectPtrSet_init(&heap->foreign_parents, hash_object_, compare_objects_);
+    ObjectPtrArray_init(&heap->young);
+    ObjectPtrArray_init(&heap->remembered);
+    heap->nursery = NULL;
+    NurseryBlockPtrArray_init(&heap->blocks);
+    NurseryBlockPtrArray_init(&heap->free_blocks);
+    heap->marker = (HeapTracer){.heap = heap, .incremental = true};
+    ObjectPtrArray_init(&heap->marker.gray);
+    ObjectPtrArray_init(&heap->marker.scanned_old);
+    ObjectPtrArray_init(&heap->marker.rescan);
+    ObjectPtrArray_init(&heap->swept);
+  }
   arena_init(&heap->object_arena, sizeof(Object));
   return heap;
 }
 
+uint32_t finish_cycle_(Heap *heap);
+
+void delete_all_(Heap *heap, ObjectPtrArray *objects) {
+  const size_t count = ObjectPtrArray_size(objects);
+  for (size_t i = 0; i < count; ++i) {
+    object_delete_(ObjectPtrArray_get_unchecked(objects, i), heap);
+  }
+  ObjectPtrArray_finalize(objects);
+}
+
 void heap_delete(Heap *heap) {
   ASSERT(heap != NULL);
-  mgraph_finalize(&heap->mg);
+  if (HEAP_COLLECTOR_REFGRAPH == heap->config.collector) {
+    mgraph_finalize(&heap->mg);
+  } else {
+    finish_cycle_(heap);
+    delete_all_(heap, &heap->objects);
+    delete_all_(heap, &heap->young);
+    ObjectPtrArray_finalize(&heap->marker.gray);
+    ObjectPtrArray_finalize(&heap->marker.scanned_old);
+    ObjectPtrArray_finalize(&heap->marker.rescan);
+    ObjectPtrArray_finalize(&heap->swept);
+    ObjectPtrArray_finalize(&heap->roots);
+    ObjectPinMap_finalize(&heap->pins);
+    ObjectPtrSet_finalize(&heap->foreign_parents);
+    mutex_close(heap->foreign_lock);
+    ObjectPtrArray_finalize(&heap->remembered);
+    const size_t num_blocks = NurseryBlockPtrArray_size(&heap->blocks);
+    for (size_t i = 0; i < num_blocks; ++i) {
+      RELEASE(NurseryBlockPtrArray_get_unchecked(&heap->blocks, i));
+    }
+    NurseryBlockPtrArray_finalize(&heap->blocks);
+    NurseryBlockPtrArray_finalize(&heap->free_blocks);
+  }
   arena_clear(&heap->object_arena);
   RELEASE(heap);
 }
 
+bool heap_collector_parse(const char name[], HeapCollector *collector) {
+  ASSERT(name != NULL);
+  ASSERT(collector != NULL);
+  if (0 == strcmp("refgraph", name)) {
+    *collector = HEAP_COLLECTOR_REFGRAPH;
+    return true;
+  }
+  if (0 == strcmp("mark_sweep", name)) {
+    *collector = HEAP_COLLECTOR_MARK_SWEEP;
+    return true;
+  }
+  if (0 == strcmp("generational", name)) {
+    *collector = HEAP_COLLECTOR_GENERATIONAL;
+    return true;
+  }
+  return false;
+}
+
+HeapCollector heap_collector(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return heap->config.collector;
+}
+
+bool is_tracing_(const Heap *const heap) {
+  return HEAP_COLLECTOR_REFGRAPH != heap->config.collector;
+}
+
+Heap *owner_(const Heap *const heap, uintptr_t gc_header) {
+  const uintptr_t owner = gc_header & ~GC_FLAG_BITS;
+  return HEAP_COLLECTOR_GENERATIONAL == heap->config.collector
+             ? ((NurseryBlock *)owner)->heap
+             : (Heap *)owner;
+}
+
+void heap_trace(HeapTracer *tracer, Object *obj) {
+  ASSERT(tracer != NULL);
+  ASSERT(obj != NULL);
+  const uintptr_t header = obj->_gc_header;
+  if ((header & GC_MARK_BIT) ||
+      (tracer->young_only && !(header & GC_YOUNG_BIT)) ||
+      owner_(tracer->heap, header) != tracer->heap) {
+    return;
+  }
+  obj->_gc_header = header | GC_MARK_BIT;
+  ObjectPtrArray_push_back(&tracer->gray, obj);
+}
+
+void heap_trace_unbarriered(HeapTracer *tracer, Object *obj) {
+  ASSERT(tracer != NULL);
+  ASSERT(obj != NULL);
+  const uintptr_t header = obj->_gc_header;
+  if (!tracer->young_only || (header & (GC_MARK_BIT | GC_YOUNG_BIT)) ||
+      owner_(tracer->heap, header) != tracer->heap) {
+    heap_trace(tracer, obj);
+    return;
+  }
+  obj->_gc_header = header | GC_MARK_BIT;
+  ObjectPtrArray_push_back(&tracer->scanned_old, obj);
+  ObjectPtrArray_push_back(&tracer->gray, obj);
+}
+
+void heap_trace_entity(HeapTracer *tracer, const Entity *e) {
+  ASSERT(e != NULL);
+  if (OBJECT == etype(e)) {
+    heap_trace(tracer, object_m(e));
+  }
+}
+
+// Tasks, Contexts and Processes change without going through the heap, so the
+// write barrier never sees their references change.
+bool is_unbarriered_(const Object *obj) {
+  return Class_Task == obj->_class || Class_Context == obj->_class ||
+         Class_Process == obj->_class;
+}
+
+void trace_references_(HeapTracer *tracer, Object *obj) {
+  if (tracer->incremental && is_unbarriered_(obj)) {
+    ObjectPtrArray_push_back(&tracer->rescan, obj);
+  }
+  // Catches any change to its size that was never reported.
+  heap_update_bytes(tracer->heap, obj);
+  const uint32_t num_slots = obj->_class->_layout->num_slots;
+  for (uint32_t i = 0; i < num_slots; ++i) {
+    heap_trace_entity(tracer, &obj->_slots[i]);
+  }
+  if (NULL != obj->_members) {
+    EntityMapIterator members;
+    EntityMap_iterator(&members, obj->_members);
+    for (; EntityMap_has_entry(&members); EntityMap_next_entry(&members)) {
+      heap_trace_entity(tracer, EntityMap_value(&members));
+    }
+  }
+  if (NULL != obj->_class->_trace_fn) {
+    obj->_class->_trace_fn(obj, tracer);
+  }
+}
+
+void trace_all_unbarriered_(HeapTracer *tracer, const ObjectPtrArray *objs) {
+  const size_t count = ObjectPtrArray_size(objs);
+  for (size_t i = 0; i < count; ++i) {
+    heap_trace_unbarriered(tracer, ObjectPtrArray_get_unchecked(objs, i));
+  }
+}
+
+void trace_roots_(Heap *heap, HeapTracer *tracer) {
+  trace_all_unbarriered_(tracer, &heap->roots);
+  ObjectPinMapIterator pins;
+  ObjectPinMap_iterator(&pins, &heap->pins);
+  for (; ObjectPinMap_has_entry(&pins); ObjectPinMap_next_entry(&pins)) {
+    if (*ObjectPinMap_value(&pins) > 0) {
+      heap_trace_unbarriered(tracer, ObjectPinMap_key(&pins));
+    }
+  }
+}
+
+// Returns the foreign parents of heap added since this was last called.
+ObjectPtrSet take_foreign_parents_(Heap *heap) {
+  ObjectPtrSet parents;
+  SYNCHRONIZED(heap->foreign_lock, {
+    parents = heap->foreign_parents;
+    ObjectPtrSet_init(&heap->foreign_parents, hash_object_, compare_objects_);
+  });
+  return parents;
+}
+
+// Foreign parents play the part of the remembered set and the write barrier
+// of incremental marking for stores by other heaps. If objects is not NULL,
+// they are added to it.
+void forget_foreign_parents_(Heap *heap, ObjectPtrArray *objects) {
+  ObjectPtrSet parents = take_foreign_parents_(heap);
+  if (NULL != objects) {
+    ObjectPtrSetIterator iter;
+    ObjectPtrSet_iterator(&iter, &parents);
+    for (; ObjectPtrSet_has_next(&iter); ObjectPtrSet_next(&iter)) {
+      ObjectPtrArray_push_back(objects, *ObjectPtrSet_mutable_value(&iter));
+    }
+  }
+  ObjectPtrSet_finalize(&parents);
+}
+
+// Marks everything reachable from the roots. When young_only, old objects are
+// assumed to be live and only the ones that may reference young objects are
+// traced through.
+void mark_(Heap *heap, bool young_only) {
+  HeapTracer tracer = {.heap = heap, .young_only = young_only};
+  ObjectPtrArray_init(&tracer.gray);
+  ObjectPtrArray_init(&tracer.scanned_old);
+  trace_roots_(heap, &tracer);
+  if (young_only) {
+    trace_all_unbarriered_(&tracer, &heap->remembered);
+    ObjectPtrArray foreign_parents;
+    ObjectPtrArray_init(&foreign_parents);
+    forget_foreign_parents_(heap, &foreign_parents);
+    trace_all_unbarriered_(&tracer, &foreign_parents);
+    ObjectPtrArray_finalize(&foreign_parents);
+  } else {
+    // Every object is traced anyway.
+    forget_foreign_parents_(heap, NULL);
+  }
+  while (!ObjectPtrArray_is_empty(&tracer.gray)) {
+    trace_references_(&tracer, ObjectPtrArray_pop_back_unchecked(&tracer.gray));
+  }
+  const size_t num_scanned_old = ObjectPtrArray_size(&tracer.scanned_old);
+  for (size_t i = 0; i < num_scanned_old; ++i) {
+    ObjectPtrArray_get_unchecked(&tracer.scanned_old, i)->_gc_header &=
+        ~GC_MARK_BIT;
+  }
+  ObjectPtrArray_finalize(&tracer.gray);
+  ObjectPtrArray_finalize(&tracer.scanned_old);
+}
+
+void forget_remembered_(Heap *heap) {
+  const size_t count = ObjectPtrArray_size(&heap->remembered);
+  for (size_t i = 0; i < count; ++i) {
+    ObjectPtrArray_get_unchecked(&heap->remembered, i)->_gc_header &=
+        ~GC_REMEMBERED_BIT;
+  }
+  ObjectPtrArray_clear(&heap->remembered);
+}
+
+// Deletes the unmarked objects and moves the rest, unmarked and old, to
+// survivors. Returns the number of objects deleted.
+uint32_t sweep_(Heap *heap, const ObjectPtrArray *objects,
+                ObjectPtrArray *survivors) {
+  uint32_t deleted_count = 0;
+  const size_t count = ObjectPtrArray_size(objects);
+  for (size_t i = 0; i < count; ++i) {
+    Object *obj = ObjectPtrArray_get_unchecked(objects, i);
+    if (obj->_gc_header & GC_MARK_BIT) {
+      obj->_gc_header &= ~(GC_MARK_BIT | GC_YOUNG_BIT);
+      ObjectPtrArray_push_back(survivors, obj);
+    } else {
+      object_delete_(obj, heap);
+      ++deleted_count;
+    }
+  }
+  return deleted_count;
+}
+
+uint32_t collect_all_(Heap *heap) {
+  mark_(heap, /*young_only=*/false);
+  forget_remembered_(heap);
+  ObjectPtrArray live;
+  ObjectPtrArray_init(&live);
+  uint32_t deleted_count = sweep_(heap, &heap->objects, &live);
+  deleted_count += sweep_(heap, &heap->young, &live);
+  ObjectPtrArray_finalize(&heap->objects);
+  heap->objects = live;
+  ObjectPtrArray_clear(&heap->young);
+  return deleted_count;
+}
+
+uint32_t collect_young_(Heap *heap) {
+  mark_(heap, /*young_only=*/true);
+  forget_remembered_(heap);
+  const uint32_t deleted_count = sweep_(heap, &heap->young, &heap->objects);
+  ObjectPtrArray_clear(&heap->young);
+  return deleted_count;
+}
+
+// Returns true once there is nothing left to mark.
+bool mark_until_(Heap *heap, int64_t deadline) {
+  HeapTracer *tracer = &heap->marker;
+  uint32_t traced_count = 0;
+  while (!ObjectPtrArray_is_empty(&tracer->gray)) {
+    trace_references_(tracer, ObjectPtrArray_pop_back_unchecked(&tracer->gray));
+    if (0 == ++traced_count % INCREMENTAL_CLOCK_INTERVAL &&
+        current_monotonic_usec() >= deadline) {
+      return ObjectPtrArray_is_empty(&tracer->gray);
+    }
+  }
+  return true;
+}
+
+// Traces the objects which may have changed without the write barrier again,
+// then sets up sweeping. With HEAP_COLLECTOR_GENERATIONAL, the nursery is swept
+// right away so that everything left is old. Returns the number of objects
+// deleted.
+uint32_t finish_marking_(Heap *heap) {
+  HeapTracer *tracer = &heap->marker;
+  tracer->incremental = false;
+  forget_foreign_parents_(heap, &tracer->rescan);
+  const size_t num_rescan = ObjectPtrArray_size(&tracer->rescan);
+  for (size_t i = 0; i < num_rescan; ++i) {
+    trace_references_(tracer, ObjectPtrArray_get_unchecked(&tracer->rescan, i));
+  }
+  ObjectPtrArray_clear(&tracer->rescan);
+  while (!ObjectPtrArray_is_empty(&tracer->gray)) {
+    trace_references_(tracer, ObjectPtrArray_pop_back_unchecked(&tracer->gray));
+  }
+  tracer->incremental = true;
+  forget_remembered_(heap);
+
+  heap->phase = GC_PHASE_SWEEPING;
+  heap->sweep_pos = 0;
+  heap->sweep_end = ObjectPtrArray_size(&heap->objects);
+  // Promoted objects are added after sweep_end so they are not swept again.
+  const uint32_t deleted_count = sweep_(heap, &heap->young, &heap->objects);
+  ObjectPtrArray_clear(&heap->young);
+  return deleted_count;
+}
+
+uint32_t sweep_until_(Heap *heap, int64_t deadline) {
+  uint32_t deleted_count = 0;
+  while (heap->sweep_pos < heap->sweep_end) {
+    Object *obj = ObjectPtrArray_get_unchecked(&heap->objects, heap->sweep_pos);
+    if (obj->_gc_header & GC_MARK_BIT) {
+      obj->_gc_header &= ~GC_MARK_BIT;
+      ObjectPtrArray_push_back(&heap->swept, obj);
+    } else {
+      object_delete_(obj, heap);
+      ++deleted_count;
+    }
+    if (0 == ++heap->sweep_pos % INCREMENTAL_CLOCK_INTERVAL &&
+        current_monotonic_usec() >= deadline) {
+      return deleted_count;
+    }
+  }
+  const size_t count = ObjectPtrArray_size(&heap->objects);
+  for (size_t i = heap->sweep_end; i < count; ++i) {
+    ObjectPtrArray_push_back(&heap->swept,
+                             ObjectPtrArray_get_unchecked(&heap->objects, i));
+  }
+  ObjectPtrArray_finalize(&heap->objects);
+  heap->objects = heap->swept;
+  ObjectPtrArray_init(&heap->swept);
+  heap->sweep_pos = 0;
+  heap->sweep_end = 0;
+  heap->phase = GC_PHASE_IDLE;
+  return deleted_count;
+}
+
+// Works on the incremental collection until it is done or deadline passes,
+// starting one if none is in progress. Returns the number of objects deleted.
+uint32_t collect_until_(Heap *heap, int64_t deadline) {
+  heap->allocated_since_step = 0;
+  uint32_t deleted_count = 0;
+  if (GC_PHASE_IDLE == heap->phase) {
+    heap->phase = GC_PHASE_MARKING;
+    // Only stores from here on can be missed by marking.
+    forget_foreign_parents_(heap, NULL);
+    trace_roots_(heap, &heap->marker);
+  }
+  if (GC_PHASE_MARKING == heap->phase) {
+    if (!mark_until_(heap, deadline)) {
+      return 0;
+    }
+    deleted_count += finish_marking_(heap);
+  }
+  return deleted_count + sweep_until_(heap, deadline);
+}
+
+uint32_t finish_cycle_(Heap *heap) {
+  if (GC_PHASE_IDLE == heap->phase) {
+    return 0;
+  }
+  return collect_until_(heap, INT64_MAX);
+}
+
 uint32_t heap_collect_garbage(Heap *heap) {
+  if (is_tracing_(heap)) {
+    const uint32_t deleted_count = finish_cycle_(heap);
+    return deleted_count + collect_all_(heap);
+  }
   return mgraph_collect_garbage(&heap->mg);
 }
 
+uint32_t heap_collect_garbage_incrementally(Heap *heap) {
+  ASSERT(heap != NULL);
+  if (!heap_is_incremental(heap)) {
+    return heap_collect_garbage(heap);
+  }
+  return collect_until_(heap,
+                        current_monotonic_usec() + heap->config.max_pause_us);
+}
+
+bool heap_is_incremental(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return is_tracing_(heap) && heap->config.max_pause_us > 0;
+}
+
+bool heap_is_collecting(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return GC_PHASE_IDLE != heap->phase;
+}
+
+uint32_t heap_collect_young_garbage(Heap *heap) {
+  if (HEAP_COLLECTOR_GENERATIONAL != heap->config.collector) {
+    return heap_collect_garbage(heap);
+  }
+  // A minor collection would disturb the marks.
+  if (heap_is_collecting(heap)) {
+    return heap_collect_garbage_incrementally(heap);
+  }
+  return collect_young_(heap);
+}
+
+bool heap_nursery_is_full(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return HEAP_COLLECTOR_GENERATIONAL == heap->config.collector &&
+         ObjectPtrArray_size(&heap->young) >= NURSERY_OBJECT_COUNT;
+}
+
+bool heap_needs_garbage_collection(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  if (heap_is_collecting(heap)) {
+    return heap->allocated_since_step >= INCREMENTAL_STEP_ALLOCATIONS;
+  }
+  return heap_is_over_threshold(heap) || heap_nursery_is_full(heap);
+}
+
 uint32_t heap_object_count(const Heap *const heap) {
   ASSERT(heap != NULL);
+  if (is_tracing_(heap)) {
+    return ObjectPtrArray_size(&heap->swept) +
+           ObjectPtrArray_size(&heap->objects) - heap->sweep_pos +
+           ObjectPtrArray_size(&heap->young);
+  }
   return mgraph_node_count(&heap->mg);
 }
 
@@ -89,36 +629,198 @@ uint32_t heap_object_count_threshold_for_garbage_collection(
   return heap->object_count_threshold_for_garbage_collection;
 }
 
+size_t heap_bytes_threshold_for_garbage_collection(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return heap->bytes_threshold_for_garbage_collection;
+}
+
 void heap_set_object_count_threshold_for_garbage_collection(
     Heap *heap, uint32_t new_threshold) {
   ASSERT(heap != NULL);
   heap->object_count_threshold_for_garbage_collection = new_threshold;
 }
 
+size_t heap_bytes(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return heap->bytes;
+}
+
+void heap_update_bytes(Heap *heap, Object *obj) {
+  ASSERT(heap != NULL);
+  ASSERT(obj != NULL);
+  if (NULL == obj->_class->_size_fn) {
+    return;
+  }
+  const size_t internal_bytes = obj->_class->_size_fn(obj);
+  heap->bytes = heap->bytes - obj->_internal_bytes + internal_bytes;
+  obj->_internal_bytes = internal_bytes;
+}
+
+bool has_max_bytes_(const Heap *const heap) {
+  return heap->config.max_bytes > 0;
+}
+
+bool heap_is_full(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return heap_object_count(heap) >= heap->config.max_object_count ||
+         (has_max_bytes_(heap) && heap->bytes >= heap->config.max_bytes);
+}
+
+bool heap_is_over_threshold(const Heap *const heap) {
+  ASSERT(heap != NULL);
+  return heap_object_count(heap) >=
+             heap->object_count_threshold_for_garbage_collection ||
+         (has_max_bytes_(heap) &&
+          heap->bytes >= heap->bytes_threshold_for_garbage_collection);
+}
+
+void heap_set_sampler(Heap *heap, const HeapSampler *sampler) {
+  ASSERT(heap != NULL);
+  ASSERT(sampler != NULL);
+  ASSERT(sampler->sample_interval > 0);
+  heap->sampler = *sampler;
+  heap->is_sampled = true;
+  heap->until_sample = sampler->sample_interval;
+}
+
+bool heap_raise_thresholds(Heap *heap) {
+  ASSERT(heap != NULL);
+  const uint32_t object_count = heap_object_count(heap);
+  const uint32_t max_object_count = heap->config.max_object_count;
+  if (object_count >= max_object_count) {
+    heap->object_count_threshold_for_garbage_collection = max_object_count;
+  } else if (object_count >=
+             heap->object_count_threshold_for_garbage_collection) {
+    heap->object_count_threshold_for_garbage_collection =
+        (max_object_count + object_count) / 2;
+  }
+  if (has_max_bytes_(heap)) {
+    const size_t max_bytes = heap->config.max_bytes;
+    if (heap->bytes >= max_bytes) {
+      heap->bytes_threshold_for_garbage_collection = max_bytes;
+    } else if (heap->bytes >= heap->bytes_threshold_for_garbage_collection) {
+      heap->bytes_threshold_for_garbage_collection =
+          heap->bytes + (max_bytes - heap->bytes) / 2;
+    }
+  }
+  return heap_is_full(heap);
+}
+
+Object *nursery_alloc_(Heap *heap) {
+  NurseryBlock *block = heap->nursery;
+  if (NULL == block || NURSERY_BLOCK_SIZE == block->allocated) {
+    if (NurseryBlockPtrArray_is_empty(&heap->free_blocks)) {
+      block = MNEW(NurseryBlock);
+      ASSERT(0 == ((uintptr_t)block & GC_FLAG_BITS));
+      block->heap = heap;
+      block->allocated = 0;
+      block->live_count = 0;
+      NurseryBlockPtrArray_push_back(&heap->blocks, block);
+    } else {
+      block = NurseryBlockPtrArray_pop_back_unchecked(&heap->free_blocks);
+    }
+    heap->nursery = block;
+  }
+  ++block->live_count;
+  Object *object = &block->objects[block->allocated++];
+  object->_gc_header = (uintptr_t)block | GC_YOUNG_BIT;
+  return object;
+}
+
+void nursery_free_(Heap *heap, Object *object) {
+  NurseryBlock *block = (NurseryBlock *)(object->_gc_header & ~GC_FLAG_BITS);
+  if (0 != --block->live_count) {
+    return;
+  }
+  block->allocated = 0;
+  if (block != heap->nursery) {
+    NurseryBlockPtrArray_push_back(&heap->free_blocks, block);
+  }
+}
+
 Object *heap_new(Heap *heap, const Class *class) {
   ASSERT(heap != NULL);
   ASSERT(class != NULL);
-  Object *object = object_create_(heap, class);
-  object->_node_ref =
-      mgraph_insert(&heap->mg, object, (MGDeleter)object_delete_);
+  Object *object;
+  switch (heap->config.collector) {
+    case HEAP_COLLECTOR_GENERATIONAL:
+      object = nursery_alloc_(heap);
+      object_init_(object, class);
+      ObjectPtrArray_push_back(&heap->young, object);
+      break;
+    case HEAP_COLLECTOR_MARK_SWEEP:
+      object = (Object *)arena_malloc(&heap->object_arena);
+      object->_gc_header = (uintptr_t)heap;
+      object_init_(object, class);
+      ObjectPtrArray_push_back(&heap->objects, object);
+      break;
+    default:
+      object = (Object *)arena_malloc(&heap->object_arena);
+      object_init_(object, class);
+      object->_node_ref =
+          mgraph_insert(&heap->mg, object, (MGDeleter)object_delete_);
+  }
+  heap->bytes += sizeof(Object) + class->_layout->num_slots * sizeof(Entity);
+  heap_update_bytes(heap, object);
+  ++heap->allocated_since_step;
+  if (GC_PHASE_MARKING == heap->phase) {
+    // Allocated black. Since its references may be set without the write
+    // barrier, it is traced again before sweeping.
+    object->_gc_header |= GC_MARK_BIT;
+    ObjectPtrArray_push_back(&heap->marker.rescan, object);
+  }
+  if (heap->is_sampled && 0 == --heap->until_sample) {
+    heap->until_sample = heap->sampler.sample_interval;
+    heap->sampler.on_sample(heap->sampler.ctx, object);
+  }
   return object;
 }
 
 void heap_make_root(Heap *heap, Object *obj) {
+  if (is_tracing_(heap)) {
+    if (GC_PHASE_MARKING == heap->phase) {
+      heap_trace(&heap->marker, obj);
+    }
+    obj->_gc_header |= GC_ROOT_BIT;
+    ObjectPtrArray_push_back(&heap->roots, obj);
+    return;
+  }
   mgraph_root(&heap->mg, (Node *)obj->_node_ref);
 }
 
+// Returns where the member key of obj is stored, adding it if it is not a
+// field. Sets is_new if it was added.
+Entity *member_ref_(Heap *heap, Object *obj, const char key[],
+                    bool *is_new) {
+  const int32_t slot = layout_slot(obj->_class->_layout, key);
+  if (slot >= 0) {
+    *is_new = UNSET == etype(&obj->_slots[slot]);
+    return &obj->_slots[slot];
+  }
+  if (NULL == obj->_members) {
+    obj->_members = MNEW(EntityMap);
+    EntityMap_init(obj->_members, hash_interned_string,
+                   compare_interned_strings);
+    heap->bytes += sizeof(EntityMap);
+  }
+  Entity *entry_pos;
+  *is_new = EntityMap_insert(obj->_members, key, sizeof(char *), &entry_pos);
+  if (*is_new) {
+    heap->bytes += MEMBER_BYTES;
+  }
+  return entry_pos;
+}
+
 void object_set_member(Heap *heap, Object *parent, const char key[],
                        const Entity *child) {
   ASSERT(heap != NULL);
   ASSERT(parent != NULL);
   ASSERT(child != NULL);
-  Entity *entry_pos;
-  const bool was_insert =
-      EntityMap_insert(&parent->_members, key, sizeof(char *), &entry_pos);
+  bool was_insert;
+  Entity *entry_pos = member_ref_(heap, parent, key, &was_insert);
   ASSERT(entry_pos != NULL);
   const bool old_member_is_obj = !was_insert && OBJECT == etype(entry_pos);
-  if (old_member_is_obj && (entry_pos->obj == child->obj)) {
+  if (old_member_is_obj && (object_m(entry_pos) == object_m(child))) {
     return;
   }
   if (old_member_is_obj) {
@@ -135,35 +837,36 @@ Entity *object_set_member_obj(Heap *heap, Object *parent, const char key[],
   ASSERT(heap != NULL);
   ASSERT(parent != NULL);
   ASSERT(child != NULL);
-  Entity *entry_pos;
-
-  const bool new_insert =
-      EntityMap_insert(&parent->_members, key, sizeof(char *), &entry_pos);
-
+  bool new_insert;
+  Entity *entry_pos = member_ref_(heap, parent, key, &new_insert);
   ASSERT(entry_pos != NULL);
   const bool old_member_is_obj = !new_insert && OBJECT == etype(entry_pos);
-  if (old_member_is_obj && entry_pos->obj == child) {
+  if (old_member_is_obj && object_m(entry_pos) == child) {
     return entry_pos;
   }
   if (old_member_is_obj) {
     heap_dec_edge(heap, parent, object_m(entry_pos));
   }
   heap_inc_edge(heap, parent, (Object *)child);
-  entry_pos->type = OBJECT;
-  entry_pos->obj = (Object *)child;
+  *entry_pos = entity_object((Object *)child);
   return entry_pos;
 }
 
-Object *object_create_(Heap *heap, const Class *class) {
-  ASSERT(heap != NULL);
-  Object *object = (Object *)arena_malloc(&heap->object_arena);
+void object_init_(Object *object, const Class *class) {
   object->_class = class;
-  EntityMap_init(&object->_members, hash_interned_string,
-                 compare_interned_strings);
+  const ObjectLayout *layout = class_layout(class);
+  object->_slots = NULL;
+  if (layout->num_slots > 0) {
+    object->_slots = MNEW_ARR(Entity, layout->num_slots);
+    for (uint32_t i = 0; i < layout->num_slots; ++i) {
+      object->_slots[i] = UNSET_ENTITY;
+    }
+  }
+  object->_members = NULL;
+  object->_internal_bytes = 0;
   if (NULL != class->_init_fn) {
     class->_init_fn(object);
   }
-  return object;
 }
 
 void print_object_summary_(Object *object) {
@@ -210,7 +913,20 @@ void print_object_summary_(Object *object) {
   // fflush(stdout);
 }
 
+void print_all_(const ObjectPtrArray *objects, size_t from) {
+  const size_t count = ObjectPtrArray_size(objects);
+  for (size_t i = from; i < count; ++i) {
+    print_object_summary_(ObjectPtrArray_get_unchecked(objects, i));
+  }
+}
+
 void heap_print_debug_summary(Heap *heap) {
+  if (is_tracing_(heap)) {
+    print_all_(&heap->swept, 0);
+    print_all_(&heap->objects, heap->sweep_pos);
+    print_all_(&heap->young, 0);
+    return;
+  }
   const NodeSet *nodes = mgraph_nodes(&heap->mg);
   NodeSetIterator iter;
   NodeSet_iterator(&iter, nodes);
@@ -224,6 +940,9 @@ void heap_print_debug_summary(Heap *heap) {
 void object_delete_(Object *object, Heap *heap) {
   ASSERT(heap != NULL);
   ASSERT(object != NULL);
+  if (heap->is_sampled) {
+    heap->sampler.on_delete(heap->sampler.ctx, object);
+  }
   // if (object->_class != Class_String && object->_class != Class_IString &&
   //     object->_class != Class_FunctionRef && object->_class != Class_Context
   //     && object->_class != Class_Task && object->_class != Class_Tuple &&
@@ -233,14 +952,114 @@ void object_delete_(Object *object, Heap *heap) {
   if (NULL != object->_class->_delete_fn) {
     object->_class->_delete_fn(object);
   }
-  EntityMap_finalize(&object->_members);
-  arena_free(&heap->object_arena, object);
+  heap->bytes -= sizeof(Object) + object->_internal_bytes;
+  if (NULL != object->_slots) {
+    heap->bytes -= object->_class->_layout->num_slots * sizeof(Entity);
+    RELEASE(object->_slots);
+  }
+  if (NULL != object->_members) {
+    EntityMapIterator members;
+    EntityMap_iterator(&members, object->_members);
+    for (; EntityMap_has_entry(&members); EntityMap_next_entry(&members)) {
+      heap->bytes -= MEMBER_BYTES;
+    }
+    heap->bytes -= sizeof(EntityMap);
+    EntityMap_finalize(object->_members);
+    RELEASE(object->_members);
+  }
+  if (HEAP_COLLECTOR_GENERATIONAL == heap->config.collector) {
+    nursery_free_(heap, object);
+  } else {
+    arena_free(&heap->object_arena, object);
+  }
+}
+
+// Edges from roots which are not members, like the ones from a Process to its
+// Tasks, are the only references the tracer cannot find on its own.
+void pin_(Heap *heap, Object *obj) {
+  const uint32_t pins =
+      ObjectPinMap_find(&heap->pins, obj, sizeof(Object *), 0);
+  ObjectPinMap_insert(&heap->pins, obj, sizeof(Object *), pins + 1);
+}
+
+void unpin_(Heap *heap, Object *obj) {
+  const uint32_t pins =
+      ObjectPinMap_find(&heap->pins, obj, sizeof(Object *), 0);
+  // Members set before the parent became a root were never pinned.
+  if (pins > 0) {
+    ObjectPinMap_insert(&heap->pins, obj, sizeof(Object *), pins - 1);
+  }
+}
+
+// The write barrier. Minor collections only trace through the old objects
+// that were given a reference to a young one since the last collection, so
+// each object serves as its own card.
+void remember_(Heap *heap, Object *parent, const Object *child) {
+  if (HEAP_COLLECTOR_GENERATIONAL != heap->config.collector ||
+      (parent->_gc_header & (GC_YOUNG_BIT | GC_REMEMBERED_BIT)) ||
+      !(child->_gc_header & GC_YOUNG_BIT)) {
+    return;
+  }
+  parent->_gc_header |= GC_REMEMBERED_BIT;
+  ObjectPtrArray_push_back(&heap->remembered, parent);
+}
+
+// The write barrier of incremental marking. A marked object may already have
+// been traced, so anything stored in it is marked too.
+void shade_(Heap *heap, const Object *parent, Object *child) {
+  if (!(parent->_gc_header & GC_MARK_BIT)) {
+    return;
+  }
+  if (GC_PHASE_MARKING == heap->phase) {
+    heap_trace(&heap->marker, child);
+  }
+}
+
+// Stores by heap into objects of another heap, such as module members set by
+// a process other than the one that loaded the module.
+//
+// Only the owner of parent may touch its collector state, so neither barrier
+// can run here. Instead, a child of heap is pinned, since the owner never
+// traces into other heaps, and a child of the owner is handed to it as a
+// foreign parent.
+void foreign_inc_edge_(Heap *heap, Heap *owner, Object *parent,
+                       Object *child) {
+  Heap *child_owner = owner_(heap, child->_gc_header);
+  if (heap == child_owner) {
+    pin_(heap, child);
+    if (GC_PHASE_MARKING == heap->phase) {
+      heap_trace(&heap->marker, child);
+    }
+    return;
+  }
+  // Neither barrier would do anything otherwise.
+  if (owner != child_owner ||
+      (HEAP_COLLECTOR_GENERATIONAL != owner->config.collector &&
+       !heap_is_incremental(owner))) {
+    return;
+  }
+  SYNCHRONIZED(owner->foreign_lock, {
+    ObjectPtrSet_insert(&owner->foreign_parents, parent, sizeof(Object *));
+  });
 }
 
 void heap_inc_edge(Heap *heap, Object *parent, Object *child) {
   ASSERT(heap != NULL);
   ASSERT(parent != NULL);
   ASSERT(child != NULL);
+  if (is_tracing_(heap)) {
+    Heap *owner = owner_(heap, parent->_gc_header);
+    if (heap != owner) {
+      foreign_inc_edge_(heap, owner, parent, child);
+      return;
+    }
+    if (parent->_gc_header & GC_ROOT_BIT) {
+      pin_(heap, child);
+    }
+    remember_(heap, parent, child);
+    shade_(heap, parent, child);
+    return;
+  }
   mgraph_inc(&heap->mg, (Node *)parent->_node_ref, (Node *)child->_node_ref);
 }
 
@@ -248,6 +1067,19 @@ void heap_dec_edge(Heap *heap, Object *parent, Object *child) {
   ASSERT(heap != NULL);
   ASSERT(parent != NULL);
   ASSERT(child != NULL);
+  if (is_tracing_(heap)) {
+    if (heap != owner_(heap, parent->_gc_header)) {
+      // Undoes foreign_inc_edge_().
+      if (heap == owner_(heap, child->_gc_header)) {
+        unpin_(heap, child);
+      }
+      return;
+    }
+    if (parent->_gc_header & GC_ROOT_BIT) {
+      unpin_(heap, child);
+    }
+    return;
+  }
   mgraph_dec(&heap->mg, (Node *)parent->_node_ref, (Node *)child->_node_ref);
 }
 
@@ -257,11 +1089,11 @@ void array_add(Heap *heap, Object *array, const Entity *child) {
   ASSERT(child != NULL);
   Entity *e = Array_push_back_ref((Array *)array->_internal_obj);
   *e = *child;
-  if (OBJECT != child->type) {
+  heap_update_bytes(heap, array);
+  if (OBJECT != etype(child)) {
     return;
   }
-  mgraph_inc(&heap->mg, (Node *)array->_node_ref,
-             (Node *)child->obj->_node_ref);
+  heap_inc_edge(heap, array, object_m(child));
 }
 
 Entity array_remove(Heap *heap, Object *array, int32_t index) {
@@ -269,8 +1101,9 @@ Entity array_remove(Heap *heap, Object *array, int32_t index) {
   ASSERT(array != NULL);
   ASSERT(index >= 0);
   Entity e = Array_remove_unchecked((Array *)array->_internal_obj, index);
-  if (OBJECT == e.type) {
-    heap_dec_edge(heap, array, e.obj);
+  heap_update_bytes(heap, array);
+  if (OBJECT == etype(&e)) {
+    heap_dec_edge(heap, array, object_m(&e));
   }
   return e;
 }
@@ -281,14 +1114,15 @@ void array_set(Heap *heap, Object *array, int32_t index, const Entity *child) {
   ASSERT(child != NULL);
   ASSERT(index >= 0);
   Entity *e = Array_set_ref_unchecked((Array *)array->_internal_obj, index);
-  if (NULL != e && OBJECT == e->type) {
-    heap_dec_edge(heap, array, e->obj);
+  if (NULL != e && OBJECT == etype(e)) {
+    heap_dec_edge(heap, array, object_m(e));
   }
   *e = *child;
-  if (OBJECT != child->type) {
+  heap_update_bytes(heap, array);
+  if (OBJECT != etype(child)) {
     return;
   }
-  heap_inc_edge(heap, array, child->obj);
+  heap_inc_edge(heap, array, object_m(child));
 }
 
 Object *array_create(Heap *heap) { return heap_new(heap, Class_Array); }
@@ -303,29 +1137,28 @@ void tuple_set(Heap *heap, Object *tuple, int32_t index, const Entity *child) {
   ASSERT(index < tuple_size((Tuple *)tuple->_internal_obj));
   Entity *e = tuple_get_mutable((Tuple *)tuple->_internal_obj, index);
   *e = *child;
-  if (OBJECT != child->type) {
+  if (OBJECT != etype(child)) {
     return;
   }
-  heap_inc_edge(heap, tuple, child->obj);
+  heap_inc_edge(heap, tuple, object_m(child));
 }
 
 Object *tuple_create_empty(Heap *heap, size_t size) {
   Object *tuple_obj = heap_new(heap, Class_Tuple);
   tuple_obj->_internal_obj = tuple_create(size);
+  heap_update_bytes(heap, tuple_obj);
   return tuple_obj;
 }
 
 Object *tuple_create2(Heap *heap, Entity *e1, Entity *e2) {
-  Object *tuple_obj = heap_new(heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(2);
+  Object *tuple_obj = tuple_create_empty(heap, 2);
   tuple_set(heap, tuple_obj, 0, e1);
   tuple_set(heap, tuple_obj, 1, e2);
   return tuple_obj;
 }
 
 Object *tuple_create3(Heap *heap, Entity *e1, Entity *e2, Entity *e3) {
-  Object *tuple_obj = heap_new(heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(3);
+  Object *tuple_obj = tuple_create_empty(heap, 3);
   tuple_set(heap, tuple_obj, 0, e1);
   tuple_set(heap, tuple_obj, 1, e2);
   tuple_set(heap, tuple_obj, 2, e3);
@@ -334,8 +1167,7 @@ Object *tuple_create3(Heap *heap, Entity *e1, Entity *e2, Entity *e3) {
 
 Object *tuple_create4(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
                       Entity *e4) {
-  Object *tuple_obj = heap_new(heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(4);
+  Object *tuple_obj = tuple_create_empty(heap, 4);
   tuple_set(heap, tuple_obj, 0, e1);
   tuple_set(heap, tuple_obj, 1, e2);
   tuple_set(heap, tuple_obj, 2, e3);
@@ -345,8 +1177,7 @@ Object *tuple_create4(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
 
 Object *tuple_create5(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
                       Entity *e4, Entity *e5) {
-  Object *tuple_obj = heap_new(heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(5);
+  Object *tuple_obj = tuple_create_empty(heap, 5);
   tuple_set(heap, tuple_obj, 0, e1);
   tuple_set(heap, tuple_obj, 1, e2);
   tuple_set(heap, tuple_obj, 2, e3);
@@ -357,8 +1188,7 @@ Object *tuple_create5(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
 
 Object *tuple_create6(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
                       Entity *e4, Entity *e5, Entity *e6) {
-  Object *tuple_obj = heap_new(heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(6);
+  Object *tuple_obj = tuple_create_empty(heap, 6);
   tuple_set(heap, tuple_obj, 0, e1);
   tuple_set(heap, tuple_obj, 1, e2);
   tuple_set(heap, tuple_obj, 2, e3);
@@ -370,8 +1200,7 @@ Object *tuple_create6(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
 
 Object *tuple_create7(Heap *heap, Entity *e1, Entity *e2, Entity *e3,
                       Entity *e4, Entity *e5, Entity *e6, Entity *e7) {
-  Object *tuple_obj = heap_new(heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(7);
+  Object *tuple_obj = tuple_create_empty(heap, 7);
   tuple_set(heap, tuple_obj, 0, e1);
   tuple_set(heap, tuple_obj, 1, e2);
   tuple_set(heap, tuple_obj, 2, e3);
@@ -398,14 +1227,14 @@ Entity entitycopier_copy(EntityCopier *copier, const Entity *e) {
   ASSERT(copier != NULL);
   ASSERT(e != NULL);
   ASSERT(e != NULL);
-  switch (e->type) {
+  switch (etype(e)) {
     case NONE:
     case PRIMITIVE:
       return *e;
     default:
-      ASSERT(OBJECT == e->type);
+      ASSERT(OBJECT == etype(e));
   }
-  Object *obj = e->obj;
+  Object *obj = object_m(e);
   // Guarantee only one copied version of each object.
   Object *cpy =
       ObjectCopyMap_find(&copier->copy_map, obj, sizeof(Object *), NULL);
@@ -425,10 +1254,22 @@ Entity entitycopier_copy(EntityCopier *copier, const Entity *e) {
 
   if (NULL != obj->_class->_copy_fn) {
     obj->_class->_copy_fn(copier, obj, cpy);
+    heap_update_bytes(copier->target, cpy);
   }
 
+  const ObjectLayout *layout = obj->_class->_layout;
+  for (uint32_t i = 0; i < layout->num_slots; ++i) {
+    if (UNSET == etype(&obj->_slots[i])) {
+      continue;
+    }
+    Entity member_cpy = entitycopier_copy(copier, &obj->_slots[i]);
+    object_set_member(copier->target, cpy, layout->names[i], &member_cpy);
+  }
+  if (NULL == obj->_members) {
+    return entity_object(cpy);
+  }
   EntityMapIterator members;
-  EntityMap_iterator(&members, &obj->_members);
+  EntityMap_iterator(&members, obj->_members);
   for (; EntityMap_has_entry(&members); EntityMap_next_entry(&members)) {
     Entity member_cpy = entitycopier_copy(copier, EntityMap_value(&members));
     object_set_member(copier->target, cpy, EntityMap_key(&members),
@@ -455,20 +1296,37 @@ void heapprofile_delete(HeapProfile *hp) {
   RELEASE(hp);
 }
 
+void count_object_(HeapProfile *hp, const Object *obj) {
+  const int existing = ObjectTypeCountMap_find(
+      &hp->object_type_counts, obj->_class, sizeof(Class *), 0);
+  ObjectTypeCountMap_insert(&hp->object_type_counts, obj->_class,
+                            sizeof(Class *), existing + 1);
+}
+
+void count_all_(HeapProfile *hp, const ObjectPtrArray *objects,
+                size_t from) {
+  const size_t count = ObjectPtrArray_size(objects);
+  for (size_t i = from; i < count; ++i) {
+    count_object_(hp, ObjectPtrArray_get_unchecked(objects, i));
+  }
+}
+
 HeapProfile *heap_create_profile(const Heap *const heap) {
   HeapProfile *hp = MNEW(HeapProfile);
   ObjectTypeCountMap_init(&hp->object_type_counts, hash_class_,
                           compare_classes_);
+  if (is_tracing_(heap)) {
+    count_all_(hp, &heap->swept, 0);
+    count_all_(hp, &heap->objects, heap->sweep_pos);
+    count_all_(hp, &heap->young, 0);
+    return hp;
+  }
   const NodeSet *nodes = mgraph_nodes(&heap->mg);
   NodeSetIterator iter;
   NodeSet_iterator(&iter, nodes);
   for (; NodeSet_has_next(&iter); NodeSet_next(&iter)) {
     const Node *node = *NodeSet_value(&iter);
-    const Object *obj = (const Object *)node_ptr(node);
-    const int existing = ObjectTypeCountMap_find(
-        &hp->object_type_counts, obj->_class, sizeof(Class *), 0);
-    ObjectTypeCountMap_insert(&hp->object_type_counts, obj->_class,
-                              sizeof(Class *), existing + 1);
+    count_object_(hp, (const Object *)node_ptr(node));
   }
   return hp;
 }
\ No newline at end of file
@@ -6,6 +6,27 @@
 // A memory-allocating heap for allocating new objects and deleting them once
 // they are no longer referenced.
 //
+// Two collectors are available:
+//   * HEAP_COLLECTOR_REFGRAPH wraps MGraph, which keeps an edge for every
+//     reference between objects and deletes the objects that are no longer
+//     reachable from a root.
+//   * HEAP_COLLECTOR_MARK_SWEEP keeps no edges. Storing a reference is a plain
+//     write, and heap_collect_garbage() instead traces every object reachable
+//     from the roots through its members and its class's _trace_fn, then
+//     deletes the rest.
+//   * HEAP_COLLECTOR_GENERATIONAL is HEAP_COLLECTOR_MARK_SWEEP with a nursery.
+//     New objects are bump-allocated and heap_collect_young_garbage() only
+//     traces the young ones, promoting the survivors in place. Storing a
+//     reference to a young object in an old one records the old one so that
+//     minor collections can find it.
+//
+// With either tracing collector, a pause budget (HeapConf.max_pause_us) makes
+// full collections incremental. heap_collect_garbage_incrementally() marks
+// (tri-color, with storing a reference into a marked object shading the
+// target) and then sweeps in slices of at most that long. Objects allocated
+// and Tasks and Contexts changed during marking are traced again before
+// sweeping starts. No minor collections happen while one is in progress.
+//
 // NOTE: Heap is NOT threadsafe. Heap wraps MGraph, which is not threadsafe and
 // provides no additional thread safety. To safely pass objects between a source
 // and target heaps, the following must occur in the specified order:
@@ -27,17 +48,53 @@ DEFINE_MAPLIKE(ObjectCopyMap, Object *, Object *);
 
 typedef struct Heap_ Heap;
 
+typedef enum {
+  HEAP_COLLECTOR_REFGRAPH,
+  HEAP_COLLECTOR_MARK_SWEEP,
+  HEAP_COLLECTOR_GENERATIONAL,
+} HeapCollector;
+
 typedef struct {
+  HeapCollector collector;
   MGraphConf mgraph_config;
   uint32_t max_object_count;
+  // Most bytes the objects in the heap may take up, including everything they
+  // own, or 0 for no limit. See heap_bytes().
+  size_t max_bytes;
+  // Longest a single step of an incremental collection should take, or 0 to
+  // always collect in one go. Only used by the tracing collectors.
+  uint32_t max_pause_us;
 } HeapConf;
 
+// Parses "refgraph", "mark_sweep" or "generational" into collector. Returns
+// false if name is not a known collector.
+bool heap_collector_parse(const char name[], HeapCollector *collector);
+
 Heap *heap_create(HeapConf *config);
 void heap_delete(Heap *heap);
 
 Object *heap_new(Heap *heap, const Class *class);
 
+// Finishes any incremental collection in progress before collecting.
 uint32_t heap_collect_garbage(Heap *heap);
+// Does at most HeapConf.max_pause_us of work on an incremental collection,
+// starting one if none is in progress. Returns the number of objects deleted
+// by this step. The same as heap_collect_garbage() without a pause budget.
+uint32_t heap_collect_garbage_incrementally(Heap *heap);
+// Whether collections are incremental. See HeapConf.max_pause_us.
+bool heap_is_incremental(const Heap *const heap);
+// Whether an incremental collection has been started and not yet finished.
+bool heap_is_collecting(const Heap *const heap);
+// Collects only the nursery with HEAP_COLLECTOR_GENERATIONAL. Otherwise the
+// same as heap_collect_garbage().
+uint32_t heap_collect_young_garbage(Heap *heap);
+// Whether enough objects have been allocated since the last collection for a
+// minor collection to be due. Always false without a nursery.
+bool heap_nursery_is_full(const Heap *const heap);
+// Whether either a full or a minor collection is due, or enough has been
+// allocated since the last step of an incremental collection for the next one.
+// Cheap enough to be polled by the interpreter.
+bool heap_needs_garbage_collection(const Heap *const heap);
 void heap_print_debug_summary(Heap *heap);
 uint32_t heap_object_count(const Heap *const heap);
 uint32_t heap_max_object_count(const Heap *const heap);
@@ -45,11 +102,54 @@ uint32_t heap_object_count_threshold_for_garbage_collection(
     const Heap *const heap);
 void heap_set_object_count_threshold_for_garbage_collection(
     Heap *heap, uint32_t new_threshold);
+size_t heap_bytes_threshold_for_garbage_collection(const Heap *const heap);
+// Bytes taken up by the objects in the heap: the objects themselves, their
+// members and whatever their classes' _size_fn reports for them.
+size_t heap_bytes(const Heap *const heap);
+// Charges the heap for the current size of obj->_internal_obj. Must be called
+// after it is created, grows or shrinks outside of the functions in this file.
+// The tracing collectors also do this for every object they mark.
+void heap_update_bytes(Heap *heap, Object *obj);
+// Whether the heap has reached either its max object count or its max bytes.
+bool heap_is_full(const Heap *const heap);
+// Whether a full collection is due based on the object count or bytes.
+bool heap_is_over_threshold(const Heap *const heap);
+// Called after a full collection. Moves any threshold the heap is still over
+// halfway towards the corresponding limit. Returns heap_is_full().
+bool heap_raise_thresholds(Heap *heap);
+
+// Observes a sample of the objects created by a heap, e.g., to profile them.
+typedef struct {
+  // Called with every sample_interval-th new object right after it is created.
+  void (*on_sample)(void *ctx, Object *obj);
+  // Called with every object the heap deletes right before it is deleted.
+  void (*on_delete)(void *ctx, Object *obj);
+  void *ctx;
+  uint32_t sample_interval;
+} HeapSampler;
+
+// Starts reporting to sampler.
+void heap_set_sampler(Heap *heap, const HeapSampler *sampler);
+
 void heap_make_root(Heap *heap, Object *obj);
+HeapCollector heap_collector(const Heap *const heap);
 
+// With the tracing collectors, these only keep child alive while the edge
+// exists when parent is a root. heap_inc_edge() is also the write barrier.
 void heap_inc_edge(Heap *heap, Object *parent, Object *child);
 void heap_dec_edge(Heap *heap, Object *parent, Object *child);
 
+// Marks obj as reachable during a tracing collection. Objects that belong to a
+// different heap are ignored.
+//
+// Should only be called from an ObjTraceFn.
+void heap_trace(HeapTracer *tracer, Object *obj);
+// Like heap_trace(), but for objects whose references change without going
+// through the heap, like Tasks and Contexts. These are traced through by minor
+// collections even when they are old.
+void heap_trace_unbarriered(HeapTracer *tracer, Object *obj);
+void heap_trace_entity(HeapTracer *tracer, const Entity *e);
+
 void object_set_member(Heap *heap, Object *parent, const char key[],
                        const Entity *child);
 Entity *object_set_member_obj(Heap *heap, Object *parent, const char key[],
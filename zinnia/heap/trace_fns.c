@@ -0,0 +1,31 @@
+// trace_fns.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/heap/trace_fns.h"
+
+#include "zinnia/entity/array/array.h"
+#include "zinnia/entity/entity.h"
+#include "zinnia/entity/object.h"
+#include "zinnia/entity/tuple/tuple.h"
+#include "zinnia/heap/heap.h"
+
+void array_trace(Object *obj, HeapTracer *tracer) {
+  Array *array = (Array *)obj->_internal_obj;
+  const size_t size = Array_size(array);
+  for (size_t i = 0; i < size; ++i) {
+    heap_trace_entity(tracer, Array_get_ref_unchecked(array, i));
+  }
+}
+
+void tuple_trace(Object *obj, HeapTracer *tracer) {
+  Tuple *tuple = (Tuple *)obj->_internal_obj;
+  if (NULL == tuple) {
+    return;
+  }
+  const size_t size = tuple_size(tuple);
+  for (size_t i = 0; i < size; ++i) {
+    heap_trace_entity(tracer, tuple_get(tuple, i));
+  }
+}
@@ -0,0 +1,15 @@
+// trace_fns.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_HEAP_TRACE_FNS_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_HEAP_TRACE_FNS_H_
+
+#include "zinnia/entity/object.h"
+#include "zinnia/heap/heap.h"
+
+void array_trace(Object *obj, HeapTracer *tracer);
+void tuple_trace(Object *obj, HeapTracer *tracer);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_HEAP_TRACE_FNS_H_ */
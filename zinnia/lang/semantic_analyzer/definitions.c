@@ -392,6 +392,22 @@ POPULATE_IMPL(postfix_expression, const SyntaxTree *stree,
   postfix_helper(analyzer, suffix, &postfix_expression->suffixes);
 }
 
+// Produces the arguments of a function call. Multiple arguments are left on the
+// stack for the callee instead of being collected into a tuple.
+int produce_call_arguments_(SemanticAnalyzer *analyzer, ExpressionTree *args,
+                            Tape *tape) {
+  if (!IS_EXPRESSION(args, tuple_expression)) {
+    return semantic_analyzer_produce(analyzer, args, tape);
+  }
+  Expression_tuple_expression *tuple_expression =
+      EXTRACT_EXPRESSION(args, tuple_expression);
+  int num_ins = tuple_expression_helper(analyzer, tuple_expression, tape);
+  num_ins += tape_ins_int(tape, ARGS,
+                          ExpressionTreeArray_size(&tuple_expression->list),
+                          tuple_expression->token);
+  return num_ins;
+}
+
 int produce_postfix(SemanticAnalyzer *analyzer, int *i, int num_postfix,
                     const PostfixArray *suffixes, const Postfix **next,
                     Tape *tape) {
@@ -403,7 +419,7 @@ int produce_postfix(SemanticAnalyzer *analyzer, int *i, int num_postfix,
   if (cur->type == Postfix_fncall) {
     num_ins += tape_ins_no_arg(tape, PUSH, cur->token);
     if (cur->exp != NULL) {
-      num_ins += semantic_analyzer_produce(analyzer, cur->exp, tape);
+      num_ins += produce_call_arguments_(analyzer, cur->exp, tape);
     }
     num_ins +=
         tape_ins_no_arg(tape, (NULL == cur->exp) ? CLLN : CALL, cur->token);
@@ -416,7 +432,7 @@ int produce_postfix(SemanticAnalyzer *analyzer, int *i, int num_postfix,
     if (NULL != *next && (*next)->type == Postfix_fncall) {
       num_ins += tape_ins_no_arg(tape, PUSH, cur->token);
       num_ins += ((*next)->exp != NULL
-                      ? semantic_analyzer_produce(analyzer, (*next)->exp, tape)
+                      ? produce_call_arguments_(analyzer, (*next)->exp, tape)
                       : 0);
       num_ins += tape_ins(tape, (NULL == (*next)->exp) ? CLLN : CALL, cur->id);
       // Advance past the function call since we have already handled it.
@@ -433,14 +449,39 @@ int produce_postfix(SemanticAnalyzer *analyzer, int *i, int num_postfix,
   return num_ins;
 }
 
+// Whether prefix is a variable name being called.
+bool is_scoped_call_(const ExpressionTree *prefix, const Postfix *first) {
+  if (!IS_EXPRESSION(prefix, identifier) || Postfix_fncall != first->type) {
+    return false;
+  }
+  const char *id = EXTRACT_EXPRESSION(prefix, identifier)->id->text;
+  return TRUE_KEYWORD != id && FALSE_KEYWORD != id && NIL_KEYWORD != id;
+}
+
 PRODUCE_IMPL(postfix_expression, SemanticAnalyzer *analyzer, Tape *target) {
-  int i, num_ins = 0,
-         num_postfix = PostfixArray_size(&postfix_expression->suffixes);
-  num_ins +=
-      semantic_analyzer_produce(analyzer, postfix_expression->prefix, target);
+  int i = 0, num_ins = 0,
+      num_postfix = PostfixArray_size(&postfix_expression->suffixes);
   const Postfix *next =
       PostfixArray_get_ref_unchecked(&postfix_expression->suffixes, 0);
-  for (i = 0; i < num_postfix; ++i) {
+  if (is_scoped_call_(postfix_expression->prefix, next)) {
+    // Looks up and calls the function in one step so methods of self can be
+    // called without binding them to self.
+    const Token *id =
+        EXTRACT_EXPRESSION(postfix_expression->prefix, identifier)->id;
+    if (NULL != next->exp) {
+      num_ins += produce_call_arguments_(analyzer, next->exp, target);
+    }
+    num_ins += tape_ins(target, (NULL == next->exp) ? SCLN : SCLL, id);
+    i = 1;
+    next = (1 == num_postfix)
+               ? NULL
+               : PostfixArray_get_ref_unchecked(&postfix_expression->suffixes,
+                                                1);
+  } else {
+    num_ins +=
+        semantic_analyzer_produce(analyzer, postfix_expression->prefix, target);
+  }
+  for (; i < num_postfix; ++i) {
     if (NULL == next) {
       break;
     }
@@ -1195,6 +1236,21 @@ int produce_all_arguments(SemanticAnalyzer *analyzer, const Arguments *args,
   return num_ins;
 }
 
+// Whether the arguments can be passed on the stack by the caller, which
+// requires binding them in order with no defaults.
+bool takes_stack_arguments_(const Arguments *args) {
+  int i, num_args = ArgumentArray_size(&args->args);
+  if (args->is_named || num_args < 2) {
+    return false;
+  }
+  for (i = 0; i < num_args; ++i) {
+    if (ArgumentArray_get_ref_unchecked(&args->args, i)->has_default) {
+      return false;
+    }
+  }
+  return true;
+}
+
 int produce_arguments(SemanticAnalyzer *analyzer, const Arguments *args,
                       Tape *tape) {
   if (args->is_named) {
@@ -1224,6 +1280,17 @@ int produce_arguments(SemanticAnalyzer *analyzer, const Arguments *args,
     num_ins += produce_argument(arg, tape);
     return num_ins;
   }
+  if (takes_stack_arguments_(args)) {
+    // PARM must be the first instruction since callers that pass the arguments
+    // on the stack skip it.
+    num_ins += tape_ins_int(tape, PARM, num_args, args->token);
+    for (i = 0; i < num_args; ++i) {
+      const Argument *arg = ArgumentArray_get_ref_unchecked(&args->args, i);
+      num_ins += tape_ins_no_arg(tape, RES, arg->arg_name);
+      num_ins += produce_argument(arg, tape);
+    }
+    return num_ins;
+  }
   num_ins += tape_ins_no_arg(tape, PUSH, args->token);
 
   // Handle case where only 1 arg is passed and the rest are optional.
@@ -62,12 +62,12 @@ PRODUCE_IMPL(foreach_statement, SemanticAnalyzer *analyzer, Tape *target) {
       continue;
     }
     // break
-    if (pint(&ins->val) == 0) {
-      pset_int(&ins->val, body_ins - i);
+    if (ins->int_val == 0) {
+      ins->int_val = body_ins - i;
     }
     // continue
-    else if (pint(&ins->val) == INT_MAX) {
-      pset_int(&ins->val, body_ins - i - 1);
+    else if (ins->int_val == INT_MAX) {
+      ins->int_val = body_ins - i - 1;
     }
   }
 
@@ -126,12 +126,12 @@ PRODUCE_IMPL(for_statement, SemanticAnalyzer *analyzer, Tape *target) {
       continue;
     }
     // break
-    if (pint(&ins->val) == 0) {
-      pset_int(&ins->val, body_ins + inc_ins - i);
+    if (ins->int_val == 0) {
+      ins->int_val = body_ins + inc_ins - i;
     }
     // continue
-    else if (pint(&ins->val) == INT_MAX) {
-      pset_int(&ins->val, body_ins - i - 1);
+    else if (ins->int_val == INT_MAX) {
+      ins->int_val = body_ins - i - 1;
     }
   }
   num_ins += body_ins + inc_ins;
@@ -179,10 +179,10 @@ PRODUCE_IMPL(while_statement, SemanticAnalyzer *analyzer, Tape *target) {
     if (ins->op != JMP) {
       continue;
     }
-    if (pint(&ins->val) == 0) {
-      pset_int(&ins->val, lines_for_body - i);
-    } else if (pint(&ins->val) == INT_MAX) {
-      pset_int(&ins->val, -(i + 1));
+    if (ins->int_val == 0) {
+      ins->int_val = lines_for_body - i;
+    } else if (ins->int_val == INT_MAX) {
+      ins->int_val = -(i + 1);
     }
   }
 
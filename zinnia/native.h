@@ -20,7 +20,7 @@
                                 num_args);                                  \
     return;                                                                 \
   }                                                                         \
-  const Tuple *var = (Tuple *)args->obj->_internal_obj;                     \
+  const Tuple *var = (Tuple *)object_m(args)->_internal_obj;                \
   if (tuple_size(var) != num_args) {                                        \
     FunctionContext_raise_error(fn_ctx,                                     \
                                 "Expects tuple(%d) but received tuple(%d)", \
@@ -28,13 +28,31 @@
     return;                                                                 \
   }
 
+// Same as EXTRACT_TUPLE_ARGS2, without requiring the arguments to be packed
+// into a Tuple. Read them with the EXTRACT_*_ARG_OR_THROW2 macros.
+#define EXPECT_NUM_ARGS2(fn_ctx, num_args)                                     \
+  if (FunctionContext_num_args(fn_ctx) != num_args) {                          \
+    FunctionContext_raise_error(fn_ctx,                                        \
+                                "Expects tuple(%d) but received tuple(%d)",    \
+                                num_args, FunctionContext_num_args(fn_ctx));   \
+    return;                                                                    \
+  }
+
+#define EXTRACT_INT_ARG_OR_THROW2(var, fn_ctx, index)                 \
+  if (!IS_INT(FunctionContext_arg(fn_ctx, index))) {                  \
+    FunctionContext_raise_error(                                      \
+        fn_ctx, "Expected argument at index %d to be an Int", index); \
+    return;                                                           \
+  }                                                                   \
+  var = eint_of(FunctionContext_arg(fn_ctx, index));
+
 #define EXTRACT_INT_AT_INDEX_OR_THROW2(var, fn_ctx, tuple, index)     \
   if (!IS_INT(tuple_get(tuple, index))) {                             \
     FunctionContext_raise_error(                                      \
         fn_ctx, "Expected argument at index %d to be an Int", index); \
     return;                                                           \
   }                                                                   \
-  var = int_of(&tuple_get(tuple, index)->pri);
+  var = eint_of(tuple_get(tuple, index));
 
 #define EXTRACT_FLOAT_AT_INDEX_OR_THROW2(var, fn_ctx, tuple, index)     \
   if (!IS_FLOAT(tuple_get(tuple, index))) {                             \
@@ -42,7 +60,7 @@
         fn_ctx, "Expected argument at index %d to be an Float", index); \
     return;                                                             \
   }                                                                     \
-  var = float_of(&tuple_get(tuple, index)->pri);
+  var = efloat_of(tuple_get(tuple, index));
 
 #define EXTRACT_BOOL_AT_INDEX_OR_THROW2(var, fn_ctx, tuple, index)     \
   if (!IS_BOOL(tuple_get(tuple, index))) {                             \
@@ -50,7 +68,7 @@
         fn_ctx, "Expected argument at index %d to be an Bool", index); \
     return;                                                            \
   }                                                                    \
-  var = bool_of(&tuple_get(tuple, index)->pri);
+  var = ebool_of(tuple_get(tuple, index));
 
 #define EXCTRACT_STRING_OR_THROW2(str, str_len, fn_ctx, entity) \
   char *str;                                                    \
@@ -14,6 +14,7 @@
 #define INT_FMT "%" PRId64
 #define FLT_FMT "%f"
 #define OP_NO_ARG_FMT "%s"
+#define SLOT_FMT "%s@%" PRIu16
 
 IMPL_ARRAYLIKE(InstructionArray, Instruction);
 
@@ -43,6 +44,11 @@ int instruction_write(const Instruction *ins, FILE *file, bool minimize) {
       return num;
     case INSTRUCTION_PRIMITIVE:
       return chars_written + _instruction_write_primitive(ins, file, minimize);
+    case INSTRUCTION_SLOT:
+      return chars_written +
+             fprintf(file, OP_FMT(minimize), op_to_str(ins->op)) +
+             fprintf(file, SLOT_FMT, ins->id == NULL ? "" : ins->id,
+                     ins->local.index);
     default:
       FATALF("Unknown instruction type.");
       return -1;
@@ -52,13 +58,44 @@ int instruction_write(const Instruction *ins, FILE *file, bool minimize) {
 int _instruction_write_primitive(const Instruction *ins, FILE *file,
                                  bool minimize) {
   int chars_written = fprintf(file, OP_FMT(minimize), op_to_str(ins->op));
-  switch (ptype(&ins->val)) {
+  switch (ins->val_type) {
     case PRIMITIVE_INT:
-      return chars_written + fprintf(file, INT_FMT, pint(&ins->val));
+      return chars_written + fprintf(file, INT_FMT, ins->int_val);
     case PRIMITIVE_FLOAT:
-      return chars_written + fprintf(file, FLT_FMT, pfloat(&ins->val));
+      return chars_written + fprintf(file, FLT_FMT, ins->float_val);
     default:
       FATALF("Unkown primitive instruction.");
       return -1;
   }
+}
+
+Primitive instruction_primitive(const Instruction *ins) {
+  switch (ins->val_type) {
+    case PRIMITIVE_BOOL:
+      return primitive_bool(0 != ins->int_val);
+    case PRIMITIVE_CHAR:
+      return primitive_char((int8_t)ins->int_val);
+    case PRIMITIVE_INT:
+      return primitive_int(ins->int_val);
+    default:
+      return primitive_float(ins->float_val);
+  }
+}
+
+void instruction_set_primitive(Instruction *ins, Primitive val) {
+  ins->val_type = (uint8_t)ptype(&val);
+  switch (ptype(&val)) {
+    case PRIMITIVE_BOOL:
+      ins->int_val = pbool(&val);
+      break;
+    case PRIMITIVE_CHAR:
+      ins->int_val = pchar(&val);
+      break;
+    case PRIMITIVE_INT:
+      ins->int_val = pint(&val);
+      break;
+    default:
+      ins->float_val = pfloat(&val);
+      break;
+  }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_PROGRAM_INSTRUCTION_H_
 #define COM_GITHUB_JEFFMANZIONE_ZINNIA_PROGRAM_INSTRUCTION_H_
 
+#include <stdint.h>
 #include <stdio.h>
 
 #include "c-data-structures/arraylike.h"
@@ -16,19 +17,55 @@ typedef enum {
   INSTRUCTION_NO_ARG,
   INSTRUCTION_ID,
   INSTRUCTION_STRING,
-  INSTRUCTION_PRIMITIVE
+  INSTRUCTION_PRIMITIVE,
+  // Only produced at load-time by resolve_locals().
+  INSTRUCTION_SLOT,
 } InstructionType;
 
+// A local variable resolved to a frame slot. The name of the variable is kept
+// in Instruction.id.
+typedef struct {
+  uint16_t index;
+  // Number of slots owned by a block; only used by NBLK.
+  uint16_t count;
+} LocalSlot;
+
+// Opaque to the program; owned by the VM.
+typedef struct _InlineCache InlineCache;
+
+// 16 bytes. Operands which do not fit in the pointer-sized operand are kept
+// beside the header or pooled in the tape.
 typedef struct {
   char op;
   char type;
+  // Handler the interpreter dispatches to. Set at load-time by the VM and
+  // changed by it when the instruction is quickened.
+  uint8_t handler;
+  // Number of times the VM has reverted a quickened handler.
+  uint8_t deopts;
+  union {
+    // PrimitiveType of the operand of an INSTRUCTION_PRIMITIVE.
+    uint8_t val_type;
+    // Only used by INSTRUCTION_SLOT.
+    LocalSlot local;
+    // Identifies the InlineCache of a GET, GTSH, CALL or CLLN on an ID. Set at
+    // load-time by the VM. See tape_get_cache().
+    uint32_t cache;
+  };
   union {
-    Primitive val;
     const char *id;
     const char *str;
+    // Bools and chars are stored as ints.
+    int64_t int_val;
+    double float_val;
   };
 } Instruction;
 
+// Gets the operand of an INSTRUCTION_PRIMITIVE.
+Primitive instruction_primitive(const Instruction *ins);
+// Sets the operand of an INSTRUCTION_PRIMITIVE.
+void instruction_set_primitive(Instruction *ins, Primitive val);
+
 DEFINE_ARRAYLIKE(InstructionArray, Instruction);
 
 int instruction_write(const Instruction *ins, FILE *file, bool minimize);
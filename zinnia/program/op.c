@@ -16,7 +16,8 @@ static const char *_op_strs[] = {
     "tlte", "teq",  "dup",  "goto", "prnt", "lmdl", "get",  "gtsh", "rnil",
     "pnil", "fld",  "fldc", "is",   "adr",  "rais", "ctch", "anew", "aidx",
     "aset", "cnst", "setc", "letc", "sget", "wait", "rtru", "rfls", "ptru",
-    "pfls", "ires", "ipsh"};
+    "pfls", "ires", "ipsh", "llet", "lset", "lres", "lpsh", "scll",
+    "scln", "args", "parm"};
 
 const char *op_to_str(Op op) { return _op_strs[op]; }
 
@@ -90,6 +90,18 @@ typedef enum {
   // Immutable
   IRES,
   IPSH,
+  // Slot-addressed locals
+  LLET,
+  LSET,
+  LRES,
+  LPSH,
+  // Calls a function looked up in the current scope.
+  SCLL,
+  SCLN,  // SCLL with no args
+  // Arguments to the next call are the given number of entities on the stack.
+  ARGS,
+  // Puts the given number of arguments on the stack for LET to bind.
+  PARM,
   // NOT A REAL OP
   OP_BOUND,
 } Op;
@@ -0,0 +1,415 @@
+// locals.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/program/optimization/locals.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "c-data-structures/arraylike.h"
+#include "zinnia/entity/function/function.h"
+#include "zinnia/entity/primitive.h"
+#include "zinnia/program/instruction.h"
+#include "zinnia/program/op.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/void_array.h"
+#include "zinnia/vm/intern.h"
+
+#define NO_BLOCK -1
+#define MAX_SLOTS UINT16_MAX
+
+#define is_goto(op) \
+  (((op) == JMP) || ((op) == IFN) || ((op) == IF) || ((op) == CTCH))
+
+typedef struct {
+  int32_t parent;
+  // Index of the NBLK that opens the block.
+  uint32_t start;
+  // Slots declared directly in this block and [lo, hi) for the block and all
+  // of its children.
+  uint16_t own, lo, hi;
+} LocalBlock;
+
+typedef struct {
+  const char *name;
+  int32_t block;
+  uint32_t first_pos;
+  // The block whose slot this declaration binds.
+  int32_t home;
+  uint16_t slot;
+  bool unsafe;
+} LocalDecl;
+
+DEFINE_ARRAYLIKE(LocalBlockArray, LocalBlock);
+IMPL_ARRAYLIKE(LocalBlockArray, LocalBlock);
+DEFINE_ARRAYLIKE(LocalDeclArray, LocalDecl);
+IMPL_ARRAYLIKE(LocalDeclArray, LocalDecl);
+DEFINE_ARRAYLIKE(FunctionRefPtrArray, FunctionRef *);
+IMPL_ARRAYLIKE(FunctionRefPtrArray, FunctionRef *);
+
+bool is_var_decl_(Op op) { return LET == op || SET == op; }
+
+// Ops which only read or update a variable in place.
+bool is_var_read_(Op op) {
+  switch (op) {
+    case RES:
+    case PUSH:
+    case PEEK:
+    case RET:
+    case ADD:
+    case SUB:
+    case MULT:
+    case DIV:
+    case MOD:
+    case AND:
+    case OR:
+    case BAND:
+    case BXOR:
+    case BOR:
+    case LT:
+    case GT:
+    case LTE:
+    case GTE:
+    case EQ:
+    case NEQ:
+    case INC:
+    case DEC:
+    case AIDX:
+    case SCLL:
+    case SCLN:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Ops whose ID names a member or module and not a variable.
+bool is_member_op_(Op op) {
+  switch (op) {
+    case GET:
+    case GTSH:
+    case CALL:
+    case CLLN:
+    case FLD:
+    case FLDC:
+    case MSET:
+    case LMDL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int32_t new_block_(LocalBlockArray *blocks, int32_t parent, uint32_t start) {
+  LocalBlock *block = LocalBlockArray_push_back_ref(blocks);
+  block->parent = parent;
+  block->start = start;
+  block->own = 0;
+  block->lo = 0;
+  block->hi = 0;
+  return LocalBlockArray_size(blocks) - 1;
+}
+
+LocalDecl *find_decl_(LocalDeclArray *decls, const char *name,
+                      int32_t block) {
+  for (int i = 0; i < LocalDeclArray_size(decls); ++i) {
+    LocalDecl *decl = LocalDeclArray_mutable_ref_unchecked(decls, i);
+    // Same pointer because string interning.
+    if (decl->name == name && decl->block == block) {
+      return decl;
+    }
+  }
+  return NULL;
+}
+
+void mark_unsafe_(LocalDeclArray *decls, const char *name) {
+  for (int i = 0; i < LocalDeclArray_size(decls); ++i) {
+    LocalDecl *decl = LocalDeclArray_mutable_ref_unchecked(decls, i);
+    if (decl->name == name) {
+      decl->unsafe = true;
+    }
+  }
+}
+
+// Whether the instruction at pos is executed on every path through the
+// function that reaches an instruction after it.
+bool always_executed_(const Tape *tape, const IntArray *gotos, uint32_t pos) {
+  for (int i = 0; i < IntArray_size(gotos); ++i) {
+    const int index = IntArray_get_unchecked(gotos, i);
+    if (index < (int)pos &&
+        index + tape_get(tape, index)->int_val >= (int)pos) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Finds the slot for name as seen from the innermost block in stack.
+LocalDecl *resolve_decl_(LocalDeclArray *decls, const IntArray *stack,
+                         const char *name) {
+  for (int i = IntArray_size(stack) - 1; i >= 0; --i) {
+    LocalDecl *decl =
+        find_decl_(decls, name, IntArray_get_unchecked(stack, i));
+    if (NULL != decl) {
+      return decl->unsafe ? NULL : decl;
+    }
+  }
+  return NULL;
+}
+
+void rewrite_ins_(Instruction *ins, uint16_t slot) {
+  const char *id = ins->id;
+  switch (ins->op) {
+    case LET:
+      ins->op = LLET;
+      break;
+    case SET:
+      ins->op = LSET;
+      break;
+    case RES:
+      ins->op = LRES;
+      break;
+    case PUSH:
+      ins->op = LPSH;
+      break;
+    default:
+      break;
+  }
+  ins->type = INSTRUCTION_SLOT;
+  ins->id = id;
+  ins->local.index = slot;
+  ins->local.count = 0;
+}
+
+void resolve_function_(Tape *tape, FunctionRef *fref, uint32_t end) {
+  LocalBlockArray blocks;
+  LocalBlockArray_init(&blocks);
+  LocalDeclArray decls;
+  LocalDeclArray_init(&decls);
+  IntArray stack;
+  IntArray_init(&stack);
+  IntArray gotos;
+  IntArray_init(&gotos);
+
+  IntArray_push_back(&stack, new_block_(&blocks, NO_BLOCK, fref->index));
+  for (uint32_t i = fref->index; i < end; ++i) {
+    const Instruction *ins = tape_get(tape, i);
+    const int32_t current = *IntArray_last_ref_unchecked(&stack);
+    if (INSTRUCTION_SLOT == ins->type) {
+      // Already resolved.
+      goto clean_up;
+    }
+    if (is_goto(ins->op) && INSTRUCTION_PRIMITIVE == ins->type) {
+      IntArray_push_back(&gotos, i);
+      continue;
+    }
+    if (NBLK == ins->op) {
+      IntArray_push_back(&stack, new_block_(&blocks, current, i));
+      continue;
+    }
+    if (BBLK == ins->op) {
+      if (IntArray_size(&stack) <= 1) {
+        goto clean_up;
+      }
+      IntArray_pop_back_unchecked(&stack);
+      continue;
+    }
+    if (INSTRUCTION_ID != ins->type || SELF == ins->id ||
+        TMP_MODULE_HOLDER == ins->id || !is_var_decl_(ins->op) ||
+        NULL != find_decl_(&decls, ins->id, current)) {
+      continue;
+    }
+    LocalDecl *decl = LocalDeclArray_push_back_ref(&decls);
+    decl->name = ins->id;
+    decl->block = current;
+    decl->first_pos = i;
+    decl->home = current;
+    decl->slot = 0;
+    decl->unsafe = false;
+  }
+  if (IntArray_size(&stack) != 1 || LocalDeclArray_size(&decls) == 0) {
+    goto clean_up;
+  }
+
+  // Variables used by anything other than simple reads and writes are left
+  // to be looked up by name.
+  for (uint32_t i = fref->index; i < end; ++i) {
+    const Instruction *ins = tape_get(tape, i);
+    if (INSTRUCTION_ID == ins->type && !is_var_decl_(ins->op) &&
+        !is_var_read_(ins->op) && !is_member_op_(ins->op)) {
+      mark_unsafe_(&decls, ins->id);
+    }
+  }
+
+  // A variable set in a block that is also set in an enclosing block shares
+  // the enclosing block's slot, but only if the enclosing block is guaranteed
+  // to have set it before the inner block is entered. Otherwise the inner
+  // block would have its own binding, so leave it to be looked up by name.
+  for (int i = 0; i < LocalDeclArray_size(&decls); ++i) {
+    LocalDecl *decl = LocalDeclArray_mutable_ref_unchecked(&decls, i);
+    if (decl->unsafe) {
+      continue;
+    }
+    const LocalBlock *block =
+        LocalBlockArray_get_ref_unchecked(&blocks, decl->block);
+    LocalDecl *outer = NULL;
+    int32_t parent = block->parent;
+    while (NO_BLOCK != parent &&
+           NULL == (outer = find_decl_(&decls, decl->name, parent))) {
+      parent = LocalBlockArray_get_ref_unchecked(&blocks, parent)->parent;
+    }
+    if (NULL == outer) {
+      LocalBlockArray_mutable_ref_unchecked(&blocks, decl->block)->own++;
+      continue;
+    }
+    if (outer->unsafe || outer->first_pos > block->start ||
+        !always_executed_(tape, &gotos, outer->first_pos)) {
+      mark_unsafe_(&decls, decl->name);
+      continue;
+    }
+    decl->home = outer->home;
+  }
+
+  // Blocks are numbered in preorder, so each block's slots are followed by
+  // the slots of its children.
+  uint32_t num_slots = 0;
+  for (int i = 0; i < LocalBlockArray_size(&blocks); ++i) {
+    LocalBlock *block = LocalBlockArray_mutable_ref_unchecked(&blocks, i);
+    block->lo = num_slots;
+    num_slots += block->own;
+    if (num_slots > MAX_SLOTS) {
+      goto clean_up;
+    }
+    block->hi = num_slots;
+    block->own = 0;
+  }
+  for (int i = LocalBlockArray_size(&blocks) - 1; i > 0; --i) {
+    const LocalBlock *block = LocalBlockArray_get_ref_unchecked(&blocks, i);
+    LocalBlock *parent =
+        LocalBlockArray_mutable_ref_unchecked(&blocks, block->parent);
+    if (block->hi > parent->hi) {
+      parent->hi = block->hi;
+    }
+  }
+  if (0 == num_slots) {
+    goto clean_up;
+  }
+  for (int i = 0; i < LocalDeclArray_size(&decls); ++i) {
+    LocalDecl *decl = LocalDeclArray_mutable_ref_unchecked(&decls, i);
+    if (decl->unsafe) {
+      continue;
+    }
+    if (decl->home == decl->block) {
+      LocalBlock *block =
+          LocalBlockArray_mutable_ref_unchecked(&blocks, decl->block);
+      decl->slot = block->lo + block->own++;
+    } else {
+      decl->slot = find_decl_(&decls, decl->name, decl->home)->slot;
+    }
+  }
+
+  IntArray_clear(&stack);
+  IntArray_push_back(&stack, 0);
+  int32_t next_block = 1;
+  for (uint32_t i = fref->index; i < end; ++i) {
+    Instruction *ins = tape_get_mutable(tape, i);
+    if (NBLK == ins->op) {
+      const LocalBlock *block =
+          LocalBlockArray_get_ref_unchecked(&blocks, next_block);
+      IntArray_push_back(&stack, next_block++);
+      if (block->hi > block->lo) {
+        ins->type = INSTRUCTION_SLOT;
+        ins->id = NULL;
+        ins->local.index = block->lo;
+        ins->local.count = block->hi - block->lo;
+      }
+      continue;
+    }
+    if (BBLK == ins->op) {
+      IntArray_pop_back_unchecked(&stack);
+      continue;
+    }
+    if (INSTRUCTION_ID != ins->type ||
+        !(is_var_decl_(ins->op) || is_var_read_(ins->op))) {
+      continue;
+    }
+    const LocalDecl *decl = resolve_decl_(&decls, &stack, ins->id);
+    if (NULL != decl) {
+      rewrite_ins_(ins, decl->slot);
+    }
+  }
+  fref->num_slots = num_slots;
+
+clean_up:
+  IntArray_finalize(&gotos);
+  IntArray_finalize(&stack);
+  LocalDeclArray_finalize(&decls);
+  LocalBlockArray_finalize(&blocks);
+}
+
+void add_functions_(FunctionRefMapIOIterator *it, FunctionRefPtrArray *funcs,
+                    IntArray *boundaries, IntArray *anons) {
+  for (; FunctionRefMap_io_has_next(it); FunctionRefMap_io_next(it)) {
+    FunctionRef *fref = FunctionRefMap_io_mutable_value(it);
+    if (is_anon(fref->name)) {
+      IntArray_push_back(anons, fref->index);
+      continue;
+    }
+    FunctionRefPtrArray_push_back(funcs, fref);
+    IntArray_push_back(boundaries, fref->index);
+  }
+}
+
+void resolve_locals(Tape *tape) {
+  ASSERT(tape != NULL);
+  FunctionRefPtrArray funcs;
+  FunctionRefPtrArray_init(&funcs);
+  // Indices where a function body must end.
+  IntArray boundaries;
+  IntArray_init(&boundaries);
+  IntArray anons;
+  IntArray_init(&anons);
+
+  FunctionRefMapIOIterator module_funcs = tape_functions(tape);
+  add_functions_(&module_funcs, &funcs, &boundaries, &anons);
+  ClassRefMapIOIterator classes = tape_classes(tape);
+  for (; ClassRefMap_io_has_next(&classes); ClassRefMap_io_next(&classes)) {
+    ClassRef *cref = ClassRefMap_io_mutable_value(&classes);
+    IntArray_push_back(&boundaries, cref->start_index);
+    IntArray_push_back(&boundaries, cref->end_index);
+    FunctionRefMapIOIterator class_funcs;
+    FunctionRefMap_io_iterator(&class_funcs, &cref->func_refs);
+    add_functions_(&class_funcs, &funcs, &boundaries, &anons);
+  }
+
+  for (int i = 0; i < FunctionRefPtrArray_size(&funcs); ++i) {
+    FunctionRef *fref = FunctionRefPtrArray_get_unchecked(&funcs, i);
+    if (fref->num_slots > 0) {
+      continue;
+    }
+    uint32_t end = tape_size(tape);
+    for (int j = 0; j < IntArray_size(&boundaries); ++j) {
+      const uint32_t boundary = IntArray_get_unchecked(&boundaries, j);
+      if (boundary > fref->index && boundary < end) {
+        end = boundary;
+      }
+    }
+    bool has_closures = false;
+    for (int j = 0; j < IntArray_size(&anons); ++j) {
+      const uint32_t anon = IntArray_get_unchecked(&anons, j);
+      if (anon > fref->index && anon < end) {
+        has_closures = true;
+        break;
+      }
+    }
+    if (!has_closures) {
+      resolve_function_(tape, fref, end);
+    }
+  }
+
+  IntArray_finalize(&anons);
+  IntArray_finalize(&boundaries);
+  FunctionRefPtrArray_finalize(&funcs);
+}
@@ -0,0 +1,24 @@
+// locals.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_PROGRAM_OPTIMIZATION_LOCALS_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_PROGRAM_OPTIMIZATION_LOCALS_H_
+
+#include "zinnia/program/tape.h"
+
+// Resolves local variables of each function in the tape to frame slots.
+//
+// Rewrites LET/SET/RES/PUSH on a resolved local into LLET/LSET/LRES/LPSH and
+// all other reads of it into INSTRUCTION_SLOT operands. NBLK instructions that
+// own slots are given the range of slots to unbind when the block is entered.
+// FunctionRef.num_slots is set to the number of slots the function needs.
+//
+// Functions that contain anonymous functions are left untouched since the
+// closures look up their free variables by name. Functions which have
+// already been resolved are skipped, so this can be run on a tape that has
+// been appended to.
+void resolve_locals(Tape *tape);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_PROGRAM_OPTIMIZATION_LOCALS_H_ */
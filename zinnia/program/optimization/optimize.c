@@ -59,7 +59,7 @@ void populate_gotos_(OptimizeHelper *oh) {
     if (!is_goto(ins->op)) {
       continue;
     }
-    int index = i + pint(&ins->val);
+    int index = i + ins->int_val;
     IntIntMap_insert(&oh->i_gotos, index, sizeof(int), i);
   }
 }
@@ -274,7 +274,7 @@ void oh_resolve_(OptimizeHelper *oh, Tape *new_tape) {
       } else if (SET_VAL == a->type) {
         new_ins->op = a->op;
         new_ins->type = INSTRUCTION_PRIMITIVE;
-        new_ins->val = a->val;
+        instruction_set_primitive(new_ins, a->val);
       } else if (REPLACE == a->type) {
         *new_ins = a->ins;
       }
@@ -287,11 +287,11 @@ void oh_resolve_(OptimizeHelper *oh, Tape *new_tape) {
       continue;
     }
     ASSERT(INSTRUCTION_PRIMITIVE == ins->type);
-    int diff = pint(&ins->val);
+    int diff = ins->int_val;
     int old_i = IntArray_get_unchecked(&old_index, i);
     int old_goto_i = old_i + diff;
     int new_goto_i = IntArray_get_unchecked(&new_index, old_goto_i);
-    ins->val = primitive_int(new_goto_i - i);
+    instruction_set_primitive(ins, primitive_int(new_goto_i - i));
   }
   IntArray_finalize(&old_index);
   IntArray_finalize(&new_index);
@@ -103,7 +103,7 @@ void optimizer_JmpRes(OptimizeHelper *oh, const Tape *const tape, int start,
     if (SET != first->op || JMP != second->op) {
       continue;
     }
-    int32_t jmp_val = pint(&second->val);
+    int32_t jmp_val = second->int_val;
     if (jmp_val >= 0) {
       continue;
     }
@@ -137,7 +137,9 @@ void optimizer_PushRes(OptimizeHelper *oh, const Tape *const tape, int start,
         continue;
       }
     } else if (first->type == INSTRUCTION_PRIMITIVE) {
-      if (!primitive_equals(&first->val, &second->val)) {
+      Primitive first_val = instruction_primitive(first);
+      Primitive second_val = instruction_primitive(second);
+      if (!primitive_equals(&first_val, &second_val)) {
         continue;
       }
     }
@@ -221,7 +223,7 @@ void optimizer_Increment(OptimizeHelper *oh, const Tape *const tape, int start,
     const Instruction *fourth = tape_get(tape, i);
     if (PUSH == first->op && INSTRUCTION_ID == first->type &&
         PUSH == second->op && INSTRUCTION_PRIMITIVE == second->type &&
-        PRIMITIVE_INT == ptype(&second->val) && 1 == pint(&second->val) &&
+        PRIMITIVE_INT == second->val_type && 1 == second->int_val &&
         (ADD == third->op || SUB == third->op) && SET == fourth->op &&
         INSTRUCTION_ID == fourth->type && first->id == fourth->id &&
         NULL == IntIntMap_find_ref(&oh->i_gotos, i, sizeof(int)) &&
@@ -246,7 +248,7 @@ void optimizer_Increment(OptimizeHelper *oh, const Tape *const tape, int start,
     if (RES == first->op && INSTRUCTION_ID == first->type &&
         (ADD == second->op || SUB == second->op) &&
         INSTRUCTION_PRIMITIVE == second->type &&
-        PRIMITIVE_INT == ptype(&second->val) && 1 == pint(&second->val) &&
+        PRIMITIVE_INT == second->val_type && 1 == second->int_val &&
         SET == third->op && INSTRUCTION_ID == third->type &&
         first->id == third->id &&
         NULL == IntIntMap_find_ref(&oh->i_gotos, i - 1, sizeof(int)) &&
@@ -73,9 +73,11 @@ int deserialize_ins(FILE *file, const CharPtrArray *strings, Instruction *ins) {
   ins->type = param;
   uint16_t ref16;
   uint8_t ref8;
+  Primitive val;
   switch (param) {
     case INSTRUCTION_PRIMITIVE:
-      i += deserialize_val(file, &ins->val);
+      i += deserialize_val(file, &val);
+      instruction_set_primitive(ins, val);
       break;
     case INSTRUCTION_ID:
     case INSTRUCTION_STRING:
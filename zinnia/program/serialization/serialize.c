@@ -63,7 +63,7 @@ int serialize_ins(WBuffer *const buffer, const Instruction *ins,
   uint16_t ref;
   switch (ins->type) {
     case INSTRUCTION_PRIMITIVE:
-      i += serialize_primitive(buffer, ins->val);
+      i += serialize_primitive(buffer, instruction_primitive(ins));
       break;
     case INSTRUCTION_STRING:
       ref = StringIndexMap_find(string_index, ins->str, sizeof(char *), -1);
@@ -31,6 +31,9 @@ IMPL_ARRAYLIKE(ClassRefPtrArray, ClassRef *);
 IMPL_STABLE_MAPLIKE(FunctionRefMap, char *, FunctionRef);
 IMPL_STABLE_MAPLIKE(FieldRefMap, char *, FieldRef);
 
+DEFINE_ARRAYLIKE(InlineCachePtrArray, InlineCache *);
+IMPL_ARRAYLIKE(InlineCachePtrArray, InlineCache *);
+
 struct Tape_ {
   const char *module_name;
   InstructionArray ins;
@@ -43,6 +46,8 @@ struct Tape_ {
   FunctionRefMap func_refs;
 
   ClassRef *current_class;
+
+  InlineCachePtrArray caches;
 };
 
 void classref_init_(ClassRef *ref, const char name[]);
@@ -60,6 +65,7 @@ Tape *tape_create() {
   tape->current_class = NULL;
   tape->external_source_fn = NULL;
   tape->module_name = NULL;
+  InlineCachePtrArray_init(&tape->caches);
   return tape;
 }
 
@@ -75,6 +81,7 @@ void tape_delete(Tape *tape) {
   }
   ClassRefMap_finalize(&tape->class_refs);
   FunctionRefMap_finalize(&tape->func_refs);
+  InlineCachePtrArray_finalize(&tape->caches);
   RELEASE(tape);
 }
 
@@ -87,7 +94,27 @@ Instruction *tape_add(Tape *tape) {
   sm->source_line = -1;
   sm->source_token = NULL;
   sm->token = NULL;
-  return InstructionArray_push_back_ref(&tape->ins);
+  Instruction *ins = InstructionArray_push_back_ref(&tape->ins);
+  // Zeroed so that load-time state (e.g., Instruction.cache) starts out unset.
+  memset(ins, 0, sizeof(Instruction));
+  return ins;
+}
+
+uint32_t tape_add_cache(Tape *tape, InlineCache *cache) {
+  ASSERT(tape != NULL);
+  InlineCachePtrArray_push_back(&tape->caches, cache);
+  return InlineCachePtrArray_size(&tape->caches);
+}
+
+InlineCache *tape_get_cache(const Tape *tape, uint32_t cache) {
+  return (0 == cache)
+             ? NULL
+             : InlineCachePtrArray_get_unchecked(&tape->caches, cache - 1);
+}
+
+void tape_clear_caches(Tape *tape) {
+  ASSERT(tape != NULL);
+  InlineCachePtrArray_clear(&tape->caches);
 }
 
 SourceMapping *tape_add_source(Tape *tape, Instruction *ins) {
@@ -132,6 +159,7 @@ void tape_start_func_at_index(Tape *tape, const char name[], uint32_t index,
   // TODO: Implement const functions.
   ref->is_const = false;
   ref->is_async = is_async;
+  ref->num_slots = 0;
 }
 
 void tape_start_func_(Tape *tape, const char name[], bool is_async) {
@@ -612,12 +640,10 @@ Primitive token_to_primitive(const Token *tok) {
   Primitive val;
   switch (tok->type) {
     case TOKEN_INTEGER:
-      val._type = PRIMITIVE_INT;
-      val._int_val = (int64_t)strtoll(tok->text, NULL, 10);
+      pset_int(&val, (int64_t)strtoll(tok->text, NULL, 10));
       break;
     case TOKEN_FLOATING:
-      val._type = PRIMITIVE_FLOAT;
-      val._float_val = strtod(tok->text, NULL);
+      pset_float(&val, strtod(tok->text, NULL));
       break;
     default:
       FATALF("Attempted to create a Value from '%s'.", tok->text);
@@ -641,7 +667,7 @@ int tape_ins(Tape *tape, Op op, const Token *token) {
     case TOKEN_INTEGER:
     case TOKEN_FLOATING:
       ins->type = INSTRUCTION_PRIMITIVE;
-      ins->val = token_to_primitive(token);
+      instruction_set_primitive(ins, token_to_primitive(token));
       break;
     case STRING_IMMUTABLE:
     case STRING_SINGLEQUOTE:
@@ -672,7 +698,7 @@ int tape_ins_neg(Tape *tape, Op op, const Token *token) {
 
   ins->type = INSTRUCTION_PRIMITIVE;
   Primitive p = token_to_primitive(token);
-  ins->val = primitive_int(-pint(&p));
+  instruction_set_primitive(ins, primitive_int(-pint(&p)));
   return 1;
 }
 
@@ -704,8 +730,7 @@ int tape_ins_int(Tape *tape, Op op, int val, const Token *token) {
   sm->col = token->col;
 
   ins->type = INSTRUCTION_PRIMITIVE;
-  ins->val._type = PRIMITIVE_INT;
-  ins->val._int_val = val;
+  instruction_set_primitive(ins, primitive_int(val));
   return 1;
 }
 
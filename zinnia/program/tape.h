@@ -31,6 +31,8 @@ typedef struct {
   const char *name;
   uint32_t index;
   bool is_const, is_async;
+  // Set by resolve_locals().
+  uint16_t num_slots;
 } FunctionRef;
 
 DEFINE_STABLE_MAPLIKE(FunctionRefMap, char *, FunctionRef);
@@ -69,6 +71,15 @@ FunctionRefMapIOIterator tape_functions(const Tape *tape);
 
 const char *tape_module_name(const Tape *tape);
 
+// Pool of InlineCaches for instructions of the tape, which are owned by the VM.
+//
+// Returns the Instruction.cache that identifies the added cache, which is
+// never 0.
+uint32_t tape_add_cache(Tape *tape, InlineCache *cache);
+// Gets the cache identified by an Instruction.cache, or NULL if it is 0.
+InlineCache *tape_get_cache(const Tape *tape, uint32_t cache);
+void tape_clear_caches(Tape *tape);
+
 // Build-related functions.
 Tape *tape_create();
 void tape_delete(Tape *tape);
@@ -5,6 +5,8 @@
 
 #include "zinnia/program/tape_binary.h"
 
+#include <string.h>
+
 #include "zinnia/program/serialization/deserialize.h"
 #include "zinnia/program/serialization/serialize.h"
 #include "zinnia/util/void_array.h"
@@ -86,6 +88,7 @@ void tape_read_binary(Tape *const tape, FILE *file) {
   deserialize_type(file, uint16_t, &num_ins);
   for (i = 0; i < num_ins; ++i) {
     Instruction ins;
+    memset(&ins, 0, sizeof(Instruction));
     deserialize_ins(file, &strings, &ins);
     tape_ins_raw(tape, &ins);
     if (has_source_map) {
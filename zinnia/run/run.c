@@ -5,7 +5,9 @@
 
 #include "zinnia/run/run.h"
 
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -21,6 +23,7 @@
 #include "zinnia/entity/module/modules.h"
 #include "zinnia/entity/object.h"
 #include "zinnia/entity/string/string_helper.h"
+#include "zinnia/heap/heap.h"
 #include "zinnia/program/optimization/optimize.h"
 #include "zinnia/program/tape.h"
 #include "zinnia/seed/seed.h"
@@ -30,6 +33,7 @@
 #include "zinnia/util/file.h"
 #include "zinnia/util/sync/constants.h"
 #include "zinnia/util/sync/thread.h"
+#include "zinnia/vm/heap_profiler.h"
 #include "zinnia/vm/intern.h"
 #include "zinnia/vm/module_manager.h"
 #include "zinnia/vm/process/process.h"
@@ -53,6 +57,79 @@ void set_args_(Heap *heap, ArgStore *store) {
                         global_intern("args"), args);
 }
 
+HeapCollector lookup_collector_(ArgStore *store) {
+  const char *name = argstore_lookup_string(store, ArgKey__GC);
+  HeapCollector collector;
+  if (!heap_collector_parse(name, &collector)) {
+    FATALF(
+        "Unknown --gc='%s'. Expected 'refgraph', 'mark_sweep' or "
+        "'generational'.",
+        name);
+  }
+  return collector;
+}
+
+void maybe_start_heap_profiler_(VM *vm, ArgStore *store) {
+  if ('\0' == argstore_lookup_string(store, ArgKey__HEAP_PROFILE)[0]) {
+    return;
+  }
+  const int sample_interval =
+      argstore_lookup_int(store, ArgKey__HEAP_PROFILE_SAMPLE_INTERVAL);
+  if (sample_interval <= 0) {
+    FATALF("--heap_profile_sample_interval must be positive, was %d.",
+           sample_interval);
+  }
+  vm_start_heap_profiler(vm, sample_interval);
+}
+
+uint32_t lookup_background_threads_(ArgStore *store) {
+  const int num_threads =
+      argstore_lookup_int(store, ArgKey__BACKGROUND_THREADS);
+  if (num_threads < 0) {
+    FATALF("--background_threads must not be negative, was %d.", num_threads);
+  }
+  return num_threads;
+}
+
+size_t lookup_max_process_heap_bytes_(ArgStore *store) {
+  const int64_t max_bytes =
+      argstore_lookup_int64(store, ArgKey__MAX_PROCESS_HEAP_BYTES);
+  if (max_bytes < 0 || (uint64_t)max_bytes > SIZE_MAX) {
+    FATALF("--max_process_heap_bytes must be in [0, %zu], was %" PRId64 ".",
+           (size_t)SIZE_MAX, max_bytes);
+  }
+  return (size_t)max_bytes;
+}
+
+uint32_t lookup_gc_max_pause_us_(ArgStore *store) {
+  const int64_t max_pause_us =
+      argstore_lookup_int64(store, ArgKey__GC_MAX_PAUSE_US);
+  if (max_pause_us < 0 || max_pause_us > UINT32_MAX) {
+    FATALF("--gc_max_pause_us must be in [0, %" PRIu32 "], was %" PRId64 ".",
+           UINT32_MAX, max_pause_us);
+  }
+  return (uint32_t)max_pause_us;
+}
+
+// Negative --scheduler_threads runs each process on a thread of its own.
+void maybe_start_scheduler_(VM *vm, ArgStore *store) {
+  const int num_threads = argstore_lookup_int(store, ArgKey__SCHEDULER_THREADS);
+  if (num_threads < 0) {
+    return;
+  }
+  vm_start_scheduler(vm, num_threads);
+}
+
+void maybe_write_heap_profile_(VM *vm, ArgStore *store) {
+  const char *path = argstore_lookup_string(store, ArgKey__HEAP_PROFILE);
+  if (NULL == vm->heap_profiler) {
+    return;
+  }
+  if (!heapprofiler_write(vm->heap_profiler, path, HEAP_PROFILE_LIVE_BYTES)) {
+    fprintf(stderr, "Could not write heap profile to '%s'.\n", path);
+  }
+}
+
 void run_files(const CharPtrArray *source_file_names,
                const FilePartsArray *source_contents,
                const VoidPtrArray *init_fns, ArgStore *store) {
@@ -63,7 +140,15 @@ void run_files(const CharPtrArray *source_file_names,
   uint32_t max_process_object_count =
       argstore_lookup_int(store, ArgKey__MAX_PROCESS_OBJECT_COUNT);
   bool async_enabled = argstore_lookup_bool(store, ArgKey__ASYNC);
-  VM *vm = vm_create(lib_location, max_process_object_count, async_enabled);
+  bool jit_enabled = argstore_lookup_bool(store, ArgKey__JIT);
+  VM *vm = vm_create(lib_location, max_process_object_count,
+                     lookup_max_process_heap_bytes_(store), async_enabled,
+                     jit_enabled, lookup_collector_(store),
+                     lookup_gc_max_pause_us_(store),
+                     lookup_background_threads_(store));
+  vm->gc_log = argstore_lookup_bool(store, ArgKey__GC_LOG);
+  maybe_start_heap_profiler_(vm, store);
+  maybe_start_scheduler_(vm, store);
   ModuleManager *mm = vm_module_manager(vm);
   Module *main_module = NULL;
 
@@ -103,6 +188,7 @@ void run_files(const CharPtrArray *source_file_names,
   Task *task = process_create_task(vm_main_process(vm));
   task_create_context(task, main_module->_reflection, main_module, 0);
   process_run(vm_main_process(vm));
+  maybe_write_heap_profile_(vm, store);
 
 #ifdef DEBUG
   vm_delete(vm);
@@ -118,7 +204,15 @@ void run(const SourceNameSet *source_files, ArgStore *store) {
   uint32_t max_process_object_count =
       argstore_lookup_int(store, ArgKey__MAX_PROCESS_OBJECT_COUNT);
   bool async_enabled = argstore_lookup_bool(store, ArgKey__ASYNC);
-  VM *vm = vm_create(lib_location, max_process_object_count, async_enabled);
+  bool jit_enabled = argstore_lookup_bool(store, ArgKey__JIT);
+  VM *vm = vm_create(lib_location, max_process_object_count,
+                     lookup_max_process_heap_bytes_(store), async_enabled,
+                     jit_enabled, lookup_collector_(store),
+                     lookup_gc_max_pause_us_(store),
+                     lookup_background_threads_(store));
+  vm->gc_log = argstore_lookup_bool(store, ArgKey__GC_LOG);
+  maybe_start_heap_profiler_(vm, store);
+  maybe_start_scheduler_(vm, store);
   ModuleManager *mm = vm_module_manager(vm);
   Module *main_module = NULL;
 
@@ -165,6 +259,7 @@ void run(const SourceNameSet *source_files, ArgStore *store) {
   Task *task = process_create_task(vm_main_process(vm));
   task_create_context(task, main_module->_reflection, main_module, 0);
   process_run(vm_main_process(vm));
+  maybe_write_heap_profile_(vm, store);
 
 #ifdef DEBUG
   vm_delete(vm);
@@ -110,6 +110,7 @@ const Arg *argstore_get(const ArgStore *store, ArgKey key) {
 }
 
 ARGSTORE_LOOKUP(int);
+ARGSTORE_LOOKUP_RETVAL(int64, int64_t);
 ARGSTORE_LOOKUP(float);
 ARGSTORE_LOOKUP_RETVAL(bool, _Bool);
 ARGSTORE_LOOKUP_RETVAL(string, const char *);
@@ -25,7 +25,16 @@ typedef enum {
   ArgKey__LIB_LOCATION,
   Argkey__MINIMIZE,
   ArgKey__MAX_PROCESS_OBJECT_COUNT,
+  ArgKey__MAX_PROCESS_HEAP_BYTES,
   ArgKey__ASYNC,
+  ArgKey__JIT,
+  ArgKey__GC,
+  ArgKey__GC_MAX_PAUSE_US,
+  ArgKey__GC_LOG,
+  ArgKey__HEAP_PROFILE,
+  ArgKey__HEAP_PROFILE_SAMPLE_INTERVAL,
+  ArgKey__SCHEDULER_THREADS,
+  ArgKey__BACKGROUND_THREADS,
   ArgKey__VERSION,
   ArgKey__END,
 } ArgKey;
@@ -51,6 +60,7 @@ ArgStore *commandline_parse_args(ArgConfig *config, int argc,
 const SourceNameSet *argstore_sources(const ArgStore *const store);
 
 ARGSTORE_TEMPLATE(int);
+ARGSTORE_TEMPLATE_RETVAL(int64, int64_t);
 ARGSTORE_TEMPLATE(float);
 ARGSTORE_TEMPLATE_RETVAL(bool, _Bool);
 ARGSTORE_TEMPLATE_RETVAL(string, const char *);
@@ -29,15 +29,29 @@ bool parse_bool(const char val[], bool *bool_val) {
   return true;
 }
 
-bool parse_int(const char val[], int32_t *int_val) {
+bool parse_int64(const char val[], int64_t *int64_val) {
   char *pEnd;
-  long int proto_val = strtol(val, &pEnd, 10);
-  if (0 == proto_val && errno != 0) {
+  errno = 0;
+  long long int proto_val = strtoll(val, &pEnd, 10);
+  if (errno != 0 || pEnd == val) {
     return false;
   }
   if (pEnd != val + strlen(val)) {
     return false;
   }
+  *int64_val = (int64_t)proto_val;
+  return true;
+}
+
+bool parse_int(const char val[], int32_t *int_val) {
+  int64_t proto_val;
+  if (!parse_int64(val, &proto_val)) {
+    return false;
+  }
+  // Rather than silently truncating.
+  if (proto_val < INT32_MIN || proto_val > INT32_MAX) {
+    return false;
+  }
   *int_val = (int32_t)proto_val;
   return true;
 }
@@ -95,6 +109,11 @@ Arg arg_parse(ArgType type, const char val[]) {
         FATALF("Could not parse '%s' to INT.", val);
       }
       break;
+    case ArgType__int64:
+      if (!parse_int64(val, &arg.int64_val)) {
+        FATALF("Could not parse '%s' to INT64.", val);
+      }
+      break;
     case ArgType__float:
       if (!parse_float(val, &arg.float_val)) {
         FATALF("Could not parse '%s' to FLOAT.", val);
@@ -121,6 +140,11 @@ Arg arg_int(int32_t int_val) {
   return arg;
 }
 
+Arg arg_int64(int64_t int64_val) {
+  Arg arg = {.used = true, .type = ArgType__int64, .int64_val = int64_val};
+  return arg;
+}
+
 Arg arg_float(float float_val) {
   Arg arg = {.used = true, .type = ArgType__float, .float_val = float_val};
   return arg;
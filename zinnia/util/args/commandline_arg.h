@@ -14,6 +14,7 @@ typedef enum {
   ArgType__none = 0,
   ArgType__bool,
   ArgType__int,
+  ArgType__int64,
   ArgType__float,
   ArgType__string,
   ArgType__stringlist,
@@ -25,6 +26,7 @@ typedef struct {
   union {
     bool bool_val;
     int32_t int_val;
+    int64_t int64_val;
     float float_val;
     const char *string_val;
     struct {
@@ -37,6 +39,8 @@ typedef struct {
 Arg arg_parse(ArgType type, const char val[]);
 Arg arg_bool(bool bool_val);
 Arg arg_int(int32_t int_val);
+// For values which may not fit in an int, like sizes in bytes.
+Arg arg_int64(int64_t int64_val);
 Arg arg_float(float float_val);
 Arg arg_string(const char string_val[]);
 Arg arg_stringlist(const char string_val[]);
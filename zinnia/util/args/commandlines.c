@@ -29,7 +29,24 @@ void argconfig_run(ArgConfig *const config) {
                 arg_string(path_to_libs()));
   argconfig_add(config, ArgKey__MAX_PROCESS_OBJECT_COUNT,
                 "zinnia/heap_object_limit", '\0', arg_int(4096 * 8));
+  argconfig_add(config, ArgKey__MAX_PROCESS_HEAP_BYTES,
+                "max_process_heap_bytes", '\0', arg_int64(0));
   argconfig_add(config, ArgKey__ASYNC, "async", '\0', arg_bool(true));
+  argconfig_add(config, ArgKey__JIT, "jit", '\0', arg_bool(false));
+  argconfig_add(config, ArgKey__GC, "gc", '\0', arg_string("refgraph"));
+  argconfig_add(config, ArgKey__GC_MAX_PAUSE_US, "gc_max_pause_us", '\0',
+                arg_int64(0));
+  argconfig_add(config, ArgKey__GC_LOG, "gc_log", '\0', arg_bool(false));
+  argconfig_add(config, ArgKey__HEAP_PROFILE, "heap_profile", '\0',
+                arg_string(""));
+  argconfig_add(config, ArgKey__HEAP_PROFILE_SAMPLE_INTERVAL,
+                "heap_profile_sample_interval", '\0', arg_int(64));
+  // 0 is one per core.
+  argconfig_add(config, ArgKey__SCHEDULER_THREADS, "scheduler_threads", '\0',
+                arg_int(0));
+  // 0 is one per core.
+  argconfig_add(config, ArgKey__BACKGROUND_THREADS, "background_threads", '\0',
+                arg_int(0));
 }
 
 void argconfig_package(ArgConfig *const config) {
@@ -0,0 +1,80 @@
+// deque.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/util/deque.h"
+
+#include <stddef.h>
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/util/error.h"
+
+#define DEFAULT_DEQUE_CAPACITY 16
+
+void deque_init(Deque *deque) {
+  ASSERT(deque != NULL);
+  deque->buffer = MNEW_ARR(void *, DEFAULT_DEQUE_CAPACITY);
+  deque->capacity = DEFAULT_DEQUE_CAPACITY;
+  deque->front = 0;
+  deque->size = 0;
+}
+
+void deque_finalize(Deque *deque) {
+  ASSERT(deque != NULL);
+  RELEASE(deque->buffer);
+}
+
+// Doubles the capacity, moving the values to the start of the new buffer.
+void grow_(Deque *deque) {
+  void **buffer = MNEW_ARR(void *, deque->capacity * 2);
+  for (uint32_t i = 0; i < deque->size; ++i) {
+    buffer[i] = deque->buffer[(deque->front + i) & (deque->capacity - 1)];
+  }
+  RELEASE(deque->buffer);
+  deque->buffer = buffer;
+  deque->capacity *= 2;
+  deque->front = 0;
+}
+
+void deque_push_back(Deque *deque, void *value) {
+  ASSERT(deque != NULL);
+  if (deque->size == deque->capacity) {
+    grow_(deque);
+  }
+  deque->buffer[(deque->front + deque->size) & (deque->capacity - 1)] = value;
+  ++deque->size;
+}
+
+bool deque_pop_front(Deque *deque, void **value) {
+  ASSERT(deque != NULL);
+  ASSERT(value != NULL);
+  if (0 == deque->size) {
+    return false;
+  }
+  *value = deque->buffer[deque->front];
+  deque->front = (deque->front + 1) & (deque->capacity - 1);
+  --deque->size;
+  return true;
+}
+
+bool deque_pop_back(Deque *deque, void **value) {
+  ASSERT(deque != NULL);
+  ASSERT(value != NULL);
+  if (0 == deque->size) {
+    return false;
+  }
+  --deque->size;
+  *value = deque->buffer[(deque->front + deque->size) & (deque->capacity - 1)];
+  return true;
+}
+
+uint32_t deque_size(const Deque *deque) {
+  ASSERT(deque != NULL);
+  return deque->size;
+}
+
+bool deque_is_empty(const Deque *deque) {
+  ASSERT(deque != NULL);
+  return 0 == deque->size;
+}
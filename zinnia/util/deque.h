@@ -0,0 +1,39 @@
+// deque.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_DEQUE_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_DEQUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Double-ended queue of pointers in a ring buffer.
+//
+// Pushing and popping at either end is O(1). The buffer doubles whenever it
+// is full and never shrinks.
+//
+// Not thread-safe.
+typedef struct {
+  void **buffer;
+  // Always a power of 2, so positions wrap with a mask.
+  uint32_t capacity;
+  // Position of the front value.
+  uint32_t front;
+  uint32_t size;
+} Deque;
+
+void deque_init(Deque *deque);
+// Values still queued are dropped.
+void deque_finalize(Deque *deque);
+
+void deque_push_back(Deque *deque, void *value);
+// Return false if there is nothing to pop.
+bool deque_pop_front(Deque *deque, void **value);
+bool deque_pop_back(Deque *deque, void **value);
+
+uint32_t deque_size(const Deque *deque);
+bool deque_is_empty(const Deque *deque);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_DEQUE_H_ */
@@ -12,4 +12,9 @@
 #define OS_WINDOWS
 #endif
 
+// epoll is on Linux itself rather than every Unix.
+#ifdef __linux__
+#define OS_HAS_EPOLL
+#endif
+
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_PLATFORM_H_ */
\ No newline at end of file
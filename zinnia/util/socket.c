@@ -12,6 +12,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <unistd.h>
 #else
@@ -62,6 +63,30 @@ void _close_socket(int sock) {
 #endif
 }
 
+// Only with epoll does the reactor wait on non-blocking sockets, so elsewhere
+// they are left blocking.
+bool _set_nonblocking(int sock) {
+#ifdef OS_HAS_EPOLL
+  const int flags = fcntl(sock, F_GETFL, 0);
+  return flags >= 0 && 0 == fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+#else
+  return false;
+#endif
+}
+
+void _print_error(const char op[]) {
+  if (socket_would_block()) {
+    return;
+  }
+#ifdef OS_WINDOWS
+  const int error_code = WSAGetLastError();
+  printf("[%s] error_code=%d\n", op, error_code);
+#else
+  printf("[%s] errno=%d\n", op, errno);
+#endif
+  fflush(stdout);
+}
+
 Socket *socket_create(int domain, int type, int protocol, unsigned long host,
                       uint16_t port) {
   Socket *sock = MNEW(Socket);
@@ -100,13 +125,7 @@ SocketHandle *socket_accept(Socket *socket) {
                            &addr_len);
 
   if (!sockethandle_is_valid(sh)) {
-#ifdef OS_WINDOWS
-    const int error_code = WSAGetLastError();
-    printf("[accept] error_code=%d\n", error_code);
-#else
-    printf("[accept] errno=%d\n", errno);
-#endif
-    fflush(stdout);
+    _print_error("accept");
   }
   return sh;
 }
@@ -161,8 +180,16 @@ AddressLookupStatus socket_port(Socket *socket, int *port) {
 void socket_close(Socket *socket) {
   socket->is_closed = true;
   _close_socket(socket->sock);
+  // So that a call racing with this fails rather than use whatever reuses it.
+  socket->sock = (SOCKET)-1;
+}
+
+bool socket_set_nonblocking(Socket *socket) {
+  return _set_nonblocking(socket->sock);
 }
 
+int socket_fd(const Socket *socket) { return (int)socket->sock; }
+
 void socket_delete(Socket *socket) {
   if (!socket->is_closed) {
     socket_close(socket);
@@ -179,13 +206,7 @@ int32_t sockethandle_send(SocketHandle *sh, const char *const msg,
   const int32_t result = send(sh->client_sock, msg, msg_len, 0);
 
   if (result == SOCKET_ERROR) {
-#ifdef OS_WINDOWS
-    const int error_code = WSAGetLastError();
-    printf("[send] error_code=%d\n", error_code);
-#else
-    printf("[send] errno=%d\n", errno);
-#endif
-    fflush(stdout);
+    _print_error("send");
   }
   return result;
 }
@@ -194,13 +215,7 @@ int32_t sockethandle_receive(SocketHandle *sh, char *buf, int buf_len) {
   const int32_t result = recv(sh->client_sock, buf, buf_len, 0);
 
   if (result == SOCKET_ERROR) {
-#ifdef OS_WINDOWS
-    const int error_code = WSAGetLastError();
-    printf("[recv] error_code=%d\n", error_code);
-#else
-    printf("[recv] errno=%d\n", errno);
-#endif
-    fflush(stdout);
+    _print_error("recv");
   }
   return result;
 }
@@ -208,6 +223,22 @@ int32_t sockethandle_receive(SocketHandle *sh, char *buf, int buf_len) {
 void sockethandle_close(SocketHandle *sh) {
   sh->is_closed = true;
   _close_socket(sh->client_sock);
+  // See socket_close().
+  sh->client_sock = (SOCKET)-1;
+}
+
+bool sockethandle_set_nonblocking(SocketHandle *sh) {
+  return _set_nonblocking(sh->client_sock);
+}
+
+int sockethandle_fd(const SocketHandle *sh) { return (int)sh->client_sock; }
+
+bool socket_would_block() {
+#ifdef OS_WINDOWS
+  return WSAEWOULDBLOCK == WSAGetLastError();
+#else
+  return EAGAIN == errno || EWOULDBLOCK == errno;
+#endif
 }
 
 void sockethandle_delete(SocketHandle *sh) {
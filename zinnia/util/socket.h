@@ -55,6 +55,11 @@ AddressLookupStatus socket_port(Socket *socket, int *port);
 
 void socket_close(Socket *socket);
 
+// Makes accepting fail with socket_would_block() instead of blocking. Returns
+// false if that is not supported, in which case it still blocks.
+bool socket_set_nonblocking(Socket *socket);
+int socket_fd(const Socket *socket);
+
 void socket_delete(Socket *socket);
 
 bool sockethandle_is_valid(const SocketHandle *sh);
@@ -65,6 +70,16 @@ int32_t sockethandle_receive(SocketHandle *sh, char *buf, int buf_len);
 
 void sockethandle_close(SocketHandle *sh);
 
+// Makes sending and receiving fail with socket_would_block() instead of
+// blocking. Returns false if that is not supported, in which case they still
+// block.
+bool sockethandle_set_nonblocking(SocketHandle *sh);
+int sockethandle_fd(const SocketHandle *sh);
+
+// Whether the last socket call on this thread failed only because it would
+// have blocked.
+bool socket_would_block();
+
 void sockethandle_delete(SocketHandle *sh);
 
 unsigned long socket_inet_address(const char *host, size_t host_len);
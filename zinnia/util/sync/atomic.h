@@ -0,0 +1,118 @@
+// atomic.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_ATOMIC_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_ATOMIC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zinnia/util/platform.h"
+
+#if defined(OS_WINDOWS) && !defined(__GNUC__)
+#include <windows.h>
+#endif
+
+// Loads are acquires and stores are releases. Read-modify-writes are both.
+
+#if defined(__GNUC__)
+
+static inline uint32_t atomic_load_u32(const volatile uint32_t *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_u32(volatile uint32_t *ptr, uint32_t val) {
+  __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+// Returns the value after incrementing.
+static inline uint32_t atomic_inc_u32(volatile uint32_t *ptr) {
+  return __atomic_add_fetch(ptr, 1, __ATOMIC_ACQ_REL);
+}
+
+// Returns the value after decrementing.
+static inline uint32_t atomic_dec_u32(volatile uint32_t *ptr) {
+  return __atomic_sub_fetch(ptr, 1, __ATOMIC_ACQ_REL);
+}
+
+// Sets *ptr to desired if it is expected. Returns whether it did.
+static inline bool atomic_cas_u32(volatile uint32_t *ptr, uint32_t expected,
+                                  uint32_t desired) {
+  return __atomic_compare_exchange_n(ptr, &expected, desired, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline void *atomic_load_ptr(void *const volatile *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_ptr(void *volatile *ptr, void *val) {
+  __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+// Sets *ptr to val. Returns what it was before.
+static inline void *atomic_exchange_ptr(void *volatile *ptr, void *val) {
+  return __atomic_exchange_n(ptr, val, __ATOMIC_ACQ_REL);
+}
+
+// Sets *ptr to desired if it is expected. Returns whether it did.
+static inline bool atomic_cas_ptr(void *volatile *ptr, void *expected,
+                                  void *desired) {
+  return __atomic_compare_exchange_n(ptr, &expected, desired, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+// Orders every access before it with every access after it.
+static inline void atomic_fence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#else
+
+// MSVC gives volatile accesses acquire/release semantics.
+
+static inline uint32_t atomic_load_u32(const volatile uint32_t *ptr) {
+  return *ptr;
+}
+
+static inline void atomic_store_u32(volatile uint32_t *ptr, uint32_t val) {
+  *ptr = val;
+}
+
+static inline uint32_t atomic_inc_u32(volatile uint32_t *ptr) {
+  return (uint32_t)InterlockedIncrement((volatile LONG *)ptr);
+}
+
+static inline uint32_t atomic_dec_u32(volatile uint32_t *ptr) {
+  return (uint32_t)InterlockedDecrement((volatile LONG *)ptr);
+}
+
+static inline bool atomic_cas_u32(volatile uint32_t *ptr, uint32_t expected,
+                                  uint32_t desired) {
+  return (uint32_t)InterlockedCompareExchange((volatile LONG *)ptr,
+                                              (LONG)desired, (LONG)expected) ==
+         expected;
+}
+
+static inline void *atomic_load_ptr(void *const volatile *ptr) {
+  return *ptr;
+}
+
+static inline void atomic_store_ptr(void *volatile *ptr, void *val) {
+  *ptr = val;
+}
+
+static inline void *atomic_exchange_ptr(void *volatile *ptr, void *val) {
+  return InterlockedExchangePointer(ptr, val);
+}
+
+static inline bool atomic_cas_ptr(void *volatile *ptr, void *expected,
+                                  void *desired) {
+  return InterlockedCompareExchangePointer(ptr, desired, expected) == expected;
+}
+
+static inline void atomic_fence() { MemoryBarrier(); }
+
+#endif
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_ATOMIC_H_ */
@@ -56,6 +56,14 @@ Condition *critical_section_create_condition(CriticalSection critical_section) {
   return cond;
 }
 
+void condition_signal(Condition *cond) {
+#ifdef OS_WINDOWS
+  WakeConditionVariable(&cond->cv);
+#else
+  pthread_cond_signal(&cond->cond);
+#endif
+}
+
 void condition_broadcast(Condition *cond) {
 #ifdef OS_WINDOWS
   WakeAllConditionVariable(&cond->cv);
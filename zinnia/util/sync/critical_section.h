@@ -36,6 +36,8 @@ void critical_section_delete(CriticalSection critical_section);
 typedef struct __Condition Condition;
 
 Condition *critical_section_create_condition(CriticalSection critical_section);
+// Wakes at least one thread waiting on cond.
+void condition_signal(Condition *cond);
 void condition_broadcast(Condition *cond);
 void condition_wait(Condition *cond);
 void condition_delete(Condition *cond);
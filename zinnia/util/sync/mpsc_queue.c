@@ -0,0 +1,145 @@
+// mpsc_queue.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/util/sync/mpsc_queue.h"
+
+#include <stddef.h>
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/util/sync/atomic.h"
+
+// The queue always holds one node more than it has values, tail, so
+// producers never touch the same node as the consumer unless it is the only
+// one.
+struct _MpscNode {
+  MpscNode *volatile next;
+  void *value;
+};
+
+// Most nodes MpscQueue.pool holds.
+#define MAX_POOL_SIZE 64
+
+bool try_lock_pool_(MpscQueue *queue) {
+  return atomic_cas_u32(&queue->is_pool_locked, false, true);
+}
+
+void unlock_pool_(MpscQueue *queue) {
+  atomic_store_u32(&queue->is_pool_locked, false);
+}
+
+MpscNode *node_create_(MpscQueue *queue, void *value) {
+  MpscNode *node = NULL;
+  if (try_lock_pool_(queue)) {
+    node = queue->pool;
+    if (NULL != node) {
+      queue->pool = node->next;
+      --queue->pool_size;
+    }
+    unlock_pool_(queue);
+  }
+  if (NULL == node) {
+    node = MNEW(MpscNode);
+  }
+  node->next = NULL;
+  node->value = value;
+  return node;
+}
+
+void node_release_(MpscQueue *queue, MpscNode *node) {
+  if (try_lock_pool_(queue)) {
+    if (queue->pool_size < MAX_POOL_SIZE) {
+      node->next = queue->pool;
+      queue->pool = node;
+      ++queue->pool_size;
+      node = NULL;
+    }
+    unlock_pool_(queue);
+  }
+  if (NULL != node) {
+    RELEASE(node);
+  }
+}
+
+MpscNode *node_next_(MpscNode *node) {
+  return (MpscNode *)atomic_load_ptr((void *const volatile *)&node->next);
+}
+
+void mpscqueue_init(MpscQueue *queue) {
+  queue->pool = NULL;
+  queue->pool_size = 0;
+  queue->is_pool_locked = false;
+  MpscNode *stub = node_create_(queue, NULL);
+  queue->head = stub;
+  queue->tail = stub;
+  queue->size = 0;
+}
+
+void free_nodes_(MpscNode *node) {
+  while (NULL != node) {
+    MpscNode *next = node_next_(node);
+    RELEASE(node);
+    node = next;
+  }
+}
+
+void mpscqueue_finalize(MpscQueue *queue) {
+  free_nodes_(queue->tail);
+  free_nodes_(queue->pool);
+  queue->head = NULL;
+  queue->tail = NULL;
+  queue->pool = NULL;
+  queue->pool_size = 0;
+}
+
+void mpscqueue_push(MpscQueue *queue, void *value) {
+  MpscNode *node = node_create_(queue, value);
+  MpscNode *prev = (MpscNode *)atomic_exchange_ptr(
+      (void *volatile *)&queue->head, (void *)node);
+  // Until this, the consumer sees the queue end at prev.
+  atomic_store_ptr((void *volatile *)&prev->next, (void *)node);
+  atomic_inc_u32(&queue->size);
+}
+
+bool mpscqueue_pop(MpscQueue *queue, void **value) {
+  MpscNode *tail = queue->tail;
+  MpscNode *next = node_next_(tail);
+  if (NULL == next) {
+    return false;
+  }
+  // next takes over as the node before the next one to pop.
+  *value = next->value;
+  next->value = NULL;
+  queue->tail = next;
+  // Producers are done with tail once they have linked next to it.
+  node_release_(queue, tail);
+  // Linked before size is incremented, so this may briefly wrap below 0.
+  atomic_dec_u32(&queue->size);
+  return true;
+}
+
+uint32_t mpscqueue_size(const MpscQueue *queue) {
+  const uint32_t size = atomic_load_u32(&queue->size);
+  // See mpscqueue_pop().
+  return size > INT32_MAX ? 0 : size;
+}
+
+void mpscqueue_iterator(MpscQueueIterator *iter, MpscQueue *queue,
+                        uint32_t limit) {
+  iter->node = node_next_(queue->tail);
+  iter->remaining = limit;
+}
+
+bool mpscqueue_has_next(const MpscQueueIterator *iter) {
+  return NULL != iter->node && iter->remaining > 0;
+}
+
+void mpscqueue_next(MpscQueueIterator *iter) {
+  iter->node = node_next_(iter->node);
+  --iter->remaining;
+}
+
+void *mpscqueue_value(const MpscQueueIterator *iter) {
+  return iter->node->value;
+}
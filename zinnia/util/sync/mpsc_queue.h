@@ -0,0 +1,66 @@
+// mpsc_queue.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_MPSC_QUEUE_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_MPSC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lock-free FIFO queue with any number of producers and a single consumer.
+//
+// Pushing is wait-free: one exchange and one store. Popping never waits for
+// producers either, but a value whose push has not finished linking it yet
+// is not seen until it has. Whoever pushes must therefore notify the consumer
+// afterwards, not before.
+//
+// Popped nodes are kept for later pushes, so a queue that stays short stops
+// allocating. The pool is only ever tried, never waited for, so a push or pop
+// that finds it busy allocates or frees instead.
+//
+// Only the consumer may pop or iterate.
+
+typedef struct _MpscNode MpscNode;
+
+typedef struct {
+  // Last node pushed. Producers swap themselves in here.
+  MpscNode *volatile head;
+  // Node before the next one to pop. Only touched by the consumer.
+  MpscNode *tail;
+  // Number of values that are fully pushed and not popped yet.
+  volatile uint32_t size;
+  // Nodes to reuse, linked through next. Guarded by is_pool_locked.
+  MpscNode *pool;
+  uint32_t pool_size;
+  volatile uint32_t is_pool_locked;
+} MpscQueue;
+
+typedef struct {
+  MpscNode *node;
+  uint32_t remaining;
+} MpscQueueIterator;
+
+void mpscqueue_init(MpscQueue *queue);
+// Frees every node. Values still queued are dropped.
+void mpscqueue_finalize(MpscQueue *queue);
+
+// Thread-safe.
+void mpscqueue_push(MpscQueue *queue, void *value);
+// Returns false if there is nothing to pop.
+bool mpscqueue_pop(MpscQueue *queue, void **value);
+
+// Thread-safe.
+uint32_t mpscqueue_size(const MpscQueue *queue);
+
+// Iterates over at most limit values from the next one to pop. Values pushed
+// meanwhile may or may not be seen, but the first limit are always the same
+// until the consumer pops.
+void mpscqueue_iterator(MpscQueueIterator *iter, MpscQueue *queue,
+                        uint32_t limit);
+bool mpscqueue_has_next(const MpscQueueIterator *iter);
+void mpscqueue_next(MpscQueueIterator *iter);
+void *mpscqueue_value(const MpscQueueIterator *iter);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_MPSC_QUEUE_H_ */
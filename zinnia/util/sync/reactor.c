@@ -0,0 +1,528 @@
+// reactor.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/util/sync/reactor.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef OS_WINDOWS
+#include <unistd.h>
+#endif
+
+#ifdef OS_HAS_EPOLL
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define REACTOR_EPOLL
+#endif
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/sync/atomic.h"
+#include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/sync/thread.h"
+
+void reactor_run_ops(ReactorOp ops[], uint32_t num_ops) {
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    ReactorOp *op = &ops[i];
+#ifdef OS_WINDOWS
+    op->result = -ENOSYS;
+#else
+    ssize_t result;
+    do {
+      result = REACTOR_READ == op->type
+                   ? pread(op->fd, op->buf, op->len, op->offset)
+                   : pwrite(op->fd, op->buf, op->len, op->offset);
+    } while (result < 0 && EINTR == errno);
+    op->result = result < 0 ? -errno : result;
+#endif
+  }
+}
+
+#ifdef REACTOR_EPOLL
+
+// Most events handled per epoll_wait().
+#define MAX_EVENTS 64
+// Watches of an fd, indexed by ReactorEvent - 1.
+#define NUM_EVENTS 2
+// Size of the io_uring submission queue. Larger submissions are split.
+#define RING_ENTRIES 256
+
+typedef struct {
+  int fd;
+  // Whether fd was added to the epoll instance. Closing fd removes it, so this
+  // may be stale.
+  bool is_added;
+  ReactorFn fns[NUM_EVENTS];
+  void *args[NUM_EVENTS];
+} Watch;
+
+typedef struct _Submission Submission;
+
+// Op in the io_uring, which its completion points back to.
+typedef struct {
+  Submission *submission;
+  ReactorOp *op;
+  struct iovec iov;
+} RingOp;
+
+struct _Submission {
+  ReactorFn fn;
+  void *arg;
+  RingOp *ops;
+  uint32_t num_ops;
+  // Only touched by the reactor thread once submitted.
+  uint32_t num_pending;
+};
+
+typedef struct {
+  // -1 if io_uring is not available.
+  int fd;
+  // Signalled by the kernel as ops complete.
+  int event_fd;
+  // Guards the submission queue.
+  Mutex submit_lock;
+  volatile uint32_t *sq_head, *sq_tail, *sq_flags;
+  uint32_t sq_mask, num_sqes;
+  uint32_t *sq_array;
+  struct io_uring_sqe *sqes;
+  // Only touched by the reactor thread.
+  volatile uint32_t *cq_head, *cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe *cqes;
+  void *sq_ring, *cq_ring;
+  size_t sq_ring_size, cq_ring_size, sqes_size;
+} Ring;
+
+struct _Reactor {
+  int epoll_fd;
+  // Becomes readable when the reactor is stopping.
+  int stop_fd;
+  Ring ring;
+  Mutex lock;
+  // Watches indexed by fd. Guarded by lock. They are only freed with the
+  // reactor since epoll may still return them after their fd is closed.
+  Watch **watches;
+  int num_watches;
+  ThreadHandle thread;
+};
+
+// Must hold lock.
+Watch *watch_for_(Reactor *reactor, int fd) {
+  if (fd >= reactor->num_watches) {
+    int num_watches = 0 == reactor->num_watches ? 64 : reactor->num_watches;
+    while (num_watches <= fd) {
+      num_watches *= 2;
+    }
+    reactor->watches = REALLOC(reactor->watches, Watch *, num_watches);
+    for (int i = reactor->num_watches; i < num_watches; ++i) {
+      reactor->watches[i] = NULL;
+    }
+    reactor->num_watches = num_watches;
+  }
+  Watch *watch = reactor->watches[fd];
+  if (NULL == watch) {
+    watch = CNEW(Watch);
+    watch->fd = fd;
+    watch->is_added = false;
+    reactor->watches[fd] = watch;
+  }
+  return watch;
+}
+
+// Must hold lock. Moves the pending watches of watch into fns and args.
+void take_watches_(Watch *watch, uint32_t events, ReactorFn fns[],
+                   void *args[]) {
+  static const uint32_t EVENT_MASKS[NUM_EVENTS] = {EPOLLIN | EPOLLRDHUP,
+                                                   EPOLLOUT};
+  for (int i = 0; i < NUM_EVENTS; ++i) {
+    if (NULL == watch->fns[i] ||
+        0 == (events & (EVENT_MASKS[i] | EPOLLERR | EPOLLHUP))) {
+      continue;
+    }
+    fns[i] = watch->fns[i];
+    args[i] = watch->args[i];
+    watch->fns[i] = NULL;
+    watch->args[i] = NULL;
+  }
+}
+
+// Must hold lock. Arms fd for one event out of those still watched. Returns
+// false if fd cannot be waited on, e.g. because it is closed.
+bool arm_(Reactor *reactor, Watch *watch) {
+  struct epoll_event event = {.events = EPOLLONESHOT, .data.ptr = watch};
+  if (NULL != watch->fns[REACTOR_READABLE - 1]) {
+    event.events |= EPOLLIN | EPOLLRDHUP;
+  }
+  if (NULL != watch->fns[REACTOR_WRITABLE - 1]) {
+    event.events |= EPOLLOUT;
+  }
+  const int op = watch->is_added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (0 == epoll_ctl(reactor->epoll_fd, op, watch->fd, &event)) {
+    watch->is_added = true;
+    return true;
+  }
+  // is_added was stale, either way.
+  if (ENOENT != errno && EEXIST != errno) {
+    return false;
+  }
+  const int retry_op = EPOLL_CTL_MOD == op ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  watch->is_added =
+      0 == epoll_ctl(reactor->epoll_fd, retry_op, watch->fd, &event);
+  return watch->is_added;
+}
+
+void call_watches_(ReactorFn fns[], void *args[]) {
+  for (int i = 0; i < NUM_EVENTS; ++i) {
+    if (NULL != fns[i]) {
+      fns[i](args[i]);
+    }
+  }
+}
+
+void ring_finalize_(Ring *ring) {
+  if (NULL != ring->sqes && MAP_FAILED != ring->sqes) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (NULL != ring->cq_ring && MAP_FAILED != ring->cq_ring &&
+      ring->cq_ring != ring->sq_ring) {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  if (NULL != ring->sq_ring && MAP_FAILED != ring->sq_ring) {
+    munmap(ring->sq_ring, ring->sq_ring_size);
+  }
+  if (ring->event_fd >= 0) {
+    close(ring->event_fd);
+  }
+  if (ring->fd >= 0) {
+    close(ring->fd);
+    mutex_close(ring->submit_lock);
+  }
+  memset(ring, 0, sizeof(Ring));
+  ring->fd = -1;
+  ring->event_fd = -1;
+}
+
+// Sets up ring, or leaves ring->fd -1 if the kernel does not let us. Kernels
+// which drop completions once too many are pending are not used.
+void ring_init_(Ring *ring) {
+  memset(ring, 0, sizeof(Ring));
+  ring->event_fd = -1;
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring->fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+  if (ring->fd < 0) {
+    return;
+  }
+  ring->submit_lock = mutex_create();
+  ring->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  ring->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool is_single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (is_single_mmap) {
+    if (ring->cq_ring_size > ring->sq_ring_size) {
+      ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  ring->cq_ring =
+      is_single_mmap
+          ? ring->sq_ring
+          : mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  ring->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (0 == (params.features & IORING_FEAT_NODROP) ||
+      MAP_FAILED == ring->sq_ring || MAP_FAILED == ring->cq_ring ||
+      MAP_FAILED == ring->sqes || ring->event_fd < 0 ||
+      0 != syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_EVENTFD,
+                   &ring->event_fd, 1)) {
+    ring_finalize_(ring);
+    return;
+  }
+  char *sq = (char *)ring->sq_ring;
+  ring->sq_head = (volatile uint32_t *)(sq + params.sq_off.head);
+  ring->sq_tail = (volatile uint32_t *)(sq + params.sq_off.tail);
+  ring->sq_flags = (volatile uint32_t *)(sq + params.sq_off.flags);
+  ring->sq_mask = *(uint32_t *)(sq + params.sq_off.ring_mask);
+  ring->num_sqes = params.sq_entries;
+  ring->sq_array = (uint32_t *)(sq + params.sq_off.array);
+  char *cq = (char *)ring->cq_ring;
+  ring->cq_head = (volatile uint32_t *)(cq + params.cq_off.head);
+  ring->cq_tail = (volatile uint32_t *)(cq + params.cq_off.tail);
+  ring->cq_mask = *(uint32_t *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+}
+
+void ring_prep_(Ring *ring, uint32_t tail, RingOp *ring_op) {
+  const uint32_t index = tail & ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  ReactorOp *op = ring_op->op;
+  ring_op->iov.iov_base = op->buf;
+  ring_op->iov.iov_len = op->len;
+  sqe->opcode = REACTOR_READ == op->type ? IORING_OP_READV : IORING_OP_WRITEV;
+  sqe->fd = op->fd;
+  sqe->off = op->offset;
+  sqe->addr = (uint64_t)(uintptr_t)&ring_op->iov;
+  sqe->len = 1;
+  sqe->user_data = (uint64_t)(uintptr_t)ring_op;
+  ring->sq_array[index] = index;
+}
+
+void ring_submit_(Ring *ring, Submission *submission) {
+  // submission may be done and freed as soon as its last op is submitted.
+  RingOp *ops = submission->ops;
+  const uint32_t num_ops = submission->num_ops;
+  SYNCHRONIZED(ring->submit_lock, {
+    uint32_t i = 0;
+    while (i < num_ops) {
+      uint32_t tail = *ring->sq_tail;
+      for (; i < num_ops && tail - atomic_load_u32(ring->sq_head) <
+                                ring->num_sqes;
+           ++i, ++tail) {
+        ring_prep_(ring, tail, &ops[i]);
+      }
+      atomic_store_u32(ring->sq_tail, tail);
+      // The kernel consumes what is submitted before returning, unless it is
+      // too busy to.
+      uint32_t head;
+      while ((head = atomic_load_u32(ring->sq_head)) != tail) {
+        if (syscall(__NR_io_uring_enter, ring->fd, tail - head, 0, 0, NULL,
+                    0) < 0 &&
+            EINTR != errno && EAGAIN != errno && EBUSY != errno) {
+          FATALF("io_uring_enter() failed. errno=%d", errno);
+        }
+      }
+    }
+  });
+}
+
+void ring_reap_(Ring *ring) {
+  uint64_t count;
+  // Only resets it. The completion queue tells what is done.
+  if (read(ring->event_fd, &count, sizeof(count)) < 0 && EAGAIN != errno) {
+    FATALF("Could not read eventfd. errno=%d", errno);
+  }
+  uint32_t head = *ring->cq_head;
+  for (;;) {
+    while (head != atomic_load_u32(ring->cq_tail)) {
+      struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+      RingOp *ring_op = (RingOp *)(uintptr_t)cqe->user_data;
+      ring_op->op->result = cqe->res;
+      atomic_store_u32(ring->cq_head, ++head);
+      Submission *submission = ring_op->submission;
+      if (0 == --submission->num_pending) {
+        submission->fn(submission->arg);
+        RELEASE(submission->ops);
+        RELEASE(submission);
+      }
+    }
+    // Completions that did not fit are held back until asked for.
+    if (0 == (atomic_load_u32(ring->sq_flags) & IORING_SQ_CQ_OVERFLOW)) {
+      return;
+    }
+    syscall(__NR_io_uring_enter, ring->fd, 0, 0, IORING_ENTER_GETEVENTS, NULL,
+            0);
+  }
+}
+
+void run_reactor_(Reactor *reactor) {
+  struct epoll_event events[MAX_EVENTS];
+  for (;;) {
+    const int num_events =
+        epoll_wait(reactor->epoll_fd, events, MAX_EVENTS, /*timeout=*/-1);
+    if (num_events < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      FATALF("epoll_wait() failed. errno=%d", errno);
+    }
+    for (int i = 0; i < num_events; ++i) {
+      if (&reactor->stop_fd == events[i].data.ptr) {
+        return;
+      }
+      if (&reactor->ring == events[i].data.ptr) {
+        ring_reap_(&reactor->ring);
+        continue;
+      }
+      Watch *watch = (Watch *)events[i].data.ptr;
+      ReactorFn fns[NUM_EVENTS] = {NULL};
+      void *args[NUM_EVENTS] = {NULL};
+      SYNCHRONIZED(reactor->lock, {
+        take_watches_(watch, events[i].events, fns, args);
+        // One-shot, so the watches left have to be armed again.
+        if ((NULL != watch->fns[0] || NULL != watch->fns[1]) &&
+            !arm_(reactor, watch)) {
+          take_watches_(watch, EPOLLERR, fns, args);
+        }
+      });
+      call_watches_(fns, args);
+    }
+  }
+}
+
+Reactor *reactor_create() {
+  Reactor *reactor = MNEW(Reactor);
+  reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (reactor->epoll_fd < 0) {
+    FATALF("epoll_create1() failed. errno=%d", errno);
+  }
+  reactor->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (reactor->stop_fd < 0) {
+    FATALF("eventfd() failed. errno=%d", errno);
+  }
+  struct epoll_event stop = {.events = EPOLLIN,
+                             .data.ptr = &reactor->stop_fd};
+  if (0 != epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->stop_fd,
+                     &stop)) {
+    FATALF("epoll_ctl() failed. errno=%d", errno);
+  }
+  ring_init_(&reactor->ring);
+  struct epoll_event reap = {.events = EPOLLIN, .data.ptr = &reactor->ring};
+  if (reactor->ring.fd >= 0 &&
+      0 != epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->ring.event_fd,
+                     &reap)) {
+    ring_finalize_(&reactor->ring);
+  }
+  reactor->lock = mutex_create();
+  reactor->watches = NULL;
+  reactor->num_watches = 0;
+  reactor->thread = thread_create((VoidFn)run_reactor_, (void *)reactor);
+  return reactor;
+}
+
+void reactor_delete(Reactor *reactor) {
+  ASSERT(reactor != NULL);
+  const uint64_t stop = 1;
+  if (sizeof(stop) != write(reactor->stop_fd, &stop, sizeof(stop))) {
+    FATALF("Could not stop reactor. errno=%d", errno);
+  }
+  thread_join(reactor->thread, INFINITE);
+  ring_finalize_(&reactor->ring);
+  close(reactor->stop_fd);
+  close(reactor->epoll_fd);
+  for (int i = 0; i < reactor->num_watches; ++i) {
+    if (NULL != reactor->watches[i]) {
+      RELEASE(reactor->watches[i]);
+    }
+  }
+  if (NULL != reactor->watches) {
+    RELEASE(reactor->watches);
+  }
+  mutex_close(reactor->lock);
+  RELEASE(reactor);
+}
+
+void reactor_watch(Reactor *reactor, int fd, ReactorEvent event, ReactorFn fn,
+                   void *arg) {
+  ASSERT(reactor != NULL);
+  ASSERT(fn != NULL);
+  ReactorFn fns[NUM_EVENTS] = {NULL};
+  void *args[NUM_EVENTS] = {NULL};
+  if (fd < 0) {
+    fn(arg);
+    return;
+  }
+  SYNCHRONIZED(reactor->lock, {
+    Watch *watch = watch_for_(reactor, fd);
+    ASSERT(NULL == watch->fns[event - 1]);
+    watch->fns[event - 1] = fn;
+    watch->args[event - 1] = arg;
+    if (!arm_(reactor, watch)) {
+      take_watches_(watch, EPOLLERR, fns, args);
+    }
+  });
+  call_watches_(fns, args);
+}
+
+void reactor_wake(Reactor *reactor, int fd) {
+  ASSERT(reactor != NULL);
+  ReactorFn fns[NUM_EVENTS] = {NULL};
+  void *args[NUM_EVENTS] = {NULL};
+  SYNCHRONIZED(reactor->lock, {
+    if (fd >= 0 && fd < reactor->num_watches &&
+        NULL != reactor->watches[fd]) {
+      take_watches_(reactor->watches[fd], EPOLLERR, fns, args);
+    }
+  });
+  call_watches_(fns, args);
+}
+
+void reactor_await(int fd, ReactorEvent event) {
+  struct pollfd pfd = {
+      .fd = fd, .events = REACTOR_READABLE == event ? POLLIN : POLLOUT};
+  while (poll(&pfd, 1, /*timeout=*/-1) < 0 && EINTR == errno) {
+  }
+}
+
+void reactor_submit(Reactor *reactor, ReactorOp ops[], uint32_t num_ops,
+                    ReactorFn fn, void *arg) {
+  ASSERT(reactor != NULL);
+  ASSERT(fn != NULL);
+  if (reactor->ring.fd < 0 || 0 == num_ops) {
+    reactor_run_ops(ops, num_ops);
+    fn(arg);
+    return;
+  }
+  Submission *submission = MNEW(Submission);
+  submission->fn = fn;
+  submission->arg = arg;
+  submission->ops = MNEW_ARR(RingOp, num_ops);
+  submission->num_ops = num_ops;
+  submission->num_pending = num_ops;
+  for (uint32_t i = 0; i < num_ops; ++i) {
+    submission->ops[i].submission = submission;
+    submission->ops[i].op = &ops[i];
+  }
+  ring_submit_(&reactor->ring, submission);
+}
+
+#else
+
+// Nothing to keep, but structs cannot be empty.
+struct _Reactor {
+  bool unused;
+};
+
+Reactor *reactor_create() { return CNEW(Reactor); }
+
+void reactor_delete(Reactor *reactor) {
+  ASSERT(reactor != NULL);
+  RELEASE(reactor);
+}
+
+void reactor_watch(Reactor *reactor, int fd, ReactorEvent event, ReactorFn fn,
+                   void *arg) {
+  ASSERT(reactor != NULL);
+  ASSERT(fn != NULL);
+  fn(arg);
+}
+
+void reactor_wake(Reactor *reactor, int fd) { ASSERT(reactor != NULL); }
+
+void reactor_await(int fd, ReactorEvent event) {}
+
+void reactor_submit(Reactor *reactor, ReactorOp ops[], uint32_t num_ops,
+                    ReactorFn fn, void *arg) {
+  ASSERT(reactor != NULL);
+  ASSERT(fn != NULL);
+  reactor_run_ops(ops, num_ops);
+  fn(arg);
+}
+
+#endif
@@ -0,0 +1,79 @@
+// reactor.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_REACTOR_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_REACTOR_H_
+
+#include <stdint.h>
+
+#include "zinnia/util/platform.h"
+
+// Waits on a thread of its own for file descriptors to become ready and for
+// file reads and writes to finish, so that whoever would otherwise block on
+// them does not hold a thread meanwhile.
+//
+// On Linux every watched descriptor shares one epoll instance, and file
+// operations are submitted to an io_uring whose completions it also waits on.
+// Without io_uring, file operations are done right away on the thread that
+// submits them. Elsewhere there is nothing to wait with, so watches fire right
+// away and whoever watches simply tries again.
+
+typedef enum {
+  REACTOR_READABLE = 1,
+  REACTOR_WRITABLE = 2,
+} ReactorEvent;
+
+typedef void (*ReactorFn)(void *arg);
+
+typedef enum {
+  REACTOR_READ,
+  REACTOR_WRITE,
+} ReactorOpType;
+
+// Read into or write from buf at offset in file fd.
+typedef struct {
+  ReactorOpType type;
+  int fd;
+  char *buf;
+  uint32_t len;
+  int64_t offset;
+  // Number of bytes read or written once done, or -errno if it failed.
+  int64_t result;
+} ReactorOp;
+
+typedef struct _Reactor Reactor;
+
+Reactor *reactor_create();
+// Stops the reactor. Watches still pending are dropped without being called.
+void reactor_delete(Reactor *reactor);
+
+// Calls fn(arg) on the reactor thread once fd is ready for event, errors or is
+// hung up on. At most one watch per fd and event may be pending at a time.
+//
+// Thread-safe.
+void reactor_watch(Reactor *reactor, int fd, ReactorEvent event, ReactorFn fn,
+                   void *arg);
+
+// Calls every watch pending on fd right away on the calling thread. Must be
+// done before fd is closed, since a closed fd is never ready.
+//
+// Thread-safe.
+void reactor_wake(Reactor *reactor, int fd);
+
+// Blocks the calling thread until fd is ready for event, for when there is no
+// thread to spare for waiting on a reactor.
+void reactor_await(int fd, ReactorEvent event);
+
+// Submits every op together and calls fn(arg) once they are all done. ops must
+// stay valid until then.
+//
+// Thread-safe.
+void reactor_submit(Reactor *reactor, ReactorOp ops[], uint32_t num_ops,
+                    ReactorFn fn, void *arg);
+
+// Does every op on the calling thread, one after the other.
+void reactor_run_ops(ReactorOp ops[], uint32_t num_ops);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_REACTOR_H_ */
@@ -10,6 +10,8 @@
 #ifdef OS_WINDOWS
 #include <process.h>
 #include <windows.h>
+#else
+#include <unistd.h>
 #endif
 
 ThreadHandle thread_create(VoidFn fn, void *arg) {
@@ -38,3 +40,14 @@ void thread_close(ThreadHandle thread) {
   pthread_cancel(thread);
 #endif
 }
+
+uint32_t thread_num_cores() {
+#ifdef OS_WINDOWS
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  const long num_cores = info.dwNumberOfProcessors;
+#else
+  const long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return num_cores < 1 ? 1 : (uint32_t)num_cores;
+}
@@ -18,14 +18,25 @@ typedef uintptr_t ThreadHandle;
 typedef unsigned (*VoidFn)(void *);
 #else
 #include <pthread.h>
+#include <stdint.h>
 typedef pthread_t ThreadHandle;
 typedef void *(*VoidFn)(void *);
 #endif
 
 #define AS_VOID_FN(fn) ((VoidFn)fn)
 
+// Gives a static variable one instance per thread.
+#if defined(OS_WINDOWS) && !defined(__GNUC__)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 ThreadHandle thread_create(VoidFn fn, void *arg);
 WaitStatus thread_join(ThreadHandle thread, unsigned long duration);
 void thread_close(ThreadHandle thread);
 
+// Returns the number of processors available, at least 1.
+uint32_t thread_num_cores();
+
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_UTIL_SYNC_THREAD_H_ */
\ No newline at end of file
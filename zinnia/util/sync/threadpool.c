@@ -1,66 +1,218 @@
 #include "zinnia/util/sync/threadpool.h"
 
+#include <stdbool.h>
+
 #include "zinnia/alloc/alloc.h"
+#include "zinnia/util/deque.h"
+#include "zinnia/util/sync/atomic.h"
 #include "zinnia/util/sync/critical_section.h"
 #include "zinnia/util/sync/thread.h"
-#include "zinnia/util/void_array.h"
+
+// Finished Work kept by each worker for reuse.
+#define MAX_FREE_WORK 64
+
+typedef struct Worker__ Worker;
 
 struct Work__ {
   VoidFnPtr fn;
   VoidFnPtr callback;
   VoidPtr fn_args;
+  Work *next_free;
+};
+
+struct Worker__ {
+  ThreadPool *tp;
+  uint32_t index;
+  // Guards work, free_work and is_woken. The worker waits on work_cond until
+  // it is woken to look for work in any of the queues.
+  CriticalSection work_cs;
+  Condition *work_cond;
+  // Popped from the front by the worker and from the back by thieves.
+  Deque work;
+  Work *free_work;
+  uint32_t num_free_work;
+  bool is_woken;
+  // Whether the worker is on the idle stack, so work is best queued on it.
+  // Only written under the pool's idle_cs.
+  volatile uint32_t is_idle;
+  ThreadHandle thread;
 };
 
 struct ThreadPool__ {
   size_t num_threads;
-  ThreadHandle *threads;
-  CriticalSection work_mutex;
-  Condition *work_cond;
-  VoidPtrArray work;
+  Worker *workers;
+  // Round-robins the workers new work is queued on and Work is taken from.
+  volatile uint32_t next_worker;
+  // Guards idle and num_idle. Every push wakes one idle worker, whichever
+  // queue it went to, so work on a busy worker's queue is stolen promptly.
+  CriticalSection idle_cs;
+  Worker **idle;
+  uint32_t num_idle;
 };
 
-void do_work_(ThreadPool *tp) {
-  Work *w = NULL;
-  for (;;) {
-    CRITICAL(tp->work_mutex, {
-      while (VoidPtrArray_is_empty(&tp->work)) {
-        condition_wait(tp->work_cond);
+Worker *next_worker_(ThreadPool *tp) {
+  return &tp->workers[atomic_inc_u32(&tp->next_worker) % tp->num_threads];
+}
+
+// Prefers an idle worker over one which would have to finish its work first.
+Worker *pick_worker_(ThreadPool *tp) {
+  const uint32_t start = atomic_inc_u32(&tp->next_worker);
+  for (uint32_t i = 0; i < tp->num_threads; ++i) {
+    Worker *worker = &tp->workers[(start + i) % tp->num_threads];
+    if (atomic_load_u32(&worker->is_idle)) {
+      return worker;
+    }
+  }
+  return &tp->workers[start % tp->num_threads];
+}
+
+Work *pop_work_(Worker *worker) {
+  void *w = NULL;
+  CRITICAL(worker->work_cs, { deque_pop_front(&worker->work, &w); });
+  return (Work *)w;
+}
+
+// Takes the most recently queued work of another worker. Only one lock is
+// held at a time, so workers stealing from each other cannot deadlock.
+Work *steal_work_(Worker *thief) {
+  ThreadPool *tp = thief->tp;
+  for (uint32_t i = 1; i < tp->num_threads; ++i) {
+    Worker *victim = &tp->workers[(thief->index + i) % tp->num_threads];
+    void *w = NULL;
+    CRITICAL(victim->work_cs, { deque_pop_back(&victim->work, &w); });
+    if (NULL != w) {
+      return (Work *)w;
+    }
+  }
+  return NULL;
+}
+
+void release_work_(Worker *worker, Work *w) {
+  CRITICAL(worker->work_cs, {
+    if (worker->num_free_work < MAX_FREE_WORK) {
+      w->next_free = worker->free_work;
+      worker->free_work = w;
+      ++worker->num_free_work;
+      w = NULL;
+    }
+  });
+  if (NULL != w) {
+    RELEASE(w);
+  }
+}
+
+bool has_work_(ThreadPool *tp) {
+  for (uint32_t i = 0; i < tp->num_threads; ++i) {
+    Worker *worker = &tp->workers[i];
+    bool has_work;
+    CRITICAL(worker->work_cs, { has_work = !deque_is_empty(&worker->work); });
+    if (has_work) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Must be called under idle_cs.
+void remove_idle_(ThreadPool *tp, Worker *worker) {
+  for (uint32_t i = 0; i < tp->num_idle; ++i) {
+    if (tp->idle[i] == worker) {
+      tp->idle[i] = tp->idle[--tp->num_idle];
+      break;
+    }
+  }
+  atomic_store_u32(&worker->is_idle, 0);
+}
+
+// Blocks until work may have been queued on any worker. The worker is on the
+// idle stack before it checks the queues, so work pushed after the check
+// always finds it there and wakes it.
+void wait_for_work_(Worker *worker) {
+  ThreadPool *tp = worker->tp;
+  CRITICAL(tp->idle_cs, {
+    tp->idle[tp->num_idle++] = worker;
+    atomic_store_u32(&worker->is_idle, 1);
+  });
+  if (has_work_(tp)) {
+    CRITICAL(tp->idle_cs, {
+      if (atomic_load_u32(&worker->is_idle)) {
+        remove_idle_(tp, worker);
       }
-      w = (Work *)VoidPtrArray_pop_front_unchecked(&tp->work);
     });
+    return;
+  }
+  CRITICAL(worker->work_cs, {
+    while (!worker->is_woken) {
+      condition_wait(worker->work_cond);
+    }
+    worker->is_woken = false;
+  });
+}
+
+void do_work_(Worker *worker) {
+  for (;;) {
+    Work *w = pop_work_(worker);
+    if (NULL == w) {
+      w = steal_work_(worker);
+    }
     if (NULL != w) {
       w->fn(w->fn_args);
       w->callback(w->fn_args);
-      RELEASE(w);
-      w = NULL;
+      release_work_(worker, w);
+      continue;
     }
+    wait_for_work_(worker);
   }
 }
 
 ThreadPool *threadpool_create(size_t num_threads) {
   ThreadPool *tp = MNEW(ThreadPool);
-  VoidPtrArray_init(&tp->work);
-
   tp->num_threads = num_threads;
-  tp->work_mutex = critical_section_create();
-  tp->work_cond = critical_section_create_condition(tp->work_mutex);
-  tp->threads = MNEW_ARR(ThreadHandle, num_threads);
+  tp->next_worker = 0;
+  tp->workers = MNEW_ARR(Worker, num_threads);
+  tp->idle_cs = critical_section_create();
+  tp->idle = MNEW_ARR(Worker *, num_threads);
+  tp->num_idle = 0;
   int i;
   for (i = 0; i < num_threads; ++i) {
-    tp->threads[i] = thread_create((VoidFn)do_work_, (VoidPtr)tp);
+    Worker *worker = &tp->workers[i];
+    worker->tp = tp;
+    worker->index = i;
+    worker->work_cs = critical_section_create();
+    worker->work_cond = critical_section_create_condition(worker->work_cs);
+    deque_init(&worker->work);
+    worker->free_work = NULL;
+    worker->num_free_work = 0;
+    worker->is_woken = false;
+    worker->is_idle = 0;
+  }
+  // Only started once every worker exists since they steal from each other.
+  for (i = 0; i < num_threads; ++i) {
+    tp->workers[i].thread =
+        thread_create((VoidFn)do_work_, (VoidPtr)&tp->workers[i]);
   }
   return tp;
 }
 
 void threadpool_delete(ThreadPool *tp) {
-  VoidPtrArray_finalize(&tp->work);
-  critical_section_delete(tp->work_mutex);
-  condition_delete(tp->work_cond);
   int i;
   for (i = 0; i < tp->num_threads; ++i) {
-    thread_close(tp->threads[i]);
+    thread_close(tp->workers[i].thread);
   }
-  RELEASE(tp->threads);
+  for (i = 0; i < tp->num_threads; ++i) {
+    Worker *worker = &tp->workers[i];
+    while (NULL != worker->free_work) {
+      Work *next = worker->free_work->next_free;
+      RELEASE(worker->free_work);
+      worker->free_work = next;
+    }
+    deque_finalize(&worker->work);
+    condition_delete(worker->work_cond);
+    critical_section_delete(worker->work_cs);
+  }
+  critical_section_delete(tp->idle_cs);
+  RELEASE(tp->idle);
+  RELEASE(tp->workers);
   RELEASE(tp);
 }
 
@@ -72,14 +224,46 @@ void threadpool_execute(ThreadPool *tp, VoidFnPtr fn, VoidFnPtr callback,
 
 Work *threadpool_create_work(ThreadPool *tp, VoidFnPtr fn, VoidFnPtr callback,
                              VoidPtr fn_args) {
-  Work *w = MNEW(Work);
+  Worker *worker = next_worker_(tp);
+  Work *w = NULL;
+  CRITICAL(worker->work_cs, {
+    if (NULL != worker->free_work) {
+      w = worker->free_work;
+      worker->free_work = w->next_free;
+      --worker->num_free_work;
+    }
+  });
+  if (NULL == w) {
+    w = MNEW(Work);
+  }
   w->fn = fn;
   w->callback = callback;
   w->fn_args = fn_args;
+  w->next_free = NULL;
   return w;
 }
 
 void threadpool_execute_work(ThreadPool *tp, Work *w) {
-  CRITICAL(tp->work_mutex, { *VoidPtrArray_push_back_ref(&tp->work) = w; });
-  condition_broadcast(tp->work_cond);
-}
\ No newline at end of file
+  Worker *worker = pick_worker_(tp);
+  CRITICAL(worker->work_cs, { deque_push_back(&worker->work, w); });
+  // Wakes the worker the work is queued on if it is idle, otherwise any idle
+  // worker so it steals the work rather than waiting on the busy one.
+  Worker *to_wake = NULL;
+  CRITICAL(tp->idle_cs, {
+    if (atomic_load_u32(&worker->is_idle)) {
+      to_wake = worker;
+    } else if (tp->num_idle > 0) {
+      to_wake = tp->idle[tp->num_idle - 1];
+    }
+    if (NULL != to_wake) {
+      remove_idle_(tp, to_wake);
+    }
+  });
+  if (NULL == to_wake) {
+    return;
+  }
+  CRITICAL(to_wake->work_cs, {
+    to_wake->is_woken = true;
+    condition_signal(to_wake->work_cond);
+  });
+}
@@ -6,6 +6,9 @@
 typedef void (*VoidFnPtr)(void *);
 typedef void *VoidPtr;
 
+// Each thread has a queue of its own and steals from the others once it is
+// empty. Work is queued on an idle thread when there is one, and every push
+// wakes one idle thread, which then scans all of the queues.
 typedef struct ThreadPool__ ThreadPool;
 typedef struct Work__ Work;
 
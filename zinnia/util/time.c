@@ -26,6 +26,22 @@ int64_t current_usec_since_epoch() {
   return timestamp_to_micros(&ts);
 }
 
+int64_t current_monotonic_usec() {
+#ifdef linux
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 * 1000 + ts.tv_nsec / 1000;
+#endif
+#ifdef _WIN32
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return counter.QuadPart / frequency.QuadPart * 1000 * 1000 +
+         counter.QuadPart % frequency.QuadPart * 1000 * 1000 /
+             frequency.QuadPart;
+#endif
+}
+
 int64_t timestamp_to_micros(const Timestamp *ts) {
   struct tm tm = {.tm_year = ts->year - 1900,
                   .tm_mon = ts->month - 1,
@@ -27,6 +27,9 @@ typedef struct {
 } TimezoneOffset;
 
 int64_t current_usec_since_epoch();
+// Microseconds since an arbitrary point which never goes backwards. Only
+// meaningful for measuring how long something took.
+int64_t current_monotonic_usec();
 Timestamp current_local_timestamp();
 Timestamp current_gmt_timestamp();
 int64_t timestamp_to_micros(const Timestamp *ts);
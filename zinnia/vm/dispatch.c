@@ -0,0 +1,148 @@
+// dispatch.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/vm/dispatch.h"
+
+Handler dispatch_handler(const Instruction *ins) {
+  switch (ins->op) {
+    case RES:
+      switch (ins->type) {
+        case INSTRUCTION_NO_ARG:
+          return RES_STACK;
+        case INSTRUCTION_ID:
+          return RES_ID;
+        case INSTRUCTION_PRIMITIVE:
+          return RES_PRIM;
+        case INSTRUCTION_STRING:
+          return RES_STR;
+        default:
+          break;
+      }
+      break;
+    case PUSH:
+      switch (ins->type) {
+        case INSTRUCTION_NO_ARG:
+          return PUSH_RES;
+        case INSTRUCTION_ID:
+          return PUSH_ID;
+        case INSTRUCTION_PRIMITIVE:
+          return PUSH_PRIM;
+        case INSTRUCTION_STRING:
+          return PUSH_STR;
+        default:
+          break;
+      }
+      break;
+    default:
+      break;
+  }
+  // Unknown ops are reported by the interpreter.
+  return (Handler)ins->op;
+}
+
+void dispatch_decode(Tape *tape) {
+  const size_t size = tape_size(tape);
+  for (int i = 0; i < size; ++i) {
+    Instruction *ins = tape_get_mutable(tape, i);
+    ins->handler = (uint8_t)dispatch_handler(ins);
+  }
+}
+
+// Number of times an instruction may be deoptimized before it is left generic.
+#define MAX_DEOPTS 4
+
+#define INT_HANDLERS(op)                         \
+  case op:                                       \
+    switch (ins->type) {                         \
+      case INSTRUCTION_NO_ARG:                   \
+        return op##_INT_INT;                     \
+      case INSTRUCTION_SLOT:                     \
+        return op##_INT_SLOT;                    \
+      case INSTRUCTION_PRIMITIVE:                \
+        if (PRIMITIVE_INT == ins->val_type) { \
+          return op##_INT_IMM;                   \
+        }                                        \
+        return (Handler)op;                      \
+      default:                                   \
+        return (Handler)op;                      \
+    }
+
+Handler int_handler_(const Instruction *ins) {
+  switch (ins->op) {
+    INT_HANDLERS(ADD)
+    INT_HANDLERS(SUB)
+    INT_HANDLERS(MULT)
+    INT_HANDLERS(LT)
+    INT_HANDLERS(GT)
+    INT_HANDLERS(LTE)
+    INT_HANDLERS(GTE)
+    default:
+      return (Handler)ins->op;
+  }
+}
+
+Handler str_handler_(const Instruction *ins) {
+  if (ADD != ins->op) {
+    return (Handler)ins->op;
+  }
+  switch (ins->type) {
+    case INSTRUCTION_NO_ARG:
+      return ADD_STR;
+    case INSTRUCTION_SLOT:
+      return ADD_STR_SLOT;
+    default:
+      return (Handler)ins->op;
+  }
+}
+
+// Instructions live in the tape, which the VM owns once it is loaded. They
+// are shared by every process running the module, so these are atomic.
+void set_handler_(const Instruction *ins, Handler handler) {
+#if defined(__GNUC__)
+  __atomic_store_n(&((Instruction *)ins)->handler, (uint8_t)handler,
+                   __ATOMIC_RELAXED);
+#else
+  *(volatile uint8_t *)&((Instruction *)ins)->handler = (uint8_t)handler;
+#endif
+}
+
+uint8_t deopts_(const Instruction *ins) {
+#if defined(__GNUC__)
+  return __atomic_load_n(&ins->deopts, __ATOMIC_RELAXED);
+#else
+  return *(const volatile uint8_t *)&ins->deopts;
+#endif
+}
+
+bool dispatch_should_quicken(const Instruction *ins) {
+#ifdef ZINNIA_COMPUTED_GOTO
+  return deopts_(ins) < MAX_DEOPTS;
+#else
+  // The switch dispatches on Instruction.op.
+  return false;
+#endif
+}
+
+void dispatch_quicken_int(const Instruction *ins) {
+  set_handler_(ins, int_handler_(ins));
+}
+
+void dispatch_quicken_str(const Instruction *ins) {
+  set_handler_(ins, str_handler_(ins));
+}
+
+void dispatch_deopt(const Instruction *ins) {
+  set_handler_(ins, dispatch_handler(ins));
+  // A racing deopt may be lost, which only delays leaving ins generic.
+  const uint8_t deopts = deopts_(ins);
+  if (deopts < MAX_DEOPTS) {
+#if defined(__GNUC__)
+    __atomic_store_n(&((Instruction *)ins)->deopts, deopts + 1,
+                     __ATOMIC_RELAXED);
+#else
+    *(volatile uint8_t *)&((Instruction *)ins)->deopts = deopts + 1;
+#endif
+  }
+}
@@ -0,0 +1,116 @@
+// dispatch.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_DISPATCH_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_DISPATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zinnia/program/instruction.h"
+#include "zinnia/program/op.h"
+#include "zinnia/program/tape.h"
+
+// Computed-goto dispatch is used whenever the compiler supports labels as
+// values. Build with --define=dispatch=switch to use the switch instead.
+#if defined(__GNUC__) && !defined(ZINNIA_SWITCH_DISPATCH) && !defined(DEBUG)
+#define ZINNIA_COMPUTED_GOTO
+#endif
+
+// What the interpreter dispatches on.
+//
+// Each op is its own handler, so handlers below OP_BOUND behave exactly like
+// the op. The rest are specialized for a single operand type, which saves
+// re-switching on Instruction.type when they are executed.
+typedef enum {
+  // RES with no arg.
+  RES_STACK = OP_BOUND,
+  RES_ID,
+  RES_PRIM,
+  RES_STR,
+  // PUSH with no arg.
+  PUSH_RES,
+  PUSH_ID,
+  PUSH_PRIM,
+  PUSH_STR,
+  // Quickened handlers. INT_INT takes two Ints from the stack, INT_SLOT takes
+  // an Int in resval and an Int local, and INT_IMM takes an Int in resval and
+  // an Int constant.
+  ADD_INT_INT,
+  ADD_INT_SLOT,
+  ADD_INT_IMM,
+  SUB_INT_INT,
+  SUB_INT_SLOT,
+  SUB_INT_IMM,
+  MULT_INT_INT,
+  MULT_INT_SLOT,
+  MULT_INT_IMM,
+  LT_INT_INT,
+  LT_INT_SLOT,
+  LT_INT_IMM,
+  GT_INT_INT,
+  GT_INT_SLOT,
+  GT_INT_IMM,
+  LTE_INT_INT,
+  LTE_INT_SLOT,
+  LTE_INT_IMM,
+  GTE_INT_INT,
+  GTE_INT_SLOT,
+  GTE_INT_IMM,
+  // ADD with two Strings from the stack.
+  ADD_STR,
+  // ADD with a String in resval and a String local.
+  ADD_STR_SLOT,
+  // NOT A REAL HANDLER
+  HANDLER_BOUND,
+} Handler;
+
+// Returns the handler that executes ins.
+Handler dispatch_handler(const Instruction *ins);
+
+// Returns the handler currently installed on ins.
+//
+// Tapes are shared by every process running the module, so the handler may
+// be quickened or deoptimized by another thread at any time. Any handler
+// that was installed is fine to run, so no ordering is needed.
+static inline Handler dispatch_current_handler(const Instruction *ins) {
+#if defined(__GNUC__)
+  return (Handler)__atomic_load_n(&ins->handler, __ATOMIC_RELAXED);
+#else
+  return (Handler)*(const volatile uint8_t *)&ins->handler;
+#endif
+}
+
+// Sets Instruction.handler on every instruction in tape.
+//
+// Must run after all other load-time rewrites of the tape, and again whenever
+// the tape is appended to.
+void dispatch_decode(Tape *tape);
+
+// Quickening.
+//
+// Arithmetic and comparisons are decoded to their generic handler. When the
+// interpreter executes one on Ints, or ADD on Strings, it quickens the
+// instruction by installing the handler specialized for those types. A
+// quickened handler checks the types of its operands and deoptimizes the
+// instruction back to the generic handler when they do not match. After being
+// deoptimized a few times, an instruction is left generic.
+//
+// Every handler of an instruction accepts any operands, so a racing reader
+// may see either the old or new handler.
+
+// Whether the interpreter should try to quicken ins.
+bool dispatch_should_quicken(const Instruction *ins);
+
+// Quickens ins for Int operands, if it has a handler for them.
+void dispatch_quicken_int(const Instruction *ins);
+
+// Quickens ins for String operands, if it has a handler for them.
+void dispatch_quicken_str(const Instruction *ins);
+
+// Reverts ins to its generic handler.
+void dispatch_deopt(const Instruction *ins);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_DISPATCH_H_ */
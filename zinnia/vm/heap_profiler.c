@@ -0,0 +1,306 @@
+// heap_profiler.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/vm/heap_profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "c-data-structures/maplike.h"
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/entity/class/layout.h"
+#include "zinnia/heap/heap.h"
+#include "zinnia/program/tape.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/void_array.h"
+#include "zinnia/vm/process/task.h"
+
+// Deeper stacks are truncated to their innermost frames.
+#define MAX_FRAMES 64
+#define MAX_STACK_LEN 4096
+
+typedef struct {
+  // Frames from the outermost in, separated by ';'.
+  char *stack;
+  // Position in _HeapProfiler.site_list.
+  uint32_t index;
+  uint64_t alloc_objects;
+  uint64_t live_objects;
+  // Bytes of the sampled objects that were already deleted.
+  uint64_t deleted_bytes;
+} HeapSite;
+
+// Passed to the sampler of each attached process.
+typedef struct _Attachment {
+  HeapProfiler *profiler;
+  Process *process;
+  struct _Attachment *next;
+} Attachment;
+
+DEFINE_MAPLIKE(HeapSiteMap, char *, HeapSite *);
+IMPL_MAPLIKE(HeapSiteMap, char *, HeapSite *);
+// Only holds the sampled objects which have not been deleted yet.
+DEFINE_MAPLIKE(SampledObjectMap, Object *, HeapSite *);
+IMPL_MAPLIKE(SampledObjectMap, Object *, HeapSite *);
+
+struct _HeapProfiler {
+  uint32_t sample_interval;
+  // Guards everything below. Processes sample on their own threads.
+  Mutex lock;
+  HeapSiteMap sites;
+  // The same sites in the order they were first sampled.
+  VoidPtrArray site_list;
+  SampledObjectMap objects;
+  Attachment *attachments;
+};
+
+uint32_t hash_sampled_object_(const Object *obj, uint32_t size) {
+  return (uint32_t)(intptr_t)obj;
+}
+
+int32_t compare_sampled_objects_(const Object *obj1, uint32_t size1,
+                                 const Object *obj2, uint32_t size2) {
+  return (intptr_t)obj1 - (intptr_t)obj2;
+}
+
+bool heapprofile_value_parse(const char name[], HeapProfileValue *value) {
+  ASSERT(name != NULL);
+  ASSERT(value != NULL);
+  if (0 == strcmp("live_bytes", name)) {
+    *value = HEAP_PROFILE_LIVE_BYTES;
+    return true;
+  }
+  if (0 == strcmp("live_objects", name)) {
+    *value = HEAP_PROFILE_LIVE_OBJECTS;
+    return true;
+  }
+  if (0 == strcmp("alloc_bytes", name)) {
+    *value = HEAP_PROFILE_ALLOC_BYTES;
+    return true;
+  }
+  if (0 == strcmp("alloc_objects", name)) {
+    *value = HEAP_PROFILE_ALLOC_OBJECTS;
+    return true;
+  }
+  return false;
+}
+
+HeapProfiler *heapprofiler_create(uint32_t sample_interval) {
+  ASSERT(sample_interval > 0);
+  HeapProfiler *profiler = MNEW(HeapProfiler);
+  profiler->sample_interval = sample_interval;
+  profiler->lock = mutex_create();
+  profiler->attachments = NULL;
+  HeapSiteMap_init(&profiler->sites, hash_string, compare_strings);
+  VoidPtrArray_init(&profiler->site_list);
+  SampledObjectMap_init(&profiler->objects, hash_sampled_object_,
+                        compare_sampled_objects_);
+  return profiler;
+}
+
+void heapprofiler_delete(HeapProfiler *profiler) {
+  ASSERT(profiler != NULL);
+  for (int i = 0; i < VoidPtrArray_size(&profiler->site_list); ++i) {
+    HeapSite *site =
+        (HeapSite *)VoidPtrArray_get_unchecked(&profiler->site_list, i);
+    RELEASE(site->stack);
+    RELEASE(site);
+  }
+  VoidPtrArray_finalize(&profiler->site_list);
+  HeapSiteMap_finalize(&profiler->sites);
+  while (NULL != profiler->attachments) {
+    Attachment *next = profiler->attachments->next;
+    RELEASE(profiler->attachments);
+    profiler->attachments = next;
+  }
+  SampledObjectMap_finalize(&profiler->objects);
+  mutex_close(profiler->lock);
+  RELEASE(profiler);
+}
+
+// What the heap is charged for obj, not counting its member map.
+size_t object_bytes_(const Object *obj) {
+  return sizeof(Object) + obj->_internal_bytes +
+         (NULL == obj->_slots
+              ? 0
+              : obj->_class->_layout->num_slots * sizeof(Entity));
+}
+
+// Whether the context after ctx belongs to the same function, i.e., ctx is a
+// block. Blocks have no func of their own.
+bool is_block_(const Context *ctx) {
+  return NULL == ctx->func && NULL != ctx->previous_context;
+}
+
+// Appends the frame whose innermost context is ctx to buf, which already
+// holds len chars.
+size_t append_frame_(char buf[], size_t len, const Context *ctx,
+                     bool is_current) {
+  int32_t line = -1;
+  if (NULL != ctx->tape && (is_current || ctx->ins > 0)) {
+    const SourceMapping *sm =
+        tape_get_source(ctx->tape, ctx->ins - (is_current ? 0 : 1));
+    line = (NULL == sm) ? -1 : sm->line + 1;
+  }
+  const char *module = NULL == ctx->module ? "?" : ctx->module->_name;
+  const Context *func_ctx = ctx;
+  while (is_block_(func_ctx)) {
+    func_ctx = func_ctx->previous_context;
+  }
+  const Function *func = func_ctx->func;
+  int written;
+  if (NULL == func) {
+    written = snprintf(buf + len, MAX_STACK_LEN - len, "%s:%d", module, line);
+  } else if (NULL != func->_parent_class) {
+    written = snprintf(buf + len, MAX_STACK_LEN - len, "%s.%s.%s:%d", module,
+                       func->_parent_class->_name, func->_name, line);
+  } else {
+    written = snprintf(buf + len, MAX_STACK_LEN - len, "%s.%s:%d", module,
+                       func->_name, line);
+  }
+  return written < 0 ? len : len + written;
+}
+
+// Writes the stack of the task currently running on process to buf.
+void current_stack_(Process *process, char buf[]) {
+  const Context *frames[MAX_FRAMES];
+  int num_frames = 0;
+  for (Task *task = process->current_task;
+       NULL != task && num_frames < MAX_FRAMES; task = task->parent_task) {
+    Context *ctx = task->current, *caller = NULL;
+    // Only the innermost context of each function is kept since it has the
+    // current instruction.
+    bool is_new_frame = true;
+    for (; NULL != ctx && num_frames < MAX_FRAMES;
+         ctx = task_next_context(ctx, &caller)) {
+      if (is_new_frame) {
+        frames[num_frames++] = ctx;
+      }
+      is_new_frame = !is_block_(ctx);
+    }
+  }
+  if (0 == num_frames) {
+    // Allocated while no task was running, e.g., while loading modules.
+    strcpy(buf, "<vm>");
+    return;
+  }
+  size_t len = 0;
+  for (int i = num_frames - 1; i >= 0 && len < MAX_STACK_LEN - 1; --i) {
+    if (len > 0) {
+      buf[len++] = ';';
+      buf[len] = '\0';
+    }
+    len = append_frame_(buf, len, frames[i],
+                        frames[i] == process->current_task->current);
+  }
+}
+
+void on_sample_(void *ctx, Object *obj) {
+  Attachment *attachment = (Attachment *)ctx;
+  HeapProfiler *profiler = attachment->profiler;
+  char stack[MAX_STACK_LEN];
+  current_stack_(attachment->process, stack);
+  SYNCHRONIZED(profiler->lock, {
+    HeapSite *site =
+        HeapSiteMap_find(&profiler->sites, stack, strlen(stack), NULL);
+    if (NULL == site) {
+      site = MNEW(HeapSite);
+      const size_t len = strlen(stack);
+      site->stack = MNEW_ARR(char, len + 1);
+      memcpy(site->stack, stack, len + 1);
+      site->alloc_objects = 0;
+      site->live_objects = 0;
+      site->deleted_bytes = 0;
+      site->index = VoidPtrArray_size(&profiler->site_list);
+      HeapSiteMap_insert(&profiler->sites, site->stack, len, site);
+      VoidPtrArray_push_back(&profiler->site_list, site);
+    }
+    ++site->alloc_objects;
+    ++site->live_objects;
+    SampledObjectMap_insert(&profiler->objects, obj, sizeof(Object *), site);
+  });
+}
+
+void on_delete_(void *ctx, Object *obj) {
+  HeapProfiler *profiler = ((Attachment *)ctx)->profiler;
+  SYNCHRONIZED(profiler->lock, {
+    HeapSite *site =
+        SampledObjectMap_find(&profiler->objects, obj, sizeof(Object *), NULL);
+    if (NULL != site) {
+      --site->live_objects;
+      site->deleted_bytes += object_bytes_(obj);
+      SampledObjectMap_remove(&profiler->objects, obj, sizeof(Object *));
+    }
+  });
+}
+
+void heapprofiler_attach(HeapProfiler *profiler, Process *process) {
+  ASSERT(profiler != NULL);
+  ASSERT(process != NULL);
+  Attachment *attachment = MNEW(Attachment);
+  attachment->profiler = profiler;
+  attachment->process = process;
+  SYNCHRONIZED(profiler->lock, {
+    attachment->next = profiler->attachments;
+    profiler->attachments = attachment;
+  });
+  HeapSampler sampler = {.on_sample = on_sample_,
+                         .on_delete = on_delete_,
+                         .ctx = attachment,
+                         .sample_interval = profiler->sample_interval};
+  heap_set_sampler(process->heap, &sampler);
+}
+
+bool heapprofiler_write(HeapProfiler *profiler, const char path[],
+                        HeapProfileValue value) {
+  ASSERT(profiler != NULL);
+  ASSERT(path != NULL);
+  FILE *file = fopen(path, "w");
+  if (NULL == file) {
+    return false;
+  }
+  SYNCHRONIZED(profiler->lock, {
+    // Sampled objects are never deleted while the lock is held, so their live
+    // bytes can be read even if they belong to another process. They are read
+    // here rather than counted when sampled since objects like Strings and
+    // Arrays grow after they are allocated.
+    const size_t num_sites = VoidPtrArray_size(&profiler->site_list);
+    uint64_t *live_bytes = CNEW_ARR(uint64_t, num_sites);
+    SampledObjectMapIterator obj_it;
+    SampledObjectMap_iterator(&obj_it, &profiler->objects);
+    for (; SampledObjectMap_has_entry(&obj_it);
+         SampledObjectMap_next_entry(&obj_it)) {
+      const HeapSite *site = *SampledObjectMap_value(&obj_it);
+      live_bytes[site->index] += object_bytes_(SampledObjectMap_key(&obj_it));
+    }
+    for (size_t i = 0; i < num_sites; ++i) {
+      const HeapSite *site =
+          (HeapSite *)VoidPtrArray_get_unchecked(&profiler->site_list, i);
+      uint64_t val;
+      switch (value) {
+        case HEAP_PROFILE_LIVE_BYTES:
+          val = live_bytes[i];
+          break;
+        case HEAP_PROFILE_LIVE_OBJECTS:
+          val = site->live_objects;
+          break;
+        case HEAP_PROFILE_ALLOC_BYTES:
+          val = live_bytes[i] + site->deleted_bytes;
+          break;
+        default:
+          val = site->alloc_objects;
+          break;
+      }
+      if (val > 0) {
+        fprintf(file, "%s %llu\n", site->stack,
+                (unsigned long long)(val * profiler->sample_interval));
+      }
+    }
+    RELEASE(live_bytes);
+  });
+  fclose(file);
+  return true;
+}
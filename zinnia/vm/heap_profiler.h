@@ -0,0 +1,55 @@
+// heap_profiler.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_HEAP_PROFILER_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_HEAP_PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zinnia/vm/process/processes.h"
+
+// Sampling allocation profiler.
+//
+// Every sample_interval-th object allocated by an attached process is recorded
+// along with the Zinnia stack that allocated it: the module, function and
+// source line of each frame. Each distinct stack is a site, which keeps count
+// of its sampled objects, how many of them are still alive and their bytes
+// (see heap_bytes()). Counts are multiplied by sample_interval when written,
+// so they estimate the totals.
+//
+// Profiles are written in the collapsed stack format read by flamegraph.pl and
+// speedscope: one line per site with its frames from the outermost in,
+// separated by ';', followed by a single value.
+
+typedef struct _HeapProfiler HeapProfiler;
+
+// Which value of each site is written.
+typedef enum {
+  HEAP_PROFILE_LIVE_BYTES,
+  HEAP_PROFILE_LIVE_OBJECTS,
+  HEAP_PROFILE_ALLOC_BYTES,
+  HEAP_PROFILE_ALLOC_OBJECTS,
+} HeapProfileValue;
+
+// Parses "live_bytes", "live_objects", "alloc_bytes" or "alloc_objects" into
+// value. Returns false if name is not one of them.
+bool heapprofile_value_parse(const char name[], HeapProfileValue *value);
+
+HeapProfiler *heapprofiler_create(uint32_t sample_interval);
+// Must only be called once no attached process can allocate anymore.
+void heapprofiler_delete(HeapProfiler *profiler);
+
+// Starts sampling the allocations of process.
+void heapprofiler_attach(HeapProfiler *profiler, Process *process);
+
+// Writes the profile to the file at path. Returns false if it could not be
+// opened.
+//
+// Thread-safe.
+bool heapprofiler_write(HeapProfiler *profiler, const char path[],
+                        HeapProfileValue value);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_HEAP_PROFILER_H_ */
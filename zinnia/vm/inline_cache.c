@@ -0,0 +1,134 @@
+// inline_cache.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/vm/inline_cache.h"
+
+#include <stdbool.h>
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/entity/class/class.h"
+#include "zinnia/entity/class/layout.h"
+#include "zinnia/program/op.h"
+#include "zinnia/util/sync/atomic.h"
+
+bool is_cached_site_(const Instruction *ins) {
+  if (INSTRUCTION_ID != ins->type) {
+    return false;
+  }
+  switch (ins->op) {
+    case GET:
+    case GTSH:
+    case CALL:
+    case CLLN:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Bits of InlineCache.fill_state that count fills.
+#define FILL_BITS 4
+#define FILL_MASK ((1 << FILL_BITS) - 1)
+
+// Copies way into entry unless it is being written meanwhile.
+bool read_way_(InlineCacheWay *way, InlineCacheEntry *entry) {
+  const uint32_t seq = atomic_load_u32(&way->seq);
+  if (seq & 1) {
+    return false;
+  }
+  entry->cls = atomic_load_ptr((void *const volatile *)&way->entry.cls);
+  entry->func = atomic_load_ptr((void *const volatile *)&way->entry.func);
+  entry->slot = (int32_t)atomic_load_u32((uint32_t *)&way->entry.slot);
+  entry->epoch = atomic_load_u32(&way->entry.epoch);
+  return seq == atomic_load_u32(&way->seq);
+}
+
+// Writes entry to way unless another thread is writing to it already.
+void write_way_(InlineCacheWay *way, const InlineCacheEntry *entry) {
+  const uint32_t seq = atomic_load_u32(&way->seq);
+  if ((seq & 1) || !atomic_cas_u32(&way->seq, seq, seq + 1)) {
+    return;
+  }
+  atomic_store_ptr((void *volatile *)&way->entry.cls, (void *)entry->cls);
+  atomic_store_ptr((void *volatile *)&way->entry.func, (void *)entry->func);
+  atomic_store_u32((uint32_t *)&way->entry.slot, (uint32_t)entry->slot);
+  atomic_store_u32(&way->entry.epoch, entry->epoch);
+  atomic_store_u32(&way->seq, seq + 2);
+}
+
+// Claims the next fill of the site in epoch. Returns false if the site is
+// megamorphic.
+bool claim_fill_(InlineCache *cache, uint32_t epoch, uint32_t *fill) {
+  const uint32_t epoch_bits = epoch << FILL_BITS;
+  for (;;) {
+    const uint32_t state = atomic_load_u32(&cache->fill_state);
+    // The count starts over in each epoch.
+    *fill = epoch_bits == (state & ~FILL_MASK) ? state & FILL_MASK : 0;
+    if (*fill >= INLINE_CACHE_MAX_FILLS) {
+      return false;
+    }
+    if (atomic_cas_u32(&cache->fill_state, state, epoch_bits | (*fill + 1))) {
+      return true;
+    }
+  }
+}
+
+bool fill_(InlineCache *cache, const Class *cls, const char name[],
+           uint32_t epoch, InlineCacheEntry *entry) {
+  uint32_t fill;
+  if (!claim_fill_(cache, epoch, &fill)) {
+    return false;
+  }
+  entry->cls = cls;
+  entry->func = class_get_function(cls, name);
+  entry->slot = layout_slot(class_layout(cls), name);
+  entry->epoch = epoch;
+  // Ways from earlier epochs are stale, so the first fills of an epoch
+  // replace them before evicting one filled in it.
+  write_way_(&cache->ways[fill % INLINE_CACHE_WAYS], entry);
+  return true;
+}
+
+bool inline_cache_get(InlineCache *cache, const Class *cls, const char name[],
+                      InlineCacheEntry *entry) {
+  const uint32_t epoch = class_lookup_epoch();
+  for (int i = 0; i < INLINE_CACHE_WAYS; ++i) {
+    if (read_way_(&cache->ways[i], entry) && cls == entry->cls &&
+        epoch == entry->epoch) {
+      return true;
+    }
+  }
+  return fill_(cache, cls, name, epoch, entry);
+}
+
+const Function *inline_cache_get_function(InlineCache *cache, const Class *cls,
+                                          const char name[]) {
+  InlineCacheEntry entry;
+  return inline_cache_get(cache, cls, name, &entry)
+             ? entry.func
+             : class_get_function(cls, name);
+}
+
+void inline_cache_attach(Tape *tape) {
+  const size_t size = tape_size(tape);
+  for (int i = 0; i < size; ++i) {
+    Instruction *ins = tape_get_mutable(tape, i);
+    if (is_cached_site_(ins) && 0 == ins->cache) {
+      ins->cache = tape_add_cache(tape, CNEW(InlineCache));
+    }
+  }
+}
+
+void inline_cache_release(Tape *tape) {
+  const size_t size = tape_size(tape);
+  for (int i = 0; i < size; ++i) {
+    Instruction *ins = tape_get_mutable(tape, i);
+    if (is_cached_site_(ins) && 0 != ins->cache) {
+      RELEASE(tape_get_cache(tape, ins->cache));
+      ins->cache = 0;
+    }
+  }
+  tape_clear_caches(tape);
+}
@@ -0,0 +1,64 @@
+// inline_cache.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_INLINE_CACHE_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_INLINE_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zinnia/entity/object.h"
+#include "zinnia/program/instruction.h"
+#include "zinnia/program/tape.h"
+
+// Number of classes a site can hold at once.
+#define INLINE_CACHE_WAYS 4
+// Number of distinct classes a site can be filled with in one class lookup
+// epoch before it is considered megamorphic and stops caching until the next.
+#define INLINE_CACHE_MAX_FILLS 8
+
+typedef struct {
+  const Class *cls;
+  // NULL if cls has no function by this name.
+  const Function *func;
+  // Slot of the field by this name in instances of cls, or -1.
+  int32_t slot;
+  uint32_t epoch;
+} InlineCacheEntry;
+
+typedef struct {
+  // Odd while entry is being written.
+  volatile uint32_t seq;
+  InlineCacheEntry entry;
+} InlineCacheWay;
+
+// Caches class_get_function() and layout_slot() for a single instruction
+// site.
+//
+// Sites are shared by every process running the module, so ways are written
+// under a sequence lock and only ever read through a copy.
+struct _InlineCache {
+  InlineCacheWay ways[INLINE_CACHE_WAYS];
+  // The class lookup epoch in the high bits and the number of fills in it in
+  // the low ones.
+  volatile uint32_t fill_state;
+};
+
+// Sets *entry to the entry for cls at the site that owns cache. Returns false
+// if the site is megamorphic.
+bool inline_cache_get(InlineCache *cache, const Class *cls, const char name[],
+                      InlineCacheEntry *entry);
+
+// Same as class_get_function(cls, name) for the site that owns cache.
+const Function *inline_cache_get_function(InlineCache *cache, const Class *cls,
+                                          const char name[]);
+
+// Gives every GET, GTSH, CALL and CLLN on an ID in tape a cache. Instructions
+// which already have one keep it.
+void inline_cache_attach(Tape *tape);
+// Frees all caches attached to instructions in tape.
+void inline_cache_release(Tape *tape);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_INLINE_CACHE_H_ */
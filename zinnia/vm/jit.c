@@ -0,0 +1,880 @@
+// jit.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/vm/jit.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/entity/entity.h"
+#include "zinnia/program/op.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/sync/mutex.h"
+#include "zinnia/vm/dispatch.h"
+
+#ifdef ZINNIA_JIT_SUPPORTED
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Functions longer than this are left to the interpreter.
+#define MAX_JIT_INSTRUCTIONS (1 << 16)
+// Upper bound on the native code emitted for a single instruction.
+#define MAX_INS_SIZE 512
+// Upper bound on the prologue, the epilogue and the exit after the last
+// instruction together.
+#define MAX_FRAME_SIZE 96
+#define NOT_COMPILED UINT32_MAX
+
+struct _JitCode {
+  const Tape *tape;
+  // The compiled instructions are [start, end).
+  uint32_t start;
+  uint32_t end;
+  // Offset into mem of the native code of each instruction, or NOT_COMPILED.
+  uint32_t *offsets;
+  uint8_t *mem;
+  size_t mem_size;
+  JitCode *next;
+};
+
+struct _Jit {
+  JitRuntime runtime;
+  Mutex lock;
+  // All compiled code, so it can be freed.
+  JitCode *codes;
+};
+
+// The native code starts with the prologue, which jumps to entry.
+typedef void (*JitEntryFn)(VM *vm, Task *task, const uint8_t *entry);
+
+Jit *jit_create(const JitRuntime *runtime) {
+  ASSERT(runtime != NULL);
+  Jit *jit = MNEW(Jit);
+  jit->runtime = *runtime;
+  jit->lock = mutex_create();
+  jit->codes = NULL;
+  return jit;
+}
+
+void jit_delete(Jit *jit) {
+  ASSERT(jit != NULL);
+  JitCode *code = jit->codes;
+  while (NULL != code) {
+    JitCode *next = code->next;
+#ifdef ZINNIA_JIT_SUPPORTED
+    munmap(code->mem, code->mem_size);
+#endif
+    RELEASE(code->offsets);
+    RELEASE(code);
+    code = next;
+  }
+  mutex_close(jit->lock);
+  RELEASE(jit);
+}
+
+// Returns the index after the last instruction of the function at start.
+//
+// A function ends at the first RET or EXIT that no jump in it skips over.
+uint32_t function_end_(const Tape *tape, uint32_t start) {
+  const uint32_t size = tape_size(tape);
+  int64_t furthest = start;
+  for (uint32_t i = start; i < size; ++i) {
+    const Instruction *ins = tape_get(tape, i);
+    switch (ins->op) {
+      case JMP:
+      case IF:
+      case IFN:
+      case CTCH:
+        if (INSTRUCTION_PRIMITIVE == ins->type) {
+          const int64_t target = (int64_t)i + ins->int_val + 1;
+          if (target > furthest) {
+            furthest = target;
+          }
+        }
+        break;
+      case RET:
+      case EXIT:
+        if (i >= furthest) {
+          return i + 1;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return size;
+}
+
+#ifdef ZINNIA_JIT_SUPPORTED
+
+typedef enum {
+  RAX,
+  RCX,
+  RDX,
+  RBX,
+  RSP,
+  RBP,
+  RSI,
+  RDI,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15,
+} Reg;
+
+// Callee-saved registers which hold the same thing throughout the native
+// code.
+#define VM_REG RBX
+#define TASK_REG R12
+// The first local slot of task->current.
+#define SLOTS_REG R13
+// task->current.
+#define CONTEXT_REG R14
+
+// Condition codes of Jcc and SETcc.
+typedef enum {
+  CC_O = 0x0,
+  CC_E = 0x4,
+  CC_NE = 0x5,
+  CC_BE = 0x6,
+  CC_A = 0x7,
+  CC_L = 0xc,
+  CC_GE = 0xd,
+  CC_LE = 0xe,
+  CC_G = 0xf,
+} Cond;
+
+typedef struct {
+  uint8_t *mem;
+  size_t pos;
+} Emitter;
+
+// A rel32 which is patched once the offset of its target is known.
+typedef struct {
+  size_t pos;
+  uint32_t target;
+} Fixup;
+
+// The rel32s of the jumps to the slow path of an instruction.
+#define MAX_SLOW_JUMPS 8
+typedef struct {
+  size_t pos[MAX_SLOW_JUMPS];
+  int num;
+} SlowJumps;
+
+typedef struct {
+  const JitRuntime *runtime;
+  Emitter e;
+  size_t exit_pos;
+  uint32_t start;
+  uint32_t end;
+  Fixup *fixups;
+  uint32_t num_fixups;
+  // Whether SLOTS_REG is known to hold the slots of task->current. It is
+  // always loaded at jump targets.
+  bool slots_loaded;
+  // What task->current->ins is known to be, or NOT_COMPILED. It is only
+  // stored before a stub is called or the native code returns.
+  uint32_t synced_ins;
+} Compiler;
+
+void emit_(Emitter *e, const uint8_t bytes[], size_t len) {
+  memcpy(e->mem + e->pos, bytes, len);
+  e->pos += len;
+}
+
+void emit_u8_(Emitter *e, uint8_t val) { e->mem[e->pos++] = val; }
+
+void emit_u32_(Emitter *e, uint32_t val) {
+  memcpy(e->mem + e->pos, &val, sizeof(val));
+  e->pos += sizeof(val);
+}
+
+void emit_u64_(Emitter *e, uint64_t val) {
+  memcpy(e->mem + e->pos, &val, sizeof(val));
+  e->pos += sizeof(val);
+}
+
+void patch_rel32_(Emitter *e, size_t pos, size_t target) {
+  const int32_t rel = (int32_t)((int64_t)target - (int64_t)(pos + 4));
+  memcpy(e->mem + pos, &rel, sizeof(rel));
+}
+
+// Emits a REX prefix for the ModRM reg and rm fields, if one is needed.
+void emit_rex_(Emitter *e, bool wide, int reg, int rm) {
+  const uint8_t rex =
+      0x40 | (wide ? 0x08 : 0) | ((reg & 8) >> 1) | ((rm & 8) >> 3);
+  if (0x40 != rex) {
+    emit_u8_(e, rex);
+  }
+}
+
+// Emits opcode with reg in the ModRM reg field and [base + disp] as rm.
+void emit_mem_op_(Emitter *e, bool wide, const uint8_t opcode[], size_t len,
+                  int reg, Reg base, int32_t disp) {
+  emit_rex_(e, wide, reg, base);
+  emit_(e, opcode, len);
+  emit_u8_(e, 0x80 | (reg & 7) << 3 | (base & 7));
+  if (RSP == (base & 7)) {
+    // rsp and r12 as a base need a SIB byte.
+    emit_u8_(e, 0x24);
+  }
+  emit_u32_(e, (uint32_t)disp);
+}
+
+// Emits opcode with reg in the ModRM reg field and register rm.
+void emit_reg_op_(Emitter *e, bool wide, const uint8_t opcode[], size_t len,
+                  int reg, Reg rm) {
+  emit_rex_(e, wide, reg, rm);
+  emit_(e, opcode, len);
+  emit_u8_(e, 0xc0 | (reg & 7) << 3 | (rm & 7));
+}
+
+static const uint8_t OP_ADD[] = {0x01};
+static const uint8_t OP_OR[] = {0x09};
+static const uint8_t OP_SUB[] = {0x29};
+static const uint8_t OP_XOR[] = {0x31};
+static const uint8_t OP_CMP[] = {0x39};
+static const uint8_t OP_IMUL[] = {0x0f, 0xaf};
+static const uint8_t OP_MOV_STORE[] = {0x89};
+static const uint8_t OP_MOV_LOAD[] = {0x8b};
+static const uint8_t OP_MOV_IMM32[] = {0xc7};
+static const uint8_t OP_GROUP1_IMM8[] = {0x80};
+static const uint8_t OP_GROUP1_IMM32[] = {0x81};
+static const uint8_t OP_SHIFT_IMM8[] = {0xc1};
+static const uint8_t OP_MOVZX_BYTE[] = {0x0f, 0xb6};
+#define GROUP1_CMP 7
+#define SHIFT_SHR 5
+
+// mov dst, [base + disp]
+void emit_load_(Emitter *e, Reg dst, Reg base, int32_t disp) {
+  emit_mem_op_(e, true, OP_MOV_LOAD, sizeof(OP_MOV_LOAD), dst, base, disp);
+}
+
+// mov [base + disp], src
+void emit_store_(Emitter *e, Reg base, int32_t disp, Reg src) {
+  emit_mem_op_(e, true, OP_MOV_STORE, sizeof(OP_MOV_STORE), src, base, disp);
+}
+
+// mov dword [base + disp], val
+void emit_store_u32_(Emitter *e, Reg base, int32_t disp, uint32_t val) {
+  emit_mem_op_(e, false, OP_MOV_IMM32, sizeof(OP_MOV_IMM32), 0, base, disp);
+  emit_u32_(e, val);
+}
+
+// cmp dword [base + disp], val
+void emit_cmp_u32_(Emitter *e, Reg base, int32_t disp, uint32_t val) {
+  emit_mem_op_(e, false, OP_GROUP1_IMM32, sizeof(OP_GROUP1_IMM32), GROUP1_CMP,
+               base, disp);
+  emit_u32_(e, val);
+}
+
+// cmp byte [base + disp], val
+void emit_cmp_u8_(Emitter *e, Reg base, int32_t disp, uint8_t val) {
+  emit_mem_op_(e, false, OP_GROUP1_IMM8, sizeof(OP_GROUP1_IMM8), GROUP1_CMP,
+               base, disp);
+  emit_u8_(e, val);
+}
+
+// mov dst, val
+void emit_mov_imm_(Emitter *e, Reg dst, uint64_t val) {
+  emit_rex_(e, true, 0, dst);
+  emit_u8_(e, 0xb8 | (dst & 7));
+  emit_u64_(e, val);
+}
+
+// mov dst, src
+void emit_mov_(Emitter *e, Reg dst, Reg src) {
+  emit_reg_op_(e, true, OP_MOV_STORE, sizeof(OP_MOV_STORE), src, dst);
+}
+
+// <op> dst, src for an op which takes r/m as its destination.
+void emit_arith_(Emitter *e, const uint8_t op[], Reg dst, Reg src) {
+  emit_reg_op_(e, true, op, 1, src, dst);
+}
+
+// shr reg, count
+void emit_shr_(Emitter *e, Reg reg, uint8_t count) {
+  emit_reg_op_(e, true, OP_SHIFT_IMM8, sizeof(OP_SHIFT_IMM8), SHIFT_SHR, reg);
+  emit_u8_(e, count);
+}
+
+// Emits Jcc and returns the position of its rel32.
+size_t emit_jcc_(Emitter *e, Cond cond) {
+  emit_u8_(e, 0x0f);
+  emit_u8_(e, 0x80 | cond);
+  const size_t pos = e->pos;
+  e->pos += 4;
+  return pos;
+}
+
+// Emits JMP and returns the position of its rel32.
+size_t emit_jmp_(Emitter *e) {
+  emit_u8_(e, 0xe9);
+  const size_t pos = e->pos;
+  e->pos += 4;
+  return pos;
+}
+
+// Sets eax to 1 if cond holds, otherwise 0.
+void emit_setcc_(Emitter *e, Cond cond) {
+  const uint8_t setcc[] = {0x0f, 0x90 | cond, 0xc0};  // setcc al
+  emit_(e, setcc, sizeof(setcc));
+  emit_reg_op_(e, false, OP_MOVZX_BYTE, sizeof(OP_MOVZX_BYTE), RAX, RAX);
+}
+
+void emit_call_(Emitter *e, const void *fn) {
+  static const uint8_t call_rax[] = {0xff, 0xd0};
+  emit_mov_imm_(e, RAX, (uint64_t)(uintptr_t)fn);
+  emit_(e, call_rax, sizeof(call_rax));
+}
+
+void add_slow_jump_(SlowJumps *slow, size_t pos) {
+  ASSERT(slow->num < MAX_SLOW_JUMPS);
+  slow->pos[slow->num++] = pos;
+}
+
+// Saves the callee-saved registers, loads them and then jumps to the entry
+// instruction.
+void emit_prologue_(Compiler *c) {
+  static const uint8_t push[] = {
+      0x53,        // push rbx
+      0x41, 0x54,  // push r12
+      0x41, 0x55,  // push r13
+      0x41, 0x56,  // push r14
+      0x41, 0x57,  // push r15 (keeps the stack 16-byte aligned)
+  };
+  static const uint8_t jmp_r15[] = {0x41, 0xff, 0xe7};
+  Emitter *e = &c->e;
+  emit_(e, push, sizeof(push));
+  emit_mov_(e, VM_REG, RDI);
+  emit_mov_(e, TASK_REG, RSI);
+  emit_mov_(e, R15, RDX);
+  emit_load_(e, CONTEXT_REG, TASK_REG, offsetof(Task, current));
+  emit_mov_(e, RDI, TASK_REG);
+  emit_call_(e, c->runtime->slots);
+  emit_mov_(e, SLOTS_REG, RAX);
+  emit_(e, jmp_r15, sizeof(jmp_r15));
+}
+
+void emit_epilogue_(Emitter *e) {
+  static const uint8_t code[] = {
+      0x41, 0x5f,  // pop r15
+      0x41, 0x5e,  // pop r14
+      0x41, 0x5d,  // pop r13
+      0x41, 0x5c,  // pop r12
+      0x5b,        // pop rbx
+      0xc3,        // ret
+  };
+  emit_(e, code, sizeof(code));
+}
+
+void sync_ins_(Compiler *c, uint32_t ins) {
+  if (ins != c->synced_ins) {
+    emit_store_u32_(&c->e, CONTEXT_REG, offsetof(Context, ins), ins);
+    c->synced_ins = ins;
+  }
+}
+
+void load_slots_(Compiler *c) {
+  if (c->slots_loaded) {
+    return;
+  }
+  emit_mov_(&c->e, RDI, TASK_REG);
+  emit_call_(&c->e, c->runtime->slots);
+  emit_mov_(&c->e, SLOTS_REG, RAX);
+  c->slots_loaded = true;
+}
+
+// Returns to the interpreter at ins.
+void emit_exit_(Compiler *c, uint32_t ins) {
+  sync_ins_(c, ins);
+  patch_rel32_(&c->e, emit_jmp_(&c->e), c->exit_pos);
+}
+
+// Calls fn(vm, task, ins) and returns to the interpreter if it returns
+// JIT_EXIT.
+void emit_call_stub_(Compiler *c, JitStub fn, const Instruction *ins) {
+  static const uint8_t test_eax[] = {0x85, 0xc0};
+  Emitter *e = &c->e;
+  emit_mov_(e, RDI, VM_REG);
+  emit_mov_(e, RSI, TASK_REG);
+  emit_mov_imm_(e, RDX, (uint64_t)(uintptr_t)ins);
+  emit_call_(e, fn);
+  emit_(e, test_eax, sizeof(test_eax));
+  patch_rel32_(e, emit_jcc_(e, CC_NE), c->exit_pos);
+}
+
+// Executes ins at index i with stub.
+void emit_stub_(Compiler *c, JitStub stub, const Instruction *ins,
+                uint32_t i) {
+  sync_ins_(c, i);
+  emit_call_stub_(c, stub, ins);
+  // The stub may have entered or left a block, or grown the stack.
+  emit_load_(&c->e, CONTEXT_REG, TASK_REG, offsetof(Task, current));
+  c->slots_loaded = false;
+  c->synced_ins = i + 1;
+}
+
+// Ends the fast path of ins at index i, and emits its slow path which
+// executes it with stub.
+void emit_slow_path_(Compiler *c, const SlowJumps *slow, JitStub stub,
+                     const Instruction *ins, uint32_t i) {
+  ASSERT(stub != NULL);
+  Emitter *e = &c->e;
+  const size_t done = emit_jmp_(e);
+  for (int j = 0; j < slow->num; ++j) {
+    patch_rel32_(e, slow->pos[j], e->pos);
+  }
+  // The fast path does not touch what is synced before jumping here.
+  emit_stub_(c, stub, ins, i);
+  load_slots_(c);
+  patch_rel32_(e, done, e->pos);
+  c->synced_ins = NOT_COMPILED;
+}
+
+int32_t resval_disp_() { return (int32_t)offsetof(Task, resval); }
+
+#ifdef ZINNIA_COMPACT_ENTITY
+uint64_t entity_bits_(const Entity *e) {
+  uint64_t bits;
+  memcpy(&bits, e, sizeof(bits));
+  return bits;
+}
+#endif
+
+int32_t slot_disp_(const Instruction *ins) {
+  return (int32_t)(ins->local.index * sizeof(Entity));
+}
+
+void emit_copy_entity_(Emitter *e, Reg dst, int32_t dst_disp, Reg src,
+                       int32_t src_disp) {
+  for (int32_t i = 0; i < (int32_t)sizeof(Entity); i += sizeof(uint64_t)) {
+    emit_load_(e, RAX, src, src_disp + i);
+    emit_store_(e, dst, dst_disp + i, RAX);
+  }
+}
+
+void emit_set_entity_(Emitter *e, Reg dst, int32_t dst_disp,
+                      const Entity *val) {
+  uint64_t words[sizeof(Entity) / sizeof(uint64_t)];
+  memcpy(words, val, sizeof(words));
+  for (int i = 0; i < (int)(sizeof(words) / sizeof(words[0])); ++i) {
+    emit_mov_imm_(e, RAX, words[i]);
+    emit_store_(e, dst, dst_disp + i * (int32_t)sizeof(uint64_t), RAX);
+  }
+}
+
+// Jumps to slow if the slot at [SLOTS_REG + disp] is UNSET.
+void emit_check_bound_(Emitter *e, int32_t disp, SlowJumps *slow) {
+#ifdef ZINNIA_COMPACT_ENTITY
+  static const uint8_t cmp_eax_unset[] = {0x83, 0xf8, UNSET};
+  emit_load_(e, RAX, SLOTS_REG, disp);
+  emit_shr_(e, RAX, 48);
+  emit_(e, cmp_eax_unset, sizeof(cmp_eax_unset));
+#else
+  emit_cmp_u32_(e, SLOTS_REG, disp + ENTITY_TYPE_OFFSET_, UNSET);
+#endif
+  add_slow_jump_(slow, emit_jcc_(e, CC_E));
+}
+
+// Loads the Int at [base + disp] into dst, or jumps to slow if it is not an
+// Int. Clobbers rdx.
+void emit_load_int_(Emitter *e, Reg dst, Reg base, int32_t disp,
+                    SlowJumps *slow) {
+#ifdef ZINNIA_COMPACT_ENTITY
+  emit_load_(e, dst, base, disp);
+  emit_mov_imm_(e, RDX, ENTITY_XOR_);
+  emit_arith_(e, OP_XOR, dst, RDX);
+  emit_mov_imm_(e, RDX, ENTITY_INT_BASE_);
+  emit_arith_(e, OP_CMP, dst, RDX);
+  add_slow_jump_(slow, emit_jcc_(e, CC_BE));
+  emit_mov_imm_(e, RDX, ENTITY_INT_BASE_ + ENTITY_INT_BIAS_);
+  emit_arith_(e, OP_SUB, dst, RDX);
+#else
+  emit_cmp_u32_(e, base, disp + ENTITY_TYPE_OFFSET_, PRIMITIVE);
+  add_slow_jump_(slow, emit_jcc_(e, CC_NE));
+  emit_cmp_u32_(e, base, disp + ENTITY_PTYPE_OFFSET_, PRIMITIVE_INT);
+  add_slow_jump_(slow, emit_jcc_(e, CC_NE));
+  emit_load_(e, dst, base, disp + ENTITY_VALUE_OFFSET_);
+#endif
+}
+
+// Stores rax into resval as an Int, or jumps to slow if it cannot be stored
+// as one. Clobbers rcx and rdx.
+void emit_store_int_(Emitter *e, SlowJumps *slow) {
+  const int32_t disp = resval_disp_();
+#ifdef ZINNIA_COMPACT_ENTITY
+  // Out of range Ints are stored as Floats by the stub.
+  emit_mov_(e, RCX, RAX);
+  emit_mov_imm_(e, RDX, ENTITY_INT_MAX);
+  emit_arith_(e, OP_ADD, RCX, RDX);
+  emit_mov_imm_(e, RDX, 2 * ENTITY_INT_MAX);
+  emit_arith_(e, OP_CMP, RCX, RDX);
+  add_slow_jump_(slow, emit_jcc_(e, CC_A));
+  emit_mov_imm_(e, RDX, ENTITY_INT_BASE_ + ENTITY_INT_BIAS_);
+  emit_arith_(e, OP_ADD, RAX, RDX);
+  emit_mov_imm_(e, RDX, ENTITY_XOR_);
+  emit_arith_(e, OP_XOR, RAX, RDX);
+  emit_store_(e, TASK_REG, disp, RAX);
+#else
+  emit_store_u32_(e, TASK_REG, disp + ENTITY_TYPE_OFFSET_, PRIMITIVE);
+  emit_store_u32_(e, TASK_REG, disp + ENTITY_PTYPE_OFFSET_, PRIMITIVE_INT);
+  emit_store_(e, TASK_REG, disp + ENTITY_VALUE_OFFSET_, RAX);
+#endif
+}
+
+// Stores whether cond holds into resval as a Bool.
+void emit_store_bool_(Emitter *e, Cond cond) {
+  const int32_t disp = resval_disp_();
+  emit_setcc_(e, cond);
+#ifdef ZINNIA_COMPACT_ENTITY
+  emit_mov_imm_(e, RDX, entity_bits_(&FALSE_ENTITY));
+  emit_arith_(e, OP_OR, RAX, RDX);
+  emit_store_(e, TASK_REG, disp, RAX);
+#else
+  emit_store_u32_(e, TASK_REG, disp + ENTITY_TYPE_OFFSET_, PRIMITIVE);
+  emit_store_u32_(e, TASK_REG, disp + ENTITY_PTYPE_OFFSET_, PRIMITIVE_BOOL);
+  emit_store_(e, TASK_REG, disp + ENTITY_VALUE_OFFSET_, RAX);
+#endif
+}
+
+// Jumps to falsy if resval is false, the same as IS_FALSE(). Falls through
+// otherwise.
+void emit_test_resval_(Emitter *e, SlowJumps *falsy) {
+  const int32_t disp = resval_disp_();
+#ifdef ZINNIA_COMPACT_ENTITY
+  emit_load_(e, RAX, TASK_REG, disp);
+  emit_mov_(e, RCX, RAX);
+  emit_shr_(e, RCX, 48);
+  // NONE
+  add_slow_jump_(falsy, emit_jcc_(e, CC_E));
+  emit_mov_imm_(e, RCX, entity_bits_(&FALSE_ENTITY));
+  emit_arith_(e, OP_CMP, RAX, RCX);
+  add_slow_jump_(falsy, emit_jcc_(e, CC_E));
+#else
+  emit_cmp_u32_(e, TASK_REG, disp + ENTITY_TYPE_OFFSET_, NONE);
+  add_slow_jump_(falsy, emit_jcc_(e, CC_E));
+  emit_cmp_u32_(e, TASK_REG, disp + ENTITY_TYPE_OFFSET_, PRIMITIVE);
+  const size_t not_primitive = emit_jcc_(e, CC_NE);
+  emit_cmp_u32_(e, TASK_REG, disp + ENTITY_PTYPE_OFFSET_, PRIMITIVE_BOOL);
+  const size_t not_bool = emit_jcc_(e, CC_NE);
+  emit_cmp_u8_(e, TASK_REG, disp + ENTITY_VALUE_OFFSET_, 0);
+  add_slow_jump_(falsy, emit_jcc_(e, CC_E));
+  patch_rel32_(e, not_primitive, e->pos);
+  patch_rel32_(e, not_bool, e->pos);
+#endif
+}
+
+// Jumps to target from the jump ins at index i.
+void emit_branch_(Compiler *c, const Instruction *ins, uint32_t i) {
+  const int64_t target = (int64_t)i + ins->int_val + 1;
+  // Only this path syncs.
+  const uint32_t synced_ins = c->synced_ins;
+  if (ins->int_val < 0) {
+    sync_ins_(c, (uint32_t)target);
+    emit_call_stub_(c, c->runtime->safepoint, ins);
+  }
+  if (target >= c->start && target < c->end) {
+    c->fixups[c->num_fixups++] =
+        (Fixup){.pos = emit_jmp_(&c->e), .target = (uint32_t)target};
+  } else {
+    emit_exit_(c, (uint32_t)target);
+  }
+  c->synced_ins = synced_ins;
+}
+
+// JMP, IF or IFN. Slots are loaded first, so they are loaded at every jump
+// target.
+void compile_jump_(Compiler *c, const Instruction *ins, uint32_t i) {
+  Emitter *e = &c->e;
+  load_slots_(c);
+  if (JMP == ins->op) {
+    emit_branch_(c, ins, i);
+    return;
+  }
+  SlowJumps falsy = {.num = 0};
+  emit_test_resval_(e, &falsy);
+  size_t skip = 0;
+  if (IF == ins->op) {
+    emit_branch_(c, ins, i);
+  } else {
+    skip = emit_jmp_(e);
+  }
+  for (int j = 0; j < falsy.num; ++j) {
+    patch_rel32_(e, falsy.pos[j], e->pos);
+  }
+  if (IFN == ins->op) {
+    emit_branch_(c, ins, i);
+    patch_rel32_(e, skip, e->pos);
+  }
+}
+
+// LRES, LLET or LSET on a slot.
+void compile_slot_move_(Compiler *c, const Instruction *ins, uint32_t i) {
+  Emitter *e = &c->e;
+  const int32_t disp = slot_disp_(ins);
+  load_slots_(c);
+  if (LLET == ins->op) {
+    emit_copy_entity_(e, SLOTS_REG, disp, TASK_REG, resval_disp_());
+    return;
+  }
+  // Unset slots are looked up by name.
+  SlowJumps slow = {.num = 0};
+  emit_check_bound_(e, disp, &slow);
+  if (LRES == ins->op) {
+    emit_copy_entity_(e, TASK_REG, resval_disp_(), SLOTS_REG, disp);
+  } else {
+    emit_copy_entity_(e, SLOTS_REG, disp, TASK_REG, resval_disp_());
+  }
+  emit_slow_path_(c, &slow, c->runtime->stub(ins), ins, i);
+}
+
+// An INT_SLOT or INT_IMM handler of ADD, SUB, MULT, LT, GT, LTE or GTE.
+void compile_int_op_(Compiler *c, const Instruction *ins, uint32_t i) {
+  Emitter *e = &c->e;
+  if (INSTRUCTION_SLOT == ins->type) {
+    load_slots_(c);
+  }
+  SlowJumps slow = {.num = 0};
+  emit_load_int_(e, RAX, TASK_REG, resval_disp_(), &slow);
+  if (INSTRUCTION_SLOT == ins->type) {
+    emit_load_int_(e, RCX, SLOTS_REG, slot_disp_(ins), &slow);
+  } else {
+    emit_mov_imm_(e, RCX, (uint64_t)ins->int_val);
+  }
+  switch (ins->op) {
+    case ADD:
+    case SUB:
+    case MULT:
+      if (ADD == ins->op) {
+        emit_arith_(e, OP_ADD, RAX, RCX);
+      } else if (SUB == ins->op) {
+        emit_arith_(e, OP_SUB, RAX, RCX);
+      } else {
+        emit_reg_op_(e, true, OP_IMUL, sizeof(OP_IMUL), RAX, RCX);
+      }
+      // The stub handles overflow the same as the interpreter.
+      add_slow_jump_(&slow, emit_jcc_(e, CC_O));
+      emit_store_int_(e, &slow);
+      break;
+    default:
+      emit_arith_(e, OP_CMP, RAX, RCX);
+      emit_store_bool_(e, LT == ins->op    ? CC_L
+                          : GT == ins->op  ? CC_G
+                          : LTE == ins->op ? CC_LE
+                                           : CC_GE);
+      break;
+  }
+  emit_slow_path_(c, &slow, c->runtime->stub(ins), ins, i);
+}
+
+bool is_inline_int_op_(Handler handler) {
+  switch (handler) {
+    case ADD_INT_SLOT:
+    case ADD_INT_IMM:
+    case SUB_INT_SLOT:
+    case SUB_INT_IMM:
+    case MULT_INT_SLOT:
+    case MULT_INT_IMM:
+    case LT_INT_SLOT:
+    case LT_INT_IMM:
+    case GT_INT_SLOT:
+    case GT_INT_IMM:
+    case LTE_INT_SLOT:
+    case LTE_INT_IMM:
+    case GTE_INT_SLOT:
+    case GTE_INT_IMM:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Compiles ins at index i. Returns false if the interpreter must execute it.
+bool compile_instruction_(Compiler *c, const Instruction *ins, uint32_t i) {
+  Entity val;
+  switch (ins->op) {
+    case JMP:
+    case IF:
+    case IFN:
+      if (INSTRUCTION_PRIMITIVE != ins->type) {
+        break;
+      }
+      compile_jump_(c, ins, i);
+      return true;
+    case RES:
+      if (INSTRUCTION_PRIMITIVE != ins->type) {
+        break;
+      }
+      val = entity_primitive(instruction_primitive(ins));
+      emit_set_entity_(&c->e, TASK_REG, resval_disp_(), &val);
+      return true;
+    case RNIL:
+    case RTRU:
+    case RFLS:
+      val = RNIL == ins->op   ? NONE_ENTITY
+            : RTRU == ins->op ? TRUE_ENTITY
+                              : FALSE_ENTITY;
+      emit_set_entity_(&c->e, TASK_REG, resval_disp_(), &val);
+      return true;
+    case LRES:
+    case LLET:
+    case LSET:
+      if (INSTRUCTION_SLOT != ins->type) {
+        break;
+      }
+      compile_slot_move_(c, ins, i);
+      return true;
+    default:
+      if (is_inline_int_op_(dispatch_current_handler(ins))) {
+        compile_int_op_(c, ins, i);
+        return true;
+      }
+      break;
+  }
+  const JitStub stub = c->runtime->stub(ins);
+  if (NULL == stub) {
+    return false;
+  }
+  emit_stub_(c, stub, ins, i);
+  return true;
+}
+
+// Marks the instructions in [start, end) which are jumped to.
+bool *find_jump_targets_(const Tape *tape, uint32_t start, uint32_t end) {
+  bool *is_target = CNEW_ARR(bool, end - start);
+  for (uint32_t i = start; i < end; ++i) {
+    const Instruction *ins = tape_get(tape, i);
+    if ((JMP != ins->op && IF != ins->op && IFN != ins->op) ||
+        INSTRUCTION_PRIMITIVE != ins->type) {
+      continue;
+    }
+    const int64_t target = (int64_t)i + ins->int_val + 1;
+    if (target >= start && target < end) {
+      is_target[target - start] = true;
+    }
+  }
+  return is_target;
+}
+
+JitCode *compile_function_(Jit *jit, const Tape *tape, uint32_t start,
+                           uint32_t end) {
+  const uint32_t num_ins = end - start;
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  size_t mem_size = MAX_FRAME_SIZE + (size_t)num_ins * MAX_INS_SIZE;
+  mem_size = (mem_size + page_size - 1) / page_size * page_size;
+  uint8_t *mem = mmap(NULL, mem_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == mem) {
+    return NULL;
+  }
+  JitCode *code = MNEW(JitCode);
+  code->tape = tape;
+  code->start = start;
+  code->end = end;
+  code->offsets = MNEW_ARR(uint32_t, num_ins);
+  code->mem = mem;
+  code->mem_size = mem_size;
+  code->next = NULL;
+
+  // Where jumps to each instruction land. Unlike offsets, this includes the
+  // code which returns to the interpreter at an instruction which was not
+  // compiled.
+  uint32_t *targets = MNEW_ARR(uint32_t, num_ins);
+  bool *is_target = find_jump_targets_(tape, start, end);
+
+  Compiler c = {.runtime = &jit->runtime,
+                .e = {.mem = mem, .pos = 0},
+                .start = start,
+                .end = end,
+                .fixups = MNEW_ARR(Fixup, num_ins),
+                .num_fixups = 0,
+                .slots_loaded = true,
+                .synced_ins = NOT_COMPILED};
+  emit_prologue_(&c);
+  c.exit_pos = c.e.pos;
+  emit_epilogue_(&c.e);
+
+  for (uint32_t i = start; i < end; ++i) {
+    const size_t ins_start = c.e.pos;
+    if (is_target[i - start]) {
+      load_slots_(&c);
+      c.synced_ins = NOT_COMPILED;
+    }
+    // Entering at i always has the slots loaded and i synced.
+    targets[i - start] = (uint32_t)c.e.pos;
+    code->offsets[i - start] = (uint32_t)c.e.pos;
+    if (!compile_instruction_(&c, tape_get(tape, i), i)) {
+      // The interpreter takes it from here.
+      code->offsets[i - start] = NOT_COMPILED;
+      emit_exit_(&c, i);
+    }
+    ASSERT(c.e.pos - ins_start <= MAX_INS_SIZE);
+  }
+  // Falling off the end returns to the interpreter.
+  emit_exit_(&c, end);
+  ASSERT(c.e.pos <= mem_size);
+
+  for (uint32_t i = 0; i < c.num_fixups; ++i) {
+    patch_rel32_(&c.e, c.fixups[i].pos, targets[c.fixups[i].target - start]);
+  }
+  RELEASE(c.fixups);
+  RELEASE(is_target);
+  RELEASE(targets);
+
+  if (0 != mprotect(mem, mem_size, PROT_READ | PROT_EXEC)) {
+    munmap(mem, mem_size);
+    RELEASE(code->offsets);
+    RELEASE(code);
+    return NULL;
+  }
+  return code;
+}
+
+#endif
+
+JitCode *jit_compile(Jit *jit, const Tape *tape, uint32_t start) {
+  ASSERT(jit != NULL);
+  ASSERT(tape != NULL);
+#ifdef ZINNIA_JIT_SUPPORTED
+  const uint32_t end = function_end_(tape, start);
+  if (end <= start || end - start > MAX_JIT_INSTRUCTIONS) {
+    return NULL;
+  }
+  JitCode *code = compile_function_(jit, tape, start, end);
+  if (NULL == code) {
+    return NULL;
+  }
+  SYNCHRONIZED(jit->lock, {
+    code->next = jit->codes;
+    jit->codes = code;
+  });
+  return code;
+#else
+  return NULL;
+#endif
+}
+
+bool jit_run(const JitCode *code, VM *vm, Task *task) {
+  ASSERT(code != NULL);
+  const Context *context = task->current;
+  if (code->tape != context->tape || context->ins < code->start ||
+      context->ins >= code->end) {
+    return false;
+  }
+  const uint32_t offset = code->offsets[context->ins - code->start];
+  if (NOT_COMPILED == offset) {
+    return false;
+  }
+  ((JitEntryFn)code->mem)(vm, task, code->mem + offset);
+  return true;
+}
@@ -0,0 +1,85 @@
+// jit.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_JIT_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_JIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zinnia/program/instruction.h"
+#include "zinnia/program/tape.h"
+#include "zinnia/vm/process/processes.h"
+
+// Baseline template JIT.
+//
+// Once a function has been entered JIT_CALL_THRESHOLD times, its body is
+// compiled to native code from a template for each instruction:
+//   - Jumps, IF and IFN are native branches.
+//   - Constants and moves between resval and local slots are native loads and
+//     stores.
+//   - Arithmetic and comparisons which were quickened for an Int in resval and
+//     an Int local or constant are native, with a type and overflow check
+//     which falls back to the stub.
+//   - Everything else calls the stub which executes the instruction like the
+//     interpreter does. Calls made by the stubs run the callee with its own
+//     compiled code, so a call only returns to the interpreter if the callee
+//     does not finish in compiled code.
+//
+// Instructions without a stub are left to the interpreter: the native code
+// returns right before executing one, and is re-entered the next time the
+// interpreter resumes the function.
+//
+// Only x86-64 Linux is supported. Elsewhere nothing is ever compiled.
+
+#if defined(__x86_64__) && defined(__linux__)
+#define ZINNIA_JIT_SUPPORTED
+#endif
+
+#define JIT_CALL_THRESHOLD 1000
+
+typedef struct _Jit Jit;
+typedef struct _JitCode JitCode;
+
+// What the native code does after a stub returns.
+typedef enum {
+  // Continue with the next instruction.
+  JIT_NEXT = 0,
+  // Return to the interpreter at task->current, e.g., because an error was
+  // raised or the function returned.
+  JIT_EXIT,
+} JitStep;
+
+// Executes ins on task->current exactly like the interpreter would, including
+// moving to the next instruction.
+typedef JitStep (*JitStub)(VM *vm, Task *task, const Instruction *ins);
+
+// What the native code calls into. Provided by the interpreter.
+typedef struct {
+  // Returns the stub for ins, or NULL if the interpreter must execute it.
+  JitStub (*stub)(const Instruction *ins);
+  // Returns the first local slot of task->current. Stubs may grow the stack,
+  // so this is called again after them before a slot is used.
+  Entity *(*slots)(Task *task);
+  // Called with the jump after a backward jump is taken, which may collect
+  // garbage.
+  JitStub safepoint;
+} JitRuntime;
+
+Jit *jit_create(const JitRuntime *runtime);
+// Frees all code compiled by jit.
+void jit_delete(Jit *jit);
+
+// Compiles the function in tape which starts at start. Returns NULL if the
+// JIT is not supported on this platform.
+//
+// Thread-safe.
+JitCode *jit_compile(Jit *jit, const Tape *tape, uint32_t start);
+
+// Runs code on task starting from the instruction at task->current->ins.
+// Returns false without doing anything if that instruction was not compiled.
+bool jit_run(const JitCode *code, VM *vm, Task *task);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_JIT_H_ */
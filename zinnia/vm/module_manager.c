@@ -24,9 +24,12 @@
 #include "zinnia/lang/lexer/lang_lexer.h"
 #include "zinnia/lang/parser/lang_parser.h"
 #include "zinnia/lang/semantic_analyzer/definitions.h"
+#include "zinnia/program/optimization/locals.h"
 #include "zinnia/program/optimization/optimize.h"
 #include "zinnia/program/tape_binary.h"
 #include "zinnia/util/file.h"
+#include "zinnia/vm/dispatch.h"
+#include "zinnia/vm/inline_cache.h"
 #include "zinnia/vm/intern.h"
 
 IMPL_MAPLIKE(ClassPtrMap, char *, Class *);
@@ -80,6 +83,9 @@ void modulemanager_finalize(ModuleManager *mm) {
     if (NULL != module_info->fi) {
       file_info_delete(module_info->fi);
     }
+    if (NULL != module_info->module._tape) {
+      inline_cache_release((Tape *)module_info->module._tape);  // Bless
+    }
     module_finalize(&module_info->module);
   }
   ModuleInfoMap_finalize(mm->_modules);
@@ -112,9 +118,11 @@ bool hydrate_class_(Module *module, ClassRef *cref) {
   FunctionRefMap_io_iterator(&funcs, &cref->func_refs);
   for (; FunctionRefMap_io_has_next(&funcs); FunctionRefMap_io_next(&funcs)) {
     FunctionRef *fref = FunctionRefMap_io_mutable_value(&funcs);
-    class_add_function(class, fref->name, fref->index, fref->is_const,
-                       fref->is_async);
+    Function *f = class_add_function(class, fref->name, fref->index,
+                                     fref->is_const, fref->is_async);
+    f->_num_slots = fref->num_slots;
   }
+  class_flatten(class);
   return true;
 }
 
@@ -145,6 +153,10 @@ ModuleInfo *modulemanager_hydrate_(ModuleManager *mm, Tape *tape,
   ASSERT(tape != NULL);
   ASSERT(module_info != NULL);
 
+  resolve_locals(tape);
+  dispatch_decode(tape);
+  inline_cache_attach(tape);
+
   Module *module = &module_info->module;
   module_init(module, tape_module_name(tape), module_info->file_path,
               module_info->relative_file_path, module_info->key, tape,
@@ -153,8 +165,9 @@ ModuleInfo *modulemanager_hydrate_(ModuleManager *mm, Tape *tape,
   FunctionRefMapIOIterator funcs = tape_functions(tape);
   for (; FunctionRefMap_io_has_next(&funcs); FunctionRefMap_io_next(&funcs)) {
     FunctionRef *fref = FunctionRefMap_io_mutable_value(&funcs);
-    module_add_function(module, fref->name, fref->index, fref->is_const,
-                        fref->is_async);
+    Function *f = module_add_function(module, fref->name, fref->index,
+                                      fref->is_const, fref->is_async);
+    f->_num_slots = fref->num_slots;
   }
 
   ClassRefMapIOIterator classes = tape_classes(tape);
@@ -199,7 +212,7 @@ void add_reflection_to_class_(Heap *heap, Module *module, Class *class) {
     class->_reflection = heap_new(heap, Class_Class);
   }
   if (NULL == class->_super && class != Class_Object) {
-    class->_super = Class_Object;
+    class_set_super(class, Class_Object);
   }
   class->_reflection->_class_obj = class;
   object_set_member_obj(heap, module->_reflection, class->_name,
@@ -531,6 +544,9 @@ void modulemanager_update_module(ModuleManager *mm, Module *m,
   ASSERT(m != NULL);
   ASSERT(new_classes != NULL);
   Tape *tape = (Tape *)m->_tape;  // bless
+  resolve_locals(tape);
+  dispatch_decode(tape);
+  inline_cache_attach(tape);
 
   ClassRefMapIOIterator classes = tape_classes(tape);
   ClassRefPtrArray classes_to_process;
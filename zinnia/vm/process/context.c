@@ -12,12 +12,30 @@
 #include "zinnia/program/tape.h"
 #include "zinnia/vm/intern.h"
 #include "zinnia/vm/process/processes.h"
+#include "zinnia/vm/process/task.h"
 
 Heap *context_heap_(Context *ctx);
 
-void context_add_reflection_(Context *context) {
-  context->_reflection = heap_new(context_heap_(context), Class_Context);
-  context->_reflection->_internal_obj = context;
+Object *context_reflection(Context *ctx) {
+  ASSERT(ctx != NULL);
+  if (NULL == ctx->_reflection) {
+    ctx->_reflection = heap_new(context_heap_(ctx), Class_Context);
+    ctx->_reflection->_internal_obj = ctx;
+  }
+  return ctx->_reflection;
+}
+
+void context_capture(Context *ctx) {
+  // Variables are also looked up in the previous contexts, so they must live
+  // as long as ctx.
+  for (; NULL != ctx; ctx = ctx->previous_context) {
+    context_reflection(ctx);
+  }
+}
+
+// Returns the variable id of ctx itself, or NULL if it has none.
+Entity *context_get_(Context *ctx, const char id[]) {
+  return NULL == ctx->_reflection ? NULL : object_get(ctx->_reflection, id);
 }
 
 void context_init(Context *ctx, Object *self, Module *module,
@@ -30,7 +48,9 @@ void context_init(Context *ctx, Object *self, Module *module,
   ctx->error = NULL;
   ctx->catch_ins = -1;
   ctx->previous_context = NULL;
-  context_add_reflection_(ctx);
+  ctx->caller = NULL;
+  ctx->slot_base = 0;
+  ctx->_reflection = NULL;
 }
 
 void context_finalize(Context *ctx) { ASSERT(ctx != NULL); }
@@ -46,7 +66,7 @@ Heap *context_heap_(Context *ctx) {
 
 Object *context_self(Context *ctx) {
   ASSERT(ctx != NULL);
-  return ctx->self.obj;
+  return object_m(&ctx->self);
 }
 
 Module *context_module(Context *ctx) {
@@ -57,44 +77,56 @@ Module *context_module(Context *ctx) {
 Object *wrap_function_in_ref(const Function *f, Object *obj, Heap *heap,
                              Context *ctx) {
   Object *fn_ref = heap_new(heap, Class_FunctionRef);
-  function_ref_init__(fn_ref, obj, f, f->_is_anon ? ctx : NULL, heap);
+  if (!f->_is_anon || NULL == ctx) {
+    function_ref_init__(fn_ref, obj, f, NULL, NULL, heap);
+    return fn_ref;
+  }
+  context_capture(ctx);
+  function_ref_init__(fn_ref, obj, f, ctx, ctx->_reflection, heap);
   return fn_ref;
 }
 
-Entity *context_lookup(Context *ctx, const char id[], Entity *tmp) {
+// If method is not NULL and id names a function on the class of self, sets
+// *method to it and returns NULL instead of binding it to self.
+Entity *context_lookup_(Context *ctx, const char id[], Entity *tmp,
+                        const Function **method) {
   ASSERT(ctx != NULL);
   ASSERT(id != NULL);
   if (SELF == id) {
     return &ctx->self;
   }
-  Entity *member = object_get(ctx->_reflection, id);
+  Entity *member = context_get_(ctx, id);
   if (NULL != member) {
     return member;
   }
   Task *task = ctx->parent_task;
   Context *parent_context = ctx->previous_context;
   while (NULL != parent_context &&
-         NULL == (member = object_get(parent_context->_reflection, id))) {
+         NULL == (member = context_get_(parent_context, id))) {
     parent_context = parent_context->previous_context;
   }
   if (NULL != member) {
     return member;
   }
-  member = object_get(ctx->self.obj, id);
+  member = object_get(object_m(&ctx->self), id);
   if (NULL != member) {
-    if (OBJECT == member->type && Class_Function == member->obj->_class &&
-        member->obj->_function_obj->_is_anon) {
-      *tmp = entity_object(
-          wrap_function_in_ref(member->obj->_function_obj, ctx->self.obj,
-                               task->parent_process->heap, ctx));
+    if (OBJECT == etype(member) && Class_Function == object_m(member)->_class &&
+        object_m(member)->_function_obj->_is_anon) {
+      *tmp = entity_object(wrap_function_in_ref(
+          object_m(member)->_function_obj, object_m(&ctx->self),
+          task->parent_process->heap, ctx));
       return tmp;
     }
     return member;
   }
-  const Function *f = class_get_function(ctx->self.obj->_class, id);
+  const Function *f = class_get_function(object_m(&ctx->self)->_class, id);
+  if (NULL != f && NULL != method) {
+    *method = f;
+    return NULL;
+  }
   if (NULL != f) {
-    Object *f_ref =
-        wrap_function_in_ref(f, ctx->self.obj, task->parent_process->heap, ctx);
+    Object *f_ref = wrap_function_in_ref(f, object_m(&ctx->self),
+                                         task->parent_process->heap, ctx);
 
     // TODO: With this uncommented code, the function ref can be collected when
     // allocated by a different heap from the object. This needs to be resolved.
@@ -118,8 +150,9 @@ Entity *context_lookup(Context *ctx, const char id[], Entity *tmp) {
   Object *obj = module_lookup(ctx->module, id);
   if (NULL != obj) {
     if (Class_Function == obj->_class && obj->_function_obj->_is_anon) {
-      *tmp = entity_object(wrap_function_in_ref(
-          obj->_function_obj, ctx->self.obj, task->parent_process->heap, ctx));
+      *tmp = entity_object(
+          wrap_function_in_ref(obj->_function_obj, object_m(&ctx->self),
+                               task->parent_process->heap, ctx));
       return tmp;
     }
     *tmp = entity_object(obj);
@@ -139,11 +172,15 @@ Entity *context_lookup(Context *ctx, const char id[], Entity *tmp) {
   return NULL;
 }
 
+Entity *context_lookup(Context *ctx, const char id[], Entity *tmp) {
+  return context_lookup_(ctx, id, tmp, NULL);
+}
+
 void context_let(Context *ctx, const char id[], const Entity *e) {
   ASSERT(ctx != NULL);
   ASSERT(id != NULL);
   ASSERT(e != NULL);
-  object_set_member(context_heap_(ctx), ctx->_reflection, id, e);
+  object_set_member(context_heap_(ctx), context_reflection(ctx), id, e);
 }
 
 void context_set(Context *ctx, const char id[], const Entity *e) {
@@ -151,13 +188,13 @@ void context_set(Context *ctx, const char id[], const Entity *e) {
   ASSERT(id != NULL);
   ASSERT(e != NULL);
   Entity *member = NULL;
-  if (NULL != object_get(ctx->_reflection, id)) {
+  if (NULL != context_get_(ctx, id)) {
     object_set_member(context_heap_(ctx), ctx->_reflection, id, e);
     return;
   }
   Context *parent_context = ctx->previous_context;
   while (NULL != parent_context &&
-         NULL == (member = object_get(parent_context->_reflection, id))) {
+         NULL == (member = context_get_(parent_context, id))) {
     parent_context = parent_context->previous_context;
   }
   if (NULL != member) {
@@ -165,13 +202,80 @@ void context_set(Context *ctx, const char id[], const Entity *e) {
                       parent_context->_reflection, id, e);
     return;
   }
-  if (NULL != object_get(ctx->self.obj, id)) {
-    object_set_member(context_heap_(ctx), ctx->self.obj, id, e);
+  if (NULL != object_get(object_m(&ctx->self), id)) {
+    object_set_member(context_heap_(ctx), object_m(&ctx->self), id, e);
     return;
   }
-  object_set_member(context_heap_(ctx), ctx->_reflection, id, e);
+  object_set_member(context_heap_(ctx), context_reflection(ctx), id, e);
 }
 
 void context_set_function(Context *ctx, const Function *func) {
   ctx->func = func;
+  Task *task = ctx->parent_task;
+  ctx->slot_base = EntityStack_size(&task->entity_stack);
+  context_clear_slots(ctx, 0, func->_num_slots);
+}
+
+Entity *context_slot_(Context *ctx, uint16_t index) {
+  return EntityStack_mutable_ref_unchecked(&ctx->parent_task->entity_stack,
+                                           ctx->slot_base + index);
+}
+
+bool is_bound_(const Entity *slot) {
+  return UNSET != etype(slot);
+}
+
+void context_clear_slots(Context *ctx, uint16_t index, uint16_t count) {
+  Task *task = ctx->parent_task;
+  int i;
+  for (i = 0; i < count; ++i) {
+    const uint32_t pos = ctx->slot_base + index + i;
+    Entity *slot = (pos < EntityStack_size(&task->entity_stack))
+                       ? context_slot_(ctx, index + i)
+                       : task_pushstack(task);
+    *slot = UNSET_ENTITY;
+  }
+}
+
+Entity *context_lookup_operand(Context *ctx, const Instruction *ins,
+                               Entity *tmp) {
+  if (INSTRUCTION_SLOT != ins->type) {
+    return context_lookup(ctx, ins->id, tmp);
+  }
+  Entity *slot = context_slot_(ctx, ins->local.index);
+  if (is_bound_(slot)) {
+    return slot;
+  }
+  // Not assigned yet, so it may refer to something outside of the function.
+  return context_lookup(ctx, ins->id, tmp);
+}
+
+Entity *context_lookup_for_call(Context *ctx, const Instruction *ins,
+                                Entity *tmp, const Function **method) {
+  *method = NULL;
+  if (INSTRUCTION_SLOT != ins->type) {
+    return context_lookup_(ctx, ins->id, tmp, method);
+  }
+  Entity *slot = context_slot_(ctx, ins->local.index);
+  if (is_bound_(slot)) {
+    return slot;
+  }
+  return context_lookup_(ctx, ins->id, tmp, method);
+}
+
+void context_let_slot(Context *ctx, const Instruction *ins, const Entity *e) {
+  ASSERT(INSTRUCTION_SLOT == ins->type);
+  *context_slot_(ctx, ins->local.index) = *e;
+}
+
+void context_set_slot(Context *ctx, const Instruction *ins, const Entity *e) {
+  ASSERT(INSTRUCTION_SLOT == ins->type);
+  Entity *slot = context_slot_(ctx, ins->local.index);
+  // Same as context_set(), members of self take precedence over creating a
+  // new variable.
+  if (!is_bound_(slot) && NULL != object_get(object_m(&ctx->self), ins->id)) {
+    object_set_member(context_heap_(ctx), object_m(&ctx->self), ins->id, e);
+    return;
+  }
+  *slot = *e;
 }
\ No newline at end of file
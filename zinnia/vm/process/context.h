@@ -14,6 +14,15 @@
 void context_init(Context *ctx, Object *self, Module *module,
                   uint32_t instruction_pos);
 void context_finalize(Context *ctx);
+// Returns the Class_Context object of ctx, creating it if ctx has none yet.
+// It holds the variables of ctx which are not in slots.
+//
+// Contexts without one are freed as soon as they are exited. Otherwise they
+// are freed when it is collected.
+Object *context_reflection(Context *ctx);
+// Must be called before anything keeps a pointer to ctx which may be used
+// after ctx is exited, e.g., a closure created in ctx.
+void context_capture(Context *ctx);
 Object *context_self(Context *ctx);
 Module *context_module(Context *ctx);
 const Instruction *context_ins(Context *ctx);
@@ -22,6 +31,20 @@ Entity *context_lookup(Context *ctx, const char id[], Entity *tmp);
 void context_let(Context *ctx, const char id[], const Entity *e);
 void context_set(Context *ctx, const char id[], const Entity *e);
 
+// Accessors for locals resolved to slots by resolve_locals().
+//
+// Looks up the operand of an INSTRUCTION_ID or INSTRUCTION_SLOT instruction.
+Entity *context_lookup_operand(Context *ctx, const Instruction *ins,
+                               Entity *tmp);
+// Same as context_lookup_operand() but for the callee of a call. If the
+// operand names a method of self, sets *method to it and returns NULL so it
+// can be called without wrapping it in a FunctionRef.
+Entity *context_lookup_for_call(Context *ctx, const Instruction *ins,
+                                Entity *tmp, const Function **method);
+void context_let_slot(Context *ctx, const Instruction *ins, const Entity *e);
+void context_set_slot(Context *ctx, const Instruction *ins, const Entity *e);
+void context_clear_slots(Context *ctx, uint16_t index, uint16_t count);
+
 Context *task_get_context_for_index(Task *task, uint32_t index);
 
 Object *wrap_function_in_ref(const Function *f, Object *obj, Heap *heap,
@@ -0,0 +1,88 @@
+// gc_stats.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/vm/process/gc_stats.h"
+
+#include <string.h>
+
+#include "zinnia/util/error.h"
+
+void gcstats_init(GcStats *stats) {
+  ASSERT(stats != NULL);
+  memset(stats, 0, sizeof(GcStats));
+}
+
+int pause_bucket_(int64_t pause_usec) {
+  int bucket = 0;
+  while (pause_usec > 0 && bucket < GC_PAUSE_BUCKETS - 1) {
+    pause_usec >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void gcstats_record(GcStats *stats, GcType type, int64_t pause_usec,
+                    uint32_t objects_freed, uint32_t objects_surviving) {
+  ASSERT(stats != NULL);
+  ASSERT(type >= 0 && type < GC_TYPE_COUNT);
+  ++stats->collections[type];
+  stats->objects_freed += objects_freed;
+  stats->objects_surviving = objects_surviving;
+  stats->total_pause_usec += pause_usec;
+  if (pause_usec > stats->max_pause_usec) {
+    stats->max_pause_usec = pause_usec;
+  }
+  ++stats->pause_histogram[pause_bucket_(pause_usec)];
+}
+
+bool gcstats_record_thresholds(GcStats *stats, uint32_t object_count_threshold,
+                               size_t bytes_threshold) {
+  ASSERT(stats != NULL);
+  if (object_count_threshold == stats->object_count_threshold &&
+      bytes_threshold == stats->bytes_threshold) {
+    return false;
+  }
+  stats->object_count_threshold = object_count_threshold;
+  stats->bytes_threshold = bytes_threshold;
+  ++stats->threshold_changes;
+  return true;
+}
+
+int64_t gcstats_pause_percentile_usec(const GcStats *stats, double percentile) {
+  ASSERT(stats != NULL);
+  ASSERT(percentile >= 0 && percentile <= 100);
+  uint64_t total = 0;
+  for (int i = 0; i < GC_TYPE_COUNT; ++i) {
+    total += stats->collections[i];
+  }
+  if (0 == total) {
+    return 0;
+  }
+  const double rank = total * percentile / 100;
+  uint64_t seen = 0;
+  for (int i = 0; i < GC_PAUSE_BUCKETS - 1; ++i) {
+    seen += stats->pause_histogram[i];
+    if (seen > 0 && seen >= rank) {
+      const int64_t upper_bound = (int64_t)1 << i;
+      return upper_bound < stats->max_pause_usec ? upper_bound
+                                                 : stats->max_pause_usec;
+    }
+  }
+  return stats->max_pause_usec;
+}
+
+const char *gctype_name(GcType type) {
+  switch (type) {
+    case GC_FULL:
+      return "full";
+    case GC_YOUNG:
+      return "young";
+    case GC_INCREMENTAL:
+      return "incremental";
+    default:
+      FATALF("Unknown GcType: %d", type);
+  }
+  return NULL;
+}
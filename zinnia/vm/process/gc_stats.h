@@ -0,0 +1,54 @@
+// gc_stats.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+//
+// Counters describing the garbage collections of a single process.
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_PROCESS_GC_STATS_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_PROCESS_GC_STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pauses of 2^(GC_PAUSE_BUCKETS - 1) usec or more all go in the last bucket.
+#define GC_PAUSE_BUCKETS 32
+
+typedef enum {
+  GC_FULL,
+  GC_YOUNG,
+  // A single step of an incremental collection.
+  GC_INCREMENTAL,
+  GC_TYPE_COUNT,
+} GcType;
+
+typedef struct {
+  uint64_t collections[GC_TYPE_COUNT];
+  uint64_t objects_freed;
+  // Objects left in the heap after the latest collection.
+  uint32_t objects_surviving;
+  int64_t total_pause_usec;
+  int64_t max_pause_usec;
+  // Pauses of at least 2^(i - 1) and less than 2^i usec are counted in
+  // pause_histogram[i].
+  uint64_t pause_histogram[GC_PAUSE_BUCKETS];
+  uint32_t object_count_threshold;
+  size_t bytes_threshold;
+  uint32_t threshold_changes;
+} GcStats;
+
+void gcstats_init(GcStats *stats);
+void gcstats_record(GcStats *stats, GcType type, int64_t pause_usec,
+                    uint32_t objects_freed, uint32_t objects_surviving);
+// Returns whether either threshold is different than the last recorded one.
+bool gcstats_record_thresholds(GcStats *stats, uint32_t object_count_threshold,
+                               size_t bytes_threshold);
+// Returns an upper bound of the shortest pause that is longer than percentile
+// (in [0, 100]) percent of all pauses, or 0 if there were none. It is exact
+// up to a factor of 2.
+int64_t gcstats_pause_percentile_usec(const GcStats *stats, double percentile);
+
+const char *gctype_name(GcType type);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_PROCESS_GC_STATS_H_ */
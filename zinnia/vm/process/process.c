@@ -7,8 +7,13 @@
 
 #include "rzalloc/rzalloc.h"
 #include "zinnia/entity/class/classes_def.h"
+#include "zinnia/heap/heap.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/sync/mpsc_queue.h"
 #include "zinnia/util/sync/mutex.h"
+#include "zinnia/vm/process/gc_stats.h"
 #include "zinnia/vm/process/processes.h"
+#include "zinnia/vm/process/scheduler.h"
 #include "zinnia/vm/process/task.h"
 
 
@@ -17,17 +22,24 @@ void process_init(Process *process, HeapConf *conf) {
   arena_init(&process->task_arena, sizeof(Task));
   arena_init(&process->context_arena, sizeof(Context));
   process->task_create_lock = mutex_create();
-  process->task_queue_lock = mutex_create();
   process->heap_access_lock = mutex_create();
+  gcstats_init(&process->gc_stats);
+  process->gc_stats.object_count_threshold =
+      heap_object_count_threshold_for_garbage_collection(process->heap);
+  process->gc_stats.bytes_threshold =
+      heap_bytes_threshold_for_garbage_collection(process->heap);
   process->task_waiting_cs = critical_section_create();
   process->task_wait_cond =
       critical_section_create_condition(process->task_waiting_cs);
   process->task_complete_lock = mutex_create();
-  TaskArray_init(&process->queued_tasks);
-  TaskSet_init(&process->waiting_tasks, hash_task, compare_tasks);
+  mpscqueue_init(&process->queued_tasks);
+  process->waiting_tasks = NULL;
+  process->num_waiting_tasks = 0;
   TaskSet_init(&process->completed_tasks, hash_task, compare_tasks);
   TaskSet_init(&process->background_tasks, hash_task, compare_tasks);
   process->_reflection = NULL;
+  process->scheduler = NULL;
+  process->schedule_state = PROCESS_IDLE;
   VoidPtrArray_init(&process->waiting_background_work);
   process->future = NULL;
   process->is_remote = false;
@@ -35,20 +47,17 @@ void process_init(Process *process, HeapConf *conf) {
 }
 
 void process_finalize(Process *process) {
-  TaskArrayIterator q_iter;
-  TaskArray_iterator(&q_iter, &process->queued_tasks);
-  for (; TaskArray_has_next(&q_iter); TaskArray_next(&q_iter)) {
-    task_finalize(*TaskArray_mutable_value(&q_iter));
+  Task *task;
+  while (mpscqueue_pop(&process->queued_tasks, (void **)&task)) {
+    task_finalize(task);
   }
-  TaskArray_finalize(&process->queued_tasks);
+  mpscqueue_finalize(&process->queued_tasks);
 
-  TaskSetIterator m_iter;
-  TaskSet_iterator(&m_iter, &process->waiting_tasks);
-  for (; TaskSet_has_next(&m_iter); TaskSet_next(&m_iter)) {
-    task_finalize(*TaskSet_mutable_value(&m_iter));
+  for (task = process->waiting_tasks; NULL != task; task = task->next_waiting) {
+    task_finalize(task);
   }
-  TaskSet_finalize(&process->waiting_tasks);
 
+  TaskSetIterator m_iter;
   TaskSet_iterator(&m_iter, &process->completed_tasks);
   for (; TaskSet_has_next(&m_iter); TaskSet_next(&m_iter)) {
     task_finalize(*TaskSet_mutable_value(&m_iter));
@@ -66,7 +75,6 @@ void process_finalize(Process *process) {
   arena_clear(&process->context_arena);
   heap_delete(process->heap);
   mutex_close(process->task_create_lock);
-  mutex_close(process->task_queue_lock);
   mutex_close(process->heap_access_lock);
   condition_delete(process->task_wait_cond);
   critical_section_delete(process->task_waiting_cs);
@@ -99,48 +107,76 @@ Task *process_create_task(Process *process) {
 
 Task *process_pop_task(Process *process) {
   Task *task;
-  SYNCHRONIZED(process->task_queue_lock, {
-    if (TaskArray_is_empty(&process->queued_tasks)) {
-      task = NULL;
-    } else {
-      task = TaskArray_pop_front_unchecked(&process->queued_tasks);
+  do {
+    if (!mpscqueue_pop(&process->queued_tasks, (void **)&task)) {
+      return NULL;
     }
-  });
-
-  // Task can be complete if it was prioritized to the front of the queue.
-  // This happens to a parent task when a child has an error.
-  if (NULL != task && TASK_COMPLETE == task->state) {
-    return process_pop_task(process);
-  }
+    // Task can be complete if it was prioritized to the front of the queue.
+    // This happens to a parent task when a child has an error.
+  } while (TASK_COMPLETE == task->state);
   return task;
 }
 
 void process_enqueue_task(Process *process, Task *task) {
-  SYNCHRONIZED(process->task_queue_lock,
-               { *TaskArray_push_back_ref(&process->queued_tasks) = task; });
+  mpscqueue_push(&process->queued_tasks, task);
+  process_notify(process);
 }
 
 void process_push_task(Process *process, Task *task) {
-  SYNCHRONIZED(process->task_queue_lock,
-               { TaskArray_push_back(&process->queued_tasks, task); });
+  mpscqueue_push(&process->queued_tasks, task);
+  process_notify(process);
 }
 
 size_t process_queue_size(Process *process) {
-  size_t size;
-  SYNCHRONIZED(process->task_queue_lock,
-               { size = TaskArray_size(&process->queued_tasks); });
-  return size;
+  return mpscqueue_size(&process->queued_tasks);
 }
 
 void process_insert_waiting_task(Process *process, Task *task) {
+  ASSERT(task->parent_process == process);
   task->state = TASK_WAITING;
-  CRITICAL(process->task_waiting_cs,
-           { TaskSet_insert(&process->waiting_tasks, task, sizeof(Task *)); });
+  CRITICAL(process->task_waiting_cs, {
+    if (!task->is_waiting) {
+      task->is_waiting = true;
+      task->prev_waiting = NULL;
+      task->next_waiting = process->waiting_tasks;
+      if (NULL != process->waiting_tasks) {
+        process->waiting_tasks->prev_waiting = task;
+      }
+      process->waiting_tasks = task;
+      ++process->num_waiting_tasks;
+    }
+  });
 }
 
 void process_remove_waiting_task(Process *process, Task *task) {
+  ASSERT(task->parent_process == process);
+  CRITICAL(process->task_waiting_cs, {
+    if (task->is_waiting) {
+      task->is_waiting = false;
+      if (NULL == task->prev_waiting) {
+        process->waiting_tasks = task->next_waiting;
+      } else {
+        task->prev_waiting->next_waiting = task->next_waiting;
+      }
+      if (NULL != task->next_waiting) {
+        task->next_waiting->prev_waiting = task->prev_waiting;
+      }
+      task->prev_waiting = NULL;
+      task->next_waiting = NULL;
+      --process->num_waiting_tasks;
+    }
+  });
+  process_notify(process);
+}
+
+void process_notify(Process *process) {
+  if (NULL != process->scheduler) {
+    scheduler_notify(process->scheduler, process);
+    return;
+  }
+  // Under task_waiting_cs so that it cannot be missed by process_run().
   CRITICAL(process->task_waiting_cs,
-           { TaskSet_remove(&process->waiting_tasks, task, sizeof(Task *)); });
+           { condition_broadcast(process->task_wait_cond); });
 }
 
 void process_mark_task_complete(Process *process, Task *task) {
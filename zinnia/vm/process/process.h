@@ -22,6 +22,12 @@ void process_insert_waiting_task(Process *process, Task *task);
 void process_remove_waiting_task(Process *process, Task *task);
 void process_mark_task_complete(Process *process, Task *task);
 
+// Wakes process up to run its queued tasks, or to find that its waiting tasks
+// changed. Called whenever a task is queued or stops waiting.
+//
+// Thread-safe.
+void process_notify(Process *process);
+
 void process_add_background_task(Process *process, Task *task,
                                  ThreadPool *background_pool, VoidFnPtr fn,
                                  VoidFnPtr callback, VoidPtr fn_args);
@@ -14,15 +14,19 @@
 #include "zinnia/heap/heap.h"
 #include "zinnia/program/tape.h"
 #include "zinnia/util/sync/critical_section.h"
+#include "zinnia/util/sync/mpsc_queue.h"
 #include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/sync/reactor.h"
 #include "zinnia/util/sync/thread.h"
 #include "zinnia/util/sync/threadpool.h"
+#include "zinnia/vm/process/gc_stats.h"
 
 typedef struct _VM VM;
 typedef struct __Context Context;
 typedef struct __Task Task;
 typedef struct __Process Process;
 typedef struct Future_ Future;
+typedef struct _Scheduler Scheduler;
 
 uint32_t hash_task(const Task *tsk, uint32_t size);
 int32_t compare_tasks(const Task *tsk1, uint32_t size1, const Task *tsk2,
@@ -35,6 +39,9 @@ DEFINE_ARRAYLIKE(TaskArray, Task *);
 struct __Context {
   Task *parent_task;
   Context *previous_context;
+  // Set on the first context of a function called directly on parent_task.
+  // This is the context that resumes when the function returns.
+  Context *caller;
 
   Object *_reflection;
 
@@ -46,6 +53,9 @@ struct __Context {
 
   Object *error;
   int32_t catch_ins;
+
+  // Index in the task entity_stack of the first local slot of the function.
+  uint32_t slot_base;
 };
 
 typedef enum {
@@ -72,6 +82,9 @@ struct __Task {
 
   Entity resval;
   EntityStack entity_stack;
+  // Number of arguments to the call being made that are on top of
+  // entity_stack. When 0, the arguments are in resval.
+  uint32_t num_stack_args;
 
   Task *parent_task;
 
@@ -80,9 +93,24 @@ struct __Task {
   bool child_task_has_error;
   bool is_finalized;
 
+  // Links of Process.waiting_tasks. Guarded by task_waiting_cs of
+  // parent_process.
+  bool is_waiting;
+  Task *prev_waiting, *next_waiting;
+
   Object *_reflection;
 
   Future *remote_future;
+
+  // Set by a background native which would block on io_wait_fd. It is then run
+  // again once io_wait_fd is ready for io_wait_event instead of completing.
+  int io_wait_fd;
+  ReactorEvent io_wait_event;
+  // Set by a background native which submitted io_ops. It is then run again
+  // once they are done, which sets io_ops_done, instead of completing.
+  ReactorOp *io_ops;
+  uint32_t num_io_ops;
+  bool io_ops_done;
 };
 
 struct __Process {
@@ -92,7 +120,6 @@ struct __Process {
   RzallocArena task_arena;
   RzallocArena context_arena;
   Mutex task_create_lock;
-  Mutex task_queue_lock;
 
   CriticalSection task_waiting_cs;
   Condition *task_wait_cond;
@@ -100,15 +127,27 @@ struct __Process {
   Mutex task_complete_lock;
 
   Task *current_task;
-  TaskArray queued_tasks;
-  TaskSet waiting_tasks;
+  // Tasks to run, pushed by any thread but only popped by the one running the
+  // process.
+  MpscQueue queued_tasks;
+  // Intrusive list of the tasks waiting on something, linked through
+  // Task.next_waiting. Guarded by task_waiting_cs.
+  Task *waiting_tasks;
+  uint32_t num_waiting_tasks;
   TaskSet completed_tasks;
   TaskSet background_tasks;
 
   Mutex heap_access_lock;
+  // Guarded by heap_access_lock.
+  GcStats gc_stats;
 
   Object *_reflection;
   ThreadHandle thread;  // Null if main thread.
+  // Runs the process once it is started. NULL if it runs on a thread of its
+  // own instead.
+  Scheduler *scheduler;
+  // ProcessScheduleState, only accessed atomically.
+  volatile uint32_t schedule_state;
 
   VoidPtrArray waiting_background_work;
 
@@ -41,7 +41,7 @@ Process *remote_get_process(Remote *remote) { return remote->remote_process; }
 
 Remote *extract_remote(Entity *remote_entity) {
   ASSERT(IS_CLASS(remote_entity, Class_Remote));
-  return (Remote *)remote_entity->obj->_internal_obj;
+  return (Remote *)object_m(remote_entity)->_internal_obj;
 }
 
 Remote *extract_remote_from_obj(Object *remote_obj) {
@@ -0,0 +1,214 @@
+// scheduler.c
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#include "zinnia/vm/process/scheduler.h"
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/util/deque.h"
+#include "zinnia/util/error.h"
+#include "zinnia/util/sync/atomic.h"
+#include "zinnia/util/sync/critical_section.h"
+#include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/sync/thread.h"
+
+typedef struct {
+  Scheduler *scheduler;
+  uint32_t index;
+  Mutex lock;
+  // Runnable processes. Guarded by lock. The worker pops from the front, so
+  // they run in the order they became runnable, and thieves pop from the
+  // back.
+  Deque queue;
+  ThreadHandle thread;
+} Worker;
+
+struct _Scheduler {
+  ProcessRunFn run;
+  uint32_t num_workers;
+  Worker *workers;
+  // Picks the queue of the next process notified from outside the workers.
+  volatile uint32_t next_worker;
+
+  // Guards num_idle and writes to is_stopping. Idle workers wait on
+  // idle_cond.
+  CriticalSection idle_cs;
+  Condition *idle_cond;
+  uint32_t num_idle;
+  // Also read by workers between processes, without idle_cs.
+  volatile uint32_t is_stopping;
+};
+
+void worker_push_(Worker *worker, Process *process) {
+  SYNCHRONIZED(worker->lock, { deque_push_back(&worker->queue, process); });
+  Scheduler *scheduler = worker->scheduler;
+  // Idle workers hold idle_cs from when they last found every queue empty
+  // until they wait, so they cannot miss this.
+  CRITICAL(scheduler->idle_cs, {
+    if (scheduler->num_idle > 0) {
+      condition_signal(scheduler->idle_cond);
+    }
+  });
+}
+
+Process *worker_pop_(Worker *worker, bool is_thief) {
+  void *process = NULL;
+  SYNCHRONIZED(worker->lock, {
+    if (is_thief) {
+      deque_pop_back(&worker->queue, &process);
+    } else {
+      deque_pop_front(&worker->queue, &process);
+    }
+  });
+  return (Process *)process;
+}
+
+// Pops from the queue of worker, or else steals from the other workers,
+// starting with the next one so that not every worker steals from the same.
+Process *next_process_(Worker *worker) {
+  Scheduler *scheduler = worker->scheduler;
+  for (uint32_t i = 0; i < scheduler->num_workers; ++i) {
+    Process *process = worker_pop_(
+        &scheduler->workers[(worker->index + i) % scheduler->num_workers],
+        /*is_thief=*/i > 0);
+    if (NULL != process) {
+      return process;
+    }
+  }
+  return NULL;
+}
+
+bool has_runnable_process_(Scheduler *scheduler) {
+  bool has_runnable = false;
+  for (uint32_t i = 0; i < scheduler->num_workers && !has_runnable; ++i) {
+    Worker *worker = &scheduler->workers[i];
+    SYNCHRONIZED(worker->lock,
+                 { has_runnable = !deque_is_empty(&worker->queue); });
+  }
+  return has_runnable;
+}
+
+void run_process_(Worker *worker, Process *process) {
+  atomic_store_u32(&process->schedule_state, PROCESS_RUNNING);
+  if (worker->scheduler->run(process)) {
+    atomic_store_u32(&process->schedule_state, PROCESS_DONE);
+    return;
+  }
+  if (atomic_cas_u32(&process->schedule_state, PROCESS_RUNNING,
+                     PROCESS_IDLE)) {
+    return;
+  }
+  // Notified while running. It goes to the back of the queue so that it does
+  // not starve the others.
+  atomic_store_u32(&process->schedule_state, PROCESS_SCHEDULED);
+  worker_push_(worker, process);
+}
+
+void do_work_(Worker *worker) {
+  Scheduler *scheduler = worker->scheduler;
+  // Runnable processes are left in the queues once stopping.
+  while (!atomic_load_u32(&scheduler->is_stopping)) {
+    Process *process = next_process_(worker);
+    if (NULL != process) {
+      run_process_(worker, process);
+      continue;
+    }
+    CRITICAL(scheduler->idle_cs, {
+      while (!scheduler->is_stopping && !has_runnable_process_(scheduler)) {
+        ++scheduler->num_idle;
+        condition_wait(scheduler->idle_cond);
+        --scheduler->num_idle;
+      }
+    });
+  }
+}
+
+Scheduler *scheduler_create(uint32_t num_workers, ProcessRunFn run) {
+  ASSERT(num_workers > 0);
+  ASSERT(run != NULL);
+  Scheduler *scheduler = MNEW(Scheduler);
+  scheduler->run = run;
+  scheduler->num_workers = num_workers;
+  scheduler->next_worker = 0;
+  scheduler->idle_cs = critical_section_create();
+  scheduler->idle_cond = critical_section_create_condition(scheduler->idle_cs);
+  scheduler->num_idle = 0;
+  scheduler->is_stopping = 0;
+  scheduler->workers = MNEW_ARR(Worker, num_workers);
+  uint32_t i;
+  for (i = 0; i < num_workers; ++i) {
+    Worker *worker = &scheduler->workers[i];
+    worker->scheduler = scheduler;
+    worker->index = i;
+    worker->lock = mutex_create();
+    deque_init(&worker->queue);
+  }
+  // Only started once every queue exists since workers steal from each other.
+  for (i = 0; i < num_workers; ++i) {
+    scheduler->workers[i].thread =
+        thread_create((VoidFn)do_work_, (void *)&scheduler->workers[i]);
+  }
+  return scheduler;
+}
+
+void scheduler_delete(Scheduler *scheduler) {
+  ASSERT(scheduler != NULL);
+  CRITICAL(scheduler->idle_cs, {
+    atomic_store_u32(&scheduler->is_stopping, 1);
+    condition_broadcast(scheduler->idle_cond);
+  });
+  uint32_t i;
+  for (i = 0; i < scheduler->num_workers; ++i) {
+    thread_join(scheduler->workers[i].thread, INFINITE);
+  }
+  for (i = 0; i < scheduler->num_workers; ++i) {
+    Worker *worker = &scheduler->workers[i];
+    deque_finalize(&worker->queue);
+    mutex_close(worker->lock);
+  }
+  RELEASE(scheduler->workers);
+  condition_delete(scheduler->idle_cond);
+  critical_section_delete(scheduler->idle_cs);
+  RELEASE(scheduler);
+}
+
+uint32_t scheduler_num_workers(const Scheduler *scheduler) {
+  ASSERT(scheduler != NULL);
+  return scheduler->num_workers;
+}
+
+void scheduler_start(Scheduler *scheduler, Process *process) {
+  ASSERT(scheduler != NULL);
+  ASSERT(process != NULL);
+  ASSERT(process->scheduler == NULL);
+  process->scheduler = scheduler;
+  scheduler_notify(scheduler, process);
+}
+
+void scheduler_notify(Scheduler *scheduler, Process *process) {
+  ASSERT(scheduler != NULL);
+  ASSERT(process != NULL);
+  for (;;) {
+    switch (atomic_load_u32(&process->schedule_state)) {
+      case PROCESS_IDLE:
+        if (atomic_cas_u32(&process->schedule_state, PROCESS_IDLE,
+                           PROCESS_SCHEDULED)) {
+          const uint32_t i =
+              atomic_inc_u32(&scheduler->next_worker) % scheduler->num_workers;
+          worker_push_(&scheduler->workers[i], process);
+          return;
+        }
+        break;
+      case PROCESS_RUNNING:
+        if (atomic_cas_u32(&process->schedule_state, PROCESS_RUNNING,
+                           PROCESS_RUNNING_NOTIFIED)) {
+          return;
+        }
+        break;
+      default:
+        // Already going to run, or never will.
+        return;
+    }
+  }
+}
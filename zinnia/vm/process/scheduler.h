@@ -0,0 +1,59 @@
+// scheduler.h
+//
+// Created on: Oct 18, 2026
+//     Author: Jeff Manzione
+
+#ifndef COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_PROCESS_SCHEDULER_H_
+#define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_PROCESS_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zinnia/vm/process/processes.h"
+
+// M:N scheduler for processes.
+//
+// A fixed number of worker threads run every started process, so a process
+// costs no thread of its own. Each worker runs the processes in its queue in
+// the order they became runnable. Once its own queue is empty, it steals the
+// most recently queued processes from the other end of the others' queues.
+//
+// A process is runnable once a task is queued on it or one of its waiting
+// tasks stops waiting (see process_notify()). A worker then runs it until no
+// task is queued on it anymore, after which it is idle until notified again.
+//
+// Natives that block the thread calling them, rather than running in the
+// background, block their worker until they return.
+
+typedef enum {
+  // Waiting to be notified.
+  PROCESS_IDLE = 0,
+  // In the queue of a worker.
+  PROCESS_SCHEDULED,
+  // Being run by a worker.
+  PROCESS_RUNNING,
+  // Being run by a worker and notified since, so it must run again.
+  PROCESS_RUNNING_NOTIFIED,
+  // Never runs again.
+  PROCESS_DONE,
+} ProcessScheduleState;
+
+// Runs the queued tasks of process. Returns whether it is done.
+typedef bool (*ProcessRunFn)(Process *process);
+
+Scheduler *scheduler_create(uint32_t num_workers, ProcessRunFn run);
+// Stops and joins the workers. Workers finish the process they are running,
+// if any, but processes which are still runnable are never run.
+void scheduler_delete(Scheduler *scheduler);
+
+uint32_t scheduler_num_workers(const Scheduler *scheduler);
+
+// Hands process to scheduler, which runs it from then on.
+void scheduler_start(Scheduler *scheduler, Process *process);
+
+// Makes process runnable if it is not already.
+//
+// Thread-safe.
+void scheduler_notify(Scheduler *scheduler, Process *process);
+
+#endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_PROCESS_SCHEDULER_H_ */
@@ -5,6 +5,7 @@
 
 #include "zinnia/vm/process/task.h"
 
+#include "rzalloc/rzalloc.h"
 #include "zinnia/entity/class/classes_def.h"
 #include "zinnia/heap/heap.h"
 #include "zinnia/util/error.h"
@@ -30,21 +31,52 @@ void task_init(Task *task) {
   task->state = TASK_NEW;
   task->wait_reason = WAITING_TO_START;
   EntityStack_init(&task->entity_stack);
+  task->num_stack_args = 0;
   task->parent_task = NULL;
   TaskSet_init(&task->dependent_tasks, hash_task, compare_tasks);
   task->child_task_has_error = false;
   task->current = NULL;
   task->_reflection = NULL;
   task->is_finalized = false;
+  task->is_waiting = false;
+  task->prev_waiting = NULL;
+  task->next_waiting = NULL;
   task->remote_future = NULL;
+  task->io_wait_fd = -1;
+  task->io_ops = NULL;
+  task->num_io_ops = 0;
+  task->io_ops_done = false;
+}
+
+// Frees ctx, which task has exited, unless its reflection is still around.
+void task_release_context_(Task *task, Context *ctx) {
+  if (NULL != ctx->_reflection) {
+    return;
+  }
+  context_finalize(ctx);
+  arena_free(&task->parent_process->context_arena, ctx);
 }
 
 void task_finalize(Task *task) {
   if (task->is_finalized) {
     return;
   }
+  // Contexts of the task which were never exited, e.g., because it completed
+  // without returning from them.
+  Context *ctx = task->current;
+  while (NULL != ctx && task == ctx->parent_task) {
+    Context *next =
+        NULL != ctx->previous_context ? ctx->previous_context : ctx->caller;
+    task_release_context_(task, ctx);
+    ctx = next;
+  }
+  task->current = NULL;
   TaskSet_finalize(&task->dependent_tasks);
   EntityStack_finalize(&task->entity_stack);
+  // The reflection may outlive the task, so it must not be traced into.
+  if (NULL != task->_reflection) {
+    task->_reflection->_internal_obj = NULL;
+  }
   if (NULL != task->parent_process) {
     heap_dec_edge(task->parent_process->heap, task->parent_process->_reflection,
                   task->_reflection);
@@ -58,13 +90,20 @@ Context *task_create_context(Task *task, Object *self, Module *module,
   ctx->parent_task = task;
   context_init(ctx, self, module, instruction_pos);
   ctx->previous_context = task->current;
+  if (NULL != task->current) {
+    ctx->slot_base = task->current->slot_base;
+  }
   task->current = ctx;
   return ctx;
 }
 
 Context *task_back_context(Task *task) {
-  uint32_t ins = task->current->ins;
-  task->current = task->current->previous_context;
+  Context *ctx = task->current;
+  uint32_t ins = ctx->ins;
+  task->current = ctx->previous_context;
+  if (task == ctx->parent_task) {
+    task_release_context_(task, ctx);
+  }
   // This was the last context.
   if (NULL == task->current) {
     return NULL;
@@ -73,6 +112,63 @@ Context *task_back_context(Task *task) {
   return task->current;
 }
 
+void task_truncate_stack_(Task *task, uint32_t size) {
+  while (EntityStack_size(&task->entity_stack) > size) {
+    EntityStack_pop_back_unchecked(&task->entity_stack);
+  }
+}
+
+Context *task_return_to_caller_(Task *task, Context *frame) {
+  task_truncate_stack_(task, frame->slot_base);
+  Context *ctx = task->current;
+  while (ctx != frame) {
+    Context *block = ctx;
+    ctx = ctx->previous_context;
+    task_release_context_(task, block);
+  }
+  task->current = frame->caller;
+  // The frame may still be reachable through its reflection, but never from
+  // its caller again.
+  frame->caller = NULL;
+  task_release_context_(task, frame);
+  return task->current;
+}
+
+Context *task_unwind_context(Task *task) {
+  Context *ctx = task->current;
+  if (NULL != ctx->caller) {
+    return task_return_to_caller_(task, ctx);
+  }
+  return task_back_context(task);
+}
+
+bool task_return_from_frame(Task *task) {
+  Context *frame = task->current;
+  // Blocks within a function have no func.
+  while (NULL == frame->func && NULL != frame->previous_context) {
+    frame = frame->previous_context;
+  }
+  if (NULL == frame->caller) {
+    return false;
+  }
+  task_return_to_caller_(task, frame);
+  return true;
+}
+
+Context *task_next_context(Context *ctx, Context **caller) {
+  // The first caller found belongs to the function ctx is in. Anonymous
+  // functions continue on to the context they were created in.
+  if (NULL == *caller) {
+    *caller = ctx->caller;
+  }
+  if (NULL != ctx->previous_context) {
+    return ctx->previous_context;
+  }
+  Context *next = *caller;
+  *caller = NULL;
+  return next;
+}
+
 Entity task_popstack(Task *task) {
   ASSERT(EntityStack_size(&task->entity_stack) > 0);
   Entity e = *task_peekstack(task);
@@ -91,6 +187,12 @@ const Entity *task_peekstack_n(Task *task, int n) {
       &task->entity_stack, EntityStack_size(&task->entity_stack) - 1 - n);
 }
 
+Entity task_removestack_n(Task *task, int n) {
+  ASSERT(EntityStack_size(&task->entity_stack) > n);
+  return EntityStack_remove_unchecked(
+      &task->entity_stack, EntityStack_size(&task->entity_stack) - 1 - n);
+}
+
 void task_dropstack(Task *task) {
   EntityStack_pop_back_unchecked(&task->entity_stack);
 }
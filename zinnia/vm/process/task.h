@@ -17,10 +17,21 @@ void task_finalize(Task *task);
 Context *task_create_context(Task *task, Object *self, Module *module,
                              uint32_t instruction_pos);
 Context *task_back_context(Task *task);
+// Leaves the current block or, if it is the first context of a function called
+// on this task, returns to the caller.
+Context *task_unwind_context(Task *task);
+// Pops the function called on this task that the current context belongs to.
+// Returns false if the function was not called on this task.
+bool task_return_from_frame(Task *task);
+// Iterates over all contexts on the task, continuing to the callers of called
+// functions. caller must point to NULL before the first call.
+Context *task_next_context(Context *ctx, Context **caller);
 
 Entity task_popstack(Task *task);
 const Entity *task_peekstack(Task *task);
 const Entity *task_peekstack_n(Task *task, int n);
+// Removes the entity n below the top of the stack.
+Entity task_removestack_n(Task *task, int n);
 void task_dropstack(Task *task);
 Entity *task_pushstack(Task *task);
 
@@ -9,6 +9,7 @@
 
 #include "zinnia/alloc/alloc.h"
 #include "zinnia/entity/array/array.h"
+#include "zinnia/entity/class/class.h"
 #include "zinnia/entity/class/classes_def.h"
 #include "zinnia/entity/entity.h"
 #include "zinnia/entity/module/modules.h"
@@ -22,17 +23,23 @@
 #include "zinnia/entity/string/string_helper.h"
 #include "zinnia/entity/tuple/tuple.h"
 #include "zinnia/heap/heap.h"
+#include "zinnia/util/sync/atomic.h"
 #include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/sync/reactor.h"
 #include "zinnia/util/sync/thread.h"
 #include "zinnia/vm/builtin_modules.h"
+#include "zinnia/vm/dispatch.h"
 #include "zinnia/vm/intern.h"
+#include "zinnia/vm/jit.h"
 #include "zinnia/vm/process/context.h"
 #include "zinnia/vm/process/process.h"
 #include "zinnia/vm/process/processes.h"
 #include "zinnia/vm/process/remote.h"
+#include "zinnia/vm/process/scheduler.h"
 #include "zinnia/vm/process/task.h"
 
-#define DEFAULT_THREADPOOL_SIZE 6
+// Calls with more arguments than this on the stack pass them in a Tuple.
+#define MAX_STACK_ARGS 16
 
 bool process_maybe_collect_garbage(Process *process);
 bool _call_function_base(Task *task, Context *context, const Function *func,
@@ -51,11 +58,22 @@ void _execute_DUP(VM *vm, Task *task, Context *context, const Instruction *ins);
 void _execute_FLD(VM *vm, Task *task, Context *context, const Instruction *ins);
 void _execute_LET(VM *vm, Task *task, Context *context, const Instruction *ins);
 void _execute_SET(VM *vm, Task *task, Context *context, const Instruction *ins);
+void _execute_LRES(VM *vm, Task *task, Context *context,
+                   const Instruction *ins);
+void _execute_LPSH(VM *vm, Task *task, Context *context,
+                   const Instruction *ins);
+void _execute_LLET(VM *vm, Task *task, Context *context,
+                   const Instruction *ins);
+void _execute_LSET(VM *vm, Task *task, Context *context,
+                   const Instruction *ins);
 void _execute_GET(VM *vm, Task *task, Context *context, const Instruction *ins);
 void _execute_GTSH(VM *vm, Task *task, Context *context,
                    const Instruction *ins);
 bool _execute_CALL(VM *vm, Task *task, Context *context,
                    const Instruction *ins);
+bool _call_entity_(Task *task, Context *context, Entity fn);
+bool _execute_SCLL(VM *vm, Task *task, Context *context,
+                   const Instruction *ins);
 void _execute_RET(VM *vm, Task *task, Context *context, const Instruction *ins);
 Context *_execute_NBLK(VM *vm, Task *task, Context *context,
                        const Instruction *ins);
@@ -79,6 +97,10 @@ bool _execute_LMDL(VM *vm, Task *task, Context *context,
                    const Instruction *ins);
 bool _execute_CTCH(VM *vm, Task *task, Context *context,
                    const Instruction *ins);
+JitStub _jit_stub_(const Instruction *ins);
+Entity *_jit_slots_(Task *task);
+JitStep _jit_safepoint_(VM *vm, Task *task, const Instruction *ins);
+Entity *context_slot_(Context *ctx, uint16_t index);
 
 #define MATH_OP(op, symbol)                                             \
   Primitive _execute_primitive_##op(const Primitive *p1,                \
@@ -116,48 +138,56 @@ bool _execute_CTCH(VM *vm, Task *task, Context *context,
                      const Instruction *ins) {                             \
     const Entity *resval, *lookup;                                         \
     Entity first, second, tmp;                                             \
+    Primitive lhs, rhs;                                                    \
     switch (ins->type) {                                                   \
       case INSTRUCTION_NO_ARG:                                             \
         second = task_popstack(task);                                      \
-        if (PRIMITIVE != second.type) {                                    \
+        if (PRIMITIVE != etype(&second)) {                                 \
           raise_error(task, context, "RHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
         first = task_popstack(task);                                       \
-        if (PRIMITIVE != first.type) {                                     \
+        if (PRIMITIVE != etype(&first)) {                                  \
           raise_error(task, context, "LHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        *task_mutable_resval(task) = entity_primitive(                     \
-            _execute_primitive_##op(&first.pri, &second.pri));             \
+        lhs = eprimitive(&first);                                          \
+        rhs = eprimitive(&second);                                         \
+        *task_mutable_resval(task) =                                       \
+            entity_primitive(_execute_primitive_##op(&lhs, &rhs));         \
         break;                                                             \
       case INSTRUCTION_ID:                                                 \
+      case INSTRUCTION_SLOT:                                               \
         resval = task_get_resval(task);                                    \
-        if (NULL != resval && PRIMITIVE != resval->type) {                 \
+        if (NULL != resval && PRIMITIVE != etype(resval)) {                \
           raise_error(task, context, "LHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        lookup = context_lookup(context, ins->id, &tmp);                   \
-        if (NULL != lookup && PRIMITIVE != lookup->type) {                 \
+        lookup = context_lookup_operand(context, ins, &tmp);               \
+        if (NULL != lookup && PRIMITIVE != etype(lookup)) {                \
           raise_error(task, context, "RHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        *task_mutable_resval(task) = entity_primitive(                     \
-            _execute_primitive_##op(&resval->pri, &lookup->pri));          \
+        lhs = eprimitive(resval);                                          \
+        rhs = eprimitive(lookup);                                          \
+        *task_mutable_resval(task) =                                       \
+            entity_primitive(_execute_primitive_##op(&lhs, &rhs));         \
         break;                                                             \
       case INSTRUCTION_PRIMITIVE:                                          \
         resval = task_get_resval(task);                                    \
-        if (NULL != resval && PRIMITIVE != resval->type) {                 \
+        if (NULL != resval && PRIMITIVE != etype(resval)) {                \
           raise_error(task, context, "LHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        *task_mutable_resval(task) = entity_primitive(                     \
-            _execute_primitive_##op(&resval->pri, &ins->val));             \
+        lhs = eprimitive(resval);                                          \
+        rhs = instruction_primitive(ins);                                  \
+        *task_mutable_resval(task) =                                       \
+            entity_primitive(_execute_primitive_##op(&lhs, &rhs));         \
         break;                                                             \
       default:                                                             \
         FATALF("Invalid arg type=%d for " #op ".", ins->type);             \
@@ -170,51 +200,58 @@ bool _execute_CTCH(VM *vm, Task *task, Context *context,
                      const Instruction *ins) {                             \
     const Entity *resval, *lookup;                                         \
     Entity first, second, tmp;                                             \
-    Primitive result;                                                      \
+    Primitive lhs, rhs, result;                                            \
     switch (ins->type) {                                                   \
       case INSTRUCTION_NO_ARG:                                             \
         second = task_popstack(task);                                      \
-        if (PRIMITIVE != second.type) {                                    \
+        if (PRIMITIVE != etype(&second)) {                                 \
           raise_error(task, context, "RHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
         first = task_popstack(task);                                       \
-        if (PRIMITIVE != first.type) {                                     \
+        if (PRIMITIVE != etype(&first)) {                                  \
           raise_error(task, context, "LHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        result = _execute_primitive_##op(&first.pri, &second.pri);         \
+        lhs = eprimitive(&first);                                          \
+        rhs = eprimitive(&second);                                         \
+        result = _execute_primitive_##op(&lhs, &rhs);                      \
         *task_mutable_resval(task) =                                       \
             int_of(&result) == 0 ? FALSE_ENTITY : TRUE_ENTITY;             \
         break;                                                             \
       case INSTRUCTION_ID:                                                 \
+      case INSTRUCTION_SLOT:                                               \
         resval = task_get_resval(task);                                    \
-        if (NULL != resval && PRIMITIVE != resval->type) {                 \
+        if (NULL != resval && PRIMITIVE != etype(resval)) {                \
           raise_error(task, context, "LHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        lookup = context_lookup(context, ins->id, &tmp);                   \
+        lookup = context_lookup_operand(context, ins, &tmp);               \
         if ((NULL == lookup) ||                                            \
-            (NULL != lookup && PRIMITIVE != lookup->type)) {               \
+            (NULL != lookup && PRIMITIVE != etype(lookup))) {              \
           raise_error(task, context, "RHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        result = _execute_primitive_##op(&resval->pri, &lookup->pri);      \
+        lhs = eprimitive(resval);                                          \
+        rhs = eprimitive(lookup);                                          \
+        result = _execute_primitive_##op(&lhs, &rhs);                      \
         *task_mutable_resval(task) =                                       \
             int_of(&result) == 0 ? FALSE_ENTITY : TRUE_ENTITY;             \
         break;                                                             \
       case INSTRUCTION_PRIMITIVE:                                          \
         resval = task_get_resval(task);                                    \
-        if (NULL != resval && PRIMITIVE != resval->type) {                 \
+        if (NULL != resval && PRIMITIVE != etype(resval)) {                \
           raise_error(task, context, "LHS for op '%s' must be primitive.", \
                       #op);                                                \
           return;                                                          \
         }                                                                  \
-        result = _execute_primitive_##op(&resval->pri, &ins->val);         \
+        lhs = eprimitive(resval);                                          \
+        rhs = instruction_primitive(ins);                                  \
+        result = _execute_primitive_##op(&lhs, &rhs);                      \
         *task_mutable_resval(task) =                                       \
             int_of(&result) == 0 ? FALSE_ENTITY : TRUE_ENTITY;             \
         break;                                                             \
@@ -253,6 +290,7 @@ Entity string_concat(Task *task, const Entity *s1, const Entity *s2) {
   Object *new = string_new(task->parent_process->heap, s1_str, s1_str_len);
   String *new_str = (String *)new->_internal_obj;
   String_append_raw(new_str, s2_str, s2_str_len);
+  heap_update_bytes(task->parent_process->heap, new);
   return entity_object(new);
 }
 
@@ -267,11 +305,11 @@ void _execute_ADD_with_string(VM *vm, Task *task, Context *context,
       *task_mutable_resval(task) = string_concat(task, &first, &second);
       return;
     }
-  } else if (INSTRUCTION_ID == ins->type) {
+  } else if (INSTRUCTION_ID == ins->type || INSTRUCTION_SLOT == ins->type) {
     const Entity *resval = task_get_resval(task);
     if (IS_STRING(resval)) {
       Entity tmp;
-      Entity *lookup = context_lookup(context, ins->id, &tmp);
+      Entity *lookup = context_lookup_operand(context, ins, &tmp);
       if (!IS_STRING(lookup)) {
         raise_error(task, context, "RHS for op '+' must be String.");
         return;
@@ -283,23 +321,135 @@ void _execute_ADD_with_string(VM *vm, Task *task, Context *context,
   _execute_ADD(vm, task, context, ins);
 }
 
+// Quickens ins if its operands are all Ints or all Strings. Called by the
+// generic handlers of arithmetic and comparisons before executing ins.
+void _quicken_(Task *task, Context *context, const Instruction *ins) {
+  if (!dispatch_should_quicken(ins)) {
+    return;
+  }
+  const Entity *lhs, *rhs;
+  Entity tmp;
+  switch (ins->type) {
+    case INSTRUCTION_NO_ARG:
+      lhs = task_peekstack_n(task, 1);
+      rhs = task_peekstack(task);
+      break;
+    case INSTRUCTION_SLOT:
+      lhs = task_get_resval(task);
+      rhs = context_lookup_operand(context, ins, &tmp);
+      break;
+    case INSTRUCTION_PRIMITIVE:
+      if (IS_INT(task_get_resval(task))) {
+        dispatch_quicken_int(ins);
+      }
+      return;
+    default:
+      return;
+  }
+  if (IS_INT(lhs) && IS_INT(rhs)) {
+    dispatch_quicken_int(ins);
+  } else if (IS_STRING(lhs) && IS_STRING(rhs)) {
+    dispatch_quicken_str(ins);
+  }
+}
+
+#define INT_ENTITY(val) entity_primitive(primitive_int(val))
+#define BOOL_ENTITY(val) ((val) ? TRUE_ENTITY : FALSE_ENTITY)
+
+// Quickened handlers for Int operands. If the operands are not Ints, they
+// deoptimize ins and execute it with generic_fn.
+#define INT_OP(op, symbol, generic_fn, result_fn)                      \
+  void _execute_##op##_INT_INT(VM *vm, Task *task, Context *context,   \
+                               const Instruction *ins) {               \
+    const Entity *first = task_peekstack_n(task, 1);                   \
+    const Entity *second = task_peekstack(task);                       \
+    if (!IS_INT(first) || !IS_INT(second)) {                           \
+      dispatch_deopt(ins);                                             \
+      generic_fn(vm, task, context, ins);                              \
+      return;                                                          \
+    }                                                                  \
+    *task_mutable_resval(task) =                                       \
+        result_fn(eint(first) symbol eint(second));                    \
+    task_dropstack(task);                                              \
+    task_dropstack(task);                                              \
+  }                                                                    \
+  void _execute_##op##_INT_SLOT(VM *vm, Task *task, Context *context,  \
+                                const Instruction *ins) {              \
+    const Entity *resval = task_get_resval(task);                      \
+    Entity tmp;                                                        \
+    const Entity *lookup = context_lookup_operand(context, ins, &tmp); \
+    if (!IS_INT(resval) || !IS_INT(lookup)) {                          \
+      dispatch_deopt(ins);                                             \
+      generic_fn(vm, task, context, ins);                              \
+      return;                                                          \
+    }                                                                  \
+    *task_mutable_resval(task) =                                       \
+        result_fn(eint(resval) symbol eint(lookup));                   \
+  }                                                                    \
+  void _execute_##op##_INT_IMM(VM *vm, Task *task, Context *context,   \
+                               const Instruction *ins) {               \
+    const Entity *resval = task_get_resval(task);                      \
+    if (!IS_INT(resval)) {                                             \
+      dispatch_deopt(ins);                                             \
+      generic_fn(vm, task, context, ins);                              \
+      return;                                                          \
+    }                                                                  \
+    *task_mutable_resval(task) =                                       \
+        result_fn(eint(resval) symbol ins->int_val);                   \
+  }
+
+INT_OP(ADD, +, _execute_ADD_with_string, INT_ENTITY);
+INT_OP(SUB, -, _execute_SUB, INT_ENTITY);
+INT_OP(MULT, *, _execute_MULT, INT_ENTITY);
+INT_OP(LT, <, _execute_LT, BOOL_ENTITY);
+INT_OP(GT, >, _execute_GT, BOOL_ENTITY);
+INT_OP(LTE, <=, _execute_LTE, BOOL_ENTITY);
+INT_OP(GTE, >=, _execute_GTE, BOOL_ENTITY);
+
+void _execute_ADD_STR(VM *vm, Task *task, Context *context,
+                      const Instruction *ins) {
+  const Entity *first = task_peekstack_n(task, 1);
+  const Entity *second = task_peekstack(task);
+  if (!IS_STRING(first) || !IS_STRING(second)) {
+    dispatch_deopt(ins);
+    _execute_ADD_with_string(vm, task, context, ins);
+    return;
+  }
+  *task_mutable_resval(task) = string_concat(task, first, second);
+  task_dropstack(task);
+  task_dropstack(task);
+}
+
+void _execute_ADD_STR_SLOT(VM *vm, Task *task, Context *context,
+                           const Instruction *ins) {
+  const Entity *resval = task_get_resval(task);
+  Entity tmp;
+  const Entity *lookup = context_lookup_operand(context, ins, &tmp);
+  if (!IS_STRING(resval) || !IS_STRING(lookup)) {
+    dispatch_deopt(ins);
+    _execute_ADD_with_string(vm, task, context, ins);
+    return;
+  }
+  *task_mutable_resval(task) = string_concat(task, resval, lookup);
+}
+
 void _execute_INC(VM *vm, Task *task, Context *context,
                   const Instruction *ins) {
   const int inc_amount = ins->op == INC ? 1 : -1;
   Entity tmp;
-  Entity *stored = context_lookup(context, ins->id, &tmp);
-  if (NULL == stored || NONE == stored->type || OBJECT == stored->type) {
+  Entity *stored = context_lookup_operand(context, ins, &tmp);
+  if (NULL == stored || NONE == etype(stored) || OBJECT == etype(stored)) {
     raise_error(task, context, "Can only increment a primitive.");
   }
-  switch (ptype(&stored->pri)) {
+  switch (eptype(stored)) {
     case PRIMITIVE_CHAR:
-      stored->pri = primitive_char(pchar(&stored->pri) + inc_amount);
+      *stored = entity_char(echar(stored) + inc_amount);
       break;
     case PRIMITIVE_INT:
-      stored->pri = primitive_int(pint(&stored->pri) + inc_amount);
+      *stored = entity_int(eint(stored) + inc_amount);
       break;
     case PRIMITIVE_FLOAT:
-      stored->pri = primitive_float(pfloat(&stored->pri) + inc_amount);
+      *stored = entity_float(efloat(stored) + inc_amount);
       break;
     default:
       FATALF("Unknown primitive type.");
@@ -314,37 +464,38 @@ void _execute_BOR_with_obj(VM *vm, Task *task, Context *context,
   switch (ins->type) {
     case INSTRUCTION_NO_ARG:
       tmp = task_peekstack_n(task, 1);
-      if (PRIMITIVE == tmp->type) {
+      if (PRIMITIVE == etype(tmp)) {
         _execute_BOR(vm, task, context, ins);
         break;
       }
       second = task_popstack(task);
       first = task_popstack(task);
-      *task_mutable_resval(task) = (NONE == first.type) ? second : first;
+      *task_mutable_resval(task) = (NONE == etype(&first)) ? second : first;
       break;
     case INSTRUCTION_ID:
+    case INSTRUCTION_SLOT:
       first = *task_get_resval(task);
-      if (PRIMITIVE == first.type) {
+      if (PRIMITIVE == etype(&first)) {
         _execute_BOR(vm, task, context, ins);
         break;
       }
-      if (NONE != first.type) {
+      if (NONE != etype(&first)) {
         *task_mutable_resval(task) = first;
         break;
       }
-      tmp = context_lookup(context, ins->id, &second);
+      tmp = context_lookup_operand(context, ins, &second);
       *task_mutable_resval(task) = (NULL == tmp) ? NONE_ENTITY : *tmp;
       break;
     case INSTRUCTION_PRIMITIVE:
       first = *task_get_resval(task);
-      if (PRIMITIVE == first.type) {
+      if (PRIMITIVE == etype(&first)) {
         _execute_BOR(vm, task, context, ins);
         break;
       }
-      if (NONE != first.type) {
+      if (NONE != etype(&first)) {
         break;
       }
-      *task_mutable_resval(task) = entity_primitive(ins->val);
+      *task_mutable_resval(task) = entity_primitive(instruction_primitive(ins));
       break;
     default:
       FATALF("Invalid arg type=%d for BOR.", ins->type);
@@ -406,16 +557,34 @@ void _add_filename_method(VM *vm) {
 }
 
 VM *vm_create(const char *lib_location, uint32_t max_process_object_count,
-              bool async_enabled) {
+              size_t max_process_heap_bytes, bool async_enabled,
+              bool jit_enabled, HeapCollector collector,
+              uint32_t gc_max_pause_us, uint32_t background_threads) {
   VM *vm = MNEW(VM);
   vm->async_enabled = async_enabled;
+  if (jit_enabled) {
+    const JitRuntime jit_runtime = {.stub = _jit_stub_,
+                                    .slots = _jit_slots_,
+                                    .safepoint = _jit_safepoint_};
+    vm->jit = jit_create(&jit_runtime);
+  } else {
+    vm->jit = NULL;
+  }
+  vm->heap_profiler = NULL;
+  vm->scheduler = NULL;
+  vm->gc_log = false;
   ProcessArray_init(&vm->processes);
   HeapConf heap_conf = {
+      .collector = collector,
       .mgraph_config = {.eager_delete_edges = true, .eager_delete_nodes = true},
-      .max_object_count = max_process_object_count};
+      .max_object_count = max_process_object_count,
+      .max_bytes = max_process_heap_bytes,
+      .max_pause_us = gc_max_pause_us};
   vm->base_heap_conf = heap_conf;
   vm->process_create_lock = mutex_create();
-  vm->background_pool = threadpool_create(DEFAULT_THREADPOOL_SIZE);
+  vm->background_pool = threadpool_create(
+      0 == background_threads ? thread_num_cores() : background_threads);
+  vm->reactor = reactor_create();
   vm->main = create_process_no_reflection(vm);
   modulemanager_init(&vm->mm, vm->main->heap);
   register_builtin(&vm->mm, vm->main->heap, lib_location);
@@ -428,40 +597,79 @@ VM *vm_create(const char *lib_location, uint32_t max_process_object_count,
 
 void vm_delete(VM *vm) {
   ASSERT(vm != NULL);
+  // Processes may still be running on it.
+  if (NULL != vm->scheduler) {
+    scheduler_delete(vm->scheduler);
+  }
+  // Hands work to background_pool, so it goes first.
+  reactor_delete(vm->reactor);
   ProcessArrayIterator iter;
   ProcessArray_iterator(&iter, &vm->processes);
   for (; ProcessArray_has_next(&iter); ProcessArray_next(&iter)) {
-    Process *proc = ProcessArray_mutable_value(&iter);
+    Process *proc = *ProcessArray_mutable_value(&iter);
     process_finalize(proc);
+    RELEASE(proc);
   }
   ProcessArray_finalize(&vm->processes);
   mutex_close(vm->process_create_lock);
   threadpool_delete(vm->background_pool);
   modulemanager_finalize(&vm->mm);
+  class_free_retired_tables();
+  if (NULL != vm->jit) {
+    jit_delete(vm->jit);
+  }
+  if (NULL != vm->heap_profiler) {
+    heapprofiler_delete(vm->heap_profiler);
+  }
   RELEASE(vm);
 }
 
+void vm_start_heap_profiler(VM *vm, uint32_t sample_interval) {
+  ASSERT(vm != NULL);
+  ASSERT(vm->heap_profiler == NULL);
+  SYNCHRONIZED(vm->process_create_lock, {
+    vm->heap_profiler = heapprofiler_create(sample_interval);
+    ProcessArrayIterator iter;
+    ProcessArray_iterator(&iter, &vm->processes);
+    for (; ProcessArray_has_next(&iter); ProcessArray_next(&iter)) {
+      heapprofiler_attach(vm->heap_profiler,
+                          *ProcessArray_mutable_value(&iter));
+    }
+  });
+}
+
+void vm_start_scheduler(VM *vm, uint32_t num_workers) {
+  ASSERT(vm != NULL);
+  ASSERT(vm->scheduler == NULL);
+  vm->scheduler = scheduler_create(
+      0 == num_workers ? thread_num_cores() : num_workers,
+      process_run_queued_tasks);
+}
+
 Process *vm_main_process(VM *vm) { return vm->main; }
 
 bool _execute_EQ(VM *vm, Task *task, Context *context, const Instruction *ins) {
   const Entity *resval, *lookup;
   Entity first, second, tmp;
+  Primitive lhs, rhs;
   bool result;
   switch (ins->type) {
     case INSTRUCTION_NO_ARG:
       second = task_popstack(task);
       first = task_popstack(task);
       if (IS_OBJECT(&first)) {
-        if (IS_OBJECT(&second) && first.obj == second.obj) {
+        if (IS_OBJECT(&second) && object_m(&first) == object_m(&second)) {
           *task_mutable_resval(task) =
               (EQ == ins->op) ? TRUE_ENTITY : FALSE_ENTITY;
           return false;
         }
-        const Function *f = class_get_function(
-            first.obj->_class, (EQ == ins->op) ? EQ_FN_NAME : NEQ_FN_NAME);
+        const Function *f =
+            class_get_function(object_m(&first)->_class,
+                               (EQ == ins->op) ? EQ_FN_NAME : NEQ_FN_NAME);
         if (NULL != f) {
           *task_mutable_resval(task) = second;
-          return _call_function_base(task, context, f, first.obj, context);
+          return _call_function_base(task, context, f, object_m(&first),
+                                     context);
         }
         *task_mutable_resval(task) =
             (EQ == ins->op) ? FALSE_ENTITY : TRUE_ENTITY;
@@ -477,50 +685,57 @@ bool _execute_EQ(VM *vm, Task *task, Context *context, const Instruction *ins) {
             (EQ == ins->op) ? FALSE_ENTITY : TRUE_ENTITY;
         return false;
       }
-      if (PRIMITIVE != second.type) {
+      if (PRIMITIVE != etype(&second)) {
         raise_error(task, context, "RHS for op 'EQ' must be primitive (1).");
         return false;
       }
-      if (PRIMITIVE != first.type) {
+      if (PRIMITIVE != etype(&first)) {
         raise_error(task, context, "LHS for op 'EQ' must be primitive (1).");
         return false;
       }
-      result = primitive_equals(&first.pri, &second.pri);
+      lhs = eprimitive(&first);
+      rhs = eprimitive(&second);
+      result = primitive_equals(&lhs, &rhs);
       *task_mutable_resval(task) =
           ((result && (EQ == ins->op)) || (!result && (NEQ == ins->op)))
               ? TRUE_ENTITY
               : FALSE_ENTITY;
       break;
     case INSTRUCTION_ID:
+    case INSTRUCTION_SLOT:
       resval = task_get_resval(task);
-      lookup = context_lookup(context, ins->id, &tmp);
+      lookup = context_lookup_operand(context, ins, &tmp);
       if (IS_OBJECT(resval)) {
         first = *resval;
-        if (IS_OBJECT(lookup) && first.obj == lookup->obj) {
+        if (IS_OBJECT(lookup) && object_m(&first) == object_m(lookup)) {
           *task_mutable_resval(task) =
               (EQ == ins->op) ? TRUE_ENTITY : FALSE_ENTITY;
           return false;
         }
-        const Function *f = class_get_function(
-            first.obj->_class, (EQ == ins->op) ? EQ_FN_NAME : NEQ_FN_NAME);
+        const Function *f =
+            class_get_function(object_m(&first)->_class,
+                               (EQ == ins->op) ? EQ_FN_NAME : NEQ_FN_NAME);
         if (NULL != f) {
           *task_mutable_resval(task) = (lookup == NULL) ? NONE_ENTITY : *lookup;
-          return _call_function_base(task, context, f, first.obj, context);
+          return _call_function_base(task, context, f, object_m(&first),
+                                     context);
         }
 
         *task_mutable_resval(task) =
             (EQ == ins->op) ? FALSE_ENTITY : TRUE_ENTITY;
         return false;
       }
-      if (NULL != resval && PRIMITIVE != resval->type) {
+      if (NULL != resval && PRIMITIVE != etype(resval)) {
         raise_error(task, context, "LHS for op 'EQ' must be primitive (2).");
         return false;
       }
-      if (NULL != lookup && PRIMITIVE != lookup->type) {
+      if (NULL != lookup && PRIMITIVE != etype(lookup)) {
         raise_error(task, context, "RHS for op 'EQ' must be primitive (2).");
         return false;
       }
-      result = primitive_equals(&resval->pri, &lookup->pri);
+      lhs = eprimitive(resval);
+      rhs = eprimitive(lookup);
+      result = primitive_equals(&lhs, &rhs);
       *task_mutable_resval(task) =
           ((result && (EQ == ins->op)) || (!result && (NEQ == ins->op)))
               ? TRUE_ENTITY
@@ -528,11 +743,13 @@ bool _execute_EQ(VM *vm, Task *task, Context *context, const Instruction *ins) {
       break;
     case INSTRUCTION_PRIMITIVE:
       resval = task_get_resval(task);
-      if (NULL != resval && PRIMITIVE != resval->type) {
+      if (NULL != resval && PRIMITIVE != etype(resval)) {
         raise_error(task, context, "LHS for op 'EQ' must be primitive (3).");
         return false;
       }
-      result = primitive_equals(&resval->pri, &ins->val);
+      lhs = eprimitive(resval);
+      rhs = instruction_primitive(ins);
+      result = primitive_equals(&lhs, &rhs);
       *task_mutable_resval(task) =
           ((result && (EQ == ins->op)) || (!result && (NEQ == ins->op)))
               ? TRUE_ENTITY
@@ -558,7 +775,7 @@ void _execute_RES(VM *vm, Task *task, Context *context,
       *task_mutable_resval(task) = (NULL == member) ? NONE_ENTITY : *member;
       break;
     case INSTRUCTION_PRIMITIVE:
-      *task_mutable_resval(task) = entity_primitive(ins->val);
+      *task_mutable_resval(task) = entity_primitive(instruction_primitive(ins));
       break;
     case INSTRUCTION_STRING:
       str = ins->type == IRES ? istring_new(task->parent_process->heap,
@@ -581,10 +798,11 @@ void _execute_PEEK(VM *vm, Task *task, Context *context,
       *task_mutable_resval(task) = *task_peekstack(task);
       break;
     case INSTRUCTION_PRIMITIVE:
-      *task_mutable_resval(task) = *task_peekstack_n(task, pint(&ins->val));
+      *task_mutable_resval(task) = *task_peekstack_n(task, ins->int_val);
       break;
     case INSTRUCTION_ID:
-      member = context_lookup(context, ins->id, &tmp);
+    case INSTRUCTION_SLOT:
+      member = context_lookup_operand(context, ins, &tmp);
       *task_mutable_resval(task) = (NULL == member) ? NONE_ENTITY : *member;
       break;
     default:
@@ -615,7 +833,7 @@ void _execute_PUSH(VM *vm, Task *task, Context *context,
       *task_pushstack(task) = (NULL == member) ? NONE_ENTITY : *member;
       break;
     case INSTRUCTION_PRIMITIVE:
-      *task_pushstack(task) = entity_primitive(ins->val);
+      *task_pushstack(task) = entity_primitive(instruction_primitive(ins));
       break;
     case INSTRUCTION_STRING:
       // TODO: Maybe precompute the length of the string?
@@ -630,6 +848,55 @@ void _execute_PUSH(VM *vm, Task *task, Context *context,
   }
 }
 
+// Specialized handlers for RES and PUSH. See dispatch_handler().
+
+void _execute_RES_STACK(VM *vm, Task *task, Context *context,
+                        const Instruction *ins) {
+  *task_mutable_resval(task) = task_popstack(task);
+}
+
+void _execute_RES_ID(VM *vm, Task *task, Context *context,
+                     const Instruction *ins) {
+  Entity tmp;
+  Entity *member = context_lookup(context, ins->id, &tmp);
+  *task_mutable_resval(task) = (NULL == member) ? NONE_ENTITY : *member;
+}
+
+void _execute_RES_PRIM(VM *vm, Task *task, Context *context,
+                       const Instruction *ins) {
+  *task_mutable_resval(task) = entity_primitive(instruction_primitive(ins));
+}
+
+void _execute_RES_STR(VM *vm, Task *task, Context *context,
+                      const Instruction *ins) {
+  *task_mutable_resval(task) = entity_object(string_new(
+      task->parent_process->heap, ins->str, strlen(ins->str)));
+}
+
+void _execute_PUSH_RES(VM *vm, Task *task, Context *context,
+                       const Instruction *ins) {
+  *task_pushstack(task) = *task_get_resval(task);
+}
+
+void _execute_PUSH_ID(VM *vm, Task *task, Context *context,
+                      const Instruction *ins) {
+  Entity tmp;
+  Entity *member = context_lookup(context, ins->id, &tmp);
+  *task_pushstack(task) = (NULL == member) ? NONE_ENTITY : *member;
+}
+
+void _execute_PUSH_PRIM(VM *vm, Task *task, Context *context,
+                        const Instruction *ins) {
+  *task_pushstack(task) = entity_primitive(instruction_primitive(ins));
+}
+
+void _execute_PUSH_STR(VM *vm, Task *task, Context *context,
+                       const Instruction *ins) {
+  Object *str =
+      string_new(task->parent_process->heap, ins->str, strlen(ins->str));
+  *task_pushstack(task) = entity_object(str);
+}
+
 void _execute_PNIL(VM *vm, Task *task, Context *context,
                    const Instruction *ins) {
   if (INSTRUCTION_NO_ARG != ins->type) {
@@ -684,14 +951,15 @@ void _execute_FLD(VM *vm, Task *task, Context *context,
     FATALF("Invalid arg type=%d for FLD.", ins->type);
   }
   const Entity *resval = task_get_resval(task);
-  if (NULL == resval || OBJECT != resval->type) {
+  if (NULL == resval || OBJECT != etype(resval)) {
     raise_error(task, context,
                 "Attempted to set field '%s' on something not an object.",
                 ins->id);
     return;
   }
   Entity obj = task_popstack(task);
-  object_set_member(task->parent_process->heap, resval->obj, ins->id, &obj);
+  object_set_member(task->parent_process->heap, object_m(resval), ins->id,
+                    &obj);
 }
 
 void _execute_LET(VM *vm, Task *task, Context *context,
@@ -716,6 +984,32 @@ void _execute_SET(VM *vm, Task *task, Context *context,
   }
 }
 
+void _execute_LRES(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  Entity tmp;
+  const Entity *member = context_lookup_operand(context, ins, &tmp);
+  *task_mutable_resval(task) = (NULL == member) ? NONE_ENTITY : *member;
+}
+
+void _execute_LPSH(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  Entity tmp;
+  const Entity *member = context_lookup_operand(context, ins, &tmp);
+  // Copy before pushing since the slot lives on the same stack.
+  const Entity e = (NULL == member) ? NONE_ENTITY : *member;
+  *task_pushstack(task) = e;
+}
+
+void _execute_LLET(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  context_let_slot(context, ins, task_get_resval(task));
+}
+
+void _execute_LSET(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  context_set_slot(context, ins, task_get_resval(task));
+}
+
 void _execute_MSET(VM *vm, Task *task, Context *context,
                    const Instruction *ins) {
   Entity tmp;
@@ -726,12 +1020,13 @@ void _execute_MSET(VM *vm, Task *task, Context *context,
   switch (ins->type) {
     case INSTRUCTION_ID:
       object_set_member_obj(task->parent_process->heap,
-                            context->module->_reflection, ins->id, mdl->obj);
+                            context->module->_reflection, ins->id,
+                            object_m(mdl));
       break;
     case INSTRUCTION_STRING:
       object_set_member_obj(task->parent_process->heap,
                             context->module->_reflection,
-                            mdl->obj->_module_obj->_name, mdl->obj);
+                            object_m(mdl)->_module_obj->_name, object_m(mdl));
       break;
     default:
       FATALF("Invalid arg type=%d for MSET.", ins->type);
@@ -744,13 +1039,14 @@ void _execute_GET(VM *vm, Task *task, Context *context,
     FATALF("Invalid arg type=%d for GET.", ins->type);
   }
   const Entity *e = task_get_resval(task);
-  if (NULL == e || OBJECT != e->type) {
+  if (NULL == e || OBJECT != etype(e)) {
     raise_error(task, context, "Attempted to get field '%s' from a %s.",
-                ins->id, (e == NULL || NONE == e->type) ? "None" : "Primtive");
+                ins->id, (e == NULL || NONE == etype(e)) ? "None" : "Primtive");
     return;
   }
-  *task_mutable_resval(task) = object_get_maybe_wrap(
-      e->obj, ins->id, task->parent_process->heap, context);
+  InlineCache *cache = tape_get_cache(context->tape, ins->cache);
+  *task_mutable_resval(task) = object_get_maybe_wrap_cached(
+      object_m(e), ins->id, cache, task->parent_process->heap, context);
 }
 
 void _execute_GTSH(VM *vm, Task *task, Context *context,
@@ -759,13 +1055,14 @@ void _execute_GTSH(VM *vm, Task *task, Context *context,
     FATALF("Invalid arg type=%d for GTSH.", ins->type);
   }
   const Entity *e = task_get_resval(task);
-  if (NULL == e || OBJECT != e->type) {
+  if (NULL == e || OBJECT != etype(e)) {
     raise_error(task, context, "Attempted to get field '%s' from a %s.",
-                ins->id, (e == NULL || NONE == e->type) ? "None" : "Primtive");
+                ins->id, (e == NULL || NONE == etype(e)) ? "None" : "Primtive");
     return;
   }
-  Entity get_result = object_get_maybe_wrap(
-      e->obj, ins->id, task->parent_process->heap, context);
+  InlineCache *cache = tape_get_cache(context->tape, ins->cache);
+  Entity get_result = object_get_maybe_wrap_cached(
+      object_m(e), ins->id, cache, task->parent_process->heap, context);
   *task_pushstack(task) = get_result;
 }
 
@@ -792,11 +1089,36 @@ void _execute_in_background(BackgroundThreadArgs *args) {
                 (Entity *)task_get_resval(args->task));
 }
 
+void _execute_in_background_callback(BackgroundThreadArgs *args);
+
+void _resume_in_background(BackgroundThreadArgs *args) {
+  threadpool_execute(args->task->parent_process->vm->background_pool,
+                     (VoidFnPtr)_execute_in_background,
+                     (VoidFnPtr)_execute_in_background_callback,
+                     (VoidPtr)args);
+}
+
 void _execute_in_background_callback(BackgroundThreadArgs *args) {
-  process_remove_background_task(args->task->parent_process, args->task);
-  args->task->state = TASK_COMPLETE;
-  _mark_task_complete(args->task->parent_process, args->task,
-                      /*should_push=*/false);
+  Task *task = args->task;
+  if (task->io_wait_fd >= 0) {
+    // Parked without holding a background thread until it can run again.
+    const int fd = task->io_wait_fd;
+    task->io_wait_fd = -1;
+    reactor_watch(task->parent_process->vm->reactor, fd, task->io_wait_event,
+                  (ReactorFn)_resume_in_background, (void *)args);
+    return;
+  }
+  if (NULL != task->io_ops && !task->io_ops_done) {
+    // Set first since the ops may be done before submitting returns.
+    task->io_ops_done = true;
+    reactor_submit(task->parent_process->vm->reactor, task->io_ops,
+                   task->num_io_ops, (ReactorFn)_resume_in_background,
+                   (void *)args);
+    return;
+  }
+  process_remove_background_task(task->parent_process, task);
+  task->state = TASK_COMPLETE;
+  _mark_task_complete(task->parent_process, task, /*should_push=*/false);
   RELEASE(args);
 }
 
@@ -826,11 +1148,84 @@ BackgroundThreadArgs *_create_background_thread_args(Task *task,
   return args;
 }
 
+// Moves the arguments passed on the stack into a Tuple in resval, which is
+// where NativeFn natives and functions without PARM expect them.
+void _pack_stack_args_(Task *task) {
+  const uint32_t num_args = task->num_stack_args;
+  if (0 == num_args) {
+    return;
+  }
+  task->num_stack_args = 0;
+  Object *tuple_obj =
+      tuple_create_empty(task->parent_process->heap, num_args);
+  int i;
+  for (i = 0; i < num_args; ++i) {
+    Entity e = task_popstack(task);
+    tuple_set(task->parent_process->heap, tuple_obj, i, &e);
+  }
+  *task_mutable_resval(task) = entity_object(tuple_obj);
+}
+
+// Discards the arguments passed on the stack if nothing took them.
+void _drop_stack_args_(Task *task) {
+  for (; task->num_stack_args > 0; --task->num_stack_args) {
+    task_dropstack(task);
+  }
+}
+
+// Pops the receiver or function being called, which is beneath the arguments
+// passed on the stack.
+Entity _pop_callee_(Task *task) {
+  return 0 == task->num_stack_args
+             ? task_popstack(task)
+             : task_removestack_n(task, task->num_stack_args);
+}
+
+// Enters func on the current task. Execution continues in the new context
+// after the calling instruction completes.
+//
+// If func starts with PARM, arguments passed on the stack are moved above its
+// slots for it to bind and PARM is skipped. Otherwise they are packed into a
+// Tuple. Missing arguments raise the same error as indexing the Tuple would
+// and extra ones are ignored.
+void _call_function_in_frame(Task *task, Context *context, const Function *func,
+                             Object *self, Context *parent_context) {
+  Context *fn_ctx = task_create_context(task, self, (Module *)func->_module,
+                                        func->_ins_pos);
+  fn_ctx->caller = context;
+  fn_ctx->previous_context = func->_is_anon ? parent_context : NULL;
+  const uint32_t num_args = task->num_stack_args;
+  const Instruction *parm = tape_get(fn_ctx->tape, fn_ctx->ins);
+  if (0 == num_args || num_args > MAX_STACK_ARGS || PARM != parm->op) {
+    _pack_stack_args_(task);
+    context_set_function(fn_ctx, func);
+    return;
+  }
+  task->num_stack_args = 0;
+  Entity args[MAX_STACK_ARGS];
+  int i;
+  for (i = 0; i < num_args; ++i) {
+    args[i] = task_popstack(task);
+  }
+  context_set_function(fn_ctx, func);
+  if (num_args < parm->int_val) {
+    raise_error(task, fn_ctx,
+                "Tuple index out of bounds. Index=%d, Tuple.len=%d.", num_args,
+                num_args);
+    return;
+  }
+  for (i = parm->int_val - 1; i >= 0; --i) {
+    *task_pushstack(task) = args[i];
+  }
+  fn_ctx->ins++;
+}
+
 // Context is only necessary for native functions.
 bool _call_function_base(Task *task, Context *context, const Function *func,
                          Object *self, Context *parent_context) {
   Process *process = task->parent_process;
   if (func->_is_native) {
+    _pack_stack_args_(task);
     NativeFn native_fn = (NativeFn)func->_native_fn;
     if (NULL == native_fn) {
       FATALF("Invalid native function.");
@@ -841,6 +1236,9 @@ bool _call_function_base(Task *task, Context *context, const Function *func,
       new_task->parent_task = task;
       *task_mutable_resval(new_task) = *task_get_resval(task);
       *task_mutable_resval(task) = entity_object(future_create(new_task));
+      // Errors raised in the background are raised on context, which may
+      // have been exited by then.
+      context_capture(context);
       BackgroundThreadArgs *args =
           _create_background_thread_args(new_task, context, func, self);
       process_add_background_task(
@@ -851,16 +1249,51 @@ bool _call_function_base(Task *task, Context *context, const Function *func,
     }
     *task_mutable_resval(task) =
         native_fn(task, context, self, (Entity *)task_get_resval(task));
+    // Nothing else could run meanwhile anyway, so this blocks instead.
+    for (;;) {
+      if (task->io_wait_fd >= 0) {
+        const int fd = task->io_wait_fd;
+        task->io_wait_fd = -1;
+        reactor_await(fd, task->io_wait_event);
+      } else if (NULL != task->io_ops && !task->io_ops_done) {
+        reactor_run_ops(task->io_ops, task->num_io_ops);
+        task->io_ops_done = true;
+      } else {
+        break;
+      }
+      *task_mutable_resval(task) =
+          native_fn(task, context, self, (Entity *)task_get_resval(task));
+    }
     return false;
   } else if (func->_is_native2) {
     NativeFunctionHandlerFn native_fn =
         (NativeFunctionHandlerFn)func->_native_fn2;
+    // Arguments passed on the stack are read in place and only packed into a
+    // Tuple if the function asks for one.
+    const uint32_t num_args = task->num_stack_args;
+    task->num_stack_args = 0;
     FunctionContext fn_ctx;
-    FunctionContext_init(&fn_ctx, task, context, task_get_resval(task));
+    if (0 == num_args) {
+      FunctionContext_init(&fn_ctx, task, context, task_get_resval(task));
+    } else {
+      FunctionContext_init_stack_args(&fn_ctx, task, context, num_args);
+    }
     native_fn(&fn_ctx);
     *task_mutable_resval(task) = *FunctionContext_get_retval(&fn_ctx);
+    int i;
+    for (i = 0; i < num_args; ++i) {
+      task_dropstack(task);
+    }
+    return false;
+  }
+  // Only async functions and functions whose module has yet to be loaded need
+  // a task of their own.
+  if (!func->_is_async && NULL != context && task->current == context &&
+      ((Module *)self->_class->_module)->_is_initialized) {
+    _call_function_in_frame(task, context, func, self, parent_context);
     return false;
   }
+  _pack_stack_args_(task);
   Context *fn_ctx =
       _execute_as_new_task(task, self, (Module *)func->_module, func->_ins_pos);
   context_set_function(fn_ctx, func);
@@ -875,6 +1308,8 @@ bool _call_function_base(Task *task, Context *context, const Function *func,
                          fn_ctx->parent_task);
   }
   if (func->_is_anon) {
+    // The new task may outlive the context that called it.
+    context_capture(parent_context);
     fn_ctx->previous_context = parent_context;
   }
   if (func->_is_async && task->parent_process->vm->async_enabled) {
@@ -892,27 +1327,34 @@ bool _call_method(Task *task, Object *obj, Context *context,
   ASSERT(ins != NULL);
   ASSERT(INSTRUCTION_ID == ins->type);
   const Class *class = (Class *)obj->_class;
-  Entity method =
-      object_get_maybe_wrap(obj, ins->id, task->parent_process->heap, context);
-  if (NONE == method.type) {
+  Entity method = object_get_unbound_cached(
+      obj, ins->id, tape_get_cache(context->tape, ins->cache));
+  // Functions are called directly on obj instead of being bound to it first.
+  if (OBJECT == etype(&method) && Class_Function == object_m(&method)->_class) {
+    const Function *f = object_m(&method)->_function_obj;
+    return _call_function_base(task, context, f, obj,
+                               f->_is_anon ? context : NULL);
+  }
+  if (NONE == etype(&method)) {
     raise_error(task, context, "Failed to find method '%s' on %s", ins->id,
                 class->_name);
     return false;
   }
-  if (OBJECT != method.type) {
+  if (OBJECT != etype(&method)) {
     raise_error(task, context, "Attempted to treat '%s' on %s as a method.",
                 ins->id, class->_name);
     return false;
   }
-  if (Class_FunctionRef != method.obj->_class) {
+  if (Class_FunctionRef != object_m(&method)->_class) {
     raise_error(task, context,
                 "Attempted to treat '%s' of type %s on %s as a method.",
-                ins->id, method.obj->_class->_name, class->_name);
+                ins->id, object_m(&method)->_class->_name, class->_name);
     return false;
   }
-  return _call_function_base(task, context, function_ref_get_func(method.obj),
-                             function_ref_get_object(method.obj),
-                             function_ref_get_parent_context(method.obj));
+  Object *method_ref = object_m(&method);
+  return _call_function_base(task, context, function_ref_get_func(method_ref),
+                             function_ref_get_object(method_ref),
+                             function_ref_get_parent_context(method_ref));
 }
 
 bool _call_function(Task *task, Context *context, Function *func) {
@@ -927,71 +1369,85 @@ bool _execute_CALL(VM *vm, Task *task, Context *context,
     if (CLLN == ins->op) {
       *task_mutable_resval(task) = NONE_ENTITY;
     }
-    Entity obj = task_popstack(task);
-    if (OBJECT != obj.type) {
+    Entity obj = _pop_callee_(task);
+    if (OBJECT != etype(&obj)) {
       const char *type_str =
-          NONE == obj.type
+          NONE == etype(&obj)
               ? "None"
-              : ptype(&obj.pri) == PRIMITIVE_CHAR
+              : eptype(&obj) == PRIMITIVE_CHAR
                     ? "Char"
-                    : ptype(&obj.pri) == PRIMITIVE_INT ? "Int" : "Float";
+                    : eptype(&obj) == PRIMITIVE_INT ? "Int" : "Float";
       raise_error(task, context, "Calling function '%s' on type %s.", ins->id,
                   type_str);
       return false;
     }
-    if (Class_Module == obj.obj->_class) {
-      Module *m = obj.obj->_module_obj;
+    if (Class_Module == object_m(&obj)->_class) {
+      Module *m = object_m(&obj)->_module_obj;
       ASSERT(m != NULL);
       Object *fn_obj = module_lookup(m, ins->id);
       if (NULL == fn_obj) {
-        return _call_method(task, obj.obj, context, ins);
+        return _call_method(task, object_m(&obj), context, ins);
       }
       fn = entity_object(fn_obj);
     } else {
-      return _call_method(task, obj.obj, context, ins);
+      return _call_method(task, object_m(&obj), context, ins);
     }
   } else {
     ASSERT(INSTRUCTION_NO_ARG == ins->type);
-    fn = task_popstack(task);
+    fn = _pop_callee_(task);
+    if (CLLN == ins->op) {
+      *task_mutable_resval(task) = NONE_ENTITY;
+    }
   }
-  if (fn.type != OBJECT) {
+  return _call_entity_(task, context, fn);
+}
+
+// Calls fn with the arguments in resval or on the stack.
+bool _call_entity_(Task *task, Context *context, Entity fn) {
+  if (etype(&fn) != OBJECT) {
     raise_error(task, context,
                 "Attempted to call something not a function (not an object).");
     return false;
   }
-  if (fn.obj->_class == Class_Class) {
-    Class *class = fn.obj->_class_obj;
+  if (object_m(&fn)->_class == Class_Class) {
+    Class *class = object_m(&fn)->_class_obj;
     Object *obj = heap_new(task->parent_process->heap, class);
     const Function *constructor = class_get_function(class, CONSTRUCTOR_KEY);
     if (NULL == constructor) {
       *task_mutable_resval(task) = entity_object(obj);
       return false;
-    } else {
-      if (CLLN == ins->op) {
-        *task_mutable_resval(task) = NONE_ENTITY;
-      }
-      return _call_function_base(task, context, constructor, obj, context);
     }
+    return _call_function_base(task, context, constructor, obj, context);
   }
-  if (fn.obj->_class == Class_FunctionRef) {
-    if (CLLN == ins->op) {
-      *task_mutable_resval(task) = NONE_ENTITY;
-    }
-    return _call_function_base(task, context, function_ref_get_func(fn.obj),
-                               function_ref_get_object(fn.obj),
-                               function_ref_get_parent_context(fn.obj));
+  if (object_m(&fn)->_class == Class_FunctionRef) {
+    Object *fn_ref = object_m(&fn);
+    return _call_function_base(task, context, function_ref_get_func(fn_ref),
+                               function_ref_get_object(fn_ref),
+                               function_ref_get_parent_context(fn_ref));
   }
-  if (fn.obj->_class != Class_Function) {
+  if (object_m(&fn)->_class != Class_Function) {
     raise_error(task, context,
                 "Attempted to call something not a function (class=%s).",
-                fn.obj->_class->_name);
+                object_m(&fn)->_class->_name);
     return false;
   }
-  Function *func = fn.obj->_function_obj;
-  if (CLLN == ins->op) {
+  Function *func = object_m(&fn)->_function_obj;
+  return _call_function(task, context, func);
+}
+
+bool _execute_SCLL(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  if (SCLN == ins->op) {
     *task_mutable_resval(task) = NONE_ENTITY;
   }
-  return _call_function(task, context, func);
+  Entity tmp;
+  const Function *method;
+  Entity *fn = context_lookup_for_call(context, ins, &tmp, &method);
+  if (NULL != method) {
+    return _call_function_base(task, context, method, object_m(&context->self),
+                               method->_is_anon ? context : NULL);
+  }
+  return _call_entity_(task, context, (NULL == fn) ? NONE_ENTITY : *fn);
 }
 
 bool _execute_WAIT(VM *vm, Task *task, Context *context,
@@ -1001,14 +1457,14 @@ bool _execute_WAIT(VM *vm, Task *task, Context *context,
   if (!IS_CLASS(resval, Class_Future)) {
     return false;
   }
-  Future *future = (Future *)resval->obj->_internal_obj;
+  Future *future = (Future *)object_m(resval)->_internal_obj;
   if (!future_is_complete(future)) {
     TaskSet_insert(&future_get_task(future)->dependent_tasks, task,
                    sizeof(Task *));
     return true;
   }
   *task_mutable_resval(task) =
-      *future_get_value(task->parent_process->heap, resval->obj);
+      *future_get_value(task->parent_process->heap, object_m(resval));
   return false;
 }
 
@@ -1023,10 +1479,11 @@ void _execute_RET(VM *vm, Task *task, Context *context,
       // *task_mutable_resval(task->dependent_task) = *task_get_resval(task);
       break;
     case INSTRUCTION_ID:
-      *task_mutable_resval(task) = *context_lookup(context, ins->id, &tmp);
+    case INSTRUCTION_SLOT:
+      *task_mutable_resval(task) = *context_lookup_operand(context, ins, &tmp);
       break;
     case INSTRUCTION_PRIMITIVE:
-      *task_mutable_resval(task) = entity_primitive(ins->val);
+      *task_mutable_resval(task) = entity_primitive(instruction_primitive(ins));
       break;
     default:
       FATALF("Invalid arg type=%d for RET.", ins->type);
@@ -1037,8 +1494,15 @@ Context *_execute_NBLK(VM *vm, Task *task, Context *context,
                        const Instruction *ins) {
   switch (ins->type) {
     case INSTRUCTION_NO_ARG:
-      return task_create_context(context->parent_task, context->self.obj,
+      return task_create_context(context->parent_task, object_m(&context->self),
                                  context->module, context->ins);
+    case INSTRUCTION_SLOT:
+      context =
+          task_create_context(context->parent_task, object_m(&context->self),
+                              context->module, context->ins);
+      // Locals of the block start unassigned each time it is entered.
+      context_clear_slots(context, ins->local.index, ins->local.count);
+      return context;
     default:
       FATALF("Invalid arg type=%d for NBLK.", ins->type);
   }
@@ -1061,7 +1525,7 @@ void _execute_JMP(VM *vm, Task *task, Context *context,
   if (INSTRUCTION_PRIMITIVE != ins->type) {
     FATALF("Invalid arg type=%d for JMP.", ins->type);
   }
-  context->ins += ins->val._int_val;
+  context->ins += ins->int_val;
 }
 
 void _execute_IF(VM *vm, Task *task, Context *context, const Instruction *ins) {
@@ -1071,14 +1535,14 @@ void _execute_IF(VM *vm, Task *task, Context *context, const Instruction *ins) {
   const Entity *resval = task_get_resval(task);
   bool is_false = IS_FALSE(resval);
   if ((is_false && (IFN == ins->op)) || (!is_false && (IF == ins->op))) {
-    context->ins += ins->val._int_val;
+    context->ins += ins->int_val;
   }
 }
 
 void _execute_EXIT(VM *vm, Task *task, Context *context,
                    const Instruction *ins) {
   if (INSTRUCTION_PRIMITIVE == ins->type) {
-    *task_mutable_resval(task) = entity_primitive(ins->val);
+    *task_mutable_resval(task) = entity_primitive(instruction_primitive(ins));
   }
   task->state = TASK_COMPLETE;
   context->ins++;
@@ -1103,10 +1567,10 @@ void _execute_ANEW(VM *vm, Task *task, Context *context,
   if (INSTRUCTION_NO_ARG == ins->type) {
     return;
   }
-  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ptype(&ins->val)) {
+  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ins->val_type) {
     FATALF("Invalid ANEW requires int primitive.");
   }
-  int32_t num_args = pint(&ins->val);
+  int32_t num_args = ins->int_val;
   int i;
   for (i = 0; i < num_args; ++i) {
     Entity e = task_popstack(task);
@@ -1121,24 +1585,25 @@ bool _execute_AIDX(VM *vm, Task *task, Context *context,
   Entity index_e;
 
   Entity arr_entity = task_popstack(task);
-  if (OBJECT != arr_entity.type) {
+  if (OBJECT != etype(&arr_entity)) {
     raise_error(task, context, "Invalid array index on non-indexable.");
     return false;
   }
-  arr_obj = arr_entity.obj;
+  arr_obj = object_m(&arr_entity);
   switch (ins->type) {
     case INSTRUCTION_NO_ARG:
       index = task_get_resval(task);
       break;
     case INSTRUCTION_ID:
-      index = context_lookup(context, ins->id, &index_e);
+    case INSTRUCTION_SLOT:
+      index = context_lookup_operand(context, ins, &index_e);
       break;
     case INSTRUCTION_PRIMITIVE:
-      if (PRIMITIVE_INT != ptype(&ins->val) || pint(&ins->val) < 0) {
+      if (PRIMITIVE_INT != ins->val_type || ins->int_val < 0) {
         raise_error(task, context, "Invalid array index.");
         return false;
       }
-      index_e = entity_primitive(ins->val);
+      index_e = entity_primitive(instruction_primitive(ins));
       index = &index_e;
       break;
     default:
@@ -1150,12 +1615,12 @@ bool _execute_AIDX(VM *vm, Task *task, Context *context,
   }
   if (Class_Array == arr_obj->_class) {
     Array *arr = (Array *)arr_obj->_internal_obj;
-    if (PRIMITIVE != index->type || PRIMITIVE_INT != ptype(&index->pri) ||
-        pint(&index->pri) < 0) {
+    if (PRIMITIVE != etype(index) || PRIMITIVE_INT != eptype(index) ||
+        eint(index) < 0) {
       raise_error(task, context, "Invalid array index.");
       return false;
     }
-    int32_t i_index = pint(&index->pri);
+    int32_t i_index = eint(index);
     if (i_index >= Array_size(arr)) {
       raise_error(task, context, "Invalid array index.");
       return false;
@@ -1165,12 +1630,12 @@ bool _execute_AIDX(VM *vm, Task *task, Context *context,
   }
   if (Class_Tuple == arr_obj->_class) {
     Tuple *tuple = (Tuple *)arr_obj->_internal_obj;
-    if (PRIMITIVE != index->type || PRIMITIVE_INT != ptype(&index->pri) ||
-        pint(&index->pri) < 0) {
+    if (PRIMITIVE != etype(index) || PRIMITIVE_INT != eptype(index) ||
+        eint(index) < 0) {
       raise_error(task, context, "Invalid tuple index.");
       return false;
     }
-    int32_t i_index = pint(&index->pri);
+    int32_t i_index = eint(index);
     if (i_index >= tuple_size(tuple)) {
       raise_error(task, context, "Invalid tuple index.");
       return false;
@@ -1197,35 +1662,36 @@ bool _execute_ASET(VM *vm, Task *task, Context *context,
   Entity arr_entity = task_popstack(task);
   Entity new_val = task_popstack(task);
   const Entity *index = task_get_resval(task);
-  if (OBJECT != arr_entity.type) {
+  if (OBJECT != etype(&arr_entity)) {
     raise_error(task, context, "Cannot set index value on non-indexable.");
     return false;
   }
 
-  if (Class_Array == arr_entity.obj->_class) {
-    if (NULL == index || PRIMITIVE != index->type ||
-        PRIMITIVE_INT != ptype(&index->pri)) {
+  if (Class_Array == object_m(&arr_entity)->_class) {
+    if (NULL == index || PRIMITIVE != etype(index) ||
+        PRIMITIVE_INT != eptype(index)) {
       raise_error(task, context, "Cannot index with non-int.");
       return false;
     }
-    int32_t i_index = pint(&index->pri);
+    int32_t i_index = eint(index);
     if (i_index < 0) {
       raise_error(task, context, "Array index out of bounds: %d", i_index);
       return false;
     }
-    array_set(task->parent_process->heap, arr_entity.obj, i_index, &new_val);
+    array_set(task->parent_process->heap, object_m(&arr_entity), i_index,
+              &new_val);
     return false;
   }
   const Function *aset_fn =
-      class_get_function(arr_entity.obj->_class, ARRAYLIKE_SET_KEY);
+      class_get_function(object_m(&arr_entity)->_class, ARRAYLIKE_SET_KEY);
   if (NULL != aset_fn) {
-    Object *args = heap_new(task->parent_process->heap, Class_Tuple);
-    args->_internal_obj = tuple_create(2);
+    Object *args = tuple_create_empty(task->parent_process->heap, 2);
     Tuple *t = (Tuple *)args->_internal_obj;
     *tuple_get_mutable(t, 0) = *index;
     *tuple_get_mutable(t, 1) = new_val;
     *task_mutable_resval(task) = entity_object(args);
-    return _call_function_base(task, context, aset_fn, arr_entity.obj, context);
+    return _call_function_base(task, context, aset_fn, object_m(&arr_entity),
+                               context);
   }
   raise_error(task, context, "Cannot set index value on non-indexable.");
   return false;
@@ -1236,14 +1702,14 @@ void _execute_TUPL(VM *vm, Task *task, Context *context,
   if (INSTRUCTION_ID == ins->type) {
     FATALF("Invalid TUPL, ID type.");
   }
-  uint32_t num_args = pint(&ins->val);
-  Object *tuple_obj = heap_new(task->parent_process->heap, Class_Tuple);
-  tuple_obj->_internal_obj = tuple_create(num_args);
+  uint32_t num_args = ins->int_val;
+  Object *tuple_obj =
+      tuple_create_empty(task->parent_process->heap, num_args);
   *task_mutable_resval(task) = entity_object(tuple_obj);
   if (INSTRUCTION_NO_ARG == ins->type) {
     return;
   }
-  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ptype(&ins->val)) {
+  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ins->val_type) {
     FATALF("Invalid TUPL requires int primitive.");
   }
   int i;
@@ -1253,50 +1719,86 @@ void _execute_TUPL(VM *vm, Task *task, Context *context,
   }
 }
 
+void _execute_ARGS(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ins->val_type) {
+    FATALF("Invalid ARGS requires int primitive.");
+  }
+  task->num_stack_args = ins->int_val;
+}
+
+// Only reached when the arguments were passed in resval.
+void _execute_PARM(VM *vm, Task *task, Context *context,
+                   const Instruction *ins) {
+  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ins->val_type) {
+    FATALF("Invalid PARM requires int primitive.");
+  }
+  const int32_t num_params = ins->int_val;
+  const Entity *args = task_get_resval(task);
+  int i;
+  if (IS_TUPLE(args)) {
+    const Tuple *t = (Tuple *)object_m(args)->_internal_obj;
+    const int32_t num_args = tuple_size(t);
+    if (num_args < num_params) {
+      raise_error(task, context,
+                  "Tuple index out of bounds. Index=%d, Tuple.len=%d.",
+                  num_args, num_args);
+      return;
+    }
+    for (i = num_params - 1; i >= 0; --i) {
+      *task_pushstack(task) = *tuple_get(t, i);
+    }
+    return;
+  }
+  // A single argument is only enough for one parameter, which PARM is never
+  // emitted for.
+  raise_error(task, context, "Attempted to index something not a tuple.");
+}
+
 void _execute_TLEN(VM *vm, Task *task, Context *context,
                    const Instruction *ins) {
   if (INSTRUCTION_NO_ARG != ins->type) {
     FATALF("Invalid TLEN type.");
   }
   const Entity *e = task_peekstack(task);
-  if (NULL == e || OBJECT != e->type || Class_Tuple != e->obj->_class) {
+  if (NULL == e || OBJECT != etype(e) || Class_Tuple != object_m(e)->_class) {
     *task_mutable_resval(task) = entity_int(-1);
     return;
   }
   *task_mutable_resval(task) =
-      entity_int(tuple_size((Tuple *)e->obj->_internal_obj));
+      entity_int(tuple_size((Tuple *)object_m(e)->_internal_obj));
 }
 
 void _execute_TGTE(VM *vm, Task *task, Context *context,
                    const Instruction *ins) {
-  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ptype(&ins->val)) {
+  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ins->val_type) {
     raise_error(task, context, "Invalid TLEN type.");
     return;
   }
   const Entity *e = task_get_resval(task);
 
-  int test_len = pint(&ins->val);
+  int test_len = ins->int_val;
   if (1 == test_len) {
     *task_mutable_resval(task) =
-        (NULL != e && NONE != e->type) ? TRUE_ENTITY : FALSE_ENTITY;
+        (NULL != e && NONE != etype(e)) ? TRUE_ENTITY : FALSE_ENTITY;
     return;
   }
-  if (NULL == e || OBJECT != e->type || Class_Tuple != e->obj->_class) {
+  if (NULL == e || OBJECT != etype(e) || Class_Tuple != object_m(e)->_class) {
     *task_mutable_resval(task) = FALSE_ENTITY;
     return;
   }
-  Tuple *t = (Tuple *)e->obj->_internal_obj;
+  Tuple *t = (Tuple *)object_m(e)->_internal_obj;
   uint32_t tlen = tuple_size(t);
   *task_mutable_resval(task) = tlen >= test_len ? TRUE_ENTITY : FALSE_ENTITY;
 }
 
 void _execute_TGET(VM *vm, Task *task, Context *context,
                    const Instruction *ins) {
-  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ptype(&ins->val)) {
+  if (INSTRUCTION_PRIMITIVE != ins->type || PRIMITIVE_INT != ins->val_type) {
     raise_error(task, context, "Invalid TGET type.");
     return;
   }
-  int32_t index = pint(&ins->val);
+  int32_t index = ins->int_val;
   const Entity *e = task_get_resval(task);
   if (!IS_TUPLE(e)) {
     if (NULL != e && 0 == index) {
@@ -1306,7 +1808,7 @@ void _execute_TGET(VM *vm, Task *task, Context *context,
     raise_error(task, context, "Attempted to index something not a tuple.");
     return;
   }
-  Tuple *t = (Tuple *)e->obj->_internal_obj;
+  Tuple *t = (Tuple *)object_m(e)->_internal_obj;
   if (index < 0 || index >= tuple_size(t)) {
     raise_error(task, context,
                 "Tuple index out of bounds. Index=%d, Tuple.len=%d.", index,
@@ -1322,16 +1824,16 @@ void _execute_IS(VM *vm, Task *task, Context *context, const Instruction *ins) {
   }
   Entity rhs = task_popstack(task);
   Entity lhs = task_popstack(task);
-  if (OBJECT != rhs.type || Class_Class != rhs.obj->_class) {
+  if (OBJECT != etype(&rhs) || Class_Class != object_m(&rhs)->_class) {
     raise_error(task, context,
                 "Cannot perform type-check against a non-object type.");
     return;
   }
-  if (lhs.type != OBJECT) {
+  if (etype(&lhs) != OBJECT) {
     *task_mutable_resval(task) = FALSE_ENTITY;
     return;
   }
-  if (inherits_from(lhs.obj->_class, rhs.obj->_class_obj)) {
+  if (inherits_from(object_m(&lhs)->_class, object_m(&rhs)->_class_obj)) {
     *task_mutable_resval(task) = TRUE_ENTITY;
   } else {
     *task_mutable_resval(task) = FALSE_ENTITY;
@@ -1361,21 +1863,22 @@ bool _execute_CTCH(VM *vm, Task *task, Context *context,
   if (INSTRUCTION_PRIMITIVE != ins->type) {
     FATALF("Invalid arg type=%d for CTCH.", ins->type);
   }
-  context->catch_ins = context->ins + ins->val._int_val + 1;
+  context->catch_ins = context->ins + ins->int_val + 1;
   return true;
 }
 
 void _execute_RAIS(VM *vm, Task *task, Context *context) {
   const Entity *err = task_get_resval(task);
-  if (OBJECT != err->type || !inherits_from(err->obj->_class, Class_Error)) {
+  if (OBJECT != etype(err) ||
+      !inherits_from(object_m(err)->_class, Class_Error)) {
     raise_error(task, context, "raise can only be invoked with an Error().");
     return;
   }
-  raise_error_with_object(task, context, err->obj);
+  raise_error_with_object(task, context, object_m(err));
 }
 
 bool _attemp_catch_error(Task *task, Context *ctx) {
-  while (ctx->catch_ins < 0 && NULL != (ctx = task_back_context(task)))
+  while (ctx->catch_ins < 0 && NULL != (ctx = task_unwind_context(task)))
     ;
   // There was no try/catch block.
   if (NULL == ctx) {
@@ -1388,8 +1891,525 @@ bool _attemp_catch_error(Task *task, Context *ctx) {
   return true;
 }
 
+// Collects garbage if enough has been allocated since the last collection.
+//
+// Tasks only return to process_run() when they wait or complete, so this is
+// also polled on backward jumps and after calls to keep a task which loops
+// without yielding from growing the heap without bound. Everything live is
+// reachable from the tasks of the process at this point.
+//
+// Returns true if the heap is still over its limit afterwards, in which case
+// an error is raised on context.
+bool _safepoint_(Task *task, Context *context) {
+  Process *process = task->parent_process;
+  if (!heap_needs_garbage_collection(process->heap)) {
+    return false;
+  }
+  if (!process_maybe_collect_garbage(process)) {
+    return false;
+  }
+  raise_error(task, context,
+              "Out of memory: Max heap size for process exceeded.");
+  return true;
+}
+
+// Stubs called by JIT-compiled code. Each executes a single instruction on the
+// current context of task exactly like vm_execute_task() does.
+#define JIT_STUB(name, execute_fn)                                  \
+  JitStep _jit_##name(VM *vm, Task *task, const Instruction *ins) { \
+    Context *context = task->current;                               \
+    execute_fn(vm, task, context, ins);                             \
+    context->ins++;                                                 \
+    return NULL == context->error ? JIT_NEXT : JIT_EXIT;            \
+  }
+
+JIT_STUB(RES, _execute_RES);
+JIT_STUB(RNIL, _execute_RNIL);
+JIT_STUB(PUSH, _execute_PUSH);
+JIT_STUB(LRES, _execute_LRES);
+JIT_STUB(LPSH, _execute_LPSH);
+JIT_STUB(PNIL, _execute_PNIL);
+JIT_STUB(PEEK, _execute_PEEK);
+JIT_STUB(DUP, _execute_DUP);
+JIT_STUB(FLD, _execute_FLD);
+JIT_STUB(LET, _execute_LET);
+JIT_STUB(SET, _execute_SET);
+JIT_STUB(LLET, _execute_LLET);
+JIT_STUB(LSET, _execute_LSET);
+JIT_STUB(MSET, _execute_MSET);
+JIT_STUB(GET, _execute_GET);
+JIT_STUB(GTSH, _execute_GTSH);
+JIT_STUB(ADD, _execute_ADD_with_string);
+JIT_STUB(SUB, _execute_SUB);
+JIT_STUB(MULT, _execute_MULT);
+JIT_STUB(DIV, _execute_DIV);
+JIT_STUB(MOD, _execute_MOD);
+JIT_STUB(INC, _execute_INC);
+JIT_STUB(AND, _execute_AND);
+JIT_STUB(OR, _execute_OR);
+JIT_STUB(BAND, _execute_BAND);
+JIT_STUB(BXOR, _execute_BXOR);
+JIT_STUB(BOR, _execute_BOR_with_obj);
+JIT_STUB(LT, _execute_LT);
+JIT_STUB(GT, _execute_GT);
+JIT_STUB(LTE, _execute_LTE);
+JIT_STUB(GTE, _execute_GTE);
+JIT_STUB(IS, _execute_IS);
+JIT_STUB(NOT, _execute_NOT);
+JIT_STUB(ANEW, _execute_ANEW);
+JIT_STUB(TUPL, _execute_TUPL);
+JIT_STUB(ARGS, _execute_ARGS);
+JIT_STUB(PARM, _execute_PARM);
+JIT_STUB(TLEN, _execute_TLEN);
+JIT_STUB(TGET, _execute_TGET);
+JIT_STUB(TGTE, _execute_TGTE);
+JIT_STUB(CTCH, _execute_CTCH);
+JIT_STUB(RTRU, _execute_RTRU);
+JIT_STUB(PTRU, _execute_PTRU);
+JIT_STUB(RFLS, _execute_RFLS);
+JIT_STUB(PFLS, _execute_PFLS);
+JIT_STUB(RES_STACK, _execute_RES_STACK);
+JIT_STUB(RES_ID, _execute_RES_ID);
+JIT_STUB(RES_PRIM, _execute_RES_PRIM);
+JIT_STUB(RES_STR, _execute_RES_STR);
+JIT_STUB(PUSH_RES, _execute_PUSH_RES);
+JIT_STUB(PUSH_ID, _execute_PUSH_ID);
+JIT_STUB(PUSH_PRIM, _execute_PUSH_PRIM);
+JIT_STUB(PUSH_STR, _execute_PUSH_STR);
+JIT_STUB(ADD_INT_INT, _execute_ADD_INT_INT);
+JIT_STUB(ADD_INT_SLOT, _execute_ADD_INT_SLOT);
+JIT_STUB(ADD_INT_IMM, _execute_ADD_INT_IMM);
+JIT_STUB(SUB_INT_INT, _execute_SUB_INT_INT);
+JIT_STUB(SUB_INT_SLOT, _execute_SUB_INT_SLOT);
+JIT_STUB(SUB_INT_IMM, _execute_SUB_INT_IMM);
+JIT_STUB(MULT_INT_INT, _execute_MULT_INT_INT);
+JIT_STUB(MULT_INT_SLOT, _execute_MULT_INT_SLOT);
+JIT_STUB(MULT_INT_IMM, _execute_MULT_INT_IMM);
+JIT_STUB(LT_INT_INT, _execute_LT_INT_INT);
+JIT_STUB(LT_INT_SLOT, _execute_LT_INT_SLOT);
+JIT_STUB(LT_INT_IMM, _execute_LT_INT_IMM);
+JIT_STUB(GT_INT_INT, _execute_GT_INT_INT);
+JIT_STUB(GT_INT_SLOT, _execute_GT_INT_SLOT);
+JIT_STUB(GT_INT_IMM, _execute_GT_INT_IMM);
+JIT_STUB(LTE_INT_INT, _execute_LTE_INT_INT);
+JIT_STUB(LTE_INT_SLOT, _execute_LTE_INT_SLOT);
+JIT_STUB(LTE_INT_IMM, _execute_LTE_INT_IMM);
+JIT_STUB(GTE_INT_INT, _execute_GTE_INT_INT);
+JIT_STUB(GTE_INT_SLOT, _execute_GTE_INT_SLOT);
+JIT_STUB(GTE_INT_IMM, _execute_GTE_INT_IMM);
+JIT_STUB(ADD_STR, _execute_ADD_STR);
+JIT_STUB(ADD_STR_SLOT, _execute_ADD_STR_SLOT);
+
+JitStep _jit_NBLK(VM *vm, Task *task, const Instruction *ins) {
+  Context *context = _execute_NBLK(vm, task, task->current, ins);
+  context->ins++;
+  return NULL == context->error ? JIT_NEXT : JIT_EXIT;
+}
+
+JitStep _jit_BBLK(VM *vm, Task *task, const Instruction *ins) {
+  Context *context = _execute_BBLK(vm, task, task->current, ins);
+  context->ins++;
+  return NULL == context->error ? JIT_NEXT : JIT_EXIT;
+}
+
+JitStep _jit_RAIS(VM *vm, Task *task, const Instruction *ins) {
+  Context *context = task->current;
+  _execute_RAIS(vm, task, context);
+  context->ins++;
+  return NULL == context->error ? JIT_NEXT : JIT_EXIT;
+}
+
+JitStep _jit_safepoint_(VM *vm, Task *task, const Instruction *ins) {
+  return _safepoint_(task, task->current) ? JIT_EXIT : JIT_NEXT;
+}
+
+Entity *_jit_slots_(Task *task) { return context_slot_(task->current, 0); }
+
+bool _maybe_run_jit_(VM *vm, Task *task, Context *context);
+
+// Compiled code which calls a function runs it on the native stack, so this
+// bounds how deeply calls nest before returning to the interpreter.
+#define MAX_JIT_CALL_DEPTH 64
+static THREAD_LOCAL uint32_t jit_call_depth_ = 0;
+
+// Finishes an instruction on context which made task wait on a call.
+JitStep _jit_wait_(Task *task, Context *context) {
+  task->state = TASK_WAITING;
+  task->wait_reason = WAITING_ON_FN_CALL;
+  context->ins++;
+  return JIT_EXIT;
+}
+
+// Called after an instruction on caller which may have entered a function on
+// task.
+//
+// The function is run with its compiled code, so compiled code only has to
+// return to the interpreter if the function does not return to caller there.
+JitStep _jit_after_call_(VM *vm, Task *task, Context *caller) {
+  Context *callee = task->current;
+  if (callee != caller && NULL == callee->error &&
+      jit_call_depth_ < MAX_JIT_CALL_DEPTH) {
+    ++jit_call_depth_;
+    _maybe_run_jit_(vm, task, callee);
+    --jit_call_depth_;
+  }
+  return (task->current == caller && NULL == caller->error &&
+          TASK_RUNNING == task->state)
+             ? JIT_NEXT
+             : JIT_EXIT;
+}
+
+// Also CLLN.
+JitStep _jit_CALL(VM *vm, Task *task, const Instruction *ins) {
+  Context *context = task->current;
+  if (_execute_CALL(vm, task, context, ins)) {
+    return _jit_wait_(task, context);
+  }
+  // The arguments are left on the stack if nothing took them.
+  _drop_stack_args_(task);
+  context->ins++;
+  _safepoint_(task, task->current);
+  return _jit_after_call_(vm, task, context);
+}
+
+// Also SCLN.
+JitStep _jit_SCLL(VM *vm, Task *task, const Instruction *ins) {
+  Context *context = task->current;
+  if (_execute_SCLL(vm, task, context, ins)) {
+    return _jit_wait_(task, context);
+  }
+  _drop_stack_args_(task);
+  context->ins++;
+  _safepoint_(task, task->current);
+  return _jit_after_call_(vm, task, context);
+}
+
+// EQ, NEQ, AIDX and ASET may call a method.
+#define JIT_CALLING_STUB(name, execute_fn)                          \
+  JitStep _jit_##name(VM *vm, Task *task, const Instruction *ins) { \
+    Context *context = task->current;                               \
+    if (execute_fn(vm, task, context, ins)) {                       \
+      return _jit_wait_(task, context);                             \
+    }                                                               \
+    context->ins++;                                                 \
+    return _jit_after_call_(vm, task, context);                     \
+  }
+
+JIT_CALLING_STUB(EQ, _execute_EQ);
+JIT_CALLING_STUB(AIDX, _execute_AIDX);
+JIT_CALLING_STUB(ASET, _execute_ASET);
+
+// Returns to the caller, which always leaves the compiled code of the
+// function. Returning from the function a task started with is left to the
+// interpreter, which completes the task.
+JitStep _jit_RET(VM *vm, Task *task, const Instruction *ins) {
+  Context *context = task->current;
+  Context *frame = context;
+  // Blocks within a function have no func.
+  while (NULL == frame->func && NULL != frame->previous_context) {
+    frame = frame->previous_context;
+  }
+  if (NULL == frame->caller) {
+    return JIT_EXIT;
+  }
+  _execute_RET(vm, task, context, ins);
+  context->ins++;
+  task_return_from_frame(task);
+  return JIT_EXIT;
+}
+
+#define JIT_CASE(handler) \
+  case handler:           \
+    return _jit_##handler
+
+// Anything which may switch tasks, e.g., loading a module or waiting on a
+// Future, is left to the interpreter. Jumps are compiled without stubs.
+JitStub _jit_stub_(const Instruction *ins) {
+  switch (dispatch_current_handler(ins)) {
+    JIT_CASE(RES_STACK);
+    JIT_CASE(RES_ID);
+    JIT_CASE(RES_PRIM);
+    JIT_CASE(RES_STR);
+    JIT_CASE(PUSH_RES);
+    JIT_CASE(PUSH_ID);
+    JIT_CASE(PUSH_PRIM);
+    JIT_CASE(PUSH_STR);
+    JIT_CASE(ADD_INT_INT);
+    JIT_CASE(ADD_INT_SLOT);
+    JIT_CASE(ADD_INT_IMM);
+    JIT_CASE(SUB_INT_INT);
+    JIT_CASE(SUB_INT_SLOT);
+    JIT_CASE(SUB_INT_IMM);
+    JIT_CASE(MULT_INT_INT);
+    JIT_CASE(MULT_INT_SLOT);
+    JIT_CASE(MULT_INT_IMM);
+    JIT_CASE(LT_INT_INT);
+    JIT_CASE(LT_INT_SLOT);
+    JIT_CASE(LT_INT_IMM);
+    JIT_CASE(GT_INT_INT);
+    JIT_CASE(GT_INT_SLOT);
+    JIT_CASE(GT_INT_IMM);
+    JIT_CASE(LTE_INT_INT);
+    JIT_CASE(LTE_INT_SLOT);
+    JIT_CASE(LTE_INT_IMM);
+    JIT_CASE(GTE_INT_INT);
+    JIT_CASE(GTE_INT_SLOT);
+    JIT_CASE(GTE_INT_IMM);
+    JIT_CASE(ADD_STR);
+    JIT_CASE(ADD_STR_SLOT);
+    default:
+      break;
+  }
+  switch (ins->op) {
+    JIT_CASE(RES);
+    JIT_CASE(RNIL);
+    JIT_CASE(PUSH);
+    JIT_CASE(LRES);
+    JIT_CASE(LPSH);
+    JIT_CASE(PNIL);
+    JIT_CASE(PEEK);
+    JIT_CASE(DUP);
+    JIT_CASE(FLD);
+    JIT_CASE(LET);
+    JIT_CASE(SET);
+    JIT_CASE(LLET);
+    JIT_CASE(LSET);
+    JIT_CASE(MSET);
+    JIT_CASE(GET);
+    JIT_CASE(GTSH);
+    JIT_CASE(CALL);
+    JIT_CASE(SCLL);
+    JIT_CASE(RET);
+    JIT_CASE(NBLK);
+    JIT_CASE(BBLK);
+    JIT_CASE(ADD);
+    JIT_CASE(SUB);
+    JIT_CASE(MULT);
+    JIT_CASE(DIV);
+    JIT_CASE(MOD);
+    JIT_CASE(INC);
+    JIT_CASE(AND);
+    JIT_CASE(OR);
+    JIT_CASE(BAND);
+    JIT_CASE(BXOR);
+    JIT_CASE(BOR);
+    JIT_CASE(LT);
+    JIT_CASE(GT);
+    JIT_CASE(LTE);
+    JIT_CASE(GTE);
+    JIT_CASE(EQ);
+    JIT_CASE(IS);
+    JIT_CASE(NOT);
+    JIT_CASE(ANEW);
+    JIT_CASE(AIDX);
+    JIT_CASE(ASET);
+    JIT_CASE(TUPL);
+    JIT_CASE(ARGS);
+    JIT_CASE(PARM);
+    JIT_CASE(TLEN);
+    JIT_CASE(TGET);
+    JIT_CASE(TGTE);
+    JIT_CASE(CTCH);
+    JIT_CASE(RAIS);
+    JIT_CASE(RTRU);
+    JIT_CASE(PTRU);
+    JIT_CASE(RFLS);
+    JIT_CASE(PFLS);
+    case IRES:
+      return _jit_RES;
+    case IPSH:
+      return _jit_PUSH;
+    case DEC:
+      return _jit_INC;
+    case CLLN:
+      return _jit_CALL;
+    case SCLN:
+      return _jit_SCLL;
+    case NEQ:
+      return _jit_EQ;
+    default:
+      return NULL;
+  }
+}
+
+// Runs the function task is in with the JIT if it has been compiled, compiling
+// it first if it has just become hot. Returns whether any of it was run.
+bool _maybe_run_jit_(VM *vm, Task *task, Context *context) {
+  Context *frame = context;
+  // Blocks within a function have no func.
+  while (NULL == frame->func && NULL != frame->previous_context) {
+    frame = frame->previous_context;
+  }
+  Function *func = (Function *)frame->func;  // Bless
+  if (NULL == func || func->_is_native || func->_is_native2) {
+    return false;
+  }
+  const JitCode *code = atomic_load_ptr(&func->_jit_code);
+  if (NULL == code) {
+    // Only count entries into the function. Those which passed the arguments
+    // on the stack begin after PARM.
+    uint32_t entry = func->_ins_pos;
+    if (PARM == tape_get(context->tape, entry)->op) {
+      ++entry;
+    }
+    if (context != frame || context->ins != entry) {
+      return false;
+    }
+    // Exactly one task sees the count reach the threshold.
+    if (JIT_CALL_THRESHOLD != atomic_inc_u32(&func->_call_count)) {
+      return false;
+    }
+    code = jit_compile(vm->jit, context->tape, func->_ins_pos);
+    if (NULL == code) {
+      return false;
+    }
+    atomic_store_ptr(&func->_jit_code, (void *)code);
+  }
+  return jit_run(code, vm, task);
+}
+
+#ifdef ZINNIA_COMPUTED_GOTO
+// Each handler jumps directly to the handler of the next instruction.
+#define TARGET(handler) \
+  case handler:         \
+  handler_##handler:
+#define SPECIALIZED_TARGET(handler) handler_##handler:
+#define UNKNOWN_TARGET handler_unknown:
+#define DISPATCH()                                       \
+  {                                                      \
+    context->ins++;                                      \
+    if (NULL != context->error) {                        \
+      continue;                                          \
+    }                                                    \
+    ins = context_ins(context);                          \
+    goto *dispatch_table[dispatch_current_handler(ins)]; \
+  }
+#else
+#define TARGET(handler) case handler:
+#define UNKNOWN_TARGET
+#define DISPATCH() break
+#endif
+
 // Please forgive me father, for I have sinned.
 TaskState vm_execute_task(VM *vm, Task *task) {
+#ifdef ZINNIA_COMPUTED_GOTO
+  static void *const dispatch_table[HANDLER_BOUND] = {
+      [NOP] = &&handler_unknown,
+      [EXIT] = &&handler_EXIT,
+      [RES] = &&handler_RES,
+      [TGET] = &&handler_TGET,
+      [TLEN] = &&handler_TLEN,
+      [SET] = &&handler_SET,
+      [MSET] = &&handler_MSET,
+      [LET] = &&handler_LET,
+      [PUSH] = &&handler_PUSH,
+      [PEEK] = &&handler_PEEK,
+      [PSRS] = &&handler_unknown,
+      [NOT] = &&handler_NOT,
+      [NOTC] = &&handler_unknown,
+      [GT] = &&handler_GT,
+      [LT] = &&handler_LT,
+      [EQ] = &&handler_EQ,
+      [NEQ] = &&handler_NEQ,
+      [GTE] = &&handler_GTE,
+      [LTE] = &&handler_LTE,
+      [AND] = &&handler_AND,
+      [OR] = &&handler_OR,
+      [XOR] = &&handler_unknown,
+      [BAND] = &&handler_BAND,
+      [BOR] = &&handler_BOR,
+      [BXOR] = &&handler_BXOR,
+      [IF] = &&handler_IF,
+      [IFN] = &&handler_IFN,
+      [JMP] = &&handler_JMP,
+      [NBLK] = &&handler_NBLK,
+      [BBLK] = &&handler_BBLK,
+      [RET] = &&handler_RET,
+      [ADD] = &&handler_ADD,
+      [SUB] = &&handler_SUB,
+      [MULT] = &&handler_MULT,
+      [DIV] = &&handler_DIV,
+      [MOD] = &&handler_MOD,
+      [INC] = &&handler_INC,
+      [DEC] = &&handler_DEC,
+      [FINC] = &&handler_unknown,
+      [FDEC] = &&handler_unknown,
+      [SINC] = &&handler_unknown,
+      [CALL] = &&handler_CALL,
+      [CLLN] = &&handler_CLLN,
+      [TUPL] = &&handler_TUPL,
+      [TGTE] = &&handler_TGTE,
+      [TLTE] = &&handler_unknown,
+      [TEQ] = &&handler_unknown,
+      [DUP] = &&handler_DUP,
+      [GOTO] = &&handler_unknown,
+      [PRNT] = &&handler_unknown,
+      [LMDL] = &&handler_LMDL,
+      [GET] = &&handler_GET,
+      [GTSH] = &&handler_GTSH,
+      [RNIL] = &&handler_RNIL,
+      [PNIL] = &&handler_PNIL,
+      [FLD] = &&handler_FLD,
+      [FLDC] = &&handler_unknown,
+      [IS] = &&handler_IS,
+      [ADR] = &&handler_unknown,
+      [RAIS] = &&handler_RAIS,
+      [CTCH] = &&handler_CTCH,
+      [ANEW] = &&handler_ANEW,
+      [AIDX] = &&handler_AIDX,
+      [ASET] = &&handler_ASET,
+      [CNST] = &&handler_unknown,
+      [SETC] = &&handler_unknown,
+      [LETC] = &&handler_unknown,
+      [SGET] = &&handler_unknown,
+      [WAIT] = &&handler_WAIT,
+      [RTRU] = &&handler_RTRU,
+      [RFLS] = &&handler_RFLS,
+      [PTRU] = &&handler_PTRU,
+      [PFLS] = &&handler_PFLS,
+      [IRES] = &&handler_IRES,
+      [IPSH] = &&handler_IPSH,
+      [LLET] = &&handler_LLET,
+      [LSET] = &&handler_LSET,
+      [LRES] = &&handler_LRES,
+      [LPSH] = &&handler_LPSH,
+      [SCLL] = &&handler_SCLL,
+      [SCLN] = &&handler_SCLN,
+      [ARGS] = &&handler_ARGS,
+      [PARM] = &&handler_PARM,
+      [RES_STACK] = &&handler_RES_STACK,
+      [RES_ID] = &&handler_RES_ID,
+      [RES_PRIM] = &&handler_RES_PRIM,
+      [RES_STR] = &&handler_RES_STR,
+      [PUSH_RES] = &&handler_PUSH_RES,
+      [PUSH_ID] = &&handler_PUSH_ID,
+      [PUSH_PRIM] = &&handler_PUSH_PRIM,
+      [PUSH_STR] = &&handler_PUSH_STR,
+      [ADD_INT_INT] = &&handler_ADD_INT_INT,
+      [ADD_INT_SLOT] = &&handler_ADD_INT_SLOT,
+      [ADD_INT_IMM] = &&handler_ADD_INT_IMM,
+      [SUB_INT_INT] = &&handler_SUB_INT_INT,
+      [SUB_INT_SLOT] = &&handler_SUB_INT_SLOT,
+      [SUB_INT_IMM] = &&handler_SUB_INT_IMM,
+      [MULT_INT_INT] = &&handler_MULT_INT_INT,
+      [MULT_INT_SLOT] = &&handler_MULT_INT_SLOT,
+      [MULT_INT_IMM] = &&handler_MULT_INT_IMM,
+      [LT_INT_INT] = &&handler_LT_INT_INT,
+      [LT_INT_SLOT] = &&handler_LT_INT_SLOT,
+      [LT_INT_IMM] = &&handler_LT_INT_IMM,
+      [GT_INT_INT] = &&handler_GT_INT_INT,
+      [GT_INT_SLOT] = &&handler_GT_INT_SLOT,
+      [GT_INT_IMM] = &&handler_GT_INT_IMM,
+      [LTE_INT_INT] = &&handler_LTE_INT_INT,
+      [LTE_INT_SLOT] = &&handler_LTE_INT_SLOT,
+      [LTE_INT_IMM] = &&handler_LTE_INT_IMM,
+      [GTE_INT_INT] = &&handler_GTE_INT_INT,
+      [GTE_INT_SLOT] = &&handler_GTE_INT_SLOT,
+      [GTE_INT_IMM] = &&handler_GTE_INT_IMM,
+      [ADD_STR] = &&handler_ADD_STR,
+      [ADD_STR_SLOT] = &&handler_ADD_STR_SLOT,
+  };
+#endif
   task->state = TASK_RUNNING;
   task->wait_reason = NOT_WAITING;
   // This only happens when an error bubbles up to the main task
@@ -1401,11 +2421,12 @@ TaskState vm_execute_task(VM *vm, Task *task) {
   if (task->child_task_has_error) {
     const Entity *error_e = task_get_resval(task);
     ASSERT(error_e != NULL);
-    ASSERT(OBJECT == error_e->type);
-    ASSERT(inherits_from(error_e->obj->_class, Class_Error));
-    context->error = error_e->obj;
+    ASSERT(OBJECT == etype(error_e));
+    ASSERT(inherits_from(object_m(error_e)->_class, Class_Error));
+    context->error = object_m(error_e);
     task->child_task_has_error = false;
   }
+  bool stopped_by_jit = false;
   for (;;) {
     if (NULL != context->error) {
       // char *tmp = CNEW_ARR(char, 100);
@@ -1414,7 +2435,21 @@ TaskState vm_execute_task(VM *vm, Task *task) {
       if (!_attemp_catch_error(task, context)) {
         goto end_of_loop;
       }
+      // The error may have been caught by a caller.
+      context = task->current;
+    }
+    if (NULL != vm->jit && !stopped_by_jit &&
+        _maybe_run_jit_(vm, task, context)) {
+      if (TASK_WAITING == task->state) {
+        // A call made by compiled code is waiting.
+        goto end_of_loop;
+      }
+      // The JIT stops at instructions it leaves to the interpreter.
+      stopped_by_jit = true;
+      context = task->current;
+      continue;
     }
+    stopped_by_jit = false;
     const Instruction *ins = context_ins(context);
 #ifdef DEBUG
     SYNCHRONIZED(vm->process_create_lock, {
@@ -1424,203 +2459,362 @@ TaskState vm_execute_task(VM *vm, Task *task) {
       fprintf(stdout, "\n");
       fflush(stdout);
     });
+#endif
+#ifdef ZINNIA_COMPUTED_GOTO
+    goto *dispatch_table[dispatch_current_handler(ins)];
 #endif
     switch (ins->op) {
-      case RES:
-      case IRES:
+      TARGET(RES)
+      TARGET(IRES)
         _execute_RES(vm, task, context, ins);
-        break;
-      case RNIL:
+        DISPATCH();
+      TARGET(RNIL)
         _execute_RNIL(vm, task, context, ins);
-        break;
-      case PUSH:
-      case IPSH:
+        DISPATCH();
+      TARGET(PUSH)
+      TARGET(IPSH)
         _execute_PUSH(vm, task, context, ins);
-        break;
-      case PNIL:
+        DISPATCH();
+      TARGET(LRES)
+        _execute_LRES(vm, task, context, ins);
+        DISPATCH();
+      TARGET(LPSH)
+        _execute_LPSH(vm, task, context, ins);
+        DISPATCH();
+      TARGET(PNIL)
         _execute_PNIL(vm, task, context, ins);
-        break;
-      case PEEK:
+        DISPATCH();
+      TARGET(PEEK)
         _execute_PEEK(vm, task, context, ins);
-        break;
-      case DUP:
+        DISPATCH();
+      TARGET(DUP)
         _execute_DUP(vm, task, context, ins);
-        break;
-      case FLD:
+        DISPATCH();
+      TARGET(FLD)
         _execute_FLD(vm, task, context, ins);
-        break;
-      case LET:
+        DISPATCH();
+      TARGET(LET)
         _execute_LET(vm, task, context, ins);
-        break;
-      case SET:
+        DISPATCH();
+      TARGET(SET)
         _execute_SET(vm, task, context, ins);
-        break;
-      case MSET:
+        DISPATCH();
+      TARGET(LLET)
+        _execute_LLET(vm, task, context, ins);
+        DISPATCH();
+      TARGET(LSET)
+        _execute_LSET(vm, task, context, ins);
+        DISPATCH();
+      TARGET(MSET)
         _execute_MSET(vm, task, context, ins);
-        break;
-      case GET:
+        DISPATCH();
+      TARGET(GET)
         _execute_GET(vm, task, context, ins);
-        break;
-      case GTSH:
+        DISPATCH();
+      TARGET(GTSH)
         _execute_GTSH(vm, task, context, ins);
-        break;
-      case CALL:
-      case CLLN:
+        DISPATCH();
+      TARGET(CALL)
+      TARGET(CLLN)
         if (_execute_CALL(vm, task, context, ins)) {
           task->state = TASK_WAITING;
           task->wait_reason = WAITING_ON_FN_CALL;
           context->ins++;
           goto end_of_loop;
         }
-        break;
-      case RET:
+        // The arguments are left on the stack if nothing took them.
+        _drop_stack_args_(task);
+        // The function may have been entered on this task.
+        context->ins++;
+        context = task->current;
+        _safepoint_(task, context);
+        continue;
+      TARGET(SCLL)
+      TARGET(SCLN)
+        if (_execute_SCLL(vm, task, context, ins)) {
+          task->state = TASK_WAITING;
+          task->wait_reason = WAITING_ON_FN_CALL;
+          context->ins++;
+          goto end_of_loop;
+        }
+        _drop_stack_args_(task);
+        context->ins++;
+        context = task->current;
+        _safepoint_(task, context);
+        continue;
+      TARGET(RET)
         _execute_RET(vm, task, context, ins);
-        task->state = TASK_COMPLETE;
         context->ins++;
+        if (task_return_from_frame(task)) {
+          context = task->current;
+          continue;
+        }
+        task->state = TASK_COMPLETE;
         goto end_of_loop;
-      case NBLK:
+      TARGET(NBLK)
         context = _execute_NBLK(vm, task, context, ins);
-        break;
-      case BBLK:
+        DISPATCH();
+      TARGET(BBLK)
         context = _execute_BBLK(vm, task, context, ins);
-        break;
-      case JMP:
+        DISPATCH();
+      TARGET(JMP)
         _execute_JMP(vm, task, context, ins);
-        break;
-      case IF:
-      case IFN:
+        if (ins->int_val < 0) {
+          _safepoint_(task, context);
+        }
+        DISPATCH();
+      TARGET(IF)
+      TARGET(IFN)
         _execute_IF(vm, task, context, ins);
-        break;
-      case EXIT:
+        if (ins->int_val < 0) {
+          _safepoint_(task, context);
+        }
+        DISPATCH();
+      TARGET(EXIT)
         _execute_EXIT(vm, task, context, ins);
         goto end_of_loop;
-      case ADD:
+      TARGET(ADD)
+        _quicken_(task, context, ins);
         _execute_ADD_with_string(vm, task, context, ins);
-        break;
-      case SUB:
+        DISPATCH();
+      TARGET(SUB)
+        _quicken_(task, context, ins);
         _execute_SUB(vm, task, context, ins);
-        break;
-      case MULT:
+        DISPATCH();
+      TARGET(MULT)
+        _quicken_(task, context, ins);
         _execute_MULT(vm, task, context, ins);
-        break;
-      case DIV:
+        DISPATCH();
+      TARGET(DIV)
         _execute_DIV(vm, task, context, ins);
-        break;
-      case MOD:
+        DISPATCH();
+      TARGET(MOD)
         _execute_MOD(vm, task, context, ins);
-        break;
-      case INC:
-      case DEC:
+        DISPATCH();
+      TARGET(INC)
+      TARGET(DEC)
         _execute_INC(vm, task, context, ins);
-        break;
-      case AND:
+        DISPATCH();
+      TARGET(AND)
         _execute_AND(vm, task, context, ins);
-        break;
-      case OR:
+        DISPATCH();
+      TARGET(OR)
         _execute_OR(vm, task, context, ins);
-        break;
-      case BAND:
+        DISPATCH();
+      TARGET(BAND)
         _execute_BAND(vm, task, context, ins);
-        break;
-      case BXOR:
+        DISPATCH();
+      TARGET(BXOR)
         _execute_BXOR(vm, task, context, ins);
-        break;
-      case BOR:
+        DISPATCH();
+      TARGET(BOR)
         _execute_BOR_with_obj(vm, task, context, ins);
-        break;
-      case LT:
+        DISPATCH();
+      TARGET(LT)
+        _quicken_(task, context, ins);
         _execute_LT(vm, task, context, ins);
-        break;
-      case GT:
+        DISPATCH();
+      TARGET(GT)
+        _quicken_(task, context, ins);
         _execute_GT(vm, task, context, ins);
-        break;
-      case LTE:
+        DISPATCH();
+      TARGET(LTE)
+        _quicken_(task, context, ins);
         _execute_LTE(vm, task, context, ins);
-        break;
-      case GTE:
+        DISPATCH();
+      TARGET(GTE)
+        _quicken_(task, context, ins);
         _execute_GTE(vm, task, context, ins);
-        break;
-      case EQ:
-      case NEQ:
+        DISPATCH();
+      TARGET(EQ)
+      TARGET(NEQ)
         if (_execute_EQ(vm, task, context, ins)) {
           task->state = TASK_WAITING;
           task->wait_reason = WAITING_ON_FN_CALL;
           context->ins++;
           goto end_of_loop;
         }
-        break;
-      case IS:
+        context->ins++;
+        context = task->current;
+        continue;
+      TARGET(IS)
         _execute_IS(vm, task, context, ins);
-        break;
-      case NOT:
+        DISPATCH();
+      TARGET(NOT)
         _execute_NOT(vm, task, context, ins);
-        break;
-      case ANEW:
+        DISPATCH();
+      TARGET(ANEW)
         _execute_ANEW(vm, task, context, ins);
-        break;
-      case AIDX:
+        DISPATCH();
+      TARGET(AIDX)
         if (_execute_AIDX(vm, task, context, ins)) {
           task->state = TASK_WAITING;
           task->wait_reason = WAITING_ON_FN_CALL;
           context->ins++;
           goto end_of_loop;
         }
-        break;
-      case ASET:
+        context->ins++;
+        context = task->current;
+        continue;
+      TARGET(ASET)
         if (_execute_ASET(vm, task, context, ins)) {
           task->state = TASK_WAITING;
           task->wait_reason = WAITING_ON_FN_CALL;
           context->ins++;
           goto end_of_loop;
         }
-        break;
-      case TUPL:
+        context->ins++;
+        context = task->current;
+        continue;
+      TARGET(TUPL)
         _execute_TUPL(vm, task, context, ins);
-        break;
-      case TLEN:
+        DISPATCH();
+      TARGET(ARGS)
+        _execute_ARGS(vm, task, context, ins);
+        DISPATCH();
+      TARGET(PARM)
+        _execute_PARM(vm, task, context, ins);
+        DISPATCH();
+      TARGET(TLEN)
         _execute_TLEN(vm, task, context, ins);
-        break;
-      case TGET:
+        DISPATCH();
+      TARGET(TGET)
         _execute_TGET(vm, task, context, ins);
-        break;
-      case TGTE:
+        DISPATCH();
+      TARGET(TGTE)
         _execute_TGTE(vm, task, context, ins);
-        break;
-      case CTCH:
+        DISPATCH();
+      TARGET(CTCH)
         _execute_CTCH(vm, task, context, ins);
-        break;
-      case RAIS:
+        DISPATCH();
+      TARGET(RAIS)
         _execute_RAIS(vm, task, context);
-        break;
-      case LMDL:
+        DISPATCH();
+      TARGET(LMDL)
         if (_execute_LMDL(vm, task, context, ins)) {
           task->state = TASK_WAITING;
           task->wait_reason = WAITING_ON_FN_CALL;
           context->ins++;
           goto end_of_loop;
         }
-        break;
-      case WAIT:
+        DISPATCH();
+      TARGET(WAIT)
         if (_execute_WAIT(vm, task, context, ins)) {
           task->state = TASK_WAITING;
           task->wait_reason = WAITING_ON_FUTURE;
           context->ins++;
           goto end_of_loop;
         }
-        break;
-      case RTRU:
+        DISPATCH();
+      TARGET(RTRU)
         _execute_RTRU(vm, task, context, ins);
-        break;
-      case PTRU:
+        DISPATCH();
+      TARGET(PTRU)
         _execute_PTRU(vm, task, context, ins);
-        break;
-      case RFLS:
+        DISPATCH();
+      TARGET(RFLS)
         _execute_RFLS(vm, task, context, ins);
-        break;
-      case PFLS:
+        DISPATCH();
+      TARGET(PFLS)
         _execute_PFLS(vm, task, context, ins);
-        break;
+        DISPATCH();
+#ifdef ZINNIA_COMPUTED_GOTO
+      SPECIALIZED_TARGET(RES_STACK)
+        _execute_RES_STACK(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(RES_ID)
+        _execute_RES_ID(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(RES_PRIM)
+        _execute_RES_PRIM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(RES_STR)
+        _execute_RES_STR(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(PUSH_RES)
+        _execute_PUSH_RES(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(PUSH_ID)
+        _execute_PUSH_ID(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(PUSH_PRIM)
+        _execute_PUSH_PRIM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(PUSH_STR)
+        _execute_PUSH_STR(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(ADD_INT_INT)
+        _execute_ADD_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(ADD_INT_SLOT)
+        _execute_ADD_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(ADD_INT_IMM)
+        _execute_ADD_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(SUB_INT_INT)
+        _execute_SUB_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(SUB_INT_SLOT)
+        _execute_SUB_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(SUB_INT_IMM)
+        _execute_SUB_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(MULT_INT_INT)
+        _execute_MULT_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(MULT_INT_SLOT)
+        _execute_MULT_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(MULT_INT_IMM)
+        _execute_MULT_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(LT_INT_INT)
+        _execute_LT_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(LT_INT_SLOT)
+        _execute_LT_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(LT_INT_IMM)
+        _execute_LT_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(GT_INT_INT)
+        _execute_GT_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(GT_INT_SLOT)
+        _execute_GT_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(GT_INT_IMM)
+        _execute_GT_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(LTE_INT_INT)
+        _execute_LTE_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(LTE_INT_SLOT)
+        _execute_LTE_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(LTE_INT_IMM)
+        _execute_LTE_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(GTE_INT_INT)
+        _execute_GTE_INT_INT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(GTE_INT_SLOT)
+        _execute_GTE_INT_SLOT(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(GTE_INT_IMM)
+        _execute_GTE_INT_IMM(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(ADD_STR)
+        _execute_ADD_STR(vm, task, context, ins);
+        DISPATCH();
+      SPECIALIZED_TARGET(ADD_STR_SLOT)
+        _execute_ADD_STR_SLOT(vm, task, context, ins);
+        DISPATCH();
+#endif
       default:
+      UNKNOWN_TARGET
         FATALF("Unknown instruction: %s", op_to_str(ins->op));
     }
     context->ins++;
@@ -1664,7 +2858,6 @@ void _broadcast_to_dependent_tasks(Process *process, Task *task,
       process_enqueue_task(dependent_task->parent_process, dependent_task);
     }
     process_remove_waiting_task(dependent_task->parent_process, dependent_task);
-    condition_broadcast(process->task_wait_cond);
   }
 }
 
@@ -1679,13 +2872,10 @@ void _mark_task_complete(Process *process, Task *task, bool should_push) {
 bool _process_is_done(Process *process) {
   bool is_done = false;
 
-  SYNCHRONIZED(process->task_queue_lock, {
-    CRITICAL(process->task_waiting_cs, {
-      if (TaskSet_size(&process->waiting_tasks) == 0 &&
-          TaskArray_size(&process->queued_tasks) == 0) {
-        is_done = true;
-      }
-    });
+  CRITICAL(process->task_waiting_cs, {
+    if (process->num_waiting_tasks == 0 && process_queue_size(process) == 0) {
+      is_done = true;
+    }
   });
   return is_done;
 }
@@ -1696,19 +2886,15 @@ bool _process_should_broadcast_to_parent(Process *process) {
   }
   bool should_broadcast = false;
 
-  SYNCHRONIZED(process->task_queue_lock, {
-    CRITICAL(process->task_waiting_cs, {
-      if (process->is_remote) {
-        should_broadcast =
-            TaskSet_size(&process->waiting_tasks) == 1 &&
-            TaskArray_size(&process->queued_tasks) == 0 &&
-            TaskSet_contains(&process->waiting_tasks,
-                             process->remote_non_daemon_task, sizeof(Task *));
-      } else if (TaskSet_size(&process->waiting_tasks) == 0 &&
-                 TaskArray_size(&process->queued_tasks) == 0) {
-        should_broadcast = true;
-      }
-    });
+  CRITICAL(process->task_waiting_cs, {
+    if (process->is_remote) {
+      should_broadcast = process->num_waiting_tasks == 1 &&
+                         process_queue_size(process) == 0 &&
+                         process->remote_non_daemon_task->is_waiting;
+    } else if (process->num_waiting_tasks == 0 &&
+               process_queue_size(process) == 0) {
+      should_broadcast = true;
+    }
   });
   return should_broadcast;
 }
@@ -1721,9 +2907,10 @@ void _process_broadcast_to_parent(Process *process) {
     if (IS_OBJECT(remote_result)) {
       // Must keep remote objects since other process assumes it will always
       // exist. In the future, there must be a better cleanup process.
-      heap_make_root(process->heap, remote_result->obj);
-      *task_mutable_resval(process_task) = entity_object(create_remote_object(
-          process_task->parent_process->heap, process, remote_result->obj));
+      heap_make_root(process->heap, object_m(remote_result));
+      *task_mutable_resval(process_task) = entity_object(
+          create_remote_object(process_task->parent_process->heap, process,
+                               object_m(remote_result)));
     } else {
       *task_mutable_resval(process_task) = *remote_result;
     }
@@ -1766,15 +2953,18 @@ void _process_handle_error(Process *process, Task *task) {
   process_push_task(task->parent_task->parent_process, task->parent_task);
 }
 
-void process_run(Process *process) {
+bool process_run_queued_tasks(Process *process) {
   VM *vm = process->vm;
   Task *task;
-top_of_fn:
   while (NULL != (task = process_pop_task(process))) {
     process->current_task = task;
     TaskState task_state;
+    // Ended after every task so that an idle worker never holds back freeing
+    // replaced class tables.
+    class_begin_lookups();
     SYNCHRONIZED(process->heap_access_lock,
                  { task_state = vm_execute_task(vm, task); });
+    class_end_lookups();
     // Release heap mutex
 #ifdef DEBUG
     SYNCHRONIZED(vm->process_create_lock, {
@@ -1808,7 +2998,7 @@ top_of_fn:
   if (process_maybe_collect_garbage(process)) {
     FATALF("MEMORY LIMIT EXCEEDED");
     raise_error(process->current_task, process->current_task->current,
-                "Out of memory: Max object count for process exceeded.");
+                "Out of memory: Max heap size for process exceeded.");
   }
 
   if (_process_should_broadcast_to_parent(process)) {
@@ -1817,20 +3007,24 @@ top_of_fn:
 
   if (_process_is_done(process)) {
     DEBUGF("Process is complete.");
-    return;
+    return true;
   }
+  return false;
+}
 
-  int waiting_task_count;
-  CRITICAL(process->task_waiting_cs,
-           { waiting_task_count = TaskSet_size(&process->waiting_tasks); });
-  CRITICAL(process->task_waiting_cs, {
-    while (TaskSet_size(&process->waiting_tasks) != 0 &&
-           TaskSet_size(&process->waiting_tasks) == waiting_task_count &&
-           process_queue_size(process) == 0) {
-      condition_wait(process->task_wait_cond);
-    }
-  });
-  goto top_of_fn;
+void process_run(Process *process) {
+  while (!process_run_queued_tasks(process)) {
+    uint32_t waiting_task_count;
+    CRITICAL(process->task_waiting_cs,
+             { waiting_task_count = process->num_waiting_tasks; });
+    CRITICAL(process->task_waiting_cs, {
+      while (process->num_waiting_tasks != 0 &&
+             process->num_waiting_tasks == waiting_task_count &&
+             process_queue_size(process) == 0) {
+        condition_wait(process->task_wait_cond);
+      }
+    });
+  }
 }
 
 void *_process_run_return_void_ptr(void *ptr) {
@@ -1844,28 +3038,47 @@ ThreadHandle process_run_in_new_thread(Process *process) {
              thread_create(AS_VOID_FN(_process_run_return_void_ptr), process);
 }
 
+void process_start(Process *process) {
+  Scheduler *scheduler = process->vm->scheduler;
+  if (NULL == scheduler) {
+    process_run_in_new_thread(process);
+  } else {
+    scheduler_start(scheduler, process);
+  }
+}
+
 bool process_maybe_collect_garbage(Process *process) {
   ASSERT(process != NULL);
 
   Heap *heap = process->heap;
-  const uint32_t object_count_thresh =
-      heap_object_count_threshold_for_garbage_collection(heap);
-  uint32_t object_count = heap_object_count(heap);
-  if (object_count < object_count_thresh) {
+  if (heap_is_collecting(heap)) {
+    if (!heap_needs_garbage_collection(heap)) {
+      return false;
+    }
+    // Only stop the world if the heap is full before the collection is done.
+    if (!heap_is_full(heap)) {
+      process_collect_garbage_incrementally(process);
+      if (heap_is_collecting(heap)) {
+        return false;
+      }
+    } else {
+      process_collect_garbage(process);
+    }
+  } else if (!heap_is_over_threshold(heap)) {
+    if (heap_nursery_is_full(heap)) {
+      process_collect_young_garbage(process);
+    }
     return false;
+  } else if (heap_is_incremental(heap) && !heap_is_full(heap)) {
+    process_collect_garbage_incrementally(process);
+    if (heap_is_collecting(heap)) {
+      return false;
+    }
+  } else {
+    // heap_print_debug_summary(heap);
+    process_collect_garbage(process);
   }
-  // heap_print_debug_summary(heap);
-  process_collect_garbage(process);
-  object_count = heap_object_count(heap);
-  const uint32_t max_object_count = heap_max_object_count(heap);
-
-  if (object_count >= max_object_count) {
-    heap_set_object_count_threshold_for_garbage_collection(heap,
-                                                           max_object_count);
-    return true;
-  } else if (object_count >= object_count_thresh) {
-    heap_set_object_count_threshold_for_garbage_collection(
-        heap, (max_object_count + object_count) / 2);
-  }
-  return false;
+  const bool is_full = heap_raise_thresholds(heap);
+  process_record_gc_thresholds(process);
+  return is_full;
 }
@@ -12,13 +12,27 @@
 #include "zinnia/vm/vm.h"
 
 VM *vm_create(const char *lib_location, uint32_t max_object_count,
-              bool async_enabled);
+              size_t max_process_heap_bytes, bool async_enabled,
+              bool jit_enabled, HeapCollector collector,
+              uint32_t gc_max_pause_us, uint32_t background_threads);
 void vm_delete(VM *vm);
+// Starts sampling every sample_interval-th allocation of every process into
+// vm->heap_profiler.
+void vm_start_heap_profiler(VM *vm, uint32_t sample_interval);
+// Runs every process started from now on on num_workers threads instead of a
+// thread each. 0 means one per core.
+void vm_start_scheduler(VM *vm, uint32_t num_workers);
 
 Process *vm_create_process(VM *vm);
 Process *vm_main_process(VM *vm);
 
+// Runs process on the calling thread until it is done.
 void process_run(Process *process);
+// Runs the tasks queued on process until there are none left. Returns whether
+// the process is done, i.e., no task is queued or waiting either.
+bool process_run_queued_tasks(Process *process);
 ThreadHandle process_run_in_new_thread(Process *process);
+// Runs process on vm->scheduler, or else on a new thread.
+void process_start(Process *process);
 
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_VIRTUAL_MACHINE_H_ */
\ No newline at end of file
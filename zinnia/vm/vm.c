@@ -5,16 +5,31 @@
 
 #include "zinnia/vm/vm.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "zinnia/alloc/alloc.h"
+#include "zinnia/entity/class/class.h"
 #include "zinnia/entity/class/classes_def.h"
+#include "zinnia/util/sync/mpsc_queue.h"
+#include "zinnia/util/time.h"
+#include "zinnia/vm/inline_cache.h"
 #include "zinnia/vm/process/context.h"
+#include "zinnia/vm/process/gc_stats.h"
 #include "zinnia/vm/process/process.h"
+#include "zinnia/vm/process/task.h"
 
-IMPL_ARRAYLIKE(ProcessArray, Process);
+IMPL_ARRAYLIKE(ProcessArray, Process *);
 
 Process *create_process_no_reflection(VM *vm) {
-  Process *process = ProcessArray_push_back_ref(&vm->processes);
+  // Allocated separately since processes run while others are created.
+  Process *process = MNEW(Process);
+  *ProcessArray_push_back_ref(&vm->processes) = process;
   process_init(process, &vm->base_heap_conf);
   process->vm = vm;
+  if (NULL != vm->heap_profiler) {
+    heapprofiler_attach(vm->heap_profiler, process);
+  }
   return process;
 }
 
@@ -49,12 +64,37 @@ Entity *class_get_field(const Class *cls, const char name[]) {
 
 Entity object_get_maybe_wrap(Object *obj, const char field[], Heap *heap,
                              Context *ctx) {
+  return object_get_maybe_wrap_cached(obj, field, NULL, heap, ctx);
+}
+
+Entity object_get_maybe_wrap_cached(Object *obj, const char field[],
+                                    InlineCache *cache, Heap *heap,
+                                    Context *ctx) {
+  Entity member = object_get_unbound_cached(obj, field, cache);
+  if (OBJECT == etype(&member) && Class_Function == object_m(&member)->_class) {
+    return entity_object(
+        wrap_function_in_ref(object_m(&member)->_function_obj, obj, heap, ctx));
+  }
+  return member;
+}
+
+Entity object_get_unbound_cached(Object *obj, const char field[],
+                                 InlineCache *cache) {
   Entity member = NONE_ENTITY;
-  const Entity *member_ptr =
-      (Class_Class == obj->_class) ? NULL : object_get(obj, field);
+  const Entity *member_ptr = NULL;
+  if (Class_Class != obj->_class) {
+    InlineCacheEntry entry;
+    if (NULL != cache && inline_cache_get(cache, obj->_class, field, &entry) &&
+        entry.slot >= 0 && UNSET != etype(&obj->_slots[entry.slot])) {
+      return obj->_slots[entry.slot];
+    }
+    member_ptr = object_get(obj, field);
+  }
 
   if (NULL == member_ptr) {
-    const Function *f = class_get_function(obj->_class, field);
+    const Function *f =
+        (NULL == cache) ? class_get_function(obj->_class, field)
+                        : inline_cache_get_function(cache, obj->_class, field);
     if (NULL != f) {
       member = entity_object(f->_reflection);
     } else {
@@ -73,10 +113,6 @@ Entity object_get_maybe_wrap(Object *obj, const char field[], Heap *heap,
   } else {
     member = *member_ptr;
   }
-  if (OBJECT == member.type && Class_Function == member.obj->_class) {
-    return entity_object(
-        wrap_function_in_ref(member.obj->_function_obj, obj, heap, ctx));
-  }
   return member;
 }
 
@@ -98,24 +134,29 @@ void task_inc_all_context_(Process *process, Task *task) {
   EntityStack_iterator(&stack, &task->entity_stack);
   for (; EntityStack_has_next(&stack); EntityStack_next(&stack)) {
     Entity *e = EntityStack_mutable_value(&stack);
-    if (OBJECT == e->type) {
-      heap_inc_edge(heap, task->_reflection, e->obj);
+    if (OBJECT == etype(e)) {
+      heap_inc_edge(heap, task->_reflection, object_m(e));
     }
   }
-  if (OBJECT == task->resval.type) {
-    heap_inc_edge(heap, task->_reflection, task->resval.obj);
+  if (OBJECT == etype(&task->resval)) {
+    heap_inc_edge(heap, task->_reflection, object_m(&task->resval));
   }
-  Context *ctx = task->current;
+  Context *ctx = task->current, *caller = NULL;
   while (NULL != ctx) {
     // printf("_task_inc_all_context task=%p ctx=%p self=%p\n",
     // task->_reflection,
     //        ctx->_reflection, IS_NONE(&ctx->self) ? NULL : ctx->self.obj);
-    heap_inc_edge(heap, task->_reflection, ctx->_reflection);
-    heap_inc_edge(heap, ctx->_reflection, ctx->self.obj);
+    // Contexts without a reflection are only reachable from the task.
+    Object *ctx_obj = task->_reflection;
+    if (NULL != ctx->_reflection) {
+      heap_inc_edge(heap, task->_reflection, ctx->_reflection);
+      ctx_obj = ctx->_reflection;
+    }
+    heap_inc_edge(heap, ctx_obj, object_m(&ctx->self));
     if (NULL != ctx->error) {
-      heap_inc_edge(heap, ctx->_reflection, ctx->error);
+      heap_inc_edge(heap, ctx_obj, ctx->error);
     }
-    ctx = ctx->previous_context;
+    ctx = task_next_context(ctx, &caller);
   }
   // printf("done\n");
 }
@@ -137,21 +178,25 @@ void task_dec_all_context_(Process *process, Task *task) {
   EntityStack_iterator(&stack, &task->entity_stack);
   for (; EntityStack_has_next(&stack); EntityStack_next(&stack)) {
     Entity *e = EntityStack_mutable_value(&stack);
-    if (OBJECT == e->type) {
-      heap_dec_edge(heap, task->_reflection, e->obj);
+    if (OBJECT == etype(e)) {
+      heap_dec_edge(heap, task->_reflection, object_m(e));
     }
   }
-  if (OBJECT == task->resval.type) {
-    heap_dec_edge(heap, task->_reflection, task->resval.obj);
+  if (OBJECT == etype(&task->resval)) {
+    heap_dec_edge(heap, task->_reflection, object_m(&task->resval));
   }
-  Context *ctx = task->current;
+  Context *ctx = task->current, *caller = NULL;
   while (NULL != ctx) {
-    heap_dec_edge(heap, ctx->_reflection, ctx->self.obj);
-    heap_dec_edge(heap, task->_reflection, ctx->_reflection);
+    Object *ctx_obj =
+        NULL != ctx->_reflection ? ctx->_reflection : task->_reflection;
+    heap_dec_edge(heap, ctx_obj, object_m(&ctx->self));
+    if (NULL != ctx->_reflection) {
+      heap_dec_edge(heap, task->_reflection, ctx->_reflection);
+    }
     if (NULL != ctx->error) {
-      heap_dec_edge(heap, ctx->_reflection, ctx->error);
+      heap_dec_edge(heap, ctx_obj, ctx->error);
     }
-    ctx = ctx->previous_context;
+    ctx = task_next_context(ctx, &caller);
   }
 }
 
@@ -167,21 +212,37 @@ void delete_completed_tasks_(Process *process) {
   TaskSet_init(&process->completed_tasks, hash_task, compare_tasks);
 }
 
-void inc_queued_tasks_(Process *process) {
-  TaskArrayIterator queued_tasks;
-  TaskArray_iterator(&queued_tasks, &process->queued_tasks);
-  for (; TaskArray_has_next(&queued_tasks); TaskArray_next(&queued_tasks)) {
-    Task *queued_task = *TaskArray_mutable_value(&queued_tasks);
-    task_inc_all_context_(process, queued_task);
+// Returns how many tasks it went through. Others may be queued meanwhile, so
+// exactly as many must be passed to dec_queued_tasks_().
+uint32_t inc_queued_tasks_(Process *process) {
+  const uint32_t num_tasks = mpscqueue_size(&process->queued_tasks);
+  MpscQueueIterator queued_tasks;
+  mpscqueue_iterator(&queued_tasks, &process->queued_tasks, num_tasks);
+  for (; mpscqueue_has_next(&queued_tasks); mpscqueue_next(&queued_tasks)) {
+    task_inc_all_context_(process, (Task *)mpscqueue_value(&queued_tasks));
+  }
+  return num_tasks;
+}
+
+void dec_queued_tasks_(Process *process, uint32_t num_tasks) {
+  MpscQueueIterator queued_tasks;
+  mpscqueue_iterator(&queued_tasks, &process->queued_tasks, num_tasks);
+  for (; mpscqueue_has_next(&queued_tasks); mpscqueue_next(&queued_tasks)) {
+    task_dec_all_context_(process, (Task *)mpscqueue_value(&queued_tasks));
+  }
+}
+
+void inc_waiting_tasks_(Process *process) {
+  for (Task *task = process->waiting_tasks; NULL != task;
+       task = task->next_waiting) {
+    task_inc_all_context_(process, task);
   }
 }
 
-void dec_queued_tasks_(Process *process) {
-  TaskArrayIterator queued_tasks;
-  TaskArray_iterator(&queued_tasks, &process->queued_tasks);
-  for (; TaskArray_has_next(&queued_tasks); TaskArray_next(&queued_tasks)) {
-    Task *queued_task = *TaskArray_mutable_value(&queued_tasks);
-    task_dec_all_context_(process, queued_task);
+void dec_waiting_tasks_(Process *process) {
+  for (Task *task = process->waiting_tasks; NULL != task;
+       task = task->next_waiting) {
+    task_dec_all_context_(process, task);
   }
 }
 
@@ -203,21 +264,59 @@ void dec_task_set_(Process *process, TaskSet *task_set) {
   }
 }
 
+// Records a collection that started at start_usec in process->gc_stats and
+// logs it with --gc_log.
+void record_collection_(Process *process, GcType type, int64_t start_usec,
+                        uint32_t deleted_nodes_count) {
+  const int64_t pause_usec = current_monotonic_usec() - start_usec;
+  const uint32_t object_count = heap_object_count(process->heap);
+  gcstats_record(&process->gc_stats, type, pause_usec, deleted_nodes_count,
+                 object_count);
+  if (process->vm->gc_log) {
+    fprintf(stderr,
+            "[gc] process=%p type=%s pause_us=%" PRId64 " freed=%" PRIu32
+            " live=%" PRIu32 " bytes=%zu\n",
+            (void *)process, gctype_name(type), pause_usec,
+            deleted_nodes_count, object_count, heap_bytes(process->heap));
+  }
+}
+
+void process_record_gc_thresholds(Process *process) {
+  ASSERT(process != NULL);
+  const uint32_t object_count_threshold =
+      heap_object_count_threshold_for_garbage_collection(process->heap);
+  const size_t bytes_threshold =
+      heap_bytes_threshold_for_garbage_collection(process->heap);
+  if (gcstats_record_thresholds(&process->gc_stats, object_count_threshold,
+                                bytes_threshold) &&
+      process->vm->gc_log) {
+    fprintf(stderr,
+            "[gc] process=%p threshold_objects=%" PRIu32
+            " threshold_bytes=%zu\n",
+            (void *)process, object_count_threshold, bytes_threshold);
+  }
+}
+
 uint32_t process_collect_garbage(Process *process) {
   ASSERT(process != NULL);
   uint32_t deleted_nodes_count;
 
   SYNCHRONIZED(process->heap_access_lock, {
-    SYNCHRONIZED(process->task_queue_lock, {
-      CRITICAL(process->task_waiting_cs, {
-        delete_completed_tasks_(process);
+    CRITICAL(process->task_waiting_cs, {
+      const int64_t start_usec = current_monotonic_usec();
+      delete_completed_tasks_(process);
 
+      if (HEAP_COLLECTOR_REFGRAPH != heap_collector(process->heap)) {
+        // The tasks are found through the trace functions of Process, Task
+        // and Context instead.
+        deleted_nodes_count = heap_collect_garbage(process->heap);
+      } else {
         task_inc_all_context_(process, process->current_task);
         if (process->is_remote) {
           task_inc_all_context_(process, process->remote_non_daemon_task);
         }
-        inc_queued_tasks_(process);
-        inc_task_set_(process, &process->waiting_tasks);
+        const uint32_t num_queued_tasks = inc_queued_tasks_(process);
+        inc_waiting_tasks_(process);
         inc_task_set_(process, &process->background_tasks);
 
         // printf("process_collect_garbage(%p)\n", process->heap);
@@ -228,11 +327,46 @@ uint32_t process_collect_garbage(Process *process) {
         if (process->is_remote) {
           task_dec_all_context_(process, process->remote_non_daemon_task);
         }
-        dec_queued_tasks_(process);
-        dec_task_set_(process, &process->waiting_tasks);
+        dec_queued_tasks_(process, num_queued_tasks);
+        dec_waiting_tasks_(process);
         dec_task_set_(process, &process->background_tasks);
-      });
+      }
+      record_collection_(process, GC_FULL, start_usec, deleted_nodes_count);
+    });
+  });
+  class_free_retired_tables();
+  return deleted_nodes_count;
+}
+
+uint32_t process_collect_garbage_incrementally(Process *process) {
+  ASSERT(process != NULL);
+  uint32_t deleted_nodes_count;
+
+  SYNCHRONIZED(process->heap_access_lock, {
+    CRITICAL(process->task_waiting_cs, {
+      const int64_t start_usec = current_monotonic_usec();
+      delete_completed_tasks_(process);
+      deleted_nodes_count = heap_collect_garbage_incrementally(process->heap);
+      record_collection_(process, GC_INCREMENTAL, start_usec,
+                         deleted_nodes_count);
+    });
+  });
+  class_free_retired_tables();
+  return deleted_nodes_count;
+}
+
+uint32_t process_collect_young_garbage(Process *process) {
+  ASSERT(process != NULL);
+  uint32_t deleted_nodes_count;
+
+  SYNCHRONIZED(process->heap_access_lock, {
+    CRITICAL(process->task_waiting_cs, {
+      const int64_t start_usec = current_monotonic_usec();
+      delete_completed_tasks_(process);
+      deleted_nodes_count = heap_collect_young_garbage(process->heap);
+      record_collection_(process, GC_YOUNG, start_usec, deleted_nodes_count);
     });
   });
+  class_free_retired_tables();
   return deleted_nodes_count;
 }
\ No newline at end of file
@@ -7,12 +7,16 @@
 #define COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_VM_H_
 
 #include "c-data-structures/arraylike.h"
+#include "zinnia/program/instruction.h"
 #include "zinnia/util/sync/mutex.h"
+#include "zinnia/util/sync/reactor.h"
 #include "zinnia/util/sync/threadpool.h"
+#include "zinnia/vm/heap_profiler.h"
+#include "zinnia/vm/jit.h"
 #include "zinnia/vm/module_manager.h"
 #include "zinnia/vm/process/processes.h"
 
-DEFINE_ARRAYLIKE(ProcessArray, Process);
+DEFINE_ARRAYLIKE(ProcessArray, Process *);
 
 typedef struct _VM {
   ModuleManager mm;
@@ -21,8 +25,18 @@ typedef struct _VM {
   Mutex process_create_lock;
   Process *main;
   ThreadPool *background_pool;
+  // Parks background natives waiting on IO until it is ready.
+  Reactor *reactor;
   HeapConf base_heap_conf;
   bool async_enabled;
+  // NULL unless the JIT is enabled.
+  Jit *jit;
+  // NULL unless heap profiling is enabled.
+  HeapProfiler *heap_profiler;
+  // Runs started processes. NULL if each runs on a thread of its own.
+  Scheduler *scheduler;
+  // Whether every collection is logged to stderr.
+  bool gc_log;
 } VM;
 
 ModuleManager *vm_module_manager(VM *vm);
@@ -31,7 +45,26 @@ Process *create_process_no_reflection(VM *vm);
 void add_reflection_to_process(Process *process);
 Entity object_get_maybe_wrap(Object *obj, const char field[], Heap *heap,
                              Context *ctx);
+// Same as object_get_maybe_wrap() but looks up functions on the class of obj
+// through cache.
+Entity object_get_maybe_wrap_cached(Object *obj, const char field[],
+                                    InlineCache *cache, Heap *heap,
+                                    Context *ctx);
+// Same as object_get_maybe_wrap_cached() but returns functions without binding
+// them to obj, so callers which only call the function need not allocate a
+// FunctionRef.
+Entity object_get_unbound_cached(Object *obj, const char field[],
+                                 InlineCache *cache);
 
 uint32_t process_collect_garbage(Process *process);
+// Does one bounded step of an incremental collection of the process heap. See
+// heap_collect_garbage_incrementally().
+uint32_t process_collect_garbage_incrementally(Process *process);
+// Collects only the nursery of the process heap. See
+// heap_collect_young_garbage().
+uint32_t process_collect_young_garbage(Process *process);
+// Records the current collection thresholds of the process heap in
+// process->gc_stats, logging them with --gc_log if they changed.
+void process_record_gc_thresholds(Process *process);
 
 #endif /* COM_GITHUB_JEFFMANZIONE_ZINNIA_VM_VM_H_ */
\ No newline at end of file
@@ -388,8 +388,20 @@ def zinnia_seed(name, deps = []):
         deps = deps,
     )
 
+def _runner_defines_transition_impl(settings, attr):
+    return {
+        "//command_line_option:define": settings["//command_line_option:define"] + attr.defines,
+    }
+
+# Builds the runner with the defines of the test added to those of the build.
+_runner_defines_transition = transition(
+    implementation = _runner_defines_transition_impl,
+    inputs = ["//command_line_option:define"],
+    outputs = ["//command_line_option:define"],
+)
+
 def _zinnia_test_impl(ctx):
-    runner_executable = ctx.attr.runner.files_to_run.executable
+    runner_executable = ctx.executable.runner
     main_file = sorted(ctx.attr.main.files.to_list(), key = _prioritize_bin)[0]
 
     test_output_file = ctx.actions.declare_file(ctx.label.name + ".out")
@@ -405,7 +417,7 @@ def _zinnia_test_impl(ctx):
 
     src_files = [main_file] + dep_files
 
-    zinnia_args = [file.path for file in src_files]
+    zinnia_args = ctx.attr.flags + [file.path for file in src_files]
     input_files = src_files
 
     ctx.actions.run_shell(
@@ -443,17 +455,23 @@ _zinnia_test = rule(
             allow_files = True,
             doc = "Data",
         ),
+        "flags": attr.string_list(
+            doc = "Flags passed to the runner",
+        ),
+        "defines": attr.string_list(
+            doc = "Defines the runner is built with, e.g., entity=compact",
+        ),
         "runner": attr.label(
             default = Label("//zinnia:zinnia"),
             executable = True,
             allow_single_file = True,
-            cfg = "target",
+            cfg = _runner_defines_transition,
         ),
     },
     test = True,
 )
 
-def zinnia_test(name, main, srcs = [], deps = [], modules = [], data = []):
+def zinnia_test(name, main, srcs = [], deps = [], modules = [], data = [], flags = [], defines = []):
     """Runs a Zinnia test.
 
     Args:
@@ -463,6 +481,8 @@ def zinnia_test(name, main, srcs = [], deps = [], modules = [], data = []):
         deps: Zinnia libraries that should be included in the binary.
         modules: Modules (zinnia_cc_library) targets that should be included in the binary.
         data: Data needed by the program.
+        flags: Flags passed to the runner, e.g., --jit.
+        defines: Defines the runner is built with, e.g., entity=compact.
     """
     if main in srcs:
         srcs.remove(main)
@@ -478,4 +498,6 @@ def zinnia_test(name, main, srcs = [], deps = [], modules = [], data = []):
         name = name,
         main = main,
         deps = deps,
+        flags = flags,
+        defines = defines,
     )